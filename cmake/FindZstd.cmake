@@ -0,0 +1,29 @@
+# - Try to find Zstd
+# Once done, this will define
+#
+#  ZSTD_FOUND - system has Zstd
+#  ZSTD_INCLUDE_DIRS - the Zstd include directories
+#  ZSTD_LIBRARIES - link these to use Zstd
+
+include(LibFindMacros)
+
+# Use pkg-config to get hints about paths
+libfind_pkg_check_modules(ZSTD_PKGCONF libzstd)
+
+# Include dir
+find_path(ZSTD_INCLUDE_DIR
+	NAMES zstd.h
+	PATHS ${ZSTD_PKGCONF_INCLUDE_DIRS}
+)
+
+# Finally the library itself
+find_library(ZSTD_LIBRARY
+	NAMES zstd
+	PATHS ${ZSTD_PKGCONF_LIBRARY_DIRS}
+)
+
+# Set the include dir variables and the libraries and let libfind_process do the rest.
+# NOTE: Singular variables for this library, plural for libraries this this lib depends on.
+set(ZSTD_PROCESS_INCLUDES ZSTD_INCLUDE_DIR)
+set(ZSTD_PROCESS_LIBS ZSTD_LIBRARY)
+libfind_process(ZSTD)
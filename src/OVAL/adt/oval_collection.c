@@ -49,6 +49,7 @@ typedef struct _oval_collection_item_frame {
 
 typedef struct oval_collection {
 	struct _oval_collection_item_frame *item_collection_frame;
+	struct oscap_arena *arena;	///< Owner of the collection and frames, NULL if they are malloc'd
 } oval_collection_t;
 
 typedef struct oval_iterator {
@@ -66,6 +67,21 @@ struct oval_collection *oval_collection_new()
 		return NULL;
 
 	collection->item_collection_frame = NULL;
+	collection->arena = NULL;
+	return collection;
+}
+
+struct oval_collection *oval_collection_new_arena(struct oscap_arena *arena)
+{
+	if (arena == NULL)
+		return oval_collection_new();
+
+	struct oval_collection *collection = oscap_arena_alloc(arena, sizeof(oval_collection_t));
+	if (collection == NULL)
+		return NULL;
+
+	collection->item_collection_frame = NULL;
+	collection->arena = arena;
 	return collection;
 }
 
@@ -77,6 +93,9 @@ void oval_collection_free(struct oval_collection *collection)
 void oval_collection_free_items(struct oval_collection *collection, oscap_destruct_func free_func)
 {
 	if (collection) {
+		/* Frames in an arena are released together with the arena */
+		if (collection->arena != NULL && free_func == NULL)
+			return;
 		struct _oval_collection_item_frame *frame = collection->item_collection_frame;
 		while (frame != NULL) {
 			if (free_func != NULL) {
@@ -87,10 +106,13 @@ void oval_collection_free_items(struct oval_collection *collection, oscap_destru
 			}
 			struct _oval_collection_item_frame *temp = frame;
 			frame = frame->next;
-			temp->next = NULL;
-			free(temp);
+			if (collection->arena == NULL) {
+				temp->next = NULL;
+				free(temp);
+			}
 		}
-		free(collection);
+		if (collection->arena == NULL)
+			free(collection);
 	}
 }
 
@@ -104,7 +126,9 @@ void oval_collection_add(struct oval_collection *collection, void *item)
 {
 	__attribute__nonnull__(collection);
 
-	struct _oval_collection_item_frame *next = malloc(sizeof(_oval_collection_item_frame_t));
+	struct _oval_collection_item_frame *next = collection->arena != NULL ?
+		oscap_arena_alloc(collection->arena, sizeof(_oval_collection_item_frame_t)) :
+		malloc(sizeof(_oval_collection_item_frame_t));
 	if (next == NULL)
 		return;
 
@@ -30,12 +30,15 @@
 #ifndef OVALCOLLECTION_H_
 #define OVALCOLLECTION_H_
 #include "../common/util.h"
+#include "../common/oscap_arena.h"
 
 
 //struct oval_collection;
 //struct oval_iterator;
 
 struct oval_collection *oval_collection_new(void);
+/* The collection and its frames live in the arena, only the items are freed */
+struct oval_collection *oval_collection_new_arena(struct oscap_arena *arena);
 void oval_collection_free(struct oval_collection *);
 void oval_collection_free_items(struct oval_collection *, oscap_destruct_func);
 int oval_collection_is_empty(struct oval_collection *collection);
@@ -63,6 +63,7 @@ struct oval_agent_session {
 	struct oval_results_model    * res_model;
 	oval_probe_session_t  * psess;
 #endif
+	bool parallel_eval;
 };
 
 
@@ -135,6 +136,7 @@ oval_agent_session_t * oval_agent_new_session(struct oval_definition_model *mode
 #endif
 
 	ag_sess->product_name = NULL;
+	ag_sess->parallel_eval = false;
 
 	return ag_sess;
 }
@@ -144,6 +146,11 @@ struct oval_definition_model* oval_agent_get_definition_model(oval_agent_session
 	return ag_sess->def_model;
 }
 
+void oval_agent_set_parallel_eval(oval_agent_session_t *ag_sess, bool parallel)
+{
+	ag_sess->parallel_eval = parallel;
+}
+
 void oval_agent_set_product_name(oval_agent_session_t *ag_sess, char * product_name)
 {
 	struct oval_generator *generator;
@@ -270,6 +277,43 @@ int oval_agent_abort_session(oval_agent_session_t *ag_sess)
 #endif
 }
 
+#if defined(OVAL_PROBES_ENABLED)
+/*
+ * Collect objects of all the definitions and evaluate their tests in parallel,
+ * oval_agent_eval_system() then reuses the results of the tests.
+ */
+static void _oval_agent_eval_tests(oval_agent_session_t *ag_sess)
+{
+	struct oval_result_system *rsystem = _oval_agent_get_first_result_system(ag_sess);
+	struct oval_result_definition **rdefs = NULL;
+	size_t rdefs_count = 0, rdefs_alloc = 0;
+	/* A definition which can't be prepared is reported by the evaluation later */
+	struct err_queue *errors = oscap_err_detach();
+	struct oval_definition_iterator *oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
+	while (oval_definition_iterator_has_more(oval_def_it)) {
+		struct oval_definition *oval_def = oval_definition_iterator_next(oval_def_it);
+		struct oval_result_definition *rdef = oval_result_system_prepare_definition(rsystem, oval_definition_get_id(oval_def));
+		if (rdef == NULL)
+			continue;
+		if (rdefs_count == rdefs_alloc) {
+			size_t new_alloc = rdefs_alloc ? rdefs_alloc * 2 : 64;
+			struct oval_result_definition **new_rdefs = realloc(rdefs, new_alloc * sizeof(struct oval_result_definition *));
+			/* The remaining definitions are evaluated one by one */
+			if (new_rdefs == NULL)
+				break;
+			rdefs = new_rdefs;
+			rdefs_alloc = new_alloc;
+		}
+		rdefs[rdefs_count++] = rdef;
+	}
+	oval_definition_iterator_free(oval_def_it);
+	oscap_clearerr();
+	oscap_err_attach(errors);
+	oval_result_system_eval_tests(rsystem, rdefs, rdefs_count);
+	free(rdefs);
+}
+#endif
+
 int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, void *arg) {
 	struct oval_definition *oval_def;
 	struct oval_definition_iterator *oval_def_it;
@@ -277,6 +321,11 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 	int ret = 0;
 
 	dI("OVAL agent started to evaluate OVAL definitions on your system.");
+#if defined(OVAL_PROBES_ENABLED)
+	if (ag_sess->parallel_eval)
+		_oval_agent_eval_tests(ag_sess);
+#endif
+
 	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
 	while (oval_definition_iterator_has_more(oval_def_it)) {
 		oval_def = oval_definition_iterator_next(oval_def_it);
@@ -425,7 +474,7 @@ static void _oval_agent_resolve_variables_conflict(struct oval_agent_session *se
 	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(dict);
 	struct oval_definition_model *def_model =
 			oval_results_model_get_definition_model(oval_agent_get_results_model(session));
-	while (!conflict && oscap_htable_iterator_has_more(hit)) {
+	while (oscap_htable_iterator_has_more(hit)) {
 		oscap_htable_iterator_next_kv(hit, &var_name, (void*) &value_list);
 		struct oval_variable *variable = oval_definition_model_get_variable(def_model, var_name);
 		if (variable != NULL) {
@@ -441,6 +490,17 @@ static void _oval_agent_resolve_variables_conflict(struct oval_agent_session *se
 				// As per OVAL 5.10.1, the Variable Schema does not allow multisets. Therefore,
 				// we will later create new variable model and export multiple variables docs.
 				conflict = true;
+				// Local variables reading the variable are computed again, the
+				// other ones keep their values. Likewise, only the objects reading
+				// the variable are collected again for the new variable instance.
+				struct oval_variable_iterator *local_it =
+					oval_definition_model_get_variables_dependent_on_variable(def_model, variable);
+				while (oval_variable_iterator_has_more(local_it))
+					oval_variable_clear_values(oval_variable_iterator_next(local_it));
+				oval_variable_iterator_free(local_it);
+#if defined(OVAL_PROBES_ENABLED)
+				oval_probe_hint_variable(session->psess, def_model, variable);
+#endif
 				// Next, in the results model, there might be already some definitions, tests
 				// states, or objects. These might be dependent on the previous value of the
 				// given variable.
@@ -474,10 +534,6 @@ static void _oval_agent_resolve_variables_conflict(struct oval_agent_session *se
 						// to the oval_variable files.
 						int instance = oval_result_definition_get_instance(r_definition);
 						oval_result_definition_set_variable_instance_hint(r_definition, instance + 1);
-						struct oval_definition *definition = oval_result_definition_get_definition(r_definition);
-#if defined(OVAL_PROBES_ENABLED)
-						oval_probe_hint_definition(session->psess, definition, instance + 1);
-#endif
 					}
 					else {
 						// TODO: We really need oval_agent_session wide variable_instance attribute
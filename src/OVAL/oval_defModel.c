@@ -60,6 +60,8 @@ typedef struct oval_definition_model {
 	struct oval_collection *bound_variable_models;
         char *schema;
 	struct oval_string_map *vardef_map;		///< look-up table for efficient @variable_instance processing
+	struct oval_string_map *vardep_map;		///< variable id -> local variables reading the variable
+	struct oval_string_map *varobj_map;		///< variable id -> objects reading the variable
 } oval_definition_model_t;
 
 /* failed   - NULL
@@ -80,6 +82,8 @@ struct oval_definition_model *oval_definition_model_new()
 	newmodel->bound_variable_models = NULL;
 	newmodel->schema = oscap_strdup(OVAL_DEF_SCHEMA_LOCATION);
 	newmodel->vardef_map = NULL;
+	newmodel->vardep_map = NULL;
+	newmodel->varobj_map = NULL;
 
 	return newmodel;
 }
@@ -120,6 +124,8 @@ struct oval_definition_model *oval_definition_model_clone(struct oval_definition
 	    (oldmodel->variable_map, newmodel, (_oval_clone_func) oval_variable_clone);
         newmodel->schema = oscap_strdup(oldmodel->schema);
 	newmodel->vardef_map = NULL;
+	newmodel->vardep_map = NULL;
+	newmodel->varobj_map = NULL;
 	return newmodel;
 }
 
@@ -133,6 +139,10 @@ void oval_definition_model_free(struct oval_definition_model *model)
 		oval_string_map_free(model->variable_map, (oscap_destruct_func) oval_variable_free);
 		if (model->vardef_map != NULL)
 			oval_string_map_free(model->vardef_map, (oscap_destruct_func) oval_string_map_free0);
+		if (model->vardep_map != NULL)
+			oval_string_map_free(model->vardep_map, (oscap_destruct_func) oval_string_map_free0);
+		if (model->varobj_map != NULL)
+			oval_string_map_free(model->varobj_map, (oscap_destruct_func) oval_string_map_free0);
 		if (model->bound_variable_models)
 			oval_collection_free_items(model->bound_variable_models,
 					   (oscap_destruct_func) oval_variable_model_free);
@@ -365,6 +375,31 @@ struct oval_string_iterator *oval_definition_model_get_definitions_dependent_on_
 		oval_string_map_keys(def_list) : oval_collection_iterator_new());
 }
 
+static struct oval_iterator *_oval_definition_model_get_vardep(struct oval_definition_model *model, struct oval_string_map **map, struct oval_variable *variable)
+{
+	if (model->vardep_map == NULL)
+		oval_definition_model_build_vardep_mapping(model, &model->vardep_map, &model->varobj_map);
+
+	struct oval_string_map *dependents = (struct oval_string_map *) oval_string_map_get_value(*map, oval_variable_get_id(variable));
+	return dependents != NULL ? oval_string_map_values(dependents) : oval_collection_iterator_new();
+}
+
+struct oval_variable_iterator *oval_definition_model_get_variables_dependent_on_variable(struct oval_definition_model *model, struct oval_variable *variable)
+{
+	__attribute__nonnull__(model);
+	__attribute__nonnull__(variable);
+
+	return (struct oval_variable_iterator *) _oval_definition_model_get_vardep(model, &model->vardep_map, variable);
+}
+
+struct oval_object_iterator *oval_definition_model_get_objects_dependent_on_variable(struct oval_definition_model *model, struct oval_variable *variable)
+{
+	__attribute__nonnull__(model);
+	__attribute__nonnull__(variable);
+
+	return (struct oval_object_iterator *) _oval_definition_model_get_vardep(model, &model->varobj_map, variable);
+}
+
 struct oval_test_iterator *oval_definition_model_get_tests(struct oval_definition_model *model)
 {
 	__attribute__nonnull__(model);
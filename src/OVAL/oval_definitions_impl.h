@@ -182,6 +182,18 @@ oval_schema_version_t oval_definition_model_get_platform_schema_version(struct o
 
 struct oval_string_map *oval_definition_model_build_vardef_mapping(struct oval_definition_model *model);
 struct oval_string_iterator *oval_definition_model_get_definitions_dependent_on_variable(struct oval_definition_model *model, struct oval_variable *variable);
+void oval_definition_model_build_vardep_mapping(struct oval_definition_model *model, struct oval_string_map **vardep, struct oval_string_map **varobj);
+/**
+ * Get local variables which read the given variable, directly or through other
+ * local variables and objects. Values of these have to be computed again when
+ * the given variable is bound to different values.
+ */
+struct oval_variable_iterator *oval_definition_model_get_variables_dependent_on_variable(struct oval_definition_model *model, struct oval_variable *variable);
+/**
+ * Get objects which read the given variable, directly or through local variables.
+ * These have to be collected again when the given variable is bound to different values.
+ */
+struct oval_object_iterator *oval_definition_model_get_objects_dependent_on_variable(struct oval_definition_model *model, struct oval_variable *variable);
 
 /* variable model */
 struct oval_collection *oval_variable_model_get_values_ref(struct oval_variable_model *, char *);
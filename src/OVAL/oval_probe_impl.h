@@ -61,7 +61,7 @@ typedef struct {
 void oval_probe_tblinit(void);
 const char *oval_subtype_to_str(oval_subtype_t subtype);
 
-int oval_probe_hint_definition(oval_probe_session_t *sess, struct oval_definition *definition, int variable_instance_hint);
+int oval_probe_hint_variable(oval_probe_session_t *sess, struct oval_definition_model *model, struct oval_variable *variable);
 
 #endif /* OVAL_PROBE_IMPL_H */
 /// @}
@@ -81,6 +81,7 @@ struct oval_session {
 
 	bool validation;
 	bool export_sys_chars;
+	bool parallel_eval;
 	bool full_validation;
 	bool fetch_remote_resources;
 	download_progress_calllback_t progress;
@@ -332,6 +333,7 @@ static int oval_session_setup_agent(struct oval_session *session)
 	free(path_clone);
 
 	oval_agent_set_product_name(session->sess, (char *)oscap_productname);
+	oval_agent_set_parallel_eval(session->sess, session->parallel_eval);
 	return 0;
 }
 
@@ -451,6 +453,11 @@ void oval_session_set_export_system_characteristics(struct oval_session *session
 	session->export_sys_chars = export;
 }
 
+void oval_session_set_parallel_eval(struct oval_session *session, bool parallel)
+{
+	session->parallel_eval = parallel;
+}
+
 void oval_session_set_remote_resources(struct oval_session *session, bool allowed, download_progress_calllback_t callback)
 {
 	session->fetch_remote_resources = allowed;
@@ -50,6 +50,7 @@
 #include "adt/oval_string_map_impl.h"
 #include "common/debug_priv.h"
 #include "common/_error.h"
+#include "common/list.h"
 #include "public/oval_schema_version.h"
 
 
@@ -651,7 +652,7 @@ static SEXP_t *oval_record_field_STATE_to_sexp(struct oval_record_field *rf)
 	return rf_sexp;
 }
 
-static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model, struct oval_sysitem *item, SEXP_t * sexp, struct oval_string_map *mask_map);
+static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model, struct oval_sysitem *item, const SEXP_t *sexp, struct oval_string_map *mask_map);
 
 static struct oval_record_field *oval_record_field_ITEM_from_sexp(SEXP_t *sexp)
 {
@@ -813,14 +814,26 @@ static struct oval_message *oval_sexp_to_msg(const SEXP_t *msg)
 	return message;
 }
 
-static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model, struct oval_sysitem *item, SEXP_t * sexp, struct oval_string_map *mask_map)
+/* Read the name of the entity into the buffer, longer names are allocated */
+static char *oval_sexp_getname(const SEXP_t *sexp, char *buffer, size_t buflen)
 {
-	char *key;
+	size_t len = probe_ent_getname_r(sexp, buffer, buflen);
+
+	if (len == 0)
+		return NULL;
+	if (len == (size_t) -1)
+		return probe_ent_getname(sexp);
+	return buffer;
+}
+
+static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model, struct oval_sysitem *item, const SEXP_t *sexp, struct oval_string_map *mask_map)
+{
+	char key_buf[128], *key;
 	oval_syschar_status_t status;
 	oval_datatype_t dt;
 	struct oval_sysent *ent;
 
-	key = probe_ent_getname(sexp);
+	key = oval_sexp_getname(sexp, key_buf, sizeof key_buf);
 	if (!key)
 		return NULL;
 
@@ -847,7 +860,8 @@ static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model,
 	    oval_message_set_text(msg, txt);
 	    oval_sysitem_add_message(item, msg);
 
-	    free(key);
+	    if (key != key_buf)
+		    free(key);
 
 	    return (NULL);
 	}
@@ -856,7 +870,10 @@ static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model,
 	dt = probe_ent_getdatatype(sexp);
 
 	ent = oval_sysent_new(model);
-	oval_sysent_set_name(ent, key);
+	oval_sysent_copy_name(ent, key);
+	if (key != key_buf)
+		free(key);
+	key = oval_sysent_get_name(ent);
 	oval_sysent_set_status(ent, status);
 	oval_sysent_set_datatype(ent, dt);
 	if (mask_map == NULL || oval_string_map_get_value(mask_map, key) == NULL)
@@ -882,6 +899,7 @@ static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model,
 		char val[64], *valp = val;
 		SEXP_t *sval;
 		SEXP_numtype_t sndt;
+		size_t len;
 
 		sval = probe_ent_getval(sexp);
 		if (sval == NULL)
@@ -921,7 +939,18 @@ static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model,
 		case OVAL_DATATYPE_IPV6ADDR:
 		case OVAL_DATATYPE_STRING:
 		case OVAL_DATATYPE_VERSION:
-			valp = SEXP_string_cstr(sval);
+			len = SEXP_string_length(sval);
+			if (len == (size_t) -1) {
+				/* Not a string */
+				valp = NULL;
+			} else if (len >= sizeof(val)) {
+				/* Long values are copied straight into the model */
+				valp = oval_sysent_alloc_value(ent, len);
+				if (valp != NULL && SEXP_string_cstr_r(sval, valp, len + 1) == (size_t) -1)
+					valp = NULL;
+			} else if (SEXP_string_cstr_r(sval, val, sizeof(val)) == (size_t) -1) {
+				valp = NULL;
+			}
 			break;
 		default:
 			dE("Unexpected OVAL datatype: %d, '%s', name: '%s'.",
@@ -930,38 +959,43 @@ static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model,
 			break;
 		}
 
-		oval_sysent_set_value(ent, valp);
-		if (valp != val)
-			free(valp);
+		if (valp == val || valp == NULL)
+			oval_sysent_set_value(ent, valp);
                 SEXP_free(sval);
 	}
 
 	return ent;
 }
 
-static struct oval_sysitem *oval_sexp_to_sysitem(struct oval_syschar_model *model, SEXP_t * sexp, struct oval_string_map *mask_map)
+static struct oval_sysitem *oval_sexp_to_sysitem(struct oval_syschar_model *model, const SEXP_t *sexp, struct oval_string_map *mask_map)
 {
 	_A(sexp);
 
+	char id_buf[64], name_buf[128];
 	char *item_name, *name, *id, *family;
 	SEXP_t *id_sexp;
 	struct oval_sysitem *sysitem = NULL;
 
 	id_sexp = probe_ent_getattrval(sexp, "id");
-	id = SEXP_string_cstr(id_sexp);
+	if (id_sexp != NULL && SEXP_string_cstr_r(id_sexp, id_buf, sizeof id_buf) != (size_t) -1)
+		id = id_buf;
+	else
+		id = SEXP_string_cstr(id_sexp);
 	SEXP_free(id_sexp);
 
 	sysitem = oval_syschar_model_get_sysitem(model, id);
 
 	if (sysitem) {
-                free(id);
+		if (id != id_buf)
+			free(id);
 		return sysitem;
         }
 
-	item_name = probe_ent_getname(sexp);
+	item_name = oval_sexp_getname(sexp, name_buf, sizeof name_buf);
 
 	if (item_name == NULL) {
-                free(id);
+		if (id != id_buf)
+			free(id);
 		return NULL;
         } else {
 		family = item_name;
@@ -984,7 +1018,7 @@ static struct oval_sysitem *oval_sexp_to_sysitem(struct oval_syschar_model *mode
 	if (type == OVAL_SUBTYPE_UNKNOWN)
 		abort();
 #endif
-	SEXP_t *sub;
+	const SEXP_t *sub;
 	struct oval_sysent *sysent;
 
 	int status = probe_ent_getstatus(sexp);
@@ -993,24 +1027,32 @@ static struct oval_sysitem *oval_sexp_to_sysitem(struct oval_syschar_model *mode
 	oval_sysitem_set_status(sysitem, status);
 	oval_sysitem_set_subtype(sysitem, type);
 
-	for (int i = 2; (sub = SEXP_list_nth(sexp, i)) != NULL; ++i) {
-	    if ((sysent = oval_sexp_to_sysent(model, sysitem, sub, mask_map)) != NULL)
-		    oval_sysitem_add_sysent(sysitem, sysent);
-		SEXP_free(sub);
+	/* The entities follow the name and attributes of the item, the
+	 * iterator borrows them from the list without taking references */
+	SEXP_list_it *sub_it = SEXP_list_it_new(sexp);
+	SEXP_list_it_next(sub_it);
+	while ((sub = SEXP_list_it_next(sub_it)) != NULL) {
+		if ((sysent = oval_sexp_to_sysent(model, sysitem, sub, mask_map)) != NULL)
+			oval_sysitem_add_sysent(sysitem, sysent);
 	}
+	SEXP_list_it_free(sub_it);
 
  cleanup:
-        free(id);
-	free(item_name);
+	if (id != id_buf)
+		free(id);
+	if (item_name != name_buf)
+		free(item_name);
 	return sysitem;
 }
 
 int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar)
 {
 	oval_syschar_collection_flag_t flag;
-	SEXP_t *messages, *msg, *items, *item, *mask;
+	SEXP_t *messages, *items, *mask;
+	const SEXP_t *msg, *item;
+	SEXP_list_it *it;
 	struct oval_syschar_model *model;
-	struct oval_string_map *itm_id_map;
+	struct oscap_htable *itm_ids;
         struct oval_string_map *item_mask_map;
 
 	_A(cobj != NULL);
@@ -1019,18 +1061,23 @@ int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar)
 	oval_syschar_set_flag(syschar, flag);
 
 	messages = probe_cobj_get_msgs(cobj);
-	SEXP_list_foreach(msg, messages) {
+	it = SEXP_list_it_new(messages);
+	while (it != NULL && (msg = SEXP_list_it_next(it)) != NULL) {
 		struct oval_message *omsg;
 
 		omsg = oval_sexp_to_msg(msg);
 		if (omsg != NULL)
 			oval_syschar_add_message(syschar, omsg);
 	}
+	SEXP_list_it_free(it);
 	SEXP_free(messages);
 
-	itm_id_map = oval_string_map_new();
+	/* Ids of the items are owned by the model */
+	itm_ids = oscap_htable_new2(0, OSCAP_HTABLE_BORROW_KEYS);
 	model = oval_syschar_get_model(syschar);
 	items = probe_cobj_get_items(cobj);
+	if (items != NULL)
+		oval_syschar_model_reserve_items(model, SEXP_list_length(items));
 
         mask = probe_cobj_get_mask(cobj);
         if (mask != NULL) {
@@ -1045,22 +1092,21 @@ int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar)
         } else
             item_mask_map = NULL;
 
-	SEXP_list_foreach(item, items) {
+	/* Walk the items linearly, indexing the chained list blocks
+	 * one by one would be quadratic for big replies */
+	it = SEXP_list_it_new(items);
+	while (it != NULL && (item = SEXP_list_it_next(it)) != NULL) {
 		struct oval_sysitem *sysitem;
 
 		sysitem = oval_sexp_to_sysitem(model, item, item_mask_map);
 		if (sysitem != NULL) {
-			char *itm_id;
-
-			itm_id = oval_sysitem_get_id(sysitem);
-			if (oval_string_map_get_value(itm_id_map, itm_id) == NULL) {
-				oval_string_map_put(itm_id_map, itm_id, itm_id);
+			if (oscap_htable_add(itm_ids, oval_sysitem_get_id(sysitem), sysitem))
 				oval_syschar_add_sysitem(syschar, sysitem);
-			}
 		}
 	}
+	SEXP_list_it_free(it);
 	SEXP_free(items);
-	oval_string_map_free(itm_id_map, NULL);
+	oscap_htable_free0(itm_ids);
         if (item_mask_map != NULL)
             oval_string_map_free_string(item_mask_map);
 
@@ -44,6 +44,10 @@
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
+#include "common/oscap_arena.h"
+
+/* Longer values are mostly unique (paths, file contents), they are copied to the arena */
+#define OVAL_SYSENT_INTERN_MAX 32
 
 typedef struct oval_sysent {
 	struct oval_syschar_model *model;
@@ -53,11 +57,13 @@ typedef struct oval_sysent {
 	int mask;
 	oval_datatype_t datatype;
 	oval_syschar_status_t status;
-} oval_sysent_t;
+} oval_sysent_t;	///< Entities of a model and their strings are owned by the model
 
 struct oval_sysent *oval_sysent_new(struct oval_syschar_model *model)
 {
-	oval_sysent_t *sysent = (oval_sysent_t *) malloc(sizeof(oval_sysent_t));
+	oval_sysent_t *sysent = (oval_sysent_t *) (model != NULL ?
+		oscap_arena_alloc(oval_syschar_model_get_arena(model), sizeof(oval_sysent_t)) :
+		malloc(sizeof(oval_sysent_t)));
 	if (sysent == NULL)
 		return NULL;
 
@@ -97,13 +103,13 @@ void oval_sysent_free(struct oval_sysent *sysent)
 	if (sysent == NULL)
 		return;
 
-	if (sysent->name != NULL)
-		free(sysent->name);
-	if (sysent->value != NULL)
-		free(sysent->value);
 	if (sysent->record_fields)
 		oval_collection_free_items(sysent->record_fields, (oscap_destruct_func) oval_record_field_free);
+	if (sysent->model != NULL)
+		return;
 
+	free(sysent->name);
+	free(sysent->value);
 	sysent->name = NULL;
 	sysent->value = NULL;
 
@@ -171,12 +177,32 @@ int oval_sysent_get_mask(struct oval_sysent *sysent)
 	return sysent->mask;
 }
 
+bool oval_sysent_name_is_interned(const struct oval_sysent *sysent, const struct oval_syschar_model *model)
+{
+	return sysent->model != NULL && sysent->model == model;
+}
+
 void oval_sysent_set_name(struct oval_sysent *sysent, char *name)
 {
 	__attribute__nonnull__(sysent);
-	if (sysent->name != NULL)
+	if (sysent->model != NULL) {
+		sysent->name = (char *) oval_syschar_model_intern(sysent->model, name);
+		free(name);
+	} else {
+		free(sysent->name);
+		sysent->name = name;
+	}
+}
+
+void oval_sysent_copy_name(struct oval_sysent *sysent, const char *name)
+{
+	__attribute__nonnull__(sysent);
+	if (sysent->model != NULL) {
+		sysent->name = (char *) oval_syschar_model_intern(sysent->model, name);
+	} else {
 		free(sysent->name);
-	sysent->name = name;
+		sysent->name = oscap_strdup(name);
+	}
 }
 
 void oval_sysent_set_status(struct oval_sysent *sysent, oval_syschar_status_t status)
@@ -200,15 +226,34 @@ void oval_sysent_set_mask(struct oval_sysent *sysent, int mask)
 void oval_sysent_set_value(struct oval_sysent *sysent, char *value)
 {
 	__attribute__nonnull__(sysent);
-	if (sysent->value != NULL)
+	if (sysent->model == NULL) {
 		free(sysent->value);
-	sysent->value = oscap_strdup(value);
+		sysent->value = oscap_strdup(value);
+	} else if (value != NULL && strnlen(value, OVAL_SYSENT_INTERN_MAX + 1) <= OVAL_SYSENT_INTERN_MAX) {
+		sysent->value = (char *) oval_syschar_model_intern(sysent->model, value);
+	} else {
+		sysent->value = oscap_arena_strdup(oval_syschar_model_get_arena(sysent->model), value);
+	}
+}
+
+char *oval_sysent_alloc_value(struct oval_sysent *sysent, size_t len)
+{
+	__attribute__nonnull__(sysent);
+	if (sysent->model != NULL) {
+		sysent->value = oscap_arena_alloc(oval_syschar_model_get_arena(sysent->model), len + 1);
+	} else {
+		free(sysent->value);
+		sysent->value = malloc(len + 1);
+	}
+	return sysent->value;
 }
 
 void oval_sysent_add_record_field(struct oval_sysent *sysent, struct oval_record_field *rf)
 {
 	if (sysent->record_fields == NULL)
-		sysent->record_fields = oval_collection_new();
+		sysent->record_fields = sysent->model != NULL ?
+			oval_collection_new_arena(oval_syschar_model_get_arena(sysent->model)) :
+			oval_collection_new();
 	oval_collection_add(sysent->record_fields, rf);
 }
 
@@ -41,6 +41,7 @@
 #include "oval_definitions_impl.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
+#include "common/oscap_arena.h"
 
 typedef struct oval_sysitem {
 	//oval_family_enum family;
@@ -57,15 +58,16 @@ struct oval_sysitem *oval_sysitem_new(struct oval_syschar_model *model, const ch
 	__attribute__nonnull__(model);
 	oval_sysitem_t *sysitem;
 
-	sysitem = (oval_sysitem_t *) malloc(sizeof(oval_sysitem_t));
+	struct oscap_arena *arena = oval_syschar_model_get_arena(model);
+	sysitem = (oval_sysitem_t *) oscap_arena_alloc(arena, sizeof(oval_sysitem_t));
 	if (sysitem == NULL)
 		return NULL;
 
-	sysitem->id = oscap_strdup(id);
+	sysitem->id = oscap_arena_strdup(arena, id);
 	sysitem->subtype = OVAL_SUBTYPE_UNKNOWN;
 	sysitem->status = SYSCHAR_STATUS_UNKNOWN;
-	sysitem->messages = oval_collection_new();
-	sysitem->sysents = oval_collection_new();
+	sysitem->messages = oval_collection_new_arena(arena);
+	sysitem->sysents = oval_collection_new_arena(arena);
 	sysitem->model = model;
 
 	oval_syschar_model_add_sysitem(model, sysitem);
@@ -104,14 +106,12 @@ void oval_sysitem_free(struct oval_sysitem *sysitem)
 	if (sysitem == NULL)
 		return;
 
+	/* The item itself lives in the arena of its model */
 	oval_collection_free_items(sysitem->messages, (oscap_destruct_func) oval_message_free);
 	oval_collection_free_items(sysitem->sysents, (oscap_destruct_func) oval_sysent_free);
-	free(sysitem->id);
 
-	sysitem->id = NULL;
 	sysitem->sysents = NULL;
 	sysitem->messages = NULL;
-	free(sysitem);
 }
 
 bool oval_sysitem_iterator_has_more(struct oval_sysitem_iterator *oc_sysitem)
@@ -46,6 +46,8 @@
 # include "oval_probe_impl.h"
 #endif
 #include "common/util.h"
+#include "common/list.h"
+#include "common/oscap_arena.h"
 #include "common/debug_priv.h"
 #include "common/_error.h"
 #include "common/elements.h"
@@ -59,9 +61,14 @@ typedef struct oval_syschar_model {
 	struct oval_definition_model *definition_model;
 	struct oval_smc *syschar_map;				///< Represents objects within <collected_objects> element
 	struct oval_string_map *sysitem_map;			///< Represents items within <system_data> element
+	struct oscap_htable *strings;				///< Interned entity names and values
+	struct oscap_arena *arena;				///< Memory of objects, items and entities
         char *schema;
 } oval_syschar_model_t;						///< Represents <oval_system_characteristics> element
 
+/* Rough size of an item with a few entities, used to pre-size the arena */
+#define OVAL_SYSITEM_SIZE_ESTIMATE 512
+
 
 /* failed   - NULL
  * success  - oval_syschar_model
@@ -80,10 +87,13 @@ struct oval_syschar_model *oval_syschar_model_new(struct oval_definition_model *
 	newmodel->definition_model = definition_model;
 	newmodel->syschar_map = oval_smc_new();
 	newmodel->sysitem_map = oval_string_map_new();
+	newmodel->strings = oscap_htable_new2(0, OSCAP_HTABLE_POOL_KEYS);
+	newmodel->arena = oscap_arena_new(0);
         newmodel->schema = oscap_strdup(OVAL_SYS_SCHEMA_LOCATION);
 
 	/* check possible allocation problems */
-	if ((newmodel->syschar_map == NULL) || (newmodel->sysitem_map == NULL) ) {
+	if ((newmodel->syschar_map == NULL) || (newmodel->sysitem_map == NULL) || (newmodel->strings == NULL)
+			|| (newmodel->arena == NULL)) {
 		oval_syschar_model_free(newmodel);
 		return NULL;
 	}
@@ -143,6 +153,11 @@ void oval_syschar_model_free(struct oval_syschar_model *model)
 		oval_smc_free(model->syschar_map, (oscap_destruct_func) oval_syschar_free);
 		if (model->sysitem_map)
 			oval_string_map_free(model->sysitem_map, (oscap_destruct_func) oval_sysitem_free);
+		/* Entities of the items refer to the interned strings */
+		if (model->strings)
+			oscap_htable_free0(model->strings);
+		/* Objects, items and entities are released at once */
+		oscap_arena_free(model->arena);
 		free(model->schema);
 		oval_generator_free(model->generator);
 		free(model);
@@ -155,8 +170,31 @@ void oval_syschar_model_reset(struct oval_syschar_model *model)
                 oval_smc_free(model->syschar_map, (oscap_destruct_func) oval_syschar_free);
         if (model->sysitem_map)
                 oval_string_map_free(model->sysitem_map, (oscap_destruct_func) oval_sysitem_free);
+        oscap_arena_free(model->arena);
         model->syschar_map = oval_smc_new();
         model->sysitem_map = oval_string_map_new();
+        model->arena = oscap_arena_new(0);
+}
+
+const char *oval_syschar_model_intern(struct oval_syschar_model *model, const char *str)
+{
+	__attribute__nonnull__(model);
+
+	return oscap_htable_intern(model->strings, str);
+}
+
+struct oscap_arena *oval_syschar_model_get_arena(struct oval_syschar_model *model)
+{
+	__attribute__nonnull__(model);
+
+	return model->arena;
+}
+
+void oval_syschar_model_reserve_items(struct oval_syschar_model *model, size_t count)
+{
+	__attribute__nonnull__(model);
+
+	oscap_arena_reserve(model->arena, count * OVAL_SYSITEM_SIZE_ESTIMATE);
 }
 
 struct oval_generator *oval_syschar_model_get_generator(struct oval_syschar_model *model)
@@ -305,6 +343,12 @@ struct oval_sysitem *oval_syschar_model_get_new_sysitem(struct oval_syschar_mode
 	return sysitem;
 }
 
+static void _oval_sysitem_array_to_dom(size_t index, xmlDocPtr doc, xmlNode *parent, void *arg)
+{
+	struct oval_sysitem **sysitems = arg;
+	oval_sysitem_to_dom(sysitems[index], doc, parent);
+}
+
 xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xmlDocPtr doc, xmlNode * parent, 
 			           oval_syschar_resolver resolver, void *user_arg, bool export_syschar)
 {
@@ -382,10 +426,23 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	struct oval_iterator *sysitems = oval_string_map_values(sysitem_map);
 	if (oval_collection_iterator_has_more(sysitems)) {
 		xmlNode *tag_items = xmlNewTextChild(root_node, ns_syschar, BAD_CAST "system_data", NULL);
-		while (oval_collection_iterator_has_more(sysitems)) {
-			struct oval_sysitem *sysitem = (struct oval_sysitem *)
-			    oval_collection_iterator_next(sysitems);
-			oval_sysitem_to_dom(sysitem, doc, tag_items);
+		/* Fields of record entities need the namespace, the threads must
+		 * not add it to the root element */
+		if (xmlSearchNsByHref(doc, tag_items, OVAL_SYSCHAR_NAMESPACE) == NULL)
+			xmlNewNs(xmlDocGetRootElement(doc), OVAL_SYSCHAR_NAMESPACE, NULL);
+		size_t sysitems_count = 0;
+		struct oval_sysitem **sysitems_array = malloc(oval_collection_iterator_remaining(sysitems) * sizeof(struct oval_sysitem *));
+		if (sysitems_array == NULL) {
+			while (oval_collection_iterator_has_more(sysitems))
+				oval_sysitem_to_dom((struct oval_sysitem *) oval_collection_iterator_next(sysitems), doc, tag_items);
+		} else {
+			while (oval_collection_iterator_has_more(sysitems)) {
+				sysitems_array[sysitems_count++] = (struct oval_sysitem *)
+				    oval_collection_iterator_next(sysitems);
+			}
+			/* Items are serialized concurrently and appended in the map order */
+			oscap_xml_build_children_parallel(doc, tag_items, sysitems_count, _oval_sysitem_array_to_dom, sysitems_array);
+			free(sysitems_array);
 		}
 	}
 	oval_collection_iterator_free(sysitems);
@@ -43,6 +43,7 @@
 
 #include "common/util.h"
 #include "common/debug_priv.h"
+#include "common/oscap_arena.h"
 
 typedef struct oval_syschar {
 	struct oval_syschar_model *model;
@@ -145,7 +146,8 @@ struct oval_syschar *oval_syschar_new(struct oval_syschar_model *model, struct o
 	__attribute__nonnull__(model);
 	oval_syschar_t *syschar;
 
-	syschar = (oval_syschar_t *) malloc(sizeof(oval_syschar_t));
+	struct oscap_arena *arena = oval_syschar_model_get_arena(model);
+	syschar = (oval_syschar_t *) oscap_arena_alloc(arena, sizeof(oval_syschar_t));
 	if (syschar == NULL)
 		return NULL;
 
@@ -153,9 +155,9 @@ struct oval_syschar *oval_syschar_new(struct oval_syschar_model *model, struct o
 	syschar->variable_instance = 1;
 	syschar->variable_instance_hint = 1;
 	syschar->object = object;
-	syschar->messages = oval_collection_new();
-	syschar->sysitem = oval_collection_new();
-	syschar->variable_bindings = oval_collection_new();
+	syschar->messages = oval_collection_new_arena(arena);
+	syschar->sysitem = oval_collection_new_arena(arena);
+	syschar->variable_bindings = oval_collection_new_arena(arena);
 	syschar->model = model;
 
 	oval_syschar_model_add_syschar(model, syschar);
@@ -223,7 +225,7 @@ void oval_syschar_free(struct oval_syschar *syschar)
 	syschar->object = NULL;
 	syschar->sysitem = NULL;
 	syschar->variable_bindings = NULL;
-	free(syschar);
+	/* The object itself lives in the arena of its model */
 }
 
 static void add_oval_syschar_message(struct oval_syschar *syschar, struct oval_message *message) {
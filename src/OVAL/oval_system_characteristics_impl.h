@@ -35,6 +35,7 @@
 #include "oval_parser_impl.h"
 #include "adt/oval_smc_impl.h"
 #include "../common/util.h"
+#include "../common/oscap_arena.h"
 
 
 /* sysint */
@@ -62,6 +63,23 @@ typedef void (*oval_sysent_consumer) (struct oval_sysent *, void *client);
 int oval_sysent_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, oval_sysent_consumer, void *);
 void oval_sysent_to_dom(struct oval_sysent *sysent, xmlDoc * doc, xmlNode * tag_parent);
 void oval_sysent_to_print(struct oval_sysent *, char *, int);
+/*
+ * Check whether the name of the entity is interned in the string pool of the
+ * model, two names interned in one pool are equal only if they are the same pointer.
+ */
+bool oval_sysent_name_is_interned(const struct oval_sysent *sysent, const struct oval_syschar_model *model);
+
+/*
+ * Set a copy of the name, the copy is interned when the entity belongs to a model.
+ */
+void oval_sysent_copy_name(struct oval_sysent *sysent, const char *name);
+
+/*
+ * Replace the value by uninitialized memory for len characters and the
+ * terminating zero, owned by the model of the entity if there is one.
+ * Used to copy long values straight from the probe replies.
+ */
+char *oval_sysent_alloc_value(struct oval_sysent *sysent, size_t len);
 
 /* syschar_model */
 typedef bool oval_syschar_resolver(struct oval_syschar *, void *);
@@ -73,6 +91,24 @@ struct oval_sysitem *oval_syschar_model_get_new_sysitem(struct oval_syschar_mode
 void oval_syschar_model_add_syschar(struct oval_syschar_model *model, struct oval_syschar *syschar);
 void oval_syschar_model_add_sysitem(struct oval_syschar_model *model, struct oval_sysitem *sysitem);
 
+/*
+ * Intern a string in the string pool of the model. Entity names and short
+ * values of the items are interned, the pool is released with the model.
+ */
+const char *oval_syschar_model_intern(struct oval_syschar_model *model, const char *str);
+
+/*
+ * Get the arena of the model. Objects, items, entities and their
+ * collections are allocated from the arena and released with the model.
+ */
+struct oscap_arena *oval_syschar_model_get_arena(struct oval_syschar_model *model);
+
+/*
+ * Pre-size the arena of the model for the given number of new items,
+ * so that they are allocated from one block of memory.
+ */
+void oval_syschar_model_reserve_items(struct oval_syschar_model *model, size_t count);
+
 void oval_syschar_model_set_schema(struct oval_syschar_model *model, const char * schema);
 const char * oval_syschar_model_get_schema(struct oval_syschar_model * model);
 
@@ -34,6 +34,7 @@ static void _oval_setobject_fill_vardef(struct oval_setobject *set, struct oval_
 static void _oval_state_fill_vardef(struct oval_state *state, struct oval_string_map *vardef, const char *definition_id);
 static void _oval_entity_fill_vardef(struct oval_entity *entity, struct oval_string_map *vardef, const char *definition_id);
 static void _vardef_insert(struct oval_string_map *vardef, const char *definition_id, const char *variable_id);
+static void _vardef_fill_transitive(struct oval_definition_model *model, struct oval_string_map *vardef);
 
 struct oval_string_map *oval_definition_model_build_vardef_mapping(struct oval_definition_model *model)
 {
@@ -44,6 +45,7 @@ struct oval_string_map *oval_definition_model_build_vardef_mapping(struct oval_d
 		_oval_definition_fill_vardef(definition, vardef);
 	}
 	oval_definition_iterator_free(def_it);
+	_vardef_fill_transitive(model, vardef);
 	return vardef;
 }
 
@@ -116,6 +118,11 @@ void _oval_object_fill_vardef(struct oval_object *object, struct oval_string_map
 			struct oval_setobject *set = oval_object_content_get_setobject(content);
 			_oval_setobject_fill_vardef(set, vardef, definition_id);
 			} break;
+		case OVAL_OBJECTCONTENT_FILTER:{
+			struct oval_state *state = oval_filter_get_state(oval_object_content_get_filter(content));
+			if (state != NULL)
+				_oval_state_fill_vardef(state, vardef, definition_id);
+			} break;
 		default:
 			break;
 		}
@@ -163,6 +170,13 @@ void _oval_state_fill_vardef(struct oval_state *state, struct oval_string_map *v
 		struct oval_entity *entity = oval_state_content_get_entity(content);
 		if (entity != NULL)
 			_oval_entity_fill_vardef(entity, vardef, definition_id);
+		struct oval_record_field_iterator *rf_it = oval_state_content_get_record_fields(content);
+		while (oval_record_field_iterator_has_more(rf_it)) {
+			struct oval_variable *variable = oval_record_field_get_variable(oval_record_field_iterator_next(rf_it));
+			if (variable != NULL)
+				_vardef_insert(vardef, definition_id, oval_variable_get_id(variable));
+		}
+		oval_record_field_iterator_free(rf_it);
 	}
 	oval_state_content_iterator_free(content_it);
 }
@@ -186,3 +200,225 @@ void _vardef_insert(struct oval_string_map *vardef, const char *definition_id, c
 	}
 	oval_string_map_put(def_list, definition_id, (void *) "");
 }
+
+/*
+ * Definitions referring to a local variable depend also on all the variables
+ * which the local variable reads.
+ */
+static void _vardef_fill_transitive(struct oval_definition_model *model, struct oval_string_map *vardef)
+{
+	struct oval_variable_iterator *var_it = oval_definition_model_get_variables(model);
+	while (oval_variable_iterator_has_more(var_it)) {
+		struct oval_variable *variable = oval_variable_iterator_next(var_it);
+		struct oval_variable_iterator *local_it = oval_definition_model_get_variables_dependent_on_variable(model, variable);
+		while (oval_variable_iterator_has_more(local_it)) {
+			struct oval_variable *local = oval_variable_iterator_next(local_it);
+			struct oval_string_map *def_list = (struct oval_string_map *) oval_string_map_get_value(vardef, oval_variable_get_id(local));
+			if (def_list == NULL)
+				continue;
+			struct oval_string_iterator *def_it = (struct oval_string_iterator *) oval_string_map_keys(def_list);
+			while (oval_string_iterator_has_more(def_it))
+				_vardef_insert(vardef, oval_string_iterator_next(def_it), oval_variable_get_id(variable));
+			oval_string_iterator_free(def_it);
+		}
+		oval_variable_iterator_free(local_it);
+	}
+	oval_variable_iterator_free(var_it);
+}
+
+/*
+ * Closures are the sets of variables read by a local variable or an object,
+ * either directly or through the variables and objects referenced from
+ * components of local variables. They are memoized by the id of the variable
+ * or the object, the empty set is stored before descending to cut cycles.
+ */
+struct vardep_closures {
+	struct oval_string_map *variables;
+	struct oval_string_map *objects;
+};
+
+static struct oval_string_map *_oval_variable_closure(struct vardep_closures *closures, struct oval_variable *variable);
+static struct oval_string_map *_oval_object_closure(struct vardep_closures *closures, struct oval_object *object);
+static void _oval_setobject_fill_closure(struct vardep_closures *closures, struct oval_setobject *set, struct oval_string_map *closure);
+static void _oval_state_fill_closure(struct vardep_closures *closures, struct oval_state *state, struct oval_string_map *closure);
+
+static void _closure_merge(struct oval_string_map *closure, struct oval_string_map *other)
+{
+	struct oval_variable_iterator *var_it = (struct oval_variable_iterator *) oval_string_map_values(other);
+	while (oval_variable_iterator_has_more(var_it)) {
+		struct oval_variable *variable = oval_variable_iterator_next(var_it);
+		oval_string_map_put(closure, oval_variable_get_id(variable), variable);
+	}
+	oval_variable_iterator_free(var_it);
+}
+
+static void _closure_add_variable(struct vardep_closures *closures, struct oval_string_map *closure, struct oval_variable *variable)
+{
+	if (variable == NULL)
+		return;
+	oval_string_map_put(closure, oval_variable_get_id(variable), variable);
+	_closure_merge(closure, _oval_variable_closure(closures, variable));
+}
+
+static void _oval_component_fill_closure(struct vardep_closures *closures, struct oval_component *component, struct oval_string_map *closure)
+{
+	switch (oval_component_get_type(component)) {
+	case OVAL_COMPONENT_LITERAL:
+		break;
+	case OVAL_COMPONENT_OBJECTREF:{
+		struct oval_object *object = oval_component_get_object(component);
+		if (object != NULL)
+			_closure_merge(closure, _oval_object_closure(closures, object));
+		} break;
+	case OVAL_COMPONENT_VARREF:
+		_closure_add_variable(closures, closure, oval_component_get_variable(component));
+		break;
+	default:{
+		struct oval_component_iterator *comp_it = oval_component_get_function_components(component);
+		if (comp_it == NULL)
+			break;
+		while (oval_component_iterator_has_more(comp_it))
+			_oval_component_fill_closure(closures, oval_component_iterator_next(comp_it), closure);
+		oval_component_iterator_free(comp_it);
+		} break;
+	}
+}
+
+static struct oval_string_map *_oval_variable_closure(struct vardep_closures *closures, struct oval_variable *variable)
+{
+	const char *id = oval_variable_get_id(variable);
+	struct oval_string_map *closure = (struct oval_string_map *) oval_string_map_get_value(closures->variables, id);
+	if (closure != NULL)
+		return closure;
+
+	closure = oval_string_map_new();
+	oval_string_map_put(closures->variables, id, closure);
+	if (oval_variable_get_type(variable) == OVAL_VARIABLE_LOCAL) {
+		struct oval_component *component = oval_variable_get_component(variable);
+		if (component != NULL)
+			_oval_component_fill_closure(closures, component, closure);
+	}
+	return closure;
+}
+
+static struct oval_string_map *_oval_object_closure(struct vardep_closures *closures, struct oval_object *object)
+{
+	const char *id = oval_object_get_id(object);
+	struct oval_string_map *closure = (struct oval_string_map *) oval_string_map_get_value(closures->objects, id);
+	if (closure != NULL)
+		return closure;
+
+	closure = oval_string_map_new();
+	oval_string_map_put(closures->objects, id, closure);
+	struct oval_object_content_iterator *content_it = oval_object_get_object_contents(object);
+	while (oval_object_content_iterator_has_more(content_it)) {
+		struct oval_object_content *content = oval_object_content_iterator_next(content_it);
+		switch (oval_object_content_get_type(content)) {
+		case OVAL_OBJECTCONTENT_ENTITY:{
+			struct oval_entity *entity = oval_object_content_get_entity(content);
+			if (entity != NULL)
+				_closure_add_variable(closures, closure, oval_entity_get_variable(entity));
+			} break;
+		case OVAL_OBJECTCONTENT_SET:
+			_oval_setobject_fill_closure(closures, oval_object_content_get_setobject(content), closure);
+			break;
+		case OVAL_OBJECTCONTENT_FILTER:{
+			struct oval_state *state = oval_filter_get_state(oval_object_content_get_filter(content));
+			if (state != NULL)
+				_oval_state_fill_closure(closures, state, closure);
+			} break;
+		default:
+			break;
+		}
+	}
+	oval_object_content_iterator_free(content_it);
+	return closure;
+}
+
+static void _oval_setobject_fill_closure(struct vardep_closures *closures, struct oval_setobject *set, struct oval_string_map *closure)
+{
+	switch (oval_setobject_get_type(set)) {
+	case OVAL_SET_AGGREGATE:{
+		struct oval_setobject_iterator *subset_it = oval_setobject_get_subsets(set);
+		while (oval_setobject_iterator_has_more(subset_it))
+			_oval_setobject_fill_closure(closures, oval_setobject_iterator_next(subset_it), closure);
+		oval_setobject_iterator_free(subset_it);
+		} break;
+	case OVAL_SET_COLLECTIVE:{
+		struct oval_object_iterator *object_it = oval_setobject_get_objects(set);
+		while (oval_object_iterator_has_more(object_it))
+			_closure_merge(closure, _oval_object_closure(closures, oval_object_iterator_next(object_it)));
+		oval_object_iterator_free(object_it);
+
+		struct oval_filter_iterator *filter_it = oval_setobject_get_filters(set);
+		while (oval_filter_iterator_has_more(filter_it)) {
+			struct oval_state *state = oval_filter_get_state(oval_filter_iterator_next(filter_it));
+			if (state != NULL)
+				_oval_state_fill_closure(closures, state, closure);
+		}
+		oval_filter_iterator_free(filter_it);
+		} break;
+	default:
+		break;
+	}
+}
+
+static void _oval_state_fill_closure(struct vardep_closures *closures, struct oval_state *state, struct oval_string_map *closure)
+{
+	struct oval_state_content_iterator *content_it = oval_state_get_contents(state);
+	while (oval_state_content_iterator_has_more(content_it)) {
+		struct oval_state_content *content = oval_state_content_iterator_next(content_it);
+		struct oval_entity *entity = oval_state_content_get_entity(content);
+		if (entity != NULL)
+			_closure_add_variable(closures, closure, oval_entity_get_variable(entity));
+		struct oval_record_field_iterator *rf_it = oval_state_content_get_record_fields(content);
+		while (oval_record_field_iterator_has_more(rf_it))
+			_closure_add_variable(closures, closure, oval_record_field_get_variable(oval_record_field_iterator_next(rf_it)));
+		oval_record_field_iterator_free(rf_it);
+	}
+	oval_state_content_iterator_free(content_it);
+}
+
+static void _vardep_insert(struct oval_string_map *vardep, struct oval_string_map *closure, const char *id, void *dependent)
+{
+	struct oval_string_iterator *var_it = (struct oval_string_iterator *) oval_string_map_keys(closure);
+	while (oval_string_iterator_has_more(var_it)) {
+		const char *variable_id = oval_string_iterator_next(var_it);
+		struct oval_string_map *dependents = (struct oval_string_map *) oval_string_map_get_value(vardep, variable_id);
+		if (dependents == NULL) {
+			dependents = oval_string_map_new();
+			oval_string_map_put(vardep, variable_id, dependents);
+		}
+		oval_string_map_put(dependents, id, dependent);
+	}
+	oval_string_iterator_free(var_it);
+}
+
+void oval_definition_model_build_vardep_mapping(struct oval_definition_model *model, struct oval_string_map **vardep, struct oval_string_map **varobj)
+{
+	struct vardep_closures closures = {
+		.variables = oval_string_map_new(),
+		.objects = oval_string_map_new(),
+	};
+	*vardep = oval_string_map_new();
+	*varobj = oval_string_map_new();
+
+	struct oval_variable_iterator *var_it = oval_definition_model_get_variables(model);
+	while (oval_variable_iterator_has_more(var_it)) {
+		struct oval_variable *variable = oval_variable_iterator_next(var_it);
+		if (oval_variable_get_type(variable) != OVAL_VARIABLE_LOCAL)
+			continue;
+		_vardep_insert(*vardep, _oval_variable_closure(&closures, variable), oval_variable_get_id(variable), variable);
+	}
+	oval_variable_iterator_free(var_it);
+
+	struct oval_object_iterator *obj_it = oval_definition_model_get_objects(model);
+	while (oval_object_iterator_has_more(obj_it)) {
+		struct oval_object *object = oval_object_iterator_next(obj_it);
+		_vardep_insert(*varobj, _oval_object_closure(&closures, object), oval_object_get_id(object), object);
+	}
+	oval_object_iterator_free(obj_it);
+
+	oval_string_map_free(closures.variables, (oscap_destruct_func) oval_string_map_free0);
+	oval_string_map_free(closures.objects, (oscap_destruct_func) oval_string_map_free0);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+#pragma once
+#ifndef _SEXP_ALLOC_H
+#define _SEXP_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Allocator of S-exp values and list blocks.
+ *
+ * Small objects are allocated from slabs of per-thread caches, bigger
+ * objects from the heap. The objects are aligned at least as the memory
+ * returned by malloc. An object can be freed by any thread, objects
+ * freed by other threads are returned to the owning cache without locks.
+ * The caller has to pass the size of the object to SEXP_dealloc and
+ * SEXP_realloc, the objects don't carry any header.
+ *
+ * The slabs can be disabled with SEXP_SLAB_DISABLE=1 in the environment,
+ * e.g. to track the objects with a memory debugger.
+ */
+
+/* Objects bigger than this are allocated from the heap */
+#define SEXP_SLAB_MAXOBJ 512
+
+void *SEXP_alloc (size_t size);
+void *SEXP_realloc (void *ptr, size_t old_size, size_t new_size);
+void  SEXP_dealloc (void *ptr, size_t size);
+
+struct SEXP_alloc_stats {
+        uint64_t allocated; /* objects allocated from slabs */
+        uint64_t live;      /* objects not freed yet */
+        uint64_t reused;    /* allocations which reused a freed object */
+};
+
+/*
+ * Sum the counters of all the caches. Counters of caches owned by
+ * running threads can be slightly behind.
+ */
+void SEXP_alloc_stats (struct SEXP_alloc_stats *stats);
+
+#endif /* _SEXP_ALLOC_H */
@@ -34,4 +34,6 @@ uint32_t SEXP_atomic_dec_u32 (volatile uint32_t *ptr);
 uint32_t SEXP_atomic_inc_u32 (volatile uint32_t *ptr);
 bool     SEXP_atomic_cas_u32 (volatile uint32_t *ptr, uint32_t old, uint32_t new);
 
+bool     SEXP_atomic_cas_ptr (void *volatile *ptr, void *old, void *new);
+
 #endif /* _SEXP_ATOMIC_H */
@@ -56,6 +56,7 @@ typedef struct {
 #define SEXP_VALP_HDR(p) ((SEXP_valhdr_t *)(((uintptr_t)(p)) & SEXP_VALP_MASK))
 
 int       SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_valtype_t type);
+void      SEXP_val_free (SEXP_val_t *dsc);
 void      SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr);
 uintptr_t SEXP_val_ptr (SEXP_val_t *dsc);
 
@@ -81,45 +82,48 @@ SEXP_DEFNUM(u64, uint64_t);
 
 /*
  * List
+ *
+ * Members of a list are stored in a single array block. The block is
+ * reference counted and shared by copies of the list and by the lists
+ * returned by SEXP_list_rest, which only move the offset. A block is
+ * copied before it's modified if it's shared (copy on write).
  */
 
 struct SEXP_val_list {
         void    *b_addr;
-        uint16_t offset;
+        uint32_t offset;
 };
 
 #define SEXP_LCASTP(p) ((struct SEXP_val_list *)(p))
 
 struct SEXP_val_lblk {
-        uintptr_t nxsz;
-        uint16_t  real;
-        uint16_t  refs;
-        SEXP_t    memb[];
+        uint32_t refs;
+        uint32_t real; /* number of used slots */
+        uint32_t size; /* number of allocated slots */
+        uint32_t skip; /* number of leading members already released */
+        SEXP_t   memb[];
 };
 
 size_t    SEXP_rawval_list_length (struct SEXP_val_list *list);
 uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp);
+int       SEXP_rawval_list_unshare (struct SEXP_val_list *list, void (*func) (SEXP_t *));
+int       SEXP_rawval_list_add (struct SEXP_val_list *list, const SEXP_t *s_exp, void (*func) (SEXP_t *));
 
-uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip);
-uintptr_t SEXP_rawval_lblk_new  (uint8_t sz);
+uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint32_t n_skip);
+uintptr_t SEXP_rawval_lblk_new  (uint32_t size);
 uintptr_t SEXP_rawval_lblk_incref (uintptr_t lblkp);
 int       SEXP_rawval_lblk_decref (uintptr_t lblkp);
 
-uintptr_t SEXP_rawval_lblk_fill (uintptr_t lblkp, SEXP_t *s_exp[], uint16_t s_exp_count);
-uintptr_t SEXP_rawval_lblk_add  (uintptr_t lblkp, const SEXP_t *s_exp);
-uintptr_t SEXP_rawval_lblk_add1 (uintptr_t lblkp, const SEXP_t *s_exp);
-uintptr_t SEXP_rawval_lblk_last (uintptr_t lblkp);
+uintptr_t SEXP_rawval_lblk_fill (uintptr_t lblkp, SEXP_t *s_exp[], uint32_t s_exp_count);
 SEXP_t   *SEXP_rawval_lblk_nth  (uintptr_t lblkp, uint32_t n);
-uintptr_t SEXP_rawval_lblk_replace (uintptr_t lblkp, uint32_t n, const SEXP_t *n_val, SEXP_t **o_val);
 int       SEXP_rawval_lblk_cb   (uintptr_t lblkp, int  (*func) (SEXP_t *, void *), void *arg, uint32_t n);
 void      SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *));
-void      SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *));
+void      SEXP_rawval_lblk_release (uintptr_t lblkp, uint32_t count, void (*func) (SEXP_t *));
 
-#define SEXP_LBLK_ALIGN (16 > sizeof(void *) ? 16 : sizeof(void *))
-#define SEXP_LBLKP_MASK (UINTPTR_MAX << 4)
-#define SEXP_LBLKS_MASK 0x0f
+#define SEXP_LBLK_MINSIZE 4
+#define SEXP_LBLK_SIZE(n) (sizeof (struct SEXP_val_lblk) + sizeof (SEXP_t) * (n))
 
-#define SEXP_VALP_LBLK(valp) ((struct SEXP_val_lblk *)((uintptr_t)(valp) & SEXP_LBLKP_MASK))
+#define SEXP_VALP_LBLK(valp) ((struct SEXP_val_lblk *)(valp))
 
 uintptr_t SEXP_rawval_copy(uintptr_t s_valp);
 
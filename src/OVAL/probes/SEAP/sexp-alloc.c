@@ -0,0 +1,396 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "_sexp-alloc.h"
+#include "_sexp-atomic.h"
+#include "debug_priv.h"
+
+/*
+ * Slabs are aligned to their size, the slab of an object is found by
+ * masking the address of the object. The size is a multiple of the
+ * biggest common page size, slabs are mapped and unmapped directly.
+ */
+#define SEXP_SLAB_SIZE (64 * 1024)
+#define SEXP_SLAB_MASK (~((uintptr_t)SEXP_SLAB_SIZE - 1))
+
+#define SEXP_SLAB_CLASSES 16
+#define SEXP_SLAB_ALIGN   16
+
+static const uint16_t SEXP_slab_class_size[SEXP_SLAB_CLASSES] = {
+	16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, SEXP_SLAB_MAXOBJ
+};
+
+struct SEXP_slab {
+	struct SEXP_slab_cache *cache; /* owner of the slab */
+	struct SEXP_slab *next;        /* slabs of the class with free objects */
+	struct SEXP_slab *prev;
+	void     *free;                /* list of freed objects */
+	char     *bump;                /* objects from here to the end were never used */
+	char     *end;
+	uint32_t  live;
+	uint8_t   class;
+	bool      listed;
+};
+
+#define SEXP_SLAB_HDR (((sizeof(struct SEXP_slab) + SEXP_SLAB_ALIGN - 1) / SEXP_SLAB_ALIGN) * SEXP_SLAB_ALIGN)
+
+struct SEXP_slab_cache {
+	struct SEXP_slab *slabs[SEXP_SLAB_CLASSES]; /* slabs with free objects */
+	struct SEXP_slab *spare;                    /* empty slab kept for reuse */
+	void *volatile remote;                      /* objects freed by other threads */
+	struct SEXP_slab_cache *next;               /* all caches */
+	struct SEXP_slab_cache *next_orphan;        /* caches of exited threads */
+	volatile bool orphan;
+	uint64_t allocated;
+	uint64_t reused;
+	uint64_t freed;
+};
+
+static pthread_once_t SEXP_slab_once = PTHREAD_ONCE_INIT;
+static pthread_key_t SEXP_slab_key;
+static pthread_mutex_t SEXP_slab_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct SEXP_slab_cache *SEXP_slab_caches = NULL;
+static struct SEXP_slab_cache *SEXP_slab_orphans = NULL;
+static bool SEXP_slab_disabled = false;
+
+static void SEXP_slab_cache_free_local(struct SEXP_slab_cache *cache, void *ptr);
+
+static void SEXP_slab_cache_drain(struct SEXP_slab_cache *cache)
+{
+	void *list;
+
+	do {
+		list = cache->remote;
+	} while (list != NULL && !SEXP_atomic_cas_ptr(&cache->remote, list, NULL));
+
+	while (list != NULL) {
+		void *next = *(void **)list;
+		SEXP_slab_cache_free_local(cache, list);
+		list = next;
+	}
+}
+
+/*
+ * The cache of an exited thread keeps its slabs because the objects
+ * can still be in use, it's adopted by the next thread which needs one.
+ * Until then the objects are freed directly to the cache under the lock
+ * so that its empty slabs are released.
+ */
+static void SEXP_slab_cache_orphan(void *arg)
+{
+	struct SEXP_slab_cache *cache = arg;
+
+	pthread_mutex_lock(&SEXP_slab_lock);
+	cache->orphan = true;
+	cache->next_orphan = SEXP_slab_orphans;
+	SEXP_slab_orphans = cache;
+	SEXP_slab_cache_drain(cache);
+	dD("Orphaned slab cache %p: allocated %"PRIu64", reused %"PRIu64", live %"PRIu64,
+	   (void *)cache, cache->allocated, cache->reused, cache->allocated - cache->freed);
+	pthread_mutex_unlock(&SEXP_slab_lock);
+}
+
+static void SEXP_slab_init(void)
+{
+	(void)pthread_key_create(&SEXP_slab_key, SEXP_slab_cache_orphan);
+	SEXP_slab_disabled = getenv("SEXP_SLAB_DISABLE") != NULL;
+}
+
+static struct SEXP_slab_cache *SEXP_slab_cache_get(void)
+{
+	struct SEXP_slab_cache *cache = pthread_getspecific(SEXP_slab_key);
+
+	if (cache != NULL)
+		return cache;
+
+	pthread_mutex_lock(&SEXP_slab_lock);
+	if (SEXP_slab_orphans != NULL) {
+		cache = SEXP_slab_orphans;
+		SEXP_slab_orphans = cache->next_orphan;
+		cache->orphan = false;
+		SEXP_slab_cache_drain(cache);
+	} else {
+		cache = calloc(1, sizeof(struct SEXP_slab_cache));
+		if (cache != NULL) {
+			cache->next = SEXP_slab_caches;
+			SEXP_slab_caches = cache;
+		}
+	}
+	pthread_mutex_unlock(&SEXP_slab_lock);
+
+	if (cache != NULL && pthread_setspecific(SEXP_slab_key, cache) != 0) {
+		SEXP_slab_cache_orphan(cache);
+		return NULL;
+	}
+
+	return cache;
+}
+
+static inline unsigned int SEXP_slab_class(size_t size)
+{
+	unsigned int class;
+
+	if (size <= 128)
+		return size == 0 ? 0 : (size - 1) / 16;
+
+	for (class = 8; SEXP_slab_class_size[class] < size; ++class);
+
+	return class;
+}
+
+static inline struct SEXP_slab *SEXP_slab_of(void *ptr)
+{
+	return (struct SEXP_slab *)((uintptr_t)ptr & SEXP_SLAB_MASK);
+}
+
+static void SEXP_slab_link(struct SEXP_slab_cache *cache, struct SEXP_slab *slab)
+{
+	slab->prev = NULL;
+	slab->next = cache->slabs[slab->class];
+	if (slab->next != NULL)
+		slab->next->prev = slab;
+	cache->slabs[slab->class] = slab;
+	slab->listed = true;
+}
+
+static void SEXP_slab_unlink(struct SEXP_slab_cache *cache, struct SEXP_slab *slab)
+{
+	if (slab->prev != NULL)
+		slab->prev->next = slab->next;
+	else
+		cache->slabs[slab->class] = slab->next;
+	if (slab->next != NULL)
+		slab->next->prev = slab->prev;
+	slab->listed = false;
+}
+
+/*
+ * Slabs are mapped directly, aligned allocations from the heap waste
+ * up to the size of the slab because of the alignment.
+ */
+static struct SEXP_slab *SEXP_slab_map(void)
+{
+	char *mem, *slab, *end;
+
+	mem = mmap(NULL, 2 * SEXP_SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+		return NULL;
+
+	slab = (char *)(((uintptr_t)mem + SEXP_SLAB_SIZE - 1) & SEXP_SLAB_MASK);
+	end = mem + 2 * SEXP_SLAB_SIZE;
+
+	if (slab > mem)
+		munmap(mem, slab - mem);
+	if (slab + SEXP_SLAB_SIZE < end)
+		munmap(slab + SEXP_SLAB_SIZE, end - (slab + SEXP_SLAB_SIZE));
+
+	return (struct SEXP_slab *)slab;
+}
+
+static struct SEXP_slab *SEXP_slab_new(struct SEXP_slab_cache *cache, unsigned int class)
+{
+	struct SEXP_slab *slab = cache->spare;
+
+	if (slab != NULL) {
+		cache->spare = NULL;
+	} else {
+		slab = SEXP_slab_map();
+		if (slab == NULL)
+			return NULL;
+	}
+
+	slab->cache = cache;
+	slab->free  = NULL;
+	slab->bump  = (char *)slab + SEXP_SLAB_HDR;
+	slab->end   = (char *)slab + SEXP_SLAB_SIZE;
+	slab->live  = 0;
+	slab->class = class;
+	SEXP_slab_link(cache, slab);
+
+	return slab;
+}
+
+static void SEXP_slab_cache_free_local(struct SEXP_slab_cache *cache, void *ptr)
+{
+	struct SEXP_slab *slab = SEXP_slab_of(ptr);
+
+	*(void **)ptr = slab->free;
+	slab->free = ptr;
+	--slab->live;
+	++cache->freed;
+
+	if (!slab->listed) {
+		SEXP_slab_link(cache, slab);
+	} else if (slab->live == 0 && cache->slabs[slab->class] != slab) {
+		/* Keep the first slab of the class so that a repeated
+		 * allocation and free of one object doesn't allocate slabs */
+		SEXP_slab_unlink(cache, slab);
+		if (cache->spare == NULL)
+			cache->spare = slab;
+		else
+			munmap(slab, SEXP_SLAB_SIZE);
+	}
+}
+
+void *SEXP_alloc(size_t size)
+{
+	struct SEXP_slab_cache *cache;
+	struct SEXP_slab *slab;
+	unsigned int class;
+	size_t obj_size;
+	void *ptr;
+
+	(void)pthread_once(&SEXP_slab_once, SEXP_slab_init);
+
+	if (size > SEXP_SLAB_MAXOBJ || SEXP_slab_disabled)
+		return malloc(size);
+
+	/* Small objects can't come from the heap, they are freed to slabs */
+	cache = SEXP_slab_cache_get();
+	if (cache == NULL)
+		return NULL;
+
+	class = SEXP_slab_class(size);
+	obj_size = SEXP_slab_class_size[class];
+	slab = cache->slabs[class];
+
+	if (slab == NULL) {
+		/* Take the objects freed by other threads before allocating a new slab */
+		SEXP_slab_cache_drain(cache);
+		slab = cache->slabs[class];
+		if (slab == NULL) {
+			slab = SEXP_slab_new(cache, class);
+			if (slab == NULL)
+				return NULL;
+		}
+	}
+
+	if (slab->free != NULL) {
+		ptr = slab->free;
+		slab->free = *(void **)ptr;
+		++cache->reused;
+	} else {
+		ptr = slab->bump;
+		slab->bump += obj_size;
+	}
+
+	++slab->live;
+	++cache->allocated;
+
+	if (slab->free == NULL && slab->bump + obj_size > slab->end)
+		SEXP_slab_unlink(cache, slab);
+
+	return ptr;
+}
+
+void SEXP_dealloc(void *ptr, size_t size)
+{
+	struct SEXP_slab_cache *cache;
+	struct SEXP_slab *slab;
+	void *head;
+
+	if (ptr == NULL)
+		return;
+
+	(void)pthread_once(&SEXP_slab_once, SEXP_slab_init);
+
+	if (size > SEXP_SLAB_MAXOBJ || SEXP_slab_disabled) {
+		free(ptr);
+		return;
+	}
+
+	slab = SEXP_slab_of(ptr);
+	cache = pthread_getspecific(SEXP_slab_key);
+
+	if (slab->cache == cache) {
+		SEXP_slab_cache_free_local(cache, ptr);
+		return;
+	}
+
+	cache = slab->cache;
+
+	if (cache->orphan) {
+		pthread_mutex_lock(&SEXP_slab_lock);
+		if (cache->orphan) {
+			SEXP_slab_cache_free_local(cache, ptr);
+			pthread_mutex_unlock(&SEXP_slab_lock);
+			return;
+		}
+		pthread_mutex_unlock(&SEXP_slab_lock);
+	}
+
+	/* Push the object to the owner of the slab */
+	do {
+		head = cache->remote;
+		*(void **)ptr = head;
+	} while (!SEXP_atomic_cas_ptr(&cache->remote, head, ptr));
+}
+
+void *SEXP_realloc(void *ptr, size_t old_size, size_t new_size)
+{
+	void *new_ptr;
+
+	if (ptr == NULL)
+		return SEXP_alloc(new_size);
+
+	(void)pthread_once(&SEXP_slab_once, SEXP_slab_init);
+
+	if (SEXP_slab_disabled || (old_size > SEXP_SLAB_MAXOBJ && new_size > SEXP_SLAB_MAXOBJ))
+		return realloc(ptr, new_size);
+
+	if (old_size <= SEXP_SLAB_MAXOBJ && new_size <= SEXP_SLAB_MAXOBJ &&
+	    SEXP_slab_class(old_size) == SEXP_slab_class(new_size))
+		return ptr;
+
+	new_ptr = SEXP_alloc(new_size);
+	if (new_ptr == NULL)
+		return NULL;
+
+	memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+	SEXP_dealloc(ptr, old_size);
+
+	return new_ptr;
+}
+
+void SEXP_alloc_stats(struct SEXP_alloc_stats *stats)
+{
+	struct SEXP_slab_cache *cache;
+
+	memset(stats, 0, sizeof(struct SEXP_alloc_stats));
+
+	pthread_mutex_lock(&SEXP_slab_lock);
+	for (cache = SEXP_slab_caches; cache != NULL; cache = cache->next) {
+		stats->allocated += cache->allocated;
+		stats->reused += cache->reused;
+		stats->live += cache->allocated - cache->freed;
+	}
+	pthread_mutex_unlock(&SEXP_slab_lock);
+}
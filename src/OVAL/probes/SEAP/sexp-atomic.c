@@ -61,6 +61,11 @@ bool SEXP_atomic_cas_u32 (volatile uint32_t *ptr, uint32_t old, uint32_t new)
         return ((bool) __sync_bool_compare_and_swap (ptr, old, new));
 }
 
+bool SEXP_atomic_cas_ptr (void *volatile *ptr, void *old, void *new)
+{
+        return ((bool) __sync_bool_compare_and_swap (ptr, old, new));
+}
+
 #ifdef SEXP_ATOMIC_64BITS
 uint64_t SEXP_atomic_dec_u64 (volatile uint64_t *ptr)
 {
@@ -210,6 +215,22 @@ bool SEXP_atomic_cas_u32 (volatile uint32_t *ptr, uint32_t old, uint32_t new)
         return (r);
 }
 
+bool SEXP_atomic_cas_ptr (void *volatile *ptr, void *old, void *new)
+{
+        bool r;
+
+        SEXP_atomic_once();
+        SEXP_atomic_lock((uintptr_t)ptr);
+        if (*ptr == old) {
+                *ptr = new;
+                r = true;
+        } else
+                r = false;
+        SEXP_atomic_unlock((uintptr_t)ptr);
+
+        return (r);
+}
+
 #ifdef SEXP_ATOMIC_64BITS
 uint64_t SEXP_atomic_dec_u64 (volatile uint64_t *ptr)
 {
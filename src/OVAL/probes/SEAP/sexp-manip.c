@@ -1070,9 +1070,9 @@ SEXP_t *SEXP_list_last (const SEXP_t *list)
                 return (NULL);
         }
 
-        l_blk = SEXP_VALP_LBLK(SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr));
+        l_blk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_addr);
 
-        if (l_blk == NULL)
+        if (l_blk == NULL || l_blk->real == SEXP_LCASTP(v_dsc.mem)->offset)
                 return (NULL);
 
         return (SEXP_ref (l_blk->memb + (l_blk->real - 1)));
@@ -1081,7 +1081,7 @@ SEXP_t *SEXP_list_last (const SEXP_t *list)
 SEXP_t *SEXP_list_replace (SEXP_t *list, uint32_t n, const SEXP_t *n_val)
 {
         SEXP_val_t v_dsc;
-        SEXP_t    *o_val;
+        SEXP_t    *o_val, *memb;
 
         if (list == NULL || n_val == NULL || n < 1) {
                 errno = EFAULT;
@@ -1111,10 +1111,30 @@ SEXP_t *SEXP_list_replace (SEXP_t *list, uint32_t n, const SEXP_t *n_val)
 
         _A(n > 0);
 
-        SEXP_LCASTP(v_dsc.mem)->b_addr = (void *) SEXP_rawval_lblk_replace ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
-                                                                            SEXP_LCASTP(v_dsc.mem)->offset + n,
-                                                                            n_val, &o_val);
+        memb = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
+                                     SEXP_LCASTP(v_dsc.mem)->offset + n);
 
+        if (memb == NULL)
+                return (NULL);
+
+        if (SEXP_rawval_list_unshare (SEXP_LCASTP(v_dsc.mem), SEXP_free_lmemb) != 0)
+                return (NULL);
+
+        memb = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
+                                     SEXP_LCASTP(v_dsc.mem)->offset + n);
+        o_val = SEXP_new ();
+        o_val->s_valp = memb->s_valp;
+        o_val->s_type = memb->s_type;
+#if !defined(NDEBUG) || defined(VALIDATE_SEXP)
+        o_val->__magic0 = memb->__magic0;
+        o_val->__magic1 = memb->__magic1;
+#endif
+        memb->s_valp = SEXP_rawval_incref (n_val->s_valp);
+        memb->s_type = n_val->s_type;
+#if !defined(NDEBUG) || defined(VALIDATE_SEXP)
+        memb->__magic0 = n_val->__magic0;
+        memb->__magic1 = n_val->__magic1;
+#endif
         return (o_val);
 }
 
@@ -1218,20 +1238,16 @@ SEXP_t *SEXP_list_add (SEXP_t *list, const SEXP_t *s_exp)
 
                 list->s_valp = uptr;
                 SEXP_val_dsc (&v_dsc, list->s_valp);
-
-                uptr = SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr);
-                SEXP_rawval_lblk_add1 (uptr, s_exp);
-        } else {
-                /*
-                 * Only one reference exists to the value.
-                 * However, list blocks have their own
-                 * reference counter and some blocks can
-                 * be shared. This case is handled by the
-                 * function SEXP_rawval_list_add.
-                 */
-                SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_add ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, s_exp);
         }
 
+        /*
+         * The block of the list can still be shared with
+         * other lists. This case is handled by the function
+         * SEXP_rawval_list_add.
+         */
+        if (SEXP_rawval_list_add (SEXP_LCASTP(v_dsc.mem), s_exp, SEXP_free_lmemb) != 0)
+                return (NULL);
+
         return (list);
 }
 
@@ -1297,13 +1313,12 @@ SEXP_t *SEXP_list_pop (SEXP_t *list)
 
         lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_addr);
 
-        if (lblk != NULL) {
-                if (++SEXP_LCASTP(v_dsc.mem)->offset == lblk->real) {
-                        SEXP_LCASTP(v_dsc.mem)->offset = 0;
-                        SEXP_LCASTP(v_dsc.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
-                }
+        if (lblk != NULL && SEXP_LCASTP(v_dsc.mem)->offset < lblk->real) {
+                ++SEXP_LCASTP(v_dsc.mem)->offset;
 
-                SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                /* Nobody else can see the popped member if the block isn't shared */
+                if (lblk->refs == 1)
+                        SEXP_rawval_lblk_release ((uintptr_t)lblk, SEXP_LCASTP(v_dsc.mem)->offset, SEXP_free_lmemb);
         }
 
 #if !defined(NDEBUG)
@@ -1313,13 +1328,10 @@ SEXP_t *SEXP_list_pop (SEXP_t *list)
         return (s_ref);
 }
 
-#define SEXP_LISTIT_ARRAY_INC  32
-#define SEXP_LISTIT_ARRAY_INIT 32
-
 struct SEXP_list_it{
         struct SEXP_val_lblk *block;
-        uint16_t index;
-        uint16_t count;
+        uint32_t index;
+        uint32_t count;
 };
 
 SEXP_list_it *SEXP_list_it_new(const SEXP_t *list)
@@ -1348,22 +1360,10 @@ SEXP_list_it *SEXP_list_it_new(const SEXP_t *list)
 
 SEXP_t *SEXP_list_it_next(SEXP_list_it *it)
 {
-        SEXP_t *item;
-
-        if (it->block == NULL)
+        if (it->index >= it->count)
                 return (NULL);
 
-        item = it->block->memb + it->index;
-
-        ++it->index;
-
-        if (it->index == it->count) {
-                it->block = SEXP_VALP_LBLK(it->block->nxsz);
-                it->index = 0;
-                it->count = it->block != NULL ? it->block->real : 0;
-        }
-
-        return (item);
+        return (it->block->memb + it->index++);
 }
 
 void SEXP_list_it_free(SEXP_list_it *it)
@@ -1374,8 +1374,7 @@ void SEXP_list_it_free(SEXP_list_it *it)
 SEXP_t *SEXP_list_sort(SEXP_t *list, int(*compare)(const SEXP_t *, const SEXP_t *))
 {
         SEXP_val_t v_dsc;
-        SEXP_list_it *list_it;
-        size_t list_it_count, list_it_alloc;
+        struct SEXP_val_lblk *lblk;
 
         if (list == NULL || compare == NULL) {
                 errno = EFAULT;
@@ -1389,113 +1388,17 @@ SEXP_t *SEXP_list_sort(SEXP_t *list, int(*compare)(const SEXP_t *, const SEXP_t
                 return (NULL);
         }
 
-        /*
-         * TODO: check reference counts and make copies of list
-         * blocks if needed
-         */
-
-        /*
-         * PASS #1: Sort each block and build the iterator array
-         */
-        list_it_count = 1;
-        list_it_alloc = SEXP_LISTIT_ARRAY_INIT;
-        list_it = malloc(sizeof(SEXP_list_it) * list_it_alloc);
-        if (list_it == NULL) {
+        if (SEXP_rawval_list_unshare (SEXP_LCASTP(v_dsc.mem), SEXP_free_lmemb) != 0)
                 return (NULL);
-        }
-
-        list_it[0].block = SEXP_LCASTP(v_dsc.mem)->b_addr;
 
-        dD("Sorting blocks & building iterator array");
-
-        while (list_it[list_it_count - 1].block != NULL) {
-                /* initialize the rest of the iterator */
-                list_it[list_it_count - 1].index = list_it_count == 1 ? SEXP_LCASTP(v_dsc.mem)->offset : 0;
-                list_it[list_it_count - 1].count = list_it[list_it_count - 1].block->real;
+        lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_addr);
 
-                /* sort */
-                qsort(list_it[list_it_count - 1].block->memb,
-                      list_it[list_it_count - 1].count, sizeof(SEXP_t),
+        if (lblk != NULL) {
+                qsort(lblk->memb + SEXP_LCASTP(v_dsc.mem)->offset,
+                      lblk->real - SEXP_LCASTP(v_dsc.mem)->offset, sizeof(SEXP_t),
                       (int(*)(const void *, const void *))compare);
-
-                /* reallocate the iterator array if needed */
-                if (list_it_count == list_it_alloc) {
-                        dD("Reallocating iterator array: %z -> %z",
-                           list_it_alloc, list_it_alloc + SEXP_LISTIT_ARRAY_INC);
-
-                        list_it_alloc += SEXP_LISTIT_ARRAY_INC;
-                        void *new_list_it = realloc(list_it, sizeof(SEXP_list_it) * list_it_alloc);
-                        if (new_list_it == NULL) {
-                                int e = errno;
-                                free(list_it);
-                                errno = e;
-                                return (NULL);
-                        }
-                        list_it = new_list_it;
-                }
-
-                /* skip to the next block */
-                list_it[list_it_count].block = SEXP_VALP_LBLK(list_it[list_it_count - 1].block->nxsz);
-                ++list_it_count;
         }
 
-        --list_it_count;
-        dD("Iterator count = %zu", list_it_count);
-
-        if (list_it_count > 0) {
-                /*
-                 * PASS #2: Mergesort all blocks
-                 */
-                for (register size_t i = 0; i < list_it_count - 1; ++i) {
-                        while(list_it[i].index < list_it[i].count) {
-                                SEXP_t *min_v, tmp_v, *first_v;
-                                size_t  min_i = i;
-
-                                /* search for minimal s_valp value */
-                                min_v = first_v = list_it[i].block->memb + list_it[i].index;
-
-                                for (register size_t j = i + 1; j < list_it_count; ++j) {
-                                        if (compare(list_it[j].block->memb + list_it[j].index, min_v) < 0) {
-                                                min_v = list_it[j].block->memb + list_it[j].index;
-                                                min_i = j;
-                                        }
-                                }
-
-                                if (min_v != first_v) {
-                                        size_t dst_i = 0;
-
-                                        /* save the old value & move the minval to it's place */
-                                        tmp_v  = list_it[i].block->memb[list_it[i].index];
-                                        list_it[i].block->memb[list_it[i].index] = *min_v;
-
-					if (list_it[min_i].count > 1) {
-						/*
-						 * find a new place for the old values in the min.
-						 * value source block
-						 */
-						(void)oscap_bfind_i(list_it[min_i].block->memb + 1,
-								    list_it[min_i].count - 1, sizeof(SEXP_t), (void *)&tmp_v,
-								    (int(*)(void *, void *))compare, &dst_i);
-
-						dD("dst_i = %zu", dst_i);
-
-						/* make place for the old value in the min. value source block */
-						memmove(list_it[min_i].block->memb, list_it[min_i].block->memb + 1,
-							sizeof(SEXP_t) * dst_i);
-					}
-
-                                        list_it[min_i].block->memb[dst_i] = tmp_v;
-                                }
-
-                                ++list_it[i].index;
-                        }
-                }
-        }
-        /*
-         * Cleanup
-         */
-	free(list_it);
-
         return (list);
 }
 
@@ -1658,16 +1561,16 @@ SEXP_t *SEXP_unref (SEXP_t *s_exp_o)
 
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -1853,16 +1756,16 @@ static void SEXP_free_lmemb (SEXP_t *s_exp)
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -1962,7 +1865,8 @@ int SEXP_datatype_set_nth (SEXP_t *list, uint32_t n, const char *name)
         if (v_dsc.type != SEXP_VALTYPE_LIST)
                 return (-1);
 
-        s_nth = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, n);
+        s_nth = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
+                                      SEXP_LCASTP(v_dsc.mem)->offset + n);
 
         if (s_nth == NULL)
                 return (-1);
@@ -2026,12 +1930,11 @@ static int __SEXP_sizeof_lmemb (const SEXP_t *s_exp, size_t *sz)
 
                 lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_addr);
 
-                while (lblk != NULL) {
-                        (*sz) += sizeof (uintptr_t) + (2 * sizeof (uint16_t)) + sizeof (SEXP_t) * (1 << (lblk->nxsz & SEXP_LBLKS_MASK));
-                        lblk = SEXP_VALP_LBLK(lblk->nxsz);
-                }
+                if (lblk != NULL)
+                        (*sz) += SEXP_LBLK_SIZE(lblk->size);
 
-                ret = SEXP_rawval_lblk_cb ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, (int(*)(SEXP_t *, void *))__SEXP_sizeof_lmemb, sz, 1);
+                ret = SEXP_rawval_lblk_cb ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, (int(*)(SEXP_t *, void *))__SEXP_sizeof_lmemb, sz,
+                                           SEXP_LCASTP(v_dsc.mem)->offset + 1);
                 (*sz) += sizeof (SEXP_valhdr_t) + v_dsc.hdr->size;
                 break;
         }
@@ -288,7 +288,6 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
         SEXP_val_t v_dsc;
         SEXP_t    *s_ptr[32];
         size_t     s_cur;
-        uint8_t    b_exp;
 
         s_cur = 0;
         s_ptr[s_cur] = memb;
@@ -300,7 +299,7 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
                 s_ptr[++s_cur] = va_arg (alist, SEXP_t *);
         }
 
-        if (SEXP_val_new (&v_dsc, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
@@ -308,10 +307,8 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
         }
 
         if (s_cur > 0) {
-                for (b_exp = 0; (size_t)(1 << b_exp) < s_cur; ++b_exp);
-
                 SEXP_LCASTP(v_dsc.mem)->offset = 0;
-                SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_new (b_exp);
+                SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_new (s_cur);
 
                 if (SEXP_rawval_lblk_fill ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
                                            s_ptr, s_cur) != ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr))
@@ -369,26 +366,24 @@ SEXP_t *SEXP_list_rest_r (SEXP_t *rest, const SEXP_t *list)
                 return (NULL);
         }
 
-        if (SEXP_val_new (&v_dsc_r, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc_r, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
                 return (NULL);
         }
 
-        SEXP_LCASTP(v_dsc_r.mem)->offset = SEXP_LCASTP(v_dsc_o.mem)->offset + 1;
+        /* The rest shares the block of the list */
+        SEXP_LCASTP(v_dsc_r.mem)->offset = SEXP_LCASTP(v_dsc_o.mem)->offset;
         SEXP_LCASTP(v_dsc_r.mem)->b_addr = SEXP_LCASTP(v_dsc_o.mem)->b_addr;
 
         lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr);
 
         if (lblk != NULL) {
-                if (SEXP_LCASTP(v_dsc_r.mem)->offset == lblk->real) {
-                        SEXP_LCASTP(v_dsc_r.mem)->offset = 0;
-                        SEXP_LCASTP(v_dsc_r.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
-                }
+                if (SEXP_LCASTP(v_dsc_r.mem)->offset < lblk->real)
+                        ++SEXP_LCASTP(v_dsc_r.mem)->offset;
 
-                if (SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr) != NULL)
-                        SEXP_LCASTP(v_dsc_r.mem)->b_addr = (void *)SEXP_rawval_lblk_incref ((uintptr_t) SEXP_LCASTP(v_dsc_r.mem)->b_addr);
+                SEXP_rawval_lblk_incref ((uintptr_t)lblk);
         }
 
         SEXP_init(rest);
@@ -430,16 +425,16 @@ void __SEXP_free_r (SEXP_t *s_exp, const char *file, uint32_t line, const char *
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_r);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
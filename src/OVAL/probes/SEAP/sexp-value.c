@@ -25,15 +25,20 @@
 //#endif
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "_sexp-alloc.h"
 #include "_sexp-atomic.h"
 #include "_sexp-value.h"
 #include "debug_priv.h"
 
 int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
 {
-	void *s_val = oscap_aligned_malloc(sizeof(SEXP_valhdr_t) + vmemsize, SEXP_VALP_ALIGN);
+	void *s_val = SEXP_alloc(sizeof(SEXP_valhdr_t) + vmemsize);
+
+	if (s_val == NULL)
+		return (-1);
 
         SEXP_val_dsc (dst, (uintptr_t) s_val);
 
@@ -48,6 +53,11 @@ int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
         return (0);
 }
 
+void SEXP_val_free (SEXP_val_t *dsc)
+{
+        SEXP_dealloc (dsc->hdr, sizeof (SEXP_valhdr_t) + dsc->hdr->size);
+}
+
 void SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr)
 {
         dst->ptr  = ptr;
@@ -86,337 +96,155 @@ SEXP_numtype_t SEXP_rawval_number_type (SEXP_val_t *dsc)
         return SEXP_NTYPEP(dsc->hdr->size, dsc->mem);
 }
 
-size_t SEXP_rawval_list_length (struct SEXP_val_list *list)
+static inline void SEXP_rawval_lmemb_set (SEXP_t *dst, const SEXP_t *src)
 {
-        size_t length;
-        register struct SEXP_val_lblk *lblk;
-
-        length = 0;
-        lblk   = SEXP_VALP_LBLK(list->b_addr);
+        dst->s_valp = SEXP_rawval_incref (src->s_valp);
+        dst->s_type = src->s_type;
+#if !defined(NDEBUG) || defined(VALIDATE_SEXP)
+        dst->__magic0 = src->__magic0;
+        dst->__magic1 = src->__magic1;
+#endif
+}
 
-        while (lblk != NULL) {
-                length += lblk->real;
-                lblk    = SEXP_VALP_LBLK(lblk->nxsz);
-        }
+size_t SEXP_rawval_list_length (struct SEXP_val_list *list)
+{
+        struct SEXP_val_lblk *lblk = SEXP_VALP_LBLK(list->b_addr);
 
-        return (length - list->offset);
+        return (lblk == NULL ? 0 : lblk->real - list->offset);
 }
 
-uintptr_t SEXP_rawval_lblk_new (uint8_t sz)
+uintptr_t SEXP_rawval_lblk_new (uint32_t size)
 {
-        _A(sz < 16);
+        struct SEXP_val_lblk *lblk;
 
-	struct SEXP_val_lblk *lblk = oscap_aligned_malloc(
-		sizeof(uintptr_t) + (2 * sizeof(uint16_t)) + (sizeof(SEXP_t) * (1 << sz)),
-		SEXP_LBLK_ALIGN
-	);
+        if (size < SEXP_LBLK_MINSIZE)
+                size = SEXP_LBLK_MINSIZE;
+
+        lblk = SEXP_alloc (SEXP_LBLK_SIZE(size));
+
+        if (lblk == NULL)
+                return ((uintptr_t) NULL);
 
-        lblk->nxsz = ((uintptr_t)(NULL) & SEXP_LBLKP_MASK) | ((uintptr_t)sz & SEXP_LBLKS_MASK);
         lblk->refs = 1;
         lblk->real = 0;
+        lblk->size = size;
+        lblk->skip = 0;
 
         return ((uintptr_t)lblk);
 }
 
 uintptr_t SEXP_rawval_lblk_incref (uintptr_t lblkp)
 {
-        struct SEXP_val_lblk *lblk;
-        uint16_t refs;
-
-        lblk = SEXP_VALP_LBLK(lblkp);
-
-        /*
-         * Atomicaly update the reference counter.
-         * If the reference counter can't be updated
-         * (it would overflow), create a copy of the
-         * list.
-         */
-        for (;;) {
-                refs = lblk->refs;
-
-                if (refs < UINT16_MAX) {
-                        if (SEXP_atomic_cas_u16 (&lblk->refs, refs, refs + 1))
-                                break;
-                } else
-                        return SEXP_rawval_lblk_copy (lblkp, 0);
-        }
-
+        SEXP_atomic_inc_u32 (&SEXP_VALP_LBLK(lblkp)->refs);
         return (lblkp);
 }
 
 int SEXP_rawval_lblk_decref (uintptr_t lblkp)
 {
-        return (SEXP_atomic_dec_u16 (&SEXP_VALP_LBLK(lblkp)->refs) == 0);
+        return (SEXP_atomic_dec_u32 (&SEXP_VALP_LBLK(lblkp)->refs) == 0);
 }
 
-uintptr_t SEXP_rawval_lblk_fill (uintptr_t lblkp, SEXP_t *s_exp[], uint16_t s_exp_count)
+uintptr_t SEXP_rawval_lblk_fill (uintptr_t lblkp, SEXP_t *s_exp[], uint32_t s_exp_count)
 {
         struct SEXP_val_lblk *lblk;
+        uint32_t i;
 
         lblk = SEXP_VALP_LBLK(lblkp);
 
-        if (s_exp_count > (1 << (lblk->nxsz & 0xf)) - lblk->real)
+        if (s_exp_count > lblk->size - lblk->real)
                 return ((uintptr_t) NULL);
 
-        lblk->real = s_exp_count;
+        for (i = 0; i < s_exp_count; ++i)
+                SEXP_rawval_lmemb_set (lblk->memb + lblk->real + i, s_exp[i]);
 
-        for (; s_exp_count > 0; --s_exp_count) {
-                lblk->memb[s_exp_count - 1].s_valp = SEXP_rawval_incref (s_exp[s_exp_count - 1]->s_valp);
-                lblk->memb[s_exp_count - 1].s_type = s_exp[s_exp_count - 1]->s_type;
-#if !defined(NDEBUG) || defined(VALIDATE_SEXP)
-                lblk->memb[s_exp_count - 1].__magic0 = s_exp[s_exp_count - 1]->__magic0;
-                lblk->memb[s_exp_count - 1].__magic1 = s_exp[s_exp_count - 1]->__magic1;
-#endif
-        }
+        lblk->real += s_exp_count;
 
         return (lblkp);
 }
 
-uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
+/*
+ * Make sure that the list is the only owner of its block so that
+ * the block can be modified. A shared block is replaced with a copy
+ * of the members which belong to the list.
+ */
+int SEXP_rawval_list_unshare (struct SEXP_val_list *list, void (*func) (SEXP_t *))
 {
-        uintptr_t lb_prev;
-        uintptr_t lb_head;
-        register struct SEXP_val_lblk *lblk;
+        uintptr_t lb_copy;
+        struct SEXP_val_lblk *lblk = SEXP_VALP_LBLK(list->b_addr);
 
-        lblk = SEXP_VALP_LBLK(lblkp);
+        if (lblk == NULL || lblk->refs < 2)
+                return (0);
 
-        if (lblk == NULL) {
-                lb_head = SEXP_rawval_lblk_new (1);
-                lb_prev = lb_head;
-        } else {
-                lb_head = lblkp;
-                lb_prev = 0;
-
-                do {
-                        if (lblk->refs < 2) {
-                                lb_prev = (uintptr_t)lblk;
-                                lblk    = SEXP_VALP_LBLK(lblk->nxsz);
-                        } else {
-                                uintptr_t lb_ptr;
-
-                                /*
-                                 * We've encountered a block which belongs to more
-                                 * than one list so we have to create a copy of the
-                                 * rest of the list.
-                                 */
-                                lb_ptr = SEXP_rawval_lblk_copy (lblkp, 0);
-
-                                if (lb_prev == 0)
-                                        lb_head = lb_ptr;
-
-                                /*
-                                 * Update pointer in the previous block (if there is one)
-                                 * to point at the copy. Also decrement the reference
-                                 * counter in current block.
-                                 */
-                                if (lb_prev != 0)
-                                        SEXP_VALP_LBLK(lb_prev)->nxsz = (lb_ptr & SEXP_LBLKP_MASK) | (SEXP_VALP_LBLK(lb_prev)->nxsz & SEXP_LBLKS_MASK);
-
-                                SEXP_rawval_lblk_decref (lblkp);
-
-                                /*
-                                 * Get the last block without checking refs
-                                 * (we don't need to because it's our copy)
-                                 */
-                                lb_prev = SEXP_rawval_lblk_last (lb_ptr);
-                                break;
-                        }
-                } while (lblk != NULL);
-        }
+        lb_copy = SEXP_rawval_lblk_copy ((uintptr_t)lblk, list->offset);
+
+        if (lb_copy == (uintptr_t) NULL)
+                return (-1);
 
-        _A(lb_prev != 0);
-        _A(lb_head != 0);
+        SEXP_rawval_lblk_free ((uintptr_t)lblk, func);
 
-        (void)SEXP_rawval_lblk_add1 (lb_prev, s_exp);
+        list->b_addr = (void *)lb_copy;
+        list->offset = 0;
 
-        return (lb_head);
+        return (0);
 }
 
-uintptr_t SEXP_rawval_lblk_add1 (uintptr_t lblkp, const SEXP_t *s_exp)
+int SEXP_rawval_list_add (struct SEXP_val_list *list, const SEXP_t *s_exp, void (*func) (SEXP_t *))
 {
-        struct SEXP_val_lblk *lblk = SEXP_VALP_LBLK(lblkp);
+        struct SEXP_val_lblk *lblk;
 
-        if (lblk->real < (1 << (lblk->nxsz & 0xf))) {
+        if (list->b_addr == NULL) {
+                list->b_addr = (void *)SEXP_rawval_lblk_new (SEXP_LBLK_MINSIZE);
+                list->offset = 0;
 
-                lblk->memb[lblk->real].s_valp = SEXP_rawval_incref (s_exp->s_valp);
-                lblk->memb[lblk->real].s_type = s_exp->s_type;
-#if !defined(NDEBUG) || defined(VALIDATE_SEXP)
-                lblk->memb[lblk->real].__magic0 = s_exp->__magic0;
-                lblk->memb[lblk->real].__magic1 = s_exp->__magic1;
-#endif
-                ++lblk->real;
+                if (list->b_addr == NULL)
+                        return (-1);
+        } else if (SEXP_rawval_list_unshare (list, func) != 0)
+                return (-1);
 
-                return (lblkp);
-        } else {
-                uint8_t   new_sz;
-                uintptr_t new_lb;
+        lblk = SEXP_VALP_LBLK(list->b_addr);
 
-		new_sz = lblk->nxsz & SEXP_LBLKS_MASK;
-		new_sz = new_sz == 15 ? 6 : new_sz + 1;
+        if (lblk->real == lblk->size) {
+                uint32_t new_size = lblk->size * 2;
 
-                new_lb     = SEXP_rawval_lblk_new (new_sz);
-                lblk->nxsz = (new_lb & SEXP_LBLKP_MASK) | (lblk->nxsz & SEXP_LBLKS_MASK);
+                lblk = SEXP_realloc (lblk, SEXP_LBLK_SIZE(lblk->size), SEXP_LBLK_SIZE(new_size));
 
-                /*
-                 * We don't need to check the return value
-                 * here because we are adding the S-exp to
-                 * a newly allocated block and there is at
-                 * least one free slot.
-                 */
-                SEXP_rawval_lblk_add1 (new_lb, s_exp);
+                if (lblk == NULL)
+                        return (-1);
 
-                return (lblkp);
+                lblk->size   = new_size;
+                list->b_addr = lblk;
         }
 
-        /* NOTREACHED */
-        return ((uintptr_t) NULL);
-}
+        SEXP_rawval_lmemb_set (lblk->memb + lblk->real, s_exp);
+        ++lblk->real;
 
-uintptr_t SEXP_rawval_lblk_last (uintptr_t lblkp)
-{
-        register struct SEXP_val_lblk *lblk;
-        register uintptr_t last;
-
-        last = lblkp;
-        lblk = SEXP_VALP_LBLK(last);
-
-        while ((lblk->nxsz & SEXP_LBLKP_MASK) != ((uintptr_t)NULL)) {
-                last = lblk->nxsz;
-                lblk = SEXP_VALP_LBLK(last);
-        }
-
-        return (last);
+        return (0);
 }
 
 SEXP_t *SEXP_rawval_lblk_nth (uintptr_t lblkp, uint32_t n)
 {
-        register struct SEXP_val_lblk *lblk;
-
-        lblk = SEXP_VALP_LBLK(lblkp);
-
-        while (lblk != NULL) {
-                if (lblk->real >= n) {
-                        return (lblk->memb + (n - 1));
-                } else {
-                        n   -= lblk->real;
-                        lblk = SEXP_VALP_LBLK(lblk->nxsz);
-                }
-        }
-
-        return (NULL);
-}
-
-uintptr_t SEXP_rawval_lblk_replace (uintptr_t lblkp, uint32_t n, const SEXP_t *n_val, SEXP_t **o_val)
-{
-        uintptr_t lb_prev;
-        uintptr_t lb_head;
-        struct SEXP_val_lblk *lblk;
-        SEXP_t   *memb;
-
-        lblk = SEXP_VALP_LBLK(lblkp);
-
-        _A(lblk != NULL);
-
-        lb_head = lblkp;
-        lb_prev = 0;
-
-        while (n > lblk->real) {
-                if (lblk->refs < 2) {
-                        n      -= lblk->real;
-                        lb_prev = (uintptr_t)lblk;
-                        lblk    = SEXP_VALP_LBLK(lblk->nxsz);
-
-                        if (lblk == NULL) {
-                                (*o_val) = NULL;
-                                return (lb_head);
-                        }
-                } else {
-                        uintptr_t lb_ptr;
-
-                        /*
-                         * We've encountered a block which belongs to more
-                         * than one list so we have to create a copy of the
-                         * rest of the list.
-                         */
-                        lb_ptr = SEXP_rawval_lblk_copy ((uintptr_t)lblk, 0);
-
-                        if (lb_prev == 0)
-                                lb_head = lb_ptr;
-
-                        /*
-                         * Update pointer in the previous block (if there is one)
-                         * to point at the copy. Also decrement the reference
-                         * counter in current block.
-                         */
-                        if (lb_prev != 0)
-                                SEXP_VALP_LBLK(lb_prev)->nxsz = (lb_ptr & SEXP_LBLKP_MASK) | (SEXP_VALP_LBLK(lb_prev)->nxsz & SEXP_LBLKS_MASK);
-
-                        SEXP_rawval_lblk_decref ((uintptr_t)lblk);
-                        memb = SEXP_rawval_lblk_nth (lb_ptr, n);
-
-			if (memb == NULL)
-				abort();
-
-                        goto replace;
-                }
-        }
-
-        _A(n > 0);
+        struct SEXP_val_lblk *lblk = SEXP_VALP_LBLK(lblkp);
 
-        memb = lblk->memb + (n - 1);
-replace:
-        _A(lb_head != 0);
-        _A(memb != NULL);
+        if (lblk == NULL || n < 1 || n > lblk->real)
+                return (NULL);
 
-        (*o_val) = SEXP_new ();
-        (*o_val)->s_valp = memb->s_valp;
-        (*o_val)->s_type = memb->s_type;
-#if !defined(NDEBUG) || defined(VALIDATE_SEXP)
-        (*o_val)->__magic0 = memb->__magic0;
-        (*o_val)->__magic1 = memb->__magic1;
-#endif
-
-        memb->s_valp = SEXP_rawval_incref (n_val->s_valp);
-        memb->s_type = n_val->s_type;
-#if !defined(NDEBUG) || defined(VALIDATE_SEXP)
-        memb->__magic0 = n_val->__magic0;
-        memb->__magic1 = n_val->__magic1;
-#endif
-        return (lb_head);
+        return (lblk->memb + (n - 1));
 }
 
 int SEXP_rawval_lblk_cb (uintptr_t lblkp, int (*func) (SEXP_t *, void *), void *arg, uint32_t n)
 {
-        register struct SEXP_val_lblk *lblk;
-        register uint16_t bi;
-
-        lblk = SEXP_VALP_LBLK(lblkp);
-
-        while (lblk != NULL) {
-                if (lblk->real >= n) {
-                        int ret;
-
-                        bi = (uint16_t)n - 1;
-
-                        do {
-                                while (bi < lblk->real) {
-                                        ret = func (lblk->memb + bi, arg);
+        struct SEXP_val_lblk *lblk = SEXP_VALP_LBLK(lblkp);
+        uint32_t i;
+        int ret;
 
-                                        if (ret != 0)
-                                                return (ret);
-                                        else
-                                                ++bi;
-                                }
+        if (lblk == NULL)
+                return (0);
 
-                                lblk = SEXP_VALP_LBLK(lblk->nxsz);
-                                bi   = 0;
-                        } while (lblk != NULL);
+        for (i = n - 1; i < lblk->real; ++i) {
+                ret = func (lblk->memb + i, arg);
 
-                        break;
-                } else {
-                        n   -= lblk->real;
-                        lblk = SEXP_VALP_LBLK(lblk->nxsz);
-                }
+                if (ret != 0)
+                        return (ret);
         }
 
         return (0);
@@ -426,7 +254,7 @@ uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp)
 {
         SEXP_val_t v_dsc_o, v_dsc_c;
 
-        if (SEXP_val_new (&v_dsc_c, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc_c, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
@@ -435,115 +263,77 @@ uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp)
 
         SEXP_val_dsc (&v_dsc_o, s_valp);
 
-        SEXP_LCASTP(v_dsc_c.mem)->b_addr = (void *) SEXP_rawval_lblk_copy ((uintptr_t)SEXP_LCASTP(v_dsc_o.mem)->b_addr,
-                                                                           (uintptr_t)SEXP_LCASTP(v_dsc_o.mem)->offset);
-        SEXP_LCASTP(v_dsc_c.mem)->offset = 0;
+        /*
+         * The block is shared with the original list, it's copied
+         * by the first modification of one of the lists.
+         */
+        SEXP_LCASTP(v_dsc_c.mem)->b_addr = SEXP_LCASTP(v_dsc_o.mem)->b_addr;
+        SEXP_LCASTP(v_dsc_c.mem)->offset = SEXP_LCASTP(v_dsc_o.mem)->offset;
+
+        if (SEXP_LCASTP(v_dsc_c.mem)->b_addr != NULL)
+                SEXP_rawval_lblk_incref ((uintptr_t)SEXP_LCASTP(v_dsc_c.mem)->b_addr);
 
         return (SEXP_val_ptr (&v_dsc_c));
 }
 
-uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip)
+uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint32_t n_skip)
 {
         struct SEXP_val_lblk *lb_new, *lb_old;
-        uintptr_t lb_next;
-        uintptr_t lb_head;
-        uint16_t  off_n;  /* offset in the new block */
-        uint16_t  off_o;  /* offset in the old block */
-        uint8_t  cur_sz;  /* size of the new block */
+        uint32_t i, count;
 
-        lb_head = 0;
-        off_n   = 0;
-        off_o   = n_skip;
-        lb_old  = SEXP_VALP_LBLK(lblkp);
+        lb_old = SEXP_VALP_LBLK(lblkp);
 
         if (lb_old == NULL)
                 return ((uintptr_t) NULL);
 
-        cur_sz  = 0;
-        lb_new  = (struct SEXP_val_lblk *)SEXP_rawval_lblk_new (cur_sz);
-        lb_head = (uintptr_t)lb_new;
-
-        while (lb_old != NULL) {
-                if ((lb_old->real - off_o) == 0) {
-                        /*
-                         * move to the next old block
-                         */
-                        lb_old = SEXP_VALP_LBLK(lb_old->nxsz);
-
-                        if (lb_old == NULL)
-                                break;
+        _A(n_skip <= lb_old->real);
 
-                        off_o  = 0;
-                }
+        count  = lb_old->real - n_skip;
+        lb_new = SEXP_VALP_LBLK(SEXP_rawval_lblk_new (count + 1));
 
-                /*
-                 * allocate new block
-                 */
-                if (lb_new->real >= (1 << (cur_sz))) {
-                        lb_next = SEXP_rawval_lblk_new (++cur_sz);
-                        lb_new->nxsz = (lb_next & SEXP_LBLKP_MASK) | (lb_new->nxsz & SEXP_LBLKS_MASK);
-                        lb_new  = SEXP_VALP_LBLK(lb_next);
-                        off_n   = 0;
-                }
+        if (lb_new == NULL)
+                return ((uintptr_t) NULL);
 
-                /*
-                 * copy list items
-                 */
-                while (off_n < ((uint16_t)1 << cur_sz) && off_o < lb_old->real) {
-                        lb_new->memb[off_n].s_valp = SEXP_rawval_incref (lb_old->memb[off_o].s_valp);
-                        lb_new->memb[off_n].s_type = lb_old->memb[off_o].s_type;
-#if !defined(NDEBUG) || defined(VALIDATE_SEXP)
-                        lb_new->memb[off_n].__magic0 = lb_old->memb[off_o].__magic0;
-                        lb_new->memb[off_n].__magic1 = lb_old->memb[off_o].__magic1;
-#endif
+        for (i = 0; i < count; ++i)
+                SEXP_rawval_lmemb_set (lb_new->memb + i, lb_old->memb + n_skip + i);
 
-                        ++off_n;
-                        ++off_o;
-                        ++lb_new->real;
-                }
-        }
+        lb_new->real = count;
 
-        return (lb_head);
+        return ((uintptr_t)lb_new);
 }
 
 void SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *))
 {
         if (SEXP_rawval_lblk_decref (lblkp)) {
-                struct SEXP_val_lblk *lblk, *next;
+                struct SEXP_val_lblk *lblk;
 
                 lblk = SEXP_VALP_LBLK(lblkp);
-                next = SEXP_VALP_LBLK(lblk->nxsz);
 
-                while (lblk->real > 0) {
+                while (lblk->real > lblk->skip) {
                         --lblk->real;
                         func (lblk->memb + lblk->real);
                 }
 
-		oscap_aligned_free(lblk);
-
-                if (next != NULL)
-                        SEXP_rawval_lblk_free ((uintptr_t)next, func);
+                SEXP_dealloc (lblk, SEXP_LBLK_SIZE(lblk->size));
         }
 
         return;
 }
 
-void SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *))
+/*
+ * Release the first count members of a block which isn't shared.
+ * The members must not be accessed anymore.
+ */
+void SEXP_rawval_lblk_release (uintptr_t lblkp, uint32_t count, void (*func) (SEXP_t *))
 {
-        if (SEXP_rawval_lblk_decref (lblkp)) {
-                struct SEXP_val_lblk *lblk;
-
-                lblk = SEXP_VALP_LBLK(lblkp);
+        struct SEXP_val_lblk *lblk = SEXP_VALP_LBLK(lblkp);
 
-                while (lblk->real > 0) {
-                        --lblk->real;
-                        func (lblk->memb + lblk->real);
-                }
+        _A(lblk->refs == 1);
 
-		oscap_aligned_free(lblk);
+        while (lblk->skip < count && lblk->skip < lblk->real) {
+                func (lblk->memb + lblk->skip);
+                ++lblk->skip;
         }
-
-        return;
 }
 
 uintptr_t SEXP_rawval_copy(uintptr_t s_valp)
@@ -48,6 +48,21 @@ struct id_desc_t {
 	int item_id_ctr;	///< id counter
 };
 
+/*
+ * Object filters, a list of (action state) pairs, compiled for evaluation
+ * against many items. The state entities and their attributes are looked
+ * up only once.
+ */
+struct probe_filters;
+
+struct probe_filters *probe_filters_compile(const SEXP_t *filters);
+void probe_filters_free(struct probe_filters *filters);
+
+/*
+ * Check whether the item is excluded by any of the filters.
+ */
+bool probe_filters_item_filtered(const struct probe_filters *filters, const SEXP_t *item);
+
 #define SEAP_LOCK pthread_mutex_lock (&globals.seap_lock)
 #define SEAP_UNLOCK pthread_mutex_unlock (&globals.seap_lock)
 
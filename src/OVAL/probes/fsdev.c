@@ -38,6 +38,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <limits.h>
+#include <pthread.h>
 
 #if defined(OS_LINUX)
 # include <mntent.h>
@@ -64,6 +66,10 @@
 # error "Sorry, your OS isn't supported."
 #endif
 
+#if defined(HAVE_BLKID_GET_TAG_VALUE)
+# include <blkid/blkid.h>
+#endif
+
 #include "fsdev.h"
 #include "common/util.h"
 
@@ -165,69 +171,346 @@ static int is_local_fs(struct mntent *ment)
 
 #endif /* OS_AIX */
 
-static fsdev_t *__fsdev_init(fsdev_t *lfs)
+#ifndef MTAB_LINE_MAX
+# define MTAB_LINE_MAX 65536
+#endif
+
+typedef struct {
+	fsmount_t m;
+	dev_t dev;
+	int dev_done;       /* dev_errno is valid */
+	int dev_errno;      /* 0 if dev is valid */
+	struct statvfs vfs;
+	int vfs_done;
+	int vfs_errno;
+	char *uuid;
+	int uuid_done;
+} fsmount_entry_t;
+
+struct fsmounts {
+	char *path;         /* mount table */
+	char *prefix;       /* prefix of the mount points */
+	dev_t root_dev;     /* root directory the table was read in */
+	ino_t root_ino;
+	fsmount_entry_t *entries;
+	size_t count;
+	dev_t *local_ids;   /* sorted ids of the local devices */
+	size_t local_cnt;
+	int local_done;
+#if defined(HAVE_BLKID_GET_TAG_VALUE)
+	blkid_cache blkcache;
+	int blkcache_done;
+#endif
+	struct fsmounts *next;
+};
+
+static pthread_mutex_t fsmounts_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int fsmounts_refs = 0;
+static struct fsmounts *fsmounts_list = NULL;
+
+static void fsmounts_free(struct fsmounts *mounts)
+{
+	for (size_t i = 0; i < mounts->count; ++i) {
+		free(mounts->entries[i].m.fsname);
+		free(mounts->entries[i].m.dir);
+		free(mounts->entries[i].m.type);
+		free(mounts->entries[i].m.opts);
+		free(mounts->entries[i].uuid);
+	}
+#if defined(HAVE_BLKID_GET_TAG_VALUE)
+	if (mounts->blkcache != NULL)
+		blkid_put_cache(mounts->blkcache);
+#endif
+	free(mounts->entries);
+	free(mounts->local_ids);
+	free(mounts->path);
+	free(mounts->prefix);
+	free(mounts);
+}
+
+static struct fsmounts *fsmounts_read(const char *path, const char *prefix, const struct stat *root)
 {
-	int e;
 	FILE *fp;
-	size_t i;
+	char *buffer;
+	struct mntent ment, *mentp;
+	struct fsmounts *mounts;
+	size_t alloc = 0;
 
-	struct mntent *ment;
-	struct stat st;
+	fp = setmntent(path, "r");
+	if (fp == NULL)
+		return (NULL);
 
-	fp = setmntent(_PATH_MOUNTED, "r");
-	if (fp == NULL) {
-		e = errno;
-		free(lfs);
+	/* Options of overlay mounts may be longer than a page */
+	buffer = malloc(MTAB_LINE_MAX);
+	mounts = calloc(1, sizeof(struct fsmounts));
+	if (buffer == NULL || mounts == NULL) {
+		int e = errno;
+		free(buffer);
+		free(mounts);
+		endmntent(fp);
 		errno = e;
 		return (NULL);
 	}
+	mounts->path = strdup(path);
+	mounts->prefix = strdup(prefix);
+	if (mounts->path == NULL || mounts->prefix == NULL)
+		goto fail;
+	mounts->root_dev = root->st_dev;
+	mounts->root_ino = root->st_ino;
 
-	lfs->ids = malloc(sizeof(dev_t) * DEVID_ARRAY_SIZE);
+#if defined(OS_LINUX)
+	while ((mentp = getmntent_r(fp, &ment, buffer, MTAB_LINE_MAX)) != NULL) {
+#else
+	while ((mentp = getmntent(fp)) != NULL) {
+#endif
+		if (mounts->count == alloc) {
+			size_t new_alloc = alloc == 0 ? DEVID_ARRAY_SIZE : alloc * 2;
+			void *new_entries = realloc(mounts->entries, sizeof(fsmount_entry_t) * new_alloc);
+			if (new_entries == NULL)
+				goto fail;
+			mounts->entries = new_entries;
+			alloc = new_alloc;
+		}
+		fsmount_entry_t *entry = &mounts->entries[mounts->count++];
+		memset(entry, 0, sizeof(fsmount_entry_t));
+		entry->m.fsname = strdup(mentp->mnt_fsname);
+		entry->m.dir = strdup(mentp->mnt_dir);
+		entry->m.type = strdup(mentp->mnt_type);
+		entry->m.opts = strdup(mentp->mnt_opts);
+		entry->m.local = is_local_fs(mentp);
+		if (entry->m.fsname == NULL || entry->m.dir == NULL
+		    || entry->m.type == NULL || entry->m.opts == NULL)
+			goto fail;
+	}
 
-	if (lfs->ids == NULL) {
-		e = errno;
-		free(lfs);
-		endmntent(fp);
-		errno = e;
+	free(buffer);
+	endmntent(fp);
+
+	return (mounts);
+fail:
+	free(buffer);
+	endmntent(fp);
+	fsmounts_free(mounts);
+	errno = ENOMEM;
+	return (NULL);
+}
+
+void fsmounts_acquire(void)
+{
+	pthread_mutex_lock(&fsmounts_lock);
+	fsmounts_refs++;
+	pthread_mutex_unlock(&fsmounts_lock);
+}
+
+void fsmounts_release(void)
+{
+	pthread_mutex_lock(&fsmounts_lock);
+	if (fsmounts_refs > 0 && --fsmounts_refs == 0) {
+		while (fsmounts_list != NULL) {
+			struct fsmounts *next = fsmounts_list->next;
+			fsmounts_free(fsmounts_list);
+			fsmounts_list = next;
+		}
+	}
+	pthread_mutex_unlock(&fsmounts_lock);
+}
+
+/*
+ * Find the snapshot of the mount table or read it. The snapshot is kept
+ * only if somebody holds a reference, *cached is set then. Probes in the
+ * chroot offline mode see a different table under the same path, so the
+ * snapshots are looked up by the root directory too. Must be called with
+ * fsmounts_lock held.
+ */
+static struct fsmounts *fsmounts_lookup(const char *path, const char *prefix, int *cached)
+{
+	struct stat root;
+	struct fsmounts *mounts;
+
+	if (stat("/", &root) != 0)
 		return (NULL);
+
+	for (mounts = fsmounts_list; mounts != NULL; mounts = mounts->next) {
+		if (strcmp(mounts->path, path) == 0 && strcmp(mounts->prefix, prefix) == 0
+		    && mounts->root_dev == root.st_dev && mounts->root_ino == root.st_ino) {
+			*cached = 1;
+			return (mounts);
+		}
 	}
 
-	lfs->cnt = DEVID_ARRAY_SIZE;
-	i = 0;
+	mounts = fsmounts_read(path, prefix, &root);
+	if (mounts != NULL && fsmounts_refs > 0) {
+		mounts->next = fsmounts_list;
+		fsmounts_list = mounts;
+		*cached = 1;
+	} else {
+		*cached = 0;
+	}
+
+	return (mounts);
+}
+
+static void fsmount_stat(struct fsmounts *mounts, fsmount_entry_t *entry)
+{
+	char path[PATH_MAX];
+	struct stat st;
+
+	if (entry->dev_done)
+		return;
+
+	snprintf(path, sizeof path, "%s%s", mounts->prefix, entry->m.dir);
+	if (stat(path, &st) == 0) {
+		entry->dev = st.st_dev;
+		entry->dev_errno = 0;
+	} else {
+		entry->dev_errno = errno;
+	}
+	entry->dev_done = 1;
+}
+
+static int fsmounts_local(struct fsmounts *mounts)
+{
+	if (mounts->local_done)
+		return (0);
 
-	while ((ment = getmntent(fp)) != NULL) {
-		if (!is_local_fs(ment))
+	mounts->local_ids = malloc(sizeof(dev_t) * (mounts->count > 0 ? mounts->count : 1));
+	if (mounts->local_ids == NULL)
+		return (-1);
+	mounts->local_cnt = 0;
+	for (size_t i = 0; i < mounts->count; ++i) {
+		fsmount_entry_t *entry = &mounts->entries[i];
+		if (!entry->m.local)
 			continue;
-		if (stat(ment->mnt_dir, &st) != 0)
+		fsmount_stat(mounts, entry);
+		if (entry->dev_errno != 0)
 			continue;
-		if (i >= lfs->cnt) {
-			lfs->cnt += DEVID_ARRAY_ADD;
-			void *new_ids = realloc(lfs->ids, sizeof(dev_t) * lfs->cnt);
-			if (new_ids == NULL) {
-				e = errno;
-				free(lfs->ids);
-				free(lfs);
-				endmntent(fp);
-				errno = e;
-				return (NULL);
-			}
-			lfs->ids = new_ids;
-		}
-		memcpy(&(lfs->ids[i++]), &st.st_dev, sizeof(dev_t));
+		memcpy(&(mounts->local_ids[mounts->local_cnt++]), &entry->dev, sizeof(dev_t));
+	}
+	if (mounts->local_cnt > 1)
+		qsort(mounts->local_ids, mounts->local_cnt, sizeof(dev_t), fsdev_cmp);
+	mounts->local_done = 1;
+	return (0);
+}
+
+fsmounts_t *fsmounts_get(const char *path, const char *prefix)
+{
+	struct fsmounts *mounts;
+	int cached;
+
+	pthread_mutex_lock(&fsmounts_lock);
+	mounts = fsmounts_lookup(path, prefix, &cached);
+	if (mounts != NULL && !cached) {
+		/* Nobody would free it */
+		fsmounts_free(mounts);
+		mounts = NULL;
+		errno = EINVAL;
 	}
+	pthread_mutex_unlock(&fsmounts_lock);
 
-	endmntent(fp);
+	return (mounts);
+}
 
-	void *new_ids = realloc(lfs->ids, sizeof(dev_t) * i);
-	if (new_ids == NULL && i > 0) {
+size_t fsmounts_count(const fsmounts_t *mounts)
+{
+	return mounts->count;
+}
+
+const fsmount_t *fsmounts_entry(const fsmounts_t *mounts, size_t index)
+{
+	return &mounts->entries[index].m;
+}
+
+int fsmounts_statvfs(fsmounts_t *mounts, size_t index, struct statvfs *buf)
+{
+	fsmount_entry_t *entry = &mounts->entries[index];
+	int ret;
+
+	pthread_mutex_lock(&fsmounts_lock);
+	if (!entry->vfs_done) {
+		char path[PATH_MAX];
+
+		snprintf(path, sizeof path, "%s%s", mounts->prefix, entry->m.dir);
+		entry->vfs_errno = statvfs(path, &entry->vfs) == 0 ? 0 : errno;
+		entry->vfs_done = 1;
+	}
+	if (entry->vfs_errno == 0) {
+		memcpy(buf, &entry->vfs, sizeof(struct statvfs));
+		ret = 0;
+	} else {
+		errno = entry->vfs_errno;
+		ret = -1;
+	}
+	pthread_mutex_unlock(&fsmounts_lock);
+
+	return (ret);
+}
+
+int fsmounts_uuid(fsmounts_t *mounts, size_t index, char **uuid)
+{
+#if defined(HAVE_BLKID_GET_TAG_VALUE)
+	fsmount_entry_t *entry = &mounts->entries[index];
+	int ret = 0;
+
+	pthread_mutex_lock(&fsmounts_lock);
+	if (!mounts->blkcache_done) {
+		if (blkid_get_cache(&mounts->blkcache, NULL) != 0)
+			mounts->blkcache = NULL;
+		mounts->blkcache_done = 1;
+	}
+	if (!entry->uuid_done && mounts->blkcache != NULL) {
+		entry->uuid = blkid_get_tag_value(mounts->blkcache, "UUID", entry->m.fsname);
+		entry->uuid_done = 1;
+	}
+	*uuid = NULL;
+	if (entry->uuid != NULL) {
+		*uuid = strdup(entry->uuid);
+		if (*uuid == NULL)
+			ret = -1;
+	}
+	pthread_mutex_unlock(&fsmounts_lock);
+
+	return (ret);
+#else
+	*uuid = NULL;
+	return (0);
+#endif
+}
+
+static fsdev_t *__fsdev_init(fsdev_t *lfs)
+{
+	int e, cached;
+	struct fsmounts *mounts;
+
+	pthread_mutex_lock(&fsmounts_lock);
+	mounts = fsmounts_lookup(_PATH_MOUNTED, "", &cached);
+	if (mounts == NULL) {
 		e = errno;
-		free(lfs->ids);
+		pthread_mutex_unlock(&fsmounts_lock);
 		free(lfs);
 		errno = e;
 		return (NULL);
 	}
-	lfs->ids = new_ids;
-	lfs->cnt = i;
+
+	if (fsmounts_local(mounts) == 0) {
+		lfs->cnt = mounts->local_cnt;
+		lfs->ids = malloc(sizeof(dev_t) * (lfs->cnt > 0 ? lfs->cnt : 1));
+	} else {
+		lfs->ids = NULL;
+	}
+	if (lfs->ids == NULL) {
+		e = errno;
+		if (!cached)
+			fsmounts_free(mounts);
+		pthread_mutex_unlock(&fsmounts_lock);
+		free(lfs);
+		errno = e;
+		return (NULL);
+	}
+	memcpy(lfs->ids, mounts->local_ids, sizeof(dev_t) * lfs->cnt);
+
+	if (!cached)
+		fsmounts_free(mounts);
+	pthread_mutex_unlock(&fsmounts_lock);
 
 	return (lfs);
 }
@@ -339,6 +622,16 @@ static fsdev_t *__fsdev_init(fsdev_t *lfs)
 }
 #endif
 
+#if !defined(OS_LINUX) && !defined(OS_AIX)
+void fsmounts_acquire(void)
+{
+}
+
+void fsmounts_release(void)
+{
+}
+#endif
+
 fsdev_t *fsdev_init()
 {
 	fsdev_t *lfs;
@@ -368,7 +661,7 @@ void fsdev_free(fsdev_t * lfs)
 
 int fsdev_search(fsdev_t * lfs, void *id)
 {
-	uint16_t w, s;
+	size_t w, s;
 	int cmp;
 
 	if (!lfs)
@@ -38,15 +38,82 @@
 #if defined(__linux__) || defined(_AIX)
 #include <mntent.h>
 #endif
+#include <sys/statvfs.h>
 
 /**
  * Filesystem device structure.
  */
 typedef struct {
 	dev_t *ids;   /**< Sorted array of device ids   */
-	uint16_t cnt; /**< Number of items in the array */
+	size_t cnt;   /**< Number of items in the array */
 } fsdev_t;
 
+/**
+ * Mount table entry.
+ */
+typedef struct {
+	char *fsname; /**< Mounted device or remote filesystem */
+	char *dir;    /**< Mount point */
+	char *type;   /**< Filesystem type */
+	char *opts;   /**< Mount options */
+	int local;    /**< Non-zero if the filesystem is local */
+} fsmount_t;
+
+/**
+ * Snapshot of a mount table. Snapshots are shared by all the probes
+ * and live while any probe holds a reference, so that the mount table
+ * is read, and each mount point is stat'ed, only once per scan.
+ */
+typedef struct fsmounts fsmounts_t;
+
+/**
+ * Take a reference to the mount table snapshots.
+ */
+void fsmounts_acquire(void);
+
+/**
+ * Drop a reference to the mount table snapshots, the snapshots are
+ * freed when the last reference is dropped.
+ */
+void fsmounts_release(void);
+
+#if defined(__linux__) || defined(_AIX)
+/**
+ * Get the snapshot of a mount table, read it if needed. Must be called
+ * while holding a reference.
+ * @param path path of the mount table
+ * @param prefix prefix of the mount points, used to stat them
+ * @return the snapshot or NULL if the mount table can't be read, errno is set
+ */
+fsmounts_t *fsmounts_get(const char *path, const char *prefix);
+
+/**
+ * Number of entries in the mount table snapshot.
+ */
+size_t fsmounts_count(const fsmounts_t *mounts);
+
+/**
+ * Get an entry of the mount table snapshot, in the order of the table.
+ */
+const fsmount_t *fsmounts_entry(const fsmounts_t *mounts, size_t index);
+
+/**
+ * Get the filesystem statistics of the mount point, statvfs() is called
+ * only on the first request.
+ * @retval 0 on success
+ * @retval -1 on failure, errno is set
+ */
+int fsmounts_statvfs(fsmounts_t *mounts, size_t index, struct statvfs *buf);
+
+/**
+ * Get a copy of the UUID of the mounted device, *uuid is set to NULL if
+ * the device has none or the UUIDs can't be read. The caller frees *uuid.
+ * @retval 0 on success
+ * @retval -1 on failure, errno is set
+ */
+int fsmounts_uuid(fsmounts_t *mounts, size_t index, char **uuid);
+#endif
+
 /**
  * Initialize the fsdev_t structure from an array of filesystem
  * names.
@@ -68,6 +68,9 @@
 #include "probe/entcmp.h"
 #include "common/debug_priv.h"
 #include "environmentvariable58_probe.h"
+#if !defined(OS_FREEBSD)
+#include "procsnap.h"
+#endif
 
 #if defined(OS_FREEBSD)
 static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
@@ -232,18 +235,14 @@ static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 }
 
 #else
-#define BUFFER_SIZE 256
-
-extern char **environ;
-
-static int collect_variable(char *buffer, size_t env_name_size, int pid, SEXP_t *name_ent, probe_ctx *ctx)
+static int collect_variable(const char *name, size_t name_len, const char *value, int pid, SEXP_t *name_ent, probe_ctx *ctx)
 {
 	int res = 1;
 
-	SEXP_t *env_name = SEXP_string_new(buffer, env_name_size);
-	SEXP_t *env_value = SEXP_string_newf("%s", buffer + env_name_size + 1);
+	SEXP_t *env_name = SEXP_string_new(name, name_len);
 
 	if (probe_entobj_cmp(name_ent, env_name) == OVAL_RESULT_TRUE) {
+		SEXP_t *env_value = SEXP_string_newf("%s", value);
 		SEXP_t *item = probe_item_create(
 			OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58, NULL,
 			"pid", OVAL_DATATYPE_INTEGER, (int64_t)pid,
@@ -251,30 +250,171 @@ static int collect_variable(char *buffer, size_t env_name_size, int pid, SEXP_t
 			"value", OVAL_DATATYPE_SEXP, env_value,
 			NULL);
 		probe_item_collect(ctx, item);
+		SEXP_free(env_value);
 		res = 0;
 	}
 	SEXP_free(env_name);
-	SEXP_free(env_value);
 
 	return res;
 }
 
+static int pid_cmp(const void *a, const void *b)
+{
+	pid_t pa = *(const pid_t *)a, pb = *(const pid_t *)b;
+
+	return (pa > pb) - (pa < pb);
+}
+
+static int str_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Get the distinct PIDs of a pid entity, sorted. Returns -1 if there isn't enough memory. */
+static int get_pid_values(SEXP_t *pid_ent, pid_t **pids, size_t *pid_cnt)
+{
+	SEXP_t *vals, *val;
+	size_t count = 0, i, j;
+
+	probe_ent_getvals(pid_ent, &vals);
+	*pids = malloc((SEXP_list_length(vals) + 1) * sizeof(pid_t));
+	if (*pids == NULL) {
+		SEXP_free(vals);
+		return -1;
+	}
+	SEXP_list_foreach(val, vals) {
+		int64_t pid;
+
+		if (!SEXP_numberp(val))
+			continue;
+		pid = SEXP_number_geti_64(val);
+		if (pid > 0 && pid <= INT32_MAX)
+			(*pids)[count++] = (pid_t)pid;
+	}
+	SEXP_free(vals);
+
+	qsort(*pids, count, sizeof(pid_t), pid_cmp);
+	for (i = j = 0; i < count; ++i) {
+		if (j == 0 || (*pids)[j - 1] != (*pids)[i])
+			(*pids)[j++] = (*pids)[i];
+	}
+
+	*pid_cnt = j;
+	return 0;
+}
+
+/* Get the distinct names of a name entity, sorted. Returns -1 if there isn't enough memory. */
+static int get_name_values(SEXP_t *name_ent, char ***names, size_t *name_cnt)
+{
+	SEXP_t *vals, *val;
+	size_t count = 0, i, j;
+	bool nomem = false;
+
+	probe_ent_getvals(name_ent, &vals);
+	*names = malloc((SEXP_list_length(vals) + 1) * sizeof(char *));
+	if (*names == NULL) {
+		SEXP_free(vals);
+		return -1;
+	}
+	SEXP_list_foreach(val, vals) {
+		char *name;
+
+		if (!SEXP_stringp(val))
+			continue;
+		name = SEXP_string_cstr(val);
+		if (name == NULL) {
+			nomem = true;
+			continue;
+		}
+		(*names)[count++] = name;
+	}
+	SEXP_free(vals);
+	if (nomem) {
+		for (i = 0; i < count; ++i)
+			free((*names)[i]);
+		free(*names);
+		*names = NULL;
+		return -1;
+	}
+
+	qsort(*names, count, sizeof(char *), str_cmp);
+	for (i = j = 0; i < count; ++i) {
+		if (j > 0 && strcmp((*names)[j - 1], (*names)[i]) == 0)
+			free((*names)[i]);
+		else
+			(*names)[j++] = (*names)[i];
+	}
+
+	*name_cnt = j;
+	return 0;
+}
+
+/* Returns -1 if there isn't enough memory to read the environment */
+static int collect_process(const char *prefix, int pid, SEXP_t *name_ent, char **names, size_t name_cnt, probe_ctx *ctx)
+{
+	const struct procsnap_environ *env;
+	SEXP_t *item;
+	size_t i;
+
+	env = procsnap_environ(prefix, pid);
+	if (env == NULL)
+		return errno == ENOMEM ? -1 : 0;
+
+	if (env->blob.error != 0) {
+		dE("Can't open \"%s/proc/%d/environ\": errno=%d, %s.",
+		   prefix ? prefix : "", pid, env->blob.error, strerror(env->blob.error));
+		item = probe_item_create(
+				OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58, NULL,
+				"pid", OVAL_DATATYPE_INTEGER, (int64_t)pid,
+				NULL
+		);
+
+		probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
+		probe_item_add_msg(item, OVAL_MESSAGE_LEVEL_ERROR,
+				   "Can't open \"%s/proc/%d/environ\": errno=%d, %s.",
+				   prefix ? prefix : "", pid, env->blob.error, strerror(env->blob.error));
+		probe_item_collect(ctx, item);
+		return 0;
+	}
+
+	if (names == NULL) {
+		for (i = 0; i < env->count; ++i)
+			collect_variable(env->vars[i].name, env->vars[i].name_len, env->vars[i].value, pid, name_ent, ctx);
+		return 0;
+	}
+
+	/* Only the variables with the requested names are looked at */
+	for (size_t n = 0; n < name_cnt; ++n) {
+		size_t first, count = procsnap_environ_find(env, names[n], &first);
+
+		for (i = first; i < first + count; ++i) {
+			const struct procsnap_var *var = env->sorted[i];
+			collect_variable(var->name, var->name_len, var->value, pid, name_ent, ctx);
+		}
+	}
+
+	return 0;
+}
+
 static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 {
-	int err = 1, pid, fd;
-	bool empty;
-	SEXP_t *item, *pid_sexp;
-	DIR *d;
-	struct dirent *d_entry;
-	char *buffer, *null_char, path[PATH_MAX] = {0};
-	ssize_t buffer_used;
-	size_t buffer_size;
+	int pid;
+	pid_t *pid_vals = NULL;
+	bool found = false;
+	SEXP_t *pid_sexp;
+	char **names = NULL;
+	const pid_t *pids;
+	size_t pid_cnt, name_cnt = 0, i;
+	int err = 0;
 
 	const char *extra_vars = getenv("OSCAP_CONTAINER_VARS");
 	if (extra_vars && *extra_vars) {
 		char *vars = strdup(extra_vars);
 		char *tok, *eq_chr, *str, *strp;
 
+		if (vars == NULL)
+			return PROBE_ENOMEM;
+
 		for (str = vars; ; str = NULL) {
 			tok = strtok_r(str, "\n", &strp);
 			if (tok == NULL)
@@ -283,7 +423,7 @@ static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 			if (eq_chr == NULL)
 				continue;
 			PROBE_ENT_I32VAL(pid_ent, pid, pid = -1;, pid = 0;);
-			collect_variable(tok, eq_chr - tok, pid, name_ent, ctx);
+			collect_variable(tok, eq_chr - tok, eq_chr + 1, pid, name_ent, ctx);
 		}
 
 		free(vars);
@@ -291,111 +431,62 @@ static int read_environment(SEXP_t *pid_ent, SEXP_t *name_ent, probe_ctx *ctx)
 	}
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
-	snprintf(path, PATH_MAX, "%s/proc", prefix ? prefix : "");
-	d = opendir(path);
-	if (d == NULL) {
+	if (procsnap_pids(prefix, &pids, &pid_cnt) != 0) {
 		dE("Can't read %s/proc: errno=%d, %s.", prefix ? prefix : "", errno, strerror(errno));
 		return PROBE_EACCESS;
 	}
 
-	if ((buffer = realloc(NULL, BUFFER_SIZE)) == NULL) {
-		dE("Can't re-allocate memory");
-		closedir(d);
-		return PROBE_EFAULT;
-	}
-	buffer_size = BUFFER_SIZE;
-
-	while ((d_entry = readdir(d))) {
-		if (strspn(d_entry->d_name, "0123456789") != strlen(d_entry->d_name))
-			continue;
+	if (probe_entobj_equals_values(name_ent) && get_name_values(name_ent, &names, &name_cnt) != 0)
+		return PROBE_ENOMEM;
 
-		pid = atoi(d_entry->d_name);
-		pid_sexp = SEXP_number_newi_32(pid);
-
-		if (probe_entobj_cmp(pid_ent, pid_sexp) != OVAL_RESULT_TRUE) {
-			SEXP_free(pid_sexp);
-			continue;
+	if (probe_entobj_equals_values(pid_ent)) {
+		/* Look up the requested processes instead of walking all of them */
+		size_t cnt;
+		if (get_pid_values(pid_ent, &pid_vals, &cnt) != 0) {
+			err = PROBE_ENOMEM;
+			goto cleanup;
 		}
-		SEXP_free(pid_sexp);
-
-		snprintf(path, PATH_MAX, "%s/proc/%d/environ", prefix ? prefix : "", pid);
-		if ((fd = open(path, O_RDONLY)) == -1) {
-			dE("Can't open \"%s\": errno=%d, %s.", path, errno, strerror (errno));
-			item = probe_item_create(
-					OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58, NULL,
-					"pid", OVAL_DATATYPE_INTEGER, (int64_t)pid,
-					NULL
-			);
-
-			probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
-			probe_item_add_msg(item, OVAL_MESSAGE_LEVEL_ERROR,
-					   "Can't open \"%s\": errno=%d, %s.", path, errno, strerror (errno));
-			probe_item_collect(ctx, item);
-			continue;
-		}
-
-		empty = true;
-
-		if ((buffer_used = read(fd, buffer, buffer_size - 1)) > 0) {
-			empty = false;
+		for (i = 0; i < cnt; ++i) {
+			if (bsearch(&pid_vals[i], pids, pid_cnt, sizeof(pid_t), pid_cmp) == NULL)
+				continue;
+			pid_sexp = SEXP_number_newi_32(pid_vals[i]);
+			if (probe_entobj_cmp(pid_ent, pid_sexp) == OVAL_RESULT_TRUE) {
+				found = true;
+				if (collect_process(prefix, pid_vals[i], name_ent, names, name_cnt, ctx) != 0)
+					err = PROBE_ENOMEM;
+			}
+			SEXP_free(pid_sexp);
+			if (err != 0)
+				goto cleanup;
 		}
-
-		while (! empty) {
-			while (! (null_char = memchr(buffer, 0, buffer_used))) {
-				ssize_t s;
-				if ((size_t)buffer_used >= buffer_size) {
-					buffer_size += BUFFER_SIZE;
-					void *new_buffer = realloc(buffer, buffer_size);
-					if (new_buffer == NULL) {
-						dE("Can't re-allocate memory");
-						free(buffer);
-						closedir(d);
-						close(fd);
-						return PROBE_ENOMEM;
-					}
-					buffer = new_buffer;
-				}
-				s = read(fd, buffer + buffer_used, buffer_size - buffer_used);
-				if (s <= 0) {
-					empty = true;
-					buffer[buffer_used++] = 0;
-				}
-				else {
-					buffer_used += s;
-				}
+	} else {
+		procsnap_prefetch(prefix, PROCSNAP_MASK(PROCSNAP_ENVIRON));
+		for (i = 0; i < pid_cnt; ++i) {
+			pid_sexp = SEXP_number_newi_32(pids[i]);
+			if (probe_entobj_cmp(pid_ent, pid_sexp) == OVAL_RESULT_TRUE) {
+				found = true;
+				if (collect_process(prefix, pids[i], name_ent, names, name_cnt, ctx) != 0)
+					err = PROBE_ENOMEM;
 			}
-
-			do {
-				char *eq_char = strchr(buffer, '=');
-				if (eq_char == NULL) {
-					/* strange but possible:
-					 * $ strings /proc/1218/environ
- 					/dev/input/event0 /dev/input/event1 /dev/input/event4 /dev/input/event3
-					*/
-					buffer_used -= null_char + 1 - buffer;
-					memmove(buffer, null_char + 1, buffer_used);
-					continue;
-				}
-
-				collect_variable(buffer, eq_char - buffer, pid, name_ent, ctx);
-
-				buffer_used -= null_char + 1 - buffer;
-				memmove(buffer, null_char + 1, buffer_used);
-			} while ((null_char = memchr(buffer, 0, buffer_used)));
+			SEXP_free(pid_sexp);
+			if (err != 0)
+				goto cleanup;
 		}
-
-		close(fd);
 	}
-	closedir(d);
-	free(buffer);
-	if (err) {
+
+	if (!found) {
 		SEXP_t *msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
 				"Can't find process with requested PID.");
 		probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
 		SEXP_free(msg);
-		err = 0;
 	}
 
+cleanup:
+	for (i = 0; i < name_cnt; ++i)
+		free(names[i]);
+	free(names);
+	free(pid_vals);
+
 	return err;
 }
 #endif
@@ -405,6 +496,21 @@ int environmentvariable58_probe_offline_mode_supported(void)
 	return PROBE_OFFLINE_OWN;
 }
 
+void *environmentvariable58_probe_init(void)
+{
+#if !defined(OS_FREEBSD)
+	procsnap_acquire();
+#endif
+	return NULL;
+}
+
+void environmentvariable58_probe_fini(void *arg)
+{
+#if !defined(OS_FREEBSD)
+	procsnap_release();
+#endif
+}
+
 int environmentvariable58_probe_main(probe_ctx *ctx, void *arg)
 {
 	SEXP_t *probe_in, *name_ent, *pid_ent;
@@ -27,5 +27,7 @@
 
 int environmentvariable58_probe_offline_mode_supported(void);
 int environmentvariable58_probe_main(probe_ctx *ctx, void *arg);
+void *environmentvariable58_probe_init(void);
+void environmentvariable58_probe_fini(void *arg);
 
 #endif /* OPENSCAP_ENVIRONMENTVARIABLE58_PROBE_H */
@@ -224,83 +224,160 @@ void probe_item_resetidctr(struct id_desc_t *id_desc)
 	id_desc->item_id_ctr = 1;
 }
 
-bool probe_item_filtered(const SEXP_t *item, const SEXP_t *filters)
+struct probe_filter_entity {
+	SEXP_t *ent;		///< state entity
+	char *name;		///< name of the entity
+	oval_check_t check;	///< entity_check attribute
+};
+
+struct probe_filter {
+	oval_filter_action_t action;
+	oval_operator_t operator;
+	size_t count;
+	struct probe_filter_entity *entities;
+};
+
+struct probe_filters {
+	size_t count;
+	struct probe_filter *filter;
+};
+
+struct probe_filters *probe_filters_compile(const SEXP_t *filters)
 {
-	bool filtered = false;
-	SEXP_t *filter, *ste;
+	struct probe_filters *cfilters;
+	SEXP_t *filter, *ste, *felm, *r0;
+	size_t i;
+
+	cfilters = calloc(1, sizeof(struct probe_filters));
+	cfilters->filter = calloc(SEXP_list_length(filters), sizeof(struct probe_filter));
 
 	SEXP_list_foreach(filter, filters) {
-		SEXP_t *felm, *ste_res, *r0;
-		oval_result_t ores;
-		oval_operator_t oopr;
-		oval_filter_action_t ofact;
+		struct probe_filter *f = &cfilters->filter[cfilters->count++];
 
 		r0 = SEXP_list_first(filter);
-		ofact = SEXP_number_getu(r0);
+		f->action = SEXP_number_getu(r0);
 		SEXP_free(r0);
 		ste = SEXP_list_nth(filter, 2);
-		ste_res = SEXP_list_new(NULL);
 
+		r0 = probe_ent_getattrval(ste, "operator");
+		f->operator = r0 == NULL ? OVAL_OPERATOR_AND : SEXP_number_geti_32(r0);
+		SEXP_free(r0);
+
+		f->entities = calloc(SEXP_list_length(ste), sizeof(struct probe_filter_entity));
+		i = 0;
 		SEXP_sublist_foreach(felm, ste, 2, SEXP_LIST_END) {
-			SEXP_t *ielm, *elm_res;
-			char *elm_name;
-			oval_check_t ochk;
-			int i;
+			struct probe_filter_entity *fe = &f->entities[i++];
 
-			elm_res = SEXP_list_new(NULL);
-			elm_name = probe_ent_getname(felm);
+			fe->ent = SEXP_ref(felm);
+			fe->name = probe_ent_getname(felm);
+			r0 = probe_ent_getattrval(felm, "entity_check");
+			fe->check = r0 == NULL ? OVAL_CHECK_ALL : SEXP_number_geti_32(r0);
+			SEXP_free(r0);
+		}
+		f->count = i;
+		SEXP_free(ste);
+	}
 
-			for (i = 1;; ++i) {
-				ielm = probe_obj_getent(item, elm_name, i);
+	return cfilters;
+}
 
-				if (ielm == NULL)
-					break;
+void probe_filters_free(struct probe_filters *filters)
+{
+	size_t i, j;
 
-				ores = probe_entste_cmp(felm, ielm);
-				SEXP_list_add(elm_res, r0 = SEXP_number_newi_32(ores));
+	if (filters == NULL)
+		return;
 
-				SEXP_free(ielm);
-				SEXP_free(r0);
-			}
+	for (i = 0; i < filters->count; ++i) {
+		struct probe_filter *f = &filters->filter[i];
 
-			if (SEXP_list_length(elm_res) > 0) {
-				r0 = probe_ent_getattrval(felm, "entity_check");
+		for (j = 0; j < f->count; ++j) {
+			SEXP_free(f->entities[j].ent);
+			free(f->entities[j].name);
+		}
+		free(f->entities);
+	}
+	free(filters->filter);
+	free(filters);
+}
 
-				if (r0 == NULL)
-					ochk = OVAL_CHECK_ALL;
-				else
-					ochk = SEXP_number_geti_32(r0);
+static bool probe_ent_name_eq(const SEXP_t *ent, const char *name)
+{
+	SEXP_t *ent_name, *nr;
+	bool eq;
 
-				SEXP_free(r0);
+	ent_name = SEXP_list_first(ent);
+	if (SEXP_listp(ent_name)) {
+		nr = SEXP_list_first(ent_name);
+		SEXP_free(ent_name);
+		ent_name = nr;
+	}
+	eq = SEXP_stringp(ent_name) && SEXP_strcmp(ent_name, name) == 0;
+	SEXP_free(ent_name);
 
-				ores = probe_ent_result_bychk(elm_res, ochk);
-			} else {
-				ores = OVAL_RESULT_FALSE;
-			}
-			SEXP_list_add(ste_res, r0 = SEXP_number_newi_32(ores));
-			SEXP_free(r0);
-			SEXP_free(elm_res);
-			free(elm_name);
-		}
+	return eq;
+}
 
-		r0 = probe_ent_getattrval(ste, "operator");
-		if (r0 == NULL)
-			oopr = OVAL_OPERATOR_AND;
-		else
-			oopr = SEXP_number_geti_32(r0);
-		ores = probe_ent_result_byopr(ste_res, oopr);
-		SEXP_free(ste);
-		SEXP_free(ste_res);
-		SEXP_free(r0);
+static oval_result_t probe_filter_entity_eval(const struct probe_filter_entity *fe, const SEXP_t *item)
+{
+	struct _oresults ores;
+	SEXP_t *ielm;
 
-		if ((ores == OVAL_RESULT_TRUE && ofact == OVAL_FILTER_ACTION_EXCLUDE)
-		    || (ores == OVAL_RESULT_FALSE && ofact == OVAL_FILTER_ACTION_INCLUDE)) {
-			filtered = true;
-			SEXP_free(filter);
-			break;
+	memset(&ores, 0, sizeof(struct _oresults));
+
+	SEXP_sublist_foreach(ielm, item, 2, SEXP_LIST_END) {
+		if (fe->name == NULL || !probe_ent_name_eq(ielm, fe->name))
+			continue;
+		probe_ent_results_add(&ores, probe_entste_cmp(fe->ent, ielm));
+	}
+
+	if (ores.true_cnt + ores.false_cnt + ores.unknown_cnt + ores.error_cnt +
+	    ores.noteval_cnt + ores.notappl_cnt == 0)
+		return OVAL_RESULT_FALSE;
+
+	return probe_ent_results_bychk(&ores, fe->check);
+}
+
+bool probe_filters_item_filtered(const struct probe_filters *filters, const SEXP_t *item)
+{
+	size_t i, j;
+
+	for (i = 0; i < filters->count; ++i) {
+		const struct probe_filter *f = &filters->filter[i];
+		struct _oresults ste_ores;
+		oval_result_t ores;
+
+		memset(&ste_ores, 0, sizeof(struct _oresults));
+
+		for (j = 0; j < f->count; ++j) {
+			ores = probe_filter_entity_eval(&f->entities[j], item);
+			probe_ent_results_add(&ste_ores, ores);
+
+			/* The remaining entities can't change the result */
+			if ((ores == OVAL_RESULT_FALSE && f->operator == OVAL_OPERATOR_AND)
+			    || (ores == OVAL_RESULT_TRUE && f->operator == OVAL_OPERATOR_OR))
+				break;
 		}
+
+		ores = f->count > 0 ? probe_ent_results_byopr(&ste_ores, f->operator) : OVAL_RESULT_UNKNOWN;
+
+		if ((ores == OVAL_RESULT_TRUE && f->action == OVAL_FILTER_ACTION_EXCLUDE)
+		    || (ores == OVAL_RESULT_FALSE && f->action == OVAL_FILTER_ACTION_INCLUDE))
+			return true;
 	}
 
+	return false;
+}
+
+bool probe_item_filtered(const SEXP_t *item, const SEXP_t *filters)
+{
+	struct probe_filters *cfilters;
+	bool filtered;
+
+	cfilters = probe_filters_compile(filters);
+	filtered = probe_filters_item_filtered(cfilters, item);
+	probe_filters_free(cfilters);
+
 	return filtered;
 }
 
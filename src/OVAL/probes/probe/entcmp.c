@@ -447,39 +447,74 @@ oval_result_t probe_entobj_cmp(SEXP_t * ent_obj, SEXP_t * val)
 	return ores;
 }
 
-struct _oresults {
-	int true_cnt, false_cnt, unknown_cnt, error_cnt, noteval_cnt, notappl_cnt;
-};
+bool probe_entobj_equals_values(SEXP_t * ent_obj)
+{
+	SEXP_t *stmp, *vals = NULL;
+	oval_check_t ochk = OVAL_CHECK_ALL;
+	int valcnt;
+
+	stmp = probe_ent_getattrval(ent_obj, "operation");
+	if (stmp != NULL) {
+		oval_operation_t op = SEXP_number_geti_32(stmp);
+		SEXP_free(stmp);
+		if (op != OVAL_OPERATION_EQUALS)
+			return false;
+	}
+
+	stmp = probe_ent_getattrval(ent_obj, "var_check");
+	if (stmp != NULL) {
+		ochk = SEXP_number_geti_32(stmp);
+		SEXP_free(stmp);
+	}
+	if (ochk == OVAL_CHECK_NONE_SATISFY || ochk == OVAL_CHECK_NONE_EXIST)
+		return false;
+
+	valcnt = probe_ent_getvals(ent_obj, &vals);
+	SEXP_free(vals);
+	if (valcnt <= 1)
+		return true;
+
+	/* A value can't be equal to all of more different values */
+	return ochk == OVAL_CHECK_AT_LEAST_ONE || ochk == OVAL_CHECK_ONLY_ONE;
+}
+
+int probe_ent_results_add(struct _oresults *ores, oval_result_t r)
+{
+	switch (r) {
+	case OVAL_RESULT_TRUE:
+		++(ores->true_cnt);
+		break;
+	case OVAL_RESULT_FALSE:
+		++(ores->false_cnt);
+		break;
+	case OVAL_RESULT_UNKNOWN:
+		++(ores->unknown_cnt);
+		break;
+	case OVAL_RESULT_ERROR:
+		++(ores->error_cnt);
+		break;
+	case OVAL_RESULT_NOT_EVALUATED:
+		++(ores->noteval_cnt);
+		break;
+	case OVAL_RESULT_NOT_APPLICABLE:
+		++(ores->notappl_cnt);
+		break;
+	default:
+		return -1;
+	}
+
+	return 0;
+}
 
 static int results_parser(SEXP_t * res_lst, struct _oresults *ores)
 {
-	oval_result_t r;
 	SEXP_t *res;
 
 	memset(ores, 0, sizeof(struct _oresults));
 
 	SEXP_list_foreach(res, res_lst) {
-		r = SEXP_number_geti_32(res);
-		switch (r) {
-		case OVAL_RESULT_TRUE:
-			++(ores->true_cnt);
-			break;
-		case OVAL_RESULT_FALSE:
-			++(ores->false_cnt);
-			break;
-		case OVAL_RESULT_UNKNOWN:
-			++(ores->unknown_cnt);
-			break;
-		case OVAL_RESULT_ERROR:
-			++(ores->error_cnt);
-			break;
-		case OVAL_RESULT_NOT_EVALUATED:
-			++(ores->noteval_cnt);
-			break;
-		case OVAL_RESULT_NOT_APPLICABLE:
-			++(ores->notappl_cnt);
-			break;
-		default:
+		if (probe_ent_results_add(ores, SEXP_number_geti_32(res)) != 0) {
+			SEXP_free(res);
 			return -1;
 		}
 	}
@@ -488,50 +523,42 @@ static int results_parser(SEXP_t * res_lst, struct _oresults *ores)
 }
 
 // todo: already implemented elsewhere; consolidate
-oval_result_t probe_ent_result_bychk(SEXP_t * res_lst, oval_check_t check)
+oval_result_t probe_ent_results_bychk(const struct _oresults *ores, oval_check_t check)
 {
 	oval_result_t result = OVAL_RESULT_UNKNOWN;
-	struct _oresults ores;
 
-	if (SEXP_list_length(res_lst) == 0)
-		return OVAL_RESULT_UNKNOWN;
-
-	if (results_parser(res_lst, &ores) != 0) {
-		return OVAL_RESULT_ERROR;
-	}
-
-	if (ores.notappl_cnt > 0 &&
-	    ores.noteval_cnt == 0 &&
-	    ores.false_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.true_cnt == 0)
+	if (ores->notappl_cnt > 0 &&
+	    ores->noteval_cnt == 0 &&
+	    ores->false_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->true_cnt == 0)
 		return OVAL_RESULT_NOT_APPLICABLE;
 
 	switch (check) {
 	case OVAL_CHECK_ALL:
-		if (ores.true_cnt > 0 &&
-		    ores.false_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt == 0) {
+		if (ores->true_cnt > 0 &&
+		    ores->false_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt == 0) {
 			result = OVAL_RESULT_TRUE;
-		} else if (ores.false_cnt > 0) {
+		} else if (ores->false_cnt > 0) {
 			result = OVAL_RESULT_FALSE;
-		} else if (ores.false_cnt == 0 && ores.error_cnt > 0) {
+		} else if (ores->false_cnt == 0 && ores->error_cnt > 0) {
 			result = OVAL_RESULT_ERROR;
-		} else if (ores.false_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt > 0) {
+		} else if (ores->false_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt > 0) {
 			result = OVAL_RESULT_UNKNOWN;
-		} else if (ores.false_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt > 0) {
+		} else if (ores->false_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt > 0) {
 			result = OVAL_RESULT_NOT_EVALUATED;
 		}
 		break;
 	case OVAL_CHECK_AT_LEAST_ONE:
-		if (ores.true_cnt > 0) {
+		if (ores->true_cnt > 0) {
 			result = OVAL_RESULT_TRUE;
-		} else if (ores.false_cnt > 0 &&
-			   ores.true_cnt == 0 &&
-			   ores.unknown_cnt == 0 && ores.error_cnt == 0 && ores.noteval_cnt == 0) {
+		} else if (ores->false_cnt > 0 &&
+			   ores->true_cnt == 0 &&
+			   ores->unknown_cnt == 0 && ores->error_cnt == 0 && ores->noteval_cnt == 0) {
 			result = OVAL_RESULT_FALSE;
-		} else if (ores.true_cnt == 0 && ores.error_cnt > 0) {
+		} else if (ores->true_cnt == 0 && ores->error_cnt > 0) {
 			result = OVAL_RESULT_ERROR;
-		} else if (ores.false_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt > 0) {
+		} else if (ores->false_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt > 0) {
 			result = OVAL_RESULT_UNKNOWN;
-		} else if (ores.false_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt > 0) {
+		} else if (ores->false_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt > 0) {
 			result = OVAL_RESULT_NOT_EVALUATED;
 		}
 		break;
@@ -540,32 +567,32 @@ oval_result_t probe_ent_result_bychk(SEXP_t * res_lst, oval_check_t check)
 		   "Converted to check='none satisfy'.");
 		/* FALLTHROUGH */
 	case OVAL_CHECK_NONE_SATISFY:
-		if (ores.true_cnt > 0) {
+		if (ores->true_cnt > 0) {
 			result = OVAL_RESULT_FALSE;
-		} else if (ores.true_cnt == 0 && ores.error_cnt > 0) {
+		} else if (ores->true_cnt == 0 && ores->error_cnt > 0) {
 			result = OVAL_RESULT_ERROR;
-		} else if (ores.true_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt > 0) {
+		} else if (ores->true_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt > 0) {
 			result = OVAL_RESULT_UNKNOWN;
-		} else if (ores.true_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt > 0) {
+		} else if (ores->true_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt > 0) {
 			result = OVAL_RESULT_NOT_EVALUATED;
-		} else if (ores.false_cnt > 0 &&
-			   ores.error_cnt == 0 &&
-			   ores.unknown_cnt == 0 && ores.noteval_cnt == 0 && ores.true_cnt == 0) {
+		} else if (ores->false_cnt > 0 &&
+			   ores->error_cnt == 0 &&
+			   ores->unknown_cnt == 0 && ores->noteval_cnt == 0 && ores->true_cnt == 0) {
 			result = OVAL_RESULT_TRUE;
 		}
 		break;
 	case OVAL_CHECK_ONLY_ONE:
-		if (ores.true_cnt == 1 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt == 0) {
+		if (ores->true_cnt == 1 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt == 0) {
 			result = OVAL_RESULT_TRUE;
-		} else if (ores.true_cnt > 1) {
+		} else if (ores->true_cnt > 1) {
 			result = OVAL_RESULT_FALSE;
-		} else if (ores.true_cnt < 2 && ores.error_cnt > 0) {
+		} else if (ores->true_cnt < 2 && ores->error_cnt > 0) {
 			result = OVAL_RESULT_ERROR;
-		} else if (ores.true_cnt < 2 && ores.error_cnt == 0 && ores.unknown_cnt > 0) {
+		} else if (ores->true_cnt < 2 && ores->error_cnt == 0 && ores->unknown_cnt > 0) {
 			result = OVAL_RESULT_UNKNOWN;
-		} else if (ores.true_cnt < 2 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt > 0) {
+		} else if (ores->true_cnt < 2 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt > 0) {
 			result = OVAL_RESULT_NOT_EVALUATED;
-		} else if (ores.true_cnt != 1 && ores.false_cnt > 0) {
+		} else if (ores->true_cnt != 1 && ores->false_cnt > 0) {
 			result = OVAL_RESULT_FALSE;
 		}
 		break;
@@ -576,10 +603,8 @@ oval_result_t probe_ent_result_bychk(SEXP_t * res_lst, oval_check_t check)
 	return result;
 }
 
-// todo: already implemented elsewhere; consolidate
-oval_result_t probe_ent_result_byopr(SEXP_t * res_lst, oval_operator_t operator)
+oval_result_t probe_ent_result_bychk(SEXP_t * res_lst, oval_check_t check)
 {
-	oval_result_t result = OVAL_RESULT_UNKNOWN;
 	struct _oresults ores;
 
 	if (SEXP_list_length(res_lst) == 0)
@@ -589,84 +614,92 @@ oval_result_t probe_ent_result_byopr(SEXP_t * res_lst, oval_operator_t operator)
 		return OVAL_RESULT_ERROR;
 	}
 
-	if (ores.notappl_cnt > 0 &&
-	    ores.noteval_cnt == 0 &&
-	    ores.false_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.true_cnt == 0)
+	return probe_ent_results_bychk(&ores, check);
+}
+
+// todo: already implemented elsewhere; consolidate
+oval_result_t probe_ent_results_byopr(const struct _oresults *ores, oval_operator_t operator)
+{
+	oval_result_t result = OVAL_RESULT_UNKNOWN;
+
+	if (ores->notappl_cnt > 0 &&
+	    ores->noteval_cnt == 0 &&
+	    ores->false_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->true_cnt == 0)
 		return OVAL_RESULT_NOT_APPLICABLE;
 
 	switch (operator) {
 	case OVAL_OPERATOR_AND:
-		if (ores.true_cnt > 0 &&
-		    ores.false_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt == 0) {
+		if (ores->true_cnt > 0 &&
+		    ores->false_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt == 0) {
 			result = OVAL_RESULT_TRUE;
-		} else if (ores.false_cnt > 0) {
+		} else if (ores->false_cnt > 0) {
 			result = OVAL_RESULT_FALSE;
-		} else if (ores.false_cnt == 0 && ores.error_cnt > 0) {
+		} else if (ores->false_cnt == 0 && ores->error_cnt > 0) {
 			result = OVAL_RESULT_ERROR;
-		} else if (ores.false_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt > 0) {
+		} else if (ores->false_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt > 0) {
 			result = OVAL_RESULT_UNKNOWN;
-		} else if (ores.false_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt > 0) {
+		} else if (ores->false_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt > 0) {
 			result = OVAL_RESULT_NOT_EVALUATED;
 		}
 		break;
 	case OVAL_OPERATOR_ONE:
-		if (ores.true_cnt == 1 &&
-		    ores.false_cnt >= 0 &&
-		    ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt == 0 && ores.notappl_cnt >= 0) {
+		if (ores->true_cnt == 1 &&
+		    ores->false_cnt >= 0 &&
+		    ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt == 0 && ores->notappl_cnt >= 0) {
 			result = OVAL_RESULT_TRUE;
-		} else if (ores.true_cnt >= 2 &&
-			   ores.false_cnt >= 0 &&
-			   ores.error_cnt >= 0 &&
-			   ores.unknown_cnt >= 0 && ores.noteval_cnt >= 0 && ores.notappl_cnt >= 0) {
+		} else if (ores->true_cnt >= 2 &&
+			   ores->false_cnt >= 0 &&
+			   ores->error_cnt >= 0 &&
+			   ores->unknown_cnt >= 0 && ores->noteval_cnt >= 0 && ores->notappl_cnt >= 0) {
 			result = OVAL_RESULT_FALSE;
-		} else if (ores.true_cnt == 0 &&
-			   ores.false_cnt >= 0 &&
-			   ores.error_cnt == 0 &&
-			   ores.unknown_cnt == 0 && ores.noteval_cnt == 0 && ores.notappl_cnt >= 0) {
+		} else if (ores->true_cnt == 0 &&
+			   ores->false_cnt >= 0 &&
+			   ores->error_cnt == 0 &&
+			   ores->unknown_cnt == 0 && ores->noteval_cnt == 0 && ores->notappl_cnt >= 0) {
 			result = OVAL_RESULT_FALSE;
-		} else if (ores.true_cnt < 2 &&
-			   ores.false_cnt >= 0 &&
-			   ores.error_cnt > 0 &&
-			   ores.unknown_cnt >= 0 && ores.noteval_cnt >= 0 && ores.notappl_cnt >= 0) {
+		} else if (ores->true_cnt < 2 &&
+			   ores->false_cnt >= 0 &&
+			   ores->error_cnt > 0 &&
+			   ores->unknown_cnt >= 0 && ores->noteval_cnt >= 0 && ores->notappl_cnt >= 0) {
 			result = OVAL_RESULT_ERROR;
-		} else if (ores.true_cnt < 2 &&
-			   ores.false_cnt >= 0 &&
-			   ores.error_cnt == 0 &&
-			   ores.unknown_cnt >= 1 && ores.noteval_cnt >= 0 && ores.notappl_cnt >= 0) {
+		} else if (ores->true_cnt < 2 &&
+			   ores->false_cnt >= 0 &&
+			   ores->error_cnt == 0 &&
+			   ores->unknown_cnt >= 1 && ores->noteval_cnt >= 0 && ores->notappl_cnt >= 0) {
 			result = OVAL_RESULT_UNKNOWN;
-		} else if (ores.true_cnt < 2 &&
-			   ores.false_cnt >= 0 &&
-			   ores.error_cnt == 0 &&
-			   ores.unknown_cnt == 0 && ores.noteval_cnt > 0 && ores.notappl_cnt >= 0) {
+		} else if (ores->true_cnt < 2 &&
+			   ores->false_cnt >= 0 &&
+			   ores->error_cnt == 0 &&
+			   ores->unknown_cnt == 0 && ores->noteval_cnt > 0 && ores->notappl_cnt >= 0) {
 			result = OVAL_RESULT_NOT_EVALUATED;
 		}
 		break;
 	case OVAL_OPERATOR_OR:
-		if (ores.true_cnt > 0) {
+		if (ores->true_cnt > 0) {
 			result = OVAL_RESULT_TRUE;
-		} else if (ores.true_cnt == 0 &&
-			   ores.false_cnt > 0 &&
-			   ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt == 0) {
+		} else if (ores->true_cnt == 0 &&
+			   ores->false_cnt > 0 &&
+			   ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt == 0) {
 			result = OVAL_RESULT_FALSE;
-		} else if (ores.true_cnt == 0 && ores.error_cnt > 0) {
+		} else if (ores->true_cnt == 0 && ores->error_cnt > 0) {
 			result = OVAL_RESULT_ERROR;
-		} else if (ores.true_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt > 0) {
+		} else if (ores->true_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt > 0) {
 			result = OVAL_RESULT_UNKNOWN;
-		} else if (ores.true_cnt == 0 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt > 0) {
+		} else if (ores->true_cnt == 0 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt > 0) {
 			result = OVAL_RESULT_NOT_EVALUATED;
 		}
 		break;
 	case OVAL_OPERATOR_XOR:
-		if ((ores.true_cnt % 2) == 1 && ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt == 0) {
+		if ((ores->true_cnt % 2) == 1 && ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt == 0) {
 			result = OVAL_RESULT_TRUE;
-		} else if ((ores.true_cnt % 2) == 0 &&
-			   ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt == 0) {
+		} else if ((ores->true_cnt % 2) == 0 &&
+			   ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt == 0) {
 			result = OVAL_RESULT_FALSE;
-		} else if (ores.error_cnt > 0) {
+		} else if (ores->error_cnt > 0) {
 			result = OVAL_RESULT_ERROR;
-		} else if (ores.error_cnt == 0 && ores.unknown_cnt > 0) {
+		} else if (ores->error_cnt == 0 && ores->unknown_cnt > 0) {
 			result = OVAL_RESULT_UNKNOWN;
-		} else if (ores.error_cnt == 0 && ores.unknown_cnt == 0 && ores.noteval_cnt > 0) {
+		} else if (ores->error_cnt == 0 && ores->unknown_cnt == 0 && ores->noteval_cnt > 0) {
 			result = OVAL_RESULT_NOT_EVALUATED;
 		}
 		break;
@@ -677,4 +710,18 @@ oval_result_t probe_ent_result_byopr(SEXP_t * res_lst, oval_operator_t operator)
 	return result;
 }
 
+oval_result_t probe_ent_result_byopr(SEXP_t * res_lst, oval_operator_t operator)
+{
+	struct _oresults ores;
+
+	if (SEXP_list_length(res_lst) == 0)
+		return OVAL_RESULT_UNKNOWN;
+
+	if (results_parser(res_lst, &ores) != 0) {
+		return OVAL_RESULT_ERROR;
+	}
+
+	return probe_ent_results_byopr(&ores, operator);
+}
+
 /// @}
@@ -32,9 +32,39 @@
 
 #include "_seap.h"
 #include <stdarg.h>
+#include <stdbool.h>
 #include "oval_definitions.h"
 #include "oval_results.h"
 
+/**
+ * Counts of individual results.
+ */
+struct _oresults {
+	int true_cnt, false_cnt, unknown_cnt, error_cnt, noteval_cnt, notappl_cnt;
+};
+
+/**
+ * Count a result.
+ * @param ores the counts
+ * @param r the result
+ * @return 0 on success, -1 if the result is not valid
+ */
+int probe_ent_results_add(struct _oresults *ores, oval_result_t r);
+
+/**
+ * Compute the overall result from counts of results and a check enumeration parameter.
+ * @param ores the counts, at least one result has to be counted
+ * @param check the check enumeration value
+ */
+oval_result_t probe_ent_results_bychk(const struct _oresults *ores, oval_check_t check);
+
+/**
+ * Compute the overall result from counts of results and a operator enumeration parameter.
+ * @param ores the counts, at least one result has to be counted
+ * @param operator the operator enumeration value
+ */
+oval_result_t probe_ent_results_byopr(const struct _oresults *ores, oval_operator_t operator);
+
 /**
  * Compute the overall result.
  * Compute the overall result from a results vector and a check enumeration parameter.
@@ -60,6 +90,16 @@ oval_result_t probe_ent_result_byopr(SEXP_t * res_lst, oval_operator_t operator)
  */
 oval_result_t probe_entobj_cmp(SEXP_t * ent_obj, SEXP_t * val);
 
+/**
+ * Check whether only the values of an object entity can match it.
+ * That is the case when the operation is equals and a value matches the
+ * entity when it equals any of the entity's values, so the probe can look
+ * up the values instead of comparing every item with the entity. The found
+ * items still have to be compared with probe_entobj_cmp().
+ * @param ent_obj object entity
+ */
+bool probe_entobj_equals_values(SEXP_t * ent_obj);
+
 /**
  * Compare state entity's content with a item entity's value.
  * The result depends on the operation attribute,
@@ -37,6 +37,7 @@
 
 #include "../SEAP/generic/rbt/rbt.h"
 #include "probe-api.h"
+#include "../_probe-api.h"
 #include "common/debug_priv.h"
 #include "common/memusage.h"
 
@@ -289,9 +290,15 @@ const char* thread_name = "icache_worker";
                                 icache_add_to_tree(cache->tree, item_ID, pair);
                         }
 
+                        /*
+                         * The probe thread may read the collected object in
+                         * probe_item_collect(), appending may move its items.
+                         */
+                        pthread_mutex_lock(&cache->cobj_mutex);
                         if (probe_cobj_add_item(pair->cobj, pair->p.item) != 0) {
                             dW("An error ocured while adding the item to the collected object");
                         }
+                        pthread_mutex_unlock(&cache->cobj_mutex);
                 }
 
                 if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
@@ -316,6 +323,11 @@ probe_icache_t *probe_icache_new(void)
                 goto fail;
         }
 
+        if (pthread_mutex_init(&cache->cobj_mutex, NULL) != 0) {
+                dE("Can't initialize icache mutex: %u, %s", errno, strerror(errno));
+                goto fail;
+        }
+
         cache->queue_beg = 0;
         cache->queue_end = 0;
         cache->queue_cnt = 0;
@@ -346,6 +358,7 @@ fail:
                 rbt_i64_free(cache->tree);
 
         pthread_mutex_destroy(&cache->queue_mutex);
+        pthread_mutex_destroy(&cache->cobj_mutex);
         pthread_cond_destroy(&cache->queue_notempty);
         free(cache);
 
@@ -547,22 +560,29 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 {
 	SEXP_t *cobj_content;
 	size_t  cobj_itemcnt;
+	oval_syschar_collection_flag_t cobj_flag;
 
 	if (ctx == NULL || ctx->probe_out == NULL || item == NULL) {
 		return -1;
 	}
 
+	/* The icache worker may be adding items to the collected object */
+	pthread_mutex_lock(&ctx->icache->cobj_mutex);
 	cobj_content = SEXP_listref_nth(ctx->probe_out, 3);
 	cobj_itemcnt = SEXP_list_length(cobj_content);
 	SEXP_free(cobj_content);
+	pthread_mutex_unlock(&ctx->icache->cobj_mutex);
 
 	if (probe_cobj_memcheck(cobj_itemcnt) != 0) {
+		pthread_mutex_lock(&ctx->icache->cobj_mutex);
+		cobj_flag = probe_cobj_get_flag(ctx->probe_out);
+		pthread_mutex_unlock(&ctx->icache->cobj_mutex);
 
 		/*
 		 * Don't set the message again if the collected object is
 		 * already flagged as incomplete.
 		 */
-		if (probe_cobj_get_flag(ctx->probe_out) != SYSCHAR_FLAG_INCOMPLETE) {
+		if (cobj_flag != SYSCHAR_FLAG_INCOMPLETE) {
 			SEXP_t *msg;
 			/*
 			 * Sync with the icache thread before modifying the
@@ -583,7 +603,7 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 		return 2;
 	}
 
-        if (ctx->filters != NULL && probe_item_filtered(item, ctx->filters)) {
+        if (ctx->filters != NULL && probe_filters_item_filtered(ctx->filters, item)) {
                 SEXP_free(item);
 		return (1);
         }
@@ -617,6 +637,7 @@ void probe_icache_free(probe_icache_t *cache)
         pthread_cancel(cache->thid);
         pthread_join(cache->thid, &ret);
         pthread_mutex_destroy(&cache->queue_mutex);
+        pthread_mutex_destroy(&cache->cobj_mutex);
         pthread_cond_destroy(&cache->queue_notempty);
         pthread_cond_destroy(&cache->queue_notfull);
 
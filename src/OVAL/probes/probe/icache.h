@@ -43,6 +43,7 @@ typedef struct {
         pthread_t thid;
 
         pthread_mutex_t queue_mutex;
+        pthread_mutex_t cobj_mutex; /* the worker adds items to collected objects under it */
         pthread_cond_t  queue_notempty;
         pthread_cond_t  queue_notfull;
 
@@ -80,7 +80,7 @@ typedef struct {
 struct probe_ctx {
         SEXP_t         *probe_in;  /**< S-exp representation of the input object */
         SEXP_t         *probe_out; /**< collected object */
-        SEXP_t         *filters;   /**< object filters (OVAL 5.8 and higher) */
+        struct probe_filters *filters; /**< compiled object filters (OVAL 5.8 and higher) */
         probe_icache_t *icache;    /**< item cache */
 	int offline_mode;
 };
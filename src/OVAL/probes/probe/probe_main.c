@@ -54,6 +54,7 @@
 #define STDOUT_FILENO _fileno(stdout)
 #else
 #include <unistd.h>
+#include "fsdev.h"
 #endif
 
 #include "probe_main.h"
@@ -160,6 +161,9 @@ static void probe_common_main_cleanup(void *arg)
 	if (fini_function != NULL) {
 		fini_function(probe->probe_arg);
 	}
+#ifndef OS_WINDOWS
+	fsmounts_release();
+#endif
 
 	probe_rcache_free(probe->rcache);
 	probe_icache_free(probe->icache);
@@ -244,6 +248,12 @@ void *probe_common_main(void *arg)
 	 */
         probe.workers   = rbt_i32_new();
 
+	/*
+	 * The mount table snapshots are shared by the probes of the scan
+	 */
+#ifndef OS_WINDOWS
+	fsmounts_acquire();
+#endif
 	probe_init_function_t init_function = probe_table_get_init_function(probe.subtype);
 	if (init_function != NULL) {
 		probe.probe_arg = init_function();
@@ -37,10 +37,12 @@
 #endif
 
 #include "probe-api.h"
+#include "../_probe-api.h"
 #include "common/debug_priv.h"
 #include "entcmp.h"
 
 #include "worker.h"
+#include "_sexp-ID.h"
 #include "probe-table.h"
 #include "probe.h"
 
@@ -102,18 +104,10 @@ void *probe_worker_runfn(void *arg)
 		dD("probe_worker_runfn has finished");
                 return (NULL);
 	} else {
-                SEXP_t *items;
-
 		dD("probe thread deleted");
 
 		obj = SEAP_msg_get(pair->pth->msg);
 		oid = probe_obj_getattrval(obj, "id");
-                items = probe_cobj_get_items(probe_res);
-
-                if (items != NULL) {
-                        SEXP_list_sort(items, SEXP_refcmp);
-                        SEXP_free(items);
-                }
 
 		if (probe_rcache_sexp_add(pair->probe->rcache, oid, probe_res) != 0) {
 			/* TODO */
@@ -429,8 +423,9 @@ static SEXP_t *probe_obj_eval(probe_t *probe, SEXP_t *id)
 	return probe_rcache_sexp_get(probe->rcache, id);
 }
 
-static SEXP_t *probe_prepare_filters(probe_t *probe, SEXP_t *obj)
+static struct probe_filters *probe_prepare_filters(probe_t *probe, SEXP_t *obj)
 {
+	struct probe_filters *cfilters;
 	SEXP_t *filters;
 	int i;
 
@@ -469,7 +464,93 @@ static SEXP_t *probe_prepare_filters(probe_t *probe, SEXP_t *obj)
 		SEXP_free(f);
 	}
 
-	return filters;
+	cfilters = probe_filters_compile(filters);
+	SEXP_free(filters);
+
+	return cfilters;
+}
+
+/*
+ * Set of items used to evaluate set operations. Items are keyed on the
+ * S-exp identifier of their entities, equal identifiers are confirmed by
+ * a deep comparison. The set doesn't own the items.
+ */
+struct probe_itemset {
+	size_t size;
+	struct probe_itemset_slot {
+		SEXP_ID_t id;
+		const SEXP_t *item;
+	} *slot;
+};
+
+static void probe_itemset_init(struct probe_itemset *set, size_t count)
+{
+	set->size = 16;
+	while (set->size < 2 * count)
+		set->size <<= 1;
+	set->slot = calloc(set->size, sizeof(struct probe_itemset_slot));
+}
+
+static SEXP_ID_t probe_item_ID(const SEXP_t *item)
+{
+	SEXP_t rest, *rest_r;
+	SEXP_ID_t id;
+
+	/* Skip the item name and its attributes, the item id is unique */
+	rest_r = SEXP_list_rest_r(&rest, item);
+	id = SEXP_ID_v(rest_r);
+	SEXP_free_r(&rest);
+
+	return id;
+}
+
+static bool probe_item_eq(const SEXP_t *item0, const SEXP_t *item1)
+{
+	SEXP_t rest0, rest1, *rest0_r, *rest1_r;
+	bool eq;
+
+	if (SEXP_refcmp(item0, item1) == 0)
+		return true;
+
+	rest0_r = SEXP_list_rest_r(&rest0, item0);
+	rest1_r = SEXP_list_rest_r(&rest1, item1);
+	eq = SEXP_deepcmp(rest0_r, rest1_r);
+	SEXP_free_r(&rest0);
+	SEXP_free_r(&rest1);
+
+	return eq;
+}
+
+/*
+ * Find the slot of the item, or the empty slot where it belongs
+ */
+static struct probe_itemset_slot *probe_itemset_find(struct probe_itemset *set, const SEXP_t *item, SEXP_ID_t id)
+{
+	size_t mask = set->size - 1;
+	size_t i = (size_t) (id ^ (id >> 32)) & mask;
+
+	while (set->slot[i].item != NULL) {
+		if (set->slot[i].id == id && probe_item_eq(set->slot[i].item, item))
+			break;
+		i = (i + 1) & mask;
+	}
+
+	return &set->slot[i];
+}
+
+/*
+ * Add the item to the set, return false if an equal item is already there
+ */
+static bool probe_itemset_add(struct probe_itemset *set, const SEXP_t *item, SEXP_ID_t id)
+{
+	struct probe_itemset_slot *slot = probe_itemset_find(set, item, id);
+
+	if (slot->item != NULL)
+		return false;
+	slot->id = id;
+	slot->item = item;
+
+	return true;
 }
 
 /**
@@ -482,9 +563,11 @@ static SEXP_t *probe_prepare_filters(probe_t *probe, SEXP_t *obj)
 static SEXP_t *probe_set_combine(SEXP_t *cobj0, SEXP_t *cobj1, oval_setobject_operation_t op)
 {
         SEXP_t *set0, *set1, *res_cobj, *cobj0_mask, *cobj1_mask, *res_mask;
-        register int cmp;
-        register SEXP_t *item0, *item1, *res;
-        register SEXP_list_it *sit0, *sit1;
+        SEXP_t *item, *res;
+        SEXP_list_it *sit0, *sit1;
+        struct probe_itemset set1_items, res_items;
+        SEXP_ID_t id;
+        bool in_set1;
 	oval_syschar_collection_flag_t res_flag;
 
 	if (cobj0 == NULL)
@@ -503,78 +586,44 @@ static SEXP_t *probe_set_combine(SEXP_t *cobj0, SEXP_t *cobj1, oval_setobject_op
                                             probe_cobj_get_flag(cobj1), op);
         res_mask = SEXP_list_join(cobj0_mask, cobj1_mask);
 
-        /* prepare iterators & first items */
-        sit0  = SEXP_list_it_new(set0);
-        sit1  = SEXP_list_it_new(set1);
-        item0 = SEXP_list_it_next(sit0);
-        item1 = SEXP_list_it_next(sit1);
+	/*
+	 * Items of the result are remembered in res_items so that an item is
+	 * added only once, items of the second collection are looked up in
+	 * set1_items.
+	 */
+	probe_itemset_init(&res_items, SEXP_list_length(set0) + SEXP_list_length(set1));
+	probe_itemset_init(&set1_items, op == OVAL_SET_OPERATION_UNION ? 0 : SEXP_list_length(set1));
+
+        /* prepare iterators */
+        sit0 = SEXP_list_it_new(set0);
+        sit1 = SEXP_list_it_new(set1);
 
         /* perform the set operation */
         switch(op) {
         case OVAL_SET_OPERATION_UNION:
-                while (item0 != NULL && item1 != NULL) {
-                        cmp = SEXP_refcmp(item0, item1);
-
-                        if (cmp < 0) {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                        } else if (cmp > 0) {
-                                SEXP_list_add(res, item1);
-                                item1 = SEXP_list_it_next(sit1);
-                        } else {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                                item1 = SEXP_list_it_next(sit1);
-                        }
-                }
-
-                if (item0 != NULL) {
-                        do {
-                                SEXP_list_add(res, item0);
-                        } while((item0 = SEXP_list_it_next(sit0)) != NULL);
-                } else if (item1 != NULL) {
-                        do {
-                                SEXP_list_add(res, item1);
-                        } while((item1 = SEXP_list_it_next(sit1)) != NULL);
-                }
+		while ((item = SEXP_list_it_next(sit0)) != NULL) {
+			if (probe_itemset_add(&res_items, item, probe_item_ID(item)))
+				SEXP_list_add(res, item);
+		}
+		while ((item = SEXP_list_it_next(sit1)) != NULL) {
+			if (probe_itemset_add(&res_items, item, probe_item_ID(item)))
+				SEXP_list_add(res, item);
+		}
 
                 break;
         case OVAL_SET_OPERATION_INTERSECTION:
-                while (item0 != NULL && item1 != NULL) {
-                        cmp = SEXP_refcmp(item0, item1);
-
-                        if (cmp < 0)
-                                item0 = SEXP_list_it_next(sit0);
-                        else if (cmp > 0)
-                                item1 = SEXP_list_it_next(sit1);
-                        else {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                                item1 = SEXP_list_it_next(sit1);
-                        }
-                }
-
-                break;
         case OVAL_SET_OPERATION_COMPLEMENT:
-                while (item0 != NULL && item1 != NULL) {
-                        cmp = SEXP_refcmp(item0, item1);
-
-                        if (cmp < 0) {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                        } else if (cmp > 0) {
-                                item1 = SEXP_list_it_next(sit1);
-                        } else {
-                                item0 = SEXP_list_it_next(sit0);
-                                item1 = SEXP_list_it_next(sit1);
-                        }
-                }
+		while ((item = SEXP_list_it_next(sit1)) != NULL)
+			probe_itemset_add(&set1_items, item, probe_item_ID(item));
 
-                if (item0 != NULL) {
-                        do {
-                                SEXP_list_add(res, item0);
-                        } while((item0 = SEXP_list_it_next(sit0)) != NULL);
-                }
+		while ((item = SEXP_list_it_next(sit0)) != NULL) {
+			id = probe_item_ID(item);
+			in_set1 = probe_itemset_find(&set1_items, item, id)->item != NULL;
+
+			if (in_set1 == (op == OVAL_SET_OPERATION_INTERSECTION)
+			    && probe_itemset_add(&res_items, item, id))
+				SEXP_list_add(res, item);
+		}
 
                 break;
         default:
@@ -584,6 +633,8 @@ static SEXP_t *probe_set_combine(SEXP_t *cobj0, SEXP_t *cobj1, oval_setobject_op
 
         SEXP_list_it_free(sit0);
         SEXP_list_it_free(sit1);
+	free(set1_items.slot);
+	free(res_items.slot);
 
 	/*
 	 * If the collected information is complete but all the items are
@@ -609,10 +660,10 @@ static SEXP_t *probe_set_combine(SEXP_t *cobj0, SEXP_t *cobj1, oval_setobject_op
 /**
  * Apply a set of filters to a collected object.
  * @param cobj item collection
- * @param filter set (list) of filters
+ * @param filters compiled set of filters
  * @return collection of items without items that match any of the filters in the input set
  */
-static SEXP_t *probe_set_apply_filters(SEXP_t *cobj, SEXP_t *filters)
+static SEXP_t *probe_set_apply_filters(SEXP_t *cobj, const struct probe_filters *filters)
 {
 	SEXP_t *result_items, *items, *item, *mask;
 	oval_syschar_status_t item_status;
@@ -651,7 +702,7 @@ static SEXP_t *probe_set_apply_filters(SEXP_t *cobj, SEXP_t *filters)
 			break;
 		}
 
-		if (!probe_item_filtered(item, filters)) {
+		if (!probe_filters_item_filtered(filters, item)) {
 			SEXP_list_add(result_items, item);
 		}
 	}
@@ -890,20 +941,25 @@ static SEXP_t *probe_set_eval(probe_t *probe, SEXP_t *set, size_t depth)
 	_A((s_subset_i > 0 && o_subset_i == 0) || (s_subset_i == 0 && o_subset_i > 0));
 
 	if (o_subset_i > 0) {
+		struct probe_filters *cfilters = probe_filters_compile(filters_a);
+
 		for (s_subset_i = 0; s_subset_i < o_subset_i; ++s_subset_i) {
-			s_subset[s_subset_i] = probe_set_apply_filters(o_subset[s_subset_i], filters_a);
+			s_subset[s_subset_i] = probe_set_apply_filters(o_subset[s_subset_i], cfilters);
 
 #ifndef NDEBUG
 			if (s_subset[s_subset_i] == NULL) {
                                 Omsg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
 							"%s: apply_filters returned NULL: set=%p, filters=%p.",
 							__FUNCTION__, o_subset[s_subset_i], filters_a);
+				probe_filters_free(cfilters);
 				goto eval_fail;
 			}
 #endif
 			SEXP_free(o_subset[s_subset_i]);
                         o_subset[s_subset_i] = NULL;
 		}
+
+		probe_filters_free(cfilters);
 	}
 
 #ifndef NDEBUG
@@ -1112,7 +1168,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 
 			if (probe_varref_create_ctx(probe_in, varrefs, &ctx) != 0) {
 				SEXP_free(varrefs);
-				SEXP_free(pctx.filters);
+				probe_filters_free(pctx.filters);
 				SEXP_free(probe_in);
 				SEXP_free(mask);
 				*ret = PROBE_EUNKNOWN;
@@ -1153,7 +1209,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			probe_varref_destroy_ctx(ctx);
 		}
 
-                SEXP_free(pctx.filters);
+                probe_filters_free(pctx.filters);
 	}
 
 	SEXP_free(probe_in);
@@ -0,0 +1,603 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "common/debug_priv.h"
+#include "common/oscap_parallel.h"
+#include "procsnap.h"
+
+/* Initial size of the buffer the files are read into */
+#define PROCSNAP_READ_SIZE 4096
+/* Number of processes read by one parallel task */
+#define PROCSNAP_CHUNK 32
+
+static const char *procsnap_file_names[PROCSNAP_FILES] = {
+	[PROCSNAP_STAT]     = "stat",
+	[PROCSNAP_STATUS]   = "status",
+	[PROCSNAP_CMDLINE]  = "cmdline",
+	[PROCSNAP_ENVIRON]  = "environ",
+	[PROCSNAP_LOGINUID] = "loginuid",
+	[PROCSNAP_MAPS]     = "maps",
+	[PROCSNAP_FD]       = "fd",
+};
+
+struct procsnap_proc {
+	pid_t pid;
+	unsigned int read;    // mask of the files which were read
+	struct procsnap_blob files[PROCSNAP_FILES];
+	struct procsnap_environ *env;
+};
+
+struct procsnap {
+	char *prefix;
+	int dir_fd;                   // prefix/proc
+	struct procsnap_proc *procs;  // sorted by the PID
+	pid_t *pids;
+	size_t count;
+	char *buffer;                 // the files are read here first
+	size_t buffer_size;
+	struct procsnap *next;
+};
+
+struct procsnap_prefetch_job {
+	int dir_fd;
+	struct procsnap_proc *procs;  // private copies of the processes
+	size_t count;
+	unsigned int mask;
+};
+
+static pthread_mutex_t procsnap_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int procsnap_refs = 0;
+static struct procsnap *procsnap_list = NULL;
+
+static void procsnap_free(struct procsnap *snap)
+{
+	while (snap != NULL) {
+		struct procsnap *next = snap->next;
+
+		for (size_t i = 0; i < snap->count; ++i) {
+			struct procsnap_proc *proc = &snap->procs[i];
+
+			for (int f = 0; f < PROCSNAP_FILES; ++f) {
+				if (proc->files[f].size > 0)
+					free((char *)proc->files[f].data);
+			}
+			if (proc->env != NULL) {
+				free((void *)proc->env->vars);
+				free((void *)proc->env->sorted);
+				free(proc->env);
+			}
+		}
+		if (snap->dir_fd != -1)
+			close(snap->dir_fd);
+		free(snap->prefix);
+		free(snap->procs);
+		free(snap->pids);
+		free(snap->buffer);
+		free(snap);
+		snap = next;
+	}
+}
+
+void procsnap_acquire(void)
+{
+	pthread_mutex_lock(&procsnap_lock);
+	procsnap_refs++;
+	pthread_mutex_unlock(&procsnap_lock);
+}
+
+void procsnap_release(void)
+{
+	pthread_mutex_lock(&procsnap_lock);
+	if (procsnap_refs > 0 && --procsnap_refs == 0) {
+		procsnap_free(procsnap_list);
+		procsnap_list = NULL;
+	}
+	pthread_mutex_unlock(&procsnap_lock);
+}
+
+static int pid_cmp(const void *a, const void *b)
+{
+	pid_t pa = *(const pid_t *)a, pb = *(const pid_t *)b;
+
+	return (pa > pb) - (pa < pb);
+}
+
+static struct procsnap *procsnap_list_procs(const char *prefix)
+{
+	char path[PATH_MAX];
+	struct procsnap *snap;
+	struct dirent *ent;
+	size_t alloc = 256;
+	int dir_fd;
+	DIR *d;
+
+	snprintf(path, sizeof path, "%s/proc", prefix);
+	dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dir_fd == -1)
+		return (NULL);
+	/* The descriptor of the stream is kept for openat() */
+	d = fdopendir(dup(dir_fd));
+	if (d == NULL) {
+		close(dir_fd);
+		return (NULL);
+	}
+
+	snap = calloc(1, sizeof(struct procsnap));
+	if (snap == NULL) {
+		closedir(d);
+		close(dir_fd);
+		errno = ENOMEM;
+		return (NULL);
+	}
+	snap->dir_fd = dir_fd;
+	snap->prefix = strdup(prefix);
+	snap->pids = malloc(alloc * sizeof(pid_t));
+	if (snap->prefix == NULL || snap->pids == NULL)
+		goto fail;
+
+	while ((ent = readdir(d)) != NULL) {
+		char *end;
+		long pid;
+
+		if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
+			continue;
+		errno = 0;
+		pid = strtol(ent->d_name, &end, 10);
+		if (errno != 0 || *end != '\0' || pid <= 0)
+			continue;
+
+		if (snap->count == alloc) {
+			pid_t *pids = realloc(snap->pids, alloc * 2 * sizeof(pid_t));
+			if (pids == NULL)
+				goto fail;
+			snap->pids = pids;
+			alloc *= 2;
+		}
+		snap->pids[snap->count++] = (pid_t)pid;
+	}
+	closedir(d);
+
+	qsort(snap->pids, snap->count, sizeof(pid_t), pid_cmp);
+
+	snap->procs = calloc(snap->count > 0 ? snap->count : 1, sizeof(struct procsnap_proc));
+	if (snap->procs == NULL) {
+		snap->count = 0;
+		procsnap_free(snap);
+		errno = ENOMEM;
+		return (NULL);
+	}
+	for (size_t i = 0; i < snap->count; ++i)
+		snap->procs[i].pid = snap->pids[i];
+
+	dD("Listed %zu processes in %s", snap->count, path);
+	return (snap);
+fail:
+	closedir(d);
+	snap->count = 0;
+	procsnap_free(snap);
+	errno = ENOMEM;
+	return (NULL);
+}
+
+/* Has to be called with the lock held */
+static struct procsnap *procsnap_get(const char *prefix)
+{
+	struct procsnap *snap;
+
+	if (prefix == NULL)
+		prefix = "";
+
+	for (snap = procsnap_list; snap != NULL; snap = snap->next) {
+		if (strcmp(snap->prefix, prefix) == 0)
+			return (snap);
+	}
+
+	snap = procsnap_list_procs(prefix);
+	if (snap == NULL)
+		return (NULL);
+
+	snap->next = procsnap_list;
+	procsnap_list = snap;
+
+	return (snap);
+}
+
+static struct procsnap_proc *procsnap_find(struct procsnap *snap, pid_t pid)
+{
+	pid_t *p = bsearch(&pid, snap->pids, snap->count, sizeof(pid_t), pid_cmp);
+
+	return p == NULL ? NULL : &snap->procs[p - snap->pids];
+}
+
+static int procsnap_buffer_reserve(char **buffer, size_t *buffer_size, size_t size)
+{
+	if (*buffer != NULL && *buffer_size >= size)
+		return (0);
+
+	size_t new_size = *buffer_size > 0 ? *buffer_size : PROCSNAP_READ_SIZE;
+	while (new_size < size)
+		new_size *= 2;
+
+	char *new_buffer = realloc(*buffer, new_size);
+	if (new_buffer == NULL)
+		return (-1);
+	*buffer = new_buffer;
+	*buffer_size = new_size;
+
+	return (0);
+}
+
+/* Read the targets of the fd links separated by NULs */
+static int procsnap_read_fds(int fd, char **buffer, size_t *buffer_size, size_t *used)
+{
+	struct dirent *ent;
+	DIR *d;
+
+	d = fdopendir(fd);
+	if (d == NULL) {
+		close(fd);
+		return (-1);
+	}
+
+	while ((ent = readdir(d)) != NULL) {
+		char target[PATH_MAX];
+		ssize_t len;
+
+		if (ent->d_name[0] == '.')
+			continue;
+		len = readlinkat(dirfd(d), ent->d_name, target, sizeof(target) - 1);
+		if (len < 0)
+			continue;
+		if (procsnap_buffer_reserve(buffer, buffer_size, *used + len + 1) != 0) {
+			closedir(d);
+			errno = ENOMEM;
+			return (-1);
+		}
+		memcpy(*buffer + *used, target, len);
+		(*buffer)[*used + len] = '\0';
+		*used += len + 1;
+	}
+	closedir(d);
+
+	return (0);
+}
+
+/*
+ * Read a file of the process. The data are terminated by an extra NUL so
+ * that the last string is terminated even if the file doesn't end with one.
+ */
+static void procsnap_read(int dir_fd, pid_t pid, procsnap_file_t file,
+		char **buffer, size_t *buffer_size, struct procsnap_blob *blob)
+{
+	char path[64];
+	size_t used = 0;
+	char *data;
+	int fd;
+
+	memset(blob, 0, sizeof(struct procsnap_blob));
+	blob->data = "";
+
+	snprintf(path, sizeof path, "%d/%s", (int)pid, procsnap_file_names[file]);
+	fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC | (file == PROCSNAP_FD ? O_DIRECTORY : 0));
+	if (fd == -1) {
+		blob->error = errno;
+		return;
+	}
+
+	if (file == PROCSNAP_FD) {
+		if (procsnap_read_fds(fd, buffer, buffer_size, &used) != 0) {
+			blob->error = errno;
+			return;
+		}
+	} else {
+		for (;;) {
+			ssize_t ret;
+
+			if (procsnap_buffer_reserve(buffer, buffer_size, used + 1) != 0) {
+				blob->error = ENOMEM;
+				close(fd);
+				return;
+			}
+			ret = read(fd, *buffer + used, *buffer_size - used);
+			if (ret < 0) {
+				if (errno == EINTR)
+					continue;
+				/* ESRCH if the process has just exited */
+				blob->error = errno;
+				close(fd);
+				return;
+			}
+			if (ret == 0)
+				break;
+			used += ret;
+		}
+		close(fd);
+	}
+
+	if (used == 0)
+		return;
+
+	data = malloc(used + 1);
+	if (data == NULL) {
+		blob->error = ENOMEM;
+		return;
+	}
+	memcpy(data, *buffer, used);
+	data[used] = '\0';
+
+	blob->data = data;
+	blob->size = used;
+}
+
+static void procsnap_prefetch_chunk(size_t index, void *arg)
+{
+	struct procsnap_prefetch_job *job = arg;
+	size_t end = (index + 1) * PROCSNAP_CHUNK;
+	size_t buffer_size = 0;
+	char *buffer = NULL;
+
+	if (end > job->count)
+		end = job->count;
+
+	for (size_t i = index * PROCSNAP_CHUNK; i < end; ++i) {
+		struct procsnap_proc *proc = &job->procs[i];
+
+		for (int f = 0; f < PROCSNAP_FILES; ++f) {
+			if (!(job->mask & PROCSNAP_MASK(f)) || (proc->read & PROCSNAP_MASK(f)))
+				continue;
+			procsnap_read(job->dir_fd, proc->pid, f, &buffer, &buffer_size, &proc->files[f]);
+			proc->read |= PROCSNAP_MASK(f);
+		}
+	}
+
+	free(buffer);
+}
+
+/* Has to be called with the lock held */
+static const struct procsnap_blob *procsnap_proc_file(struct procsnap *snap, struct procsnap_proc *proc, procsnap_file_t file)
+{
+	if (!(proc->read & PROCSNAP_MASK(file))) {
+		procsnap_read(snap->dir_fd, proc->pid, file, &snap->buffer, &snap->buffer_size, &proc->files[file]);
+		proc->read |= PROCSNAP_MASK(file);
+	}
+
+	return &proc->files[file];
+}
+
+static int name_cmp(const struct procsnap_var *var, const char *name, size_t name_len)
+{
+	size_t len = var->name_len < name_len ? var->name_len : name_len;
+	int ret = memcmp(var->name, name, len);
+
+	if (ret != 0)
+		return ret;
+	return (var->name_len > name_len) - (var->name_len < name_len);
+}
+
+static int var_cmp(const void *a, const void *b)
+{
+	const struct procsnap_var *va = *(const struct procsnap_var **)a;
+	const struct procsnap_var *vb = *(const struct procsnap_var **)b;
+	int ret = name_cmp(va, vb->name, vb->name_len);
+
+	if (ret != 0)
+		return ret;
+	/* Keep the variables of the same name in the file order */
+	return (va > vb) - (va < vb);
+}
+
+static int procsnap_index_environ(struct procsnap_environ *env)
+{
+	const char *data = env->blob.data, *end = data + env->blob.size;
+	const struct procsnap_var **sorted;
+	struct procsnap_var *vars;
+	size_t count = 0;
+
+	for (const char *str = data; str < end; str += strlen(str) + 1)
+		count++;
+
+	vars = malloc((count > 0 ? count : 1) * sizeof(struct procsnap_var));
+	sorted = malloc((count > 0 ? count : 1) * sizeof(struct procsnap_var *));
+	if (vars == NULL || sorted == NULL) {
+		free(vars);
+		free(sorted);
+		return (-1);
+	}
+
+	for (const char *str = data; str < end; str += strlen(str) + 1) {
+		const char *eq_char = strchr(str, '=');
+
+		/* strange but possible:
+		 * $ strings /proc/1218/environ
+		 * /dev/input/event0 /dev/input/event1 /dev/input/event4 /dev/input/event3
+		 */
+		if (eq_char == NULL)
+			continue;
+
+		vars[env->count].name = str;
+		vars[env->count].name_len = eq_char - str;
+		vars[env->count].value = eq_char + 1;
+		sorted[env->count] = &vars[env->count];
+		env->count++;
+	}
+	qsort(sorted, env->count, sizeof(struct procsnap_var *), var_cmp);
+
+	env->vars = vars;
+	env->sorted = sorted;
+
+	return (0);
+}
+
+int procsnap_pids(const char *prefix, const pid_t **pids, size_t *count)
+{
+	struct procsnap *snap;
+	int err;
+
+	pthread_mutex_lock(&procsnap_lock);
+	snap = procsnap_get(prefix);
+	err = errno;
+	if (snap != NULL) {
+		*pids = snap->pids;
+		*count = snap->count;
+	}
+	pthread_mutex_unlock(&procsnap_lock);
+
+	if (snap == NULL) {
+		errno = err;
+		return (-1);
+	}
+
+	return (0);
+}
+
+void procsnap_prefetch(const char *prefix, unsigned int mask)
+{
+	struct procsnap_prefetch_job job = { .mask = mask };
+	struct procsnap *snap;
+
+	pthread_mutex_lock(&procsnap_lock);
+	snap = procsnap_get(prefix);
+	if (snap != NULL && snap->count > 0)
+		job.procs = calloc(snap->count, sizeof(struct procsnap_proc));
+	if (job.procs == NULL) {
+		/* The files are read one by one when asked for */
+		pthread_mutex_unlock(&procsnap_lock);
+		return;
+	}
+	job.dir_fd = snap->dir_fd;
+	job.count = snap->count;
+	for (size_t i = 0; i < job.count; ++i) {
+		job.procs[i].pid = snap->procs[i].pid;
+		job.procs[i].read = snap->procs[i].read;
+	}
+	pthread_mutex_unlock(&procsnap_lock);
+
+	/* The snapshot stays while the caller holds a reference, the other
+	 * probes can use it meanwhile */
+	oscap_parallel_run((job.count + PROCSNAP_CHUNK - 1) / PROCSNAP_CHUNK,
+	                   procsnap_prefetch_chunk, &job);
+
+	pthread_mutex_lock(&procsnap_lock);
+	for (size_t i = 0; i < job.count; ++i) {
+		struct procsnap_proc *proc = &snap->procs[i], *read = &job.procs[i];
+
+		for (int f = 0; f < PROCSNAP_FILES; ++f) {
+			/* Read blobs always have the data set */
+			if (read->files[f].data == NULL)
+				continue;
+			if (proc->read & PROCSNAP_MASK(f)) {
+				/* Read by another probe meanwhile */
+				if (read->files[f].size > 0)
+					free((char *)read->files[f].data);
+				continue;
+			}
+			proc->files[f] = read->files[f];
+			proc->read |= PROCSNAP_MASK(f);
+		}
+	}
+	pthread_mutex_unlock(&procsnap_lock);
+
+	free(job.procs);
+}
+
+const struct procsnap_blob *procsnap_file(const char *prefix, pid_t pid, procsnap_file_t file)
+{
+	const struct procsnap_blob *blob = NULL;
+	struct procsnap_proc *proc;
+	struct procsnap *snap;
+
+	pthread_mutex_lock(&procsnap_lock);
+	snap = procsnap_get(prefix);
+	proc = snap == NULL ? NULL : procsnap_find(snap, pid);
+	if (proc != NULL)
+		blob = procsnap_proc_file(snap, proc, file);
+	pthread_mutex_unlock(&procsnap_lock);
+
+	return (blob);
+}
+
+const struct procsnap_environ *procsnap_environ(const char *prefix, pid_t pid)
+{
+	struct procsnap_environ *env = NULL;
+	struct procsnap_proc *proc;
+	struct procsnap *snap;
+
+	pthread_mutex_lock(&procsnap_lock);
+	snap = procsnap_get(prefix);
+	proc = snap == NULL ? NULL : procsnap_find(snap, pid);
+	if (proc == NULL) {
+		pthread_mutex_unlock(&procsnap_lock);
+		errno = ESRCH;
+		return (NULL);
+	}
+	if (proc->env == NULL) {
+		env = calloc(1, sizeof(struct procsnap_environ));
+		if (env == NULL)
+			goto fail;
+		env->blob = *procsnap_proc_file(snap, proc, PROCSNAP_ENVIRON);
+		if (env->blob.error == 0 && procsnap_index_environ(env) != 0) {
+			free(env);
+			goto fail;
+		}
+		proc->env = env;
+	}
+	env = proc->env;
+	pthread_mutex_unlock(&procsnap_lock);
+
+	return (env);
+fail:
+	pthread_mutex_unlock(&procsnap_lock);
+	errno = ENOMEM;
+	return (NULL);
+}
+
+size_t procsnap_environ_find(const struct procsnap_environ *env, const char *name, size_t *first)
+{
+	size_t len = strlen(name), lo = 0, hi = env->count, end;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (name_cmp(env->sorted[mid], name, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (end = lo; end < env->count && name_cmp(env->sorted[end], name, len) == 0; ++end)
+		;
+
+	*first = lo;
+	return (end - lo);
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef OPENSCAP_PROCSNAP_H
+#define OPENSCAP_PROCSNAP_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/*
+ * Snapshot of the processes in /proc shared by the probes which look at
+ * running processes.
+ *
+ * The processes are listed once. A file of a process is read when it is
+ * asked for the first time, or together with the same file of all the
+ * other processes by procsnap_prefetch(), and it is kept as read. All of
+ * it lives until the last probe drops its reference, the functions below
+ * may be called only while a reference is held.
+ *
+ * Processes may exit while the snapshot is used, their files have the
+ * error set then.
+ */
+
+/* Files of a process kept in the snapshot */
+typedef enum {
+	PROCSNAP_STAT,
+	PROCSNAP_STATUS,
+	PROCSNAP_CMDLINE,
+	PROCSNAP_ENVIRON,
+	PROCSNAP_LOGINUID,
+	PROCSNAP_MAPS,
+	PROCSNAP_FD,         // targets of the links in the fd directory
+	PROCSNAP_FILES
+} procsnap_file_t;
+
+#define PROCSNAP_MASK(file) (1u << (file))
+
+/* Contents of a file, the lines or NUL separated strings as read */
+struct procsnap_blob {
+	const char *data;    // followed by an extra NUL
+	size_t size;
+	int error;           // errno if the file couldn't be read
+};
+
+/* An environment variable, the value is NUL terminated */
+struct procsnap_var {
+	const char *name;
+	size_t name_len;
+	const char *value;
+};
+
+struct procsnap_environ {
+	struct procsnap_blob blob;
+	const struct procsnap_var *vars;          // in the order of the file
+	const struct procsnap_var **sorted;       // sorted by the name
+	size_t count;
+};
+
+void procsnap_acquire(void);
+void procsnap_release(void);
+
+/*
+ * Get the PIDs of the processes in prefix/proc in ascending order, prefix
+ * may be NULL. Returns -1 with errno set if the directory can't be read.
+ */
+int procsnap_pids(const char *prefix, const pid_t **pids, size_t *count);
+
+/*
+ * Read the files in mask of all the listed processes which weren't read
+ * yet. The processes are divided between parallel threads, the files are
+ * opened relative to the /proc directory.
+ */
+void procsnap_prefetch(const char *prefix, unsigned int mask);
+
+/*
+ * Get a file of a listed process, read it if needed.
+ * Returns NULL if the process wasn't listed.
+ */
+const struct procsnap_blob *procsnap_file(const char *prefix, pid_t pid, procsnap_file_t file);
+
+/*
+ * Get the environment of a listed process, read it if needed.
+ * Returns NULL with errno set to ESRCH if the process wasn't listed, or
+ * to ENOMEM if there isn't enough memory.
+ */
+const struct procsnap_environ *procsnap_environ(const char *prefix, pid_t pid);
+
+/*
+ * Find the variables with the given name. Returns their number, the
+ * variables are at env->sorted[*first] and after it, in the file order.
+ */
+size_t procsnap_environ_find(const struct procsnap_environ *env, const char *name, size_t *first);
+
+#endif /* OPENSCAP_PROCSNAP_H */
@@ -0,0 +1,307 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common/debug_priv.h"
+#include "common/util.h"
+#include "oscap_helpers.h"
+#include "dpkginfo-helper.h"
+
+#define DPKG_STATUS_PATH "/var/lib/dpkg/status"
+
+/* Installed packages sorted by name and architecture */
+static struct dpkginfo_reply_t *dpkg_packages = NULL;
+static size_t dpkg_count = 0;
+
+/* Fields of a paragraph of the status file, they point to the mapped file */
+struct dpkg_paragraph {
+	const char *name, *arch, *version, *status;
+	size_t name_len, arch_len, version_len, status_len;
+};
+
+/*
+ * A package has an installed version unless its state, the last word of
+ * the Status field, says that only the configuration files are left.
+ */
+static bool dpkg_status_installed(const char *status, size_t len)
+{
+	const char *state = status + len;
+
+	while (state > status && state[-1] != ' ')
+		state--;
+	len -= state - status;
+
+	return !(len == strlen("not-installed") && strncmp(state, "not-installed", len) == 0) &&
+	       !(len == strlen("config-files") && strncmp(state, "config-files", len) == 0);
+}
+
+static void dpkg_free_package(struct dpkginfo_reply_t *pkg)
+{
+	free(pkg->name);
+	free(pkg->arch);
+	free(pkg->epoch);
+	free(pkg->release);
+	free(pkg->version);
+	free(pkg->evr);
+}
+
+/* Split [epoch:]upstream_version[-debian_revision] as dpkg does */
+static int dpkg_add_package(const struct dpkg_paragraph *par, size_t *alloc)
+{
+	const char *version = par->version, *end = par->version + par->version_len;
+	const char *colon, *hyphen;
+	struct dpkginfo_reply_t *pkg;
+
+	if (dpkg_count == *alloc) {
+		size_t new_alloc = *alloc ? *alloc * 2 : 1024;
+		void *new_packages = realloc(dpkg_packages, new_alloc * sizeof(struct dpkginfo_reply_t));
+		if (new_packages == NULL) {
+			dE("Can't allocate memory for %zu packages.", new_alloc);
+			return -1;
+		}
+		dpkg_packages = new_packages;
+		*alloc = new_alloc;
+	}
+	pkg = &dpkg_packages[dpkg_count];
+
+	pkg->name = strndup(par->name, par->name_len);
+	pkg->arch = strndup(par->arch != NULL ? par->arch : "", par->arch_len);
+
+	colon = memchr(version, ':', end - version);
+	if (colon != NULL) {
+		pkg->epoch = strndup(version, colon - version);
+		version = colon + 1;
+	} else {
+		pkg->epoch = strdup("0");
+	}
+
+	for (hyphen = end; hyphen > version && hyphen[-1] != '-'; hyphen--)
+		;
+	if (hyphen > version) {
+		pkg->version = strndup(version, hyphen - 1 - version);
+		pkg->release = strndup(hyphen, end - hyphen);
+	} else { /* no release number, probably a native package */
+		pkg->version = strndup(version, end - version);
+		pkg->release = strdup("");
+	}
+
+	pkg->evr = NULL;
+	if (pkg->epoch != NULL && pkg->version != NULL && pkg->release != NULL) {
+		if (hyphen > version)
+			pkg->evr = oscap_sprintf("%s:%s-%s", pkg->epoch, pkg->version, pkg->release);
+		else
+			pkg->evr = oscap_sprintf("%s:%s", pkg->epoch, pkg->version);
+	}
+
+	if (pkg->name == NULL || pkg->arch == NULL || pkg->evr == NULL) {
+		dE("Can't allocate memory for package %.*s.", (int)par->name_len, par->name);
+		dpkg_free_package(pkg);
+		return -1;
+	}
+	dpkg_count++;
+
+	return 0;
+}
+
+static int dpkg_parse_status(const char *data, size_t size)
+{
+	const char *line = data, *end = data + size;
+	struct dpkg_paragraph par;
+	size_t alloc = 0;
+
+	memset(&par, 0, sizeof(par));
+	while (line < end) {
+		const char *eol = memchr(line, '\n', end - line);
+		const char *colon, *value, *value_end;
+
+		if (eol == NULL)
+			eol = end;
+		value_end = eol;
+		while (value_end > line && (value_end[-1] == ' ' || value_end[-1] == '\t' || value_end[-1] == '\r'))
+			value_end--;
+
+		if (value_end == line) {
+			/* An empty line ends the paragraph */
+			if (par.name != NULL && par.version != NULL && par.status != NULL &&
+			    dpkg_status_installed(par.status, par.status_len) &&
+			    dpkg_add_package(&par, &alloc) != 0)
+				return -1;
+			memset(&par, 0, sizeof(par));
+		} else if (*line != ' ' && *line != '\t' &&
+		           (colon = memchr(line, ':', value_end - line)) != NULL) {
+			/* Continuation lines of multiline fields are skipped */
+			value = colon + 1;
+			while (value < value_end && (*value == ' ' || *value == '\t'))
+				value++;
+
+#define DPKG_FIELD(field_name, member) \
+			if ((size_t)(colon - line) == strlen(field_name) && \
+			    strncasecmp(line, field_name, colon - line) == 0) { \
+				par.member = value; \
+				par.member ## _len = value_end - value; \
+			}
+
+			DPKG_FIELD("Package", name)
+			else DPKG_FIELD("Architecture", arch)
+			else DPKG_FIELD("Version", version)
+			else DPKG_FIELD("Status", status)
+#undef DPKG_FIELD
+		}
+
+		line = eol + 1;
+	}
+	if (par.name != NULL && par.version != NULL && par.status != NULL &&
+	    dpkg_status_installed(par.status, par.status_len) &&
+	    dpkg_add_package(&par, &alloc) != 0)
+		return -1;
+
+	return 0;
+}
+
+static int dpkg_package_cmp(const void *a, const void *b)
+{
+	const struct dpkginfo_reply_t *pa = a, *pb = b;
+	int ret = strcmp(pa->name, pb->name);
+
+	return ret != 0 ? ret : strcmp(pa->arch, pb->arch);
+}
+
+int dpkginfo_init(void)
+{
+	const char *root = getenv("OSCAP_PROBE_ROOT");
+	char *path;
+	struct stat st;
+	void *data;
+	int fd, ret;
+
+	path = root != NULL ? oscap_path_join(root, DPKG_STATUS_PATH) : strdup(DPKG_STATUS_PATH);
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		/* Not a Debian system, there are no packages */
+		if (errno == ENOENT) {
+			dD("%s doesn't exist.", path);
+			free(path);
+			return 0;
+		}
+		dE("Can't open %s: %s", path, strerror(errno));
+		free(path);
+		return -1;
+	}
+	if (fstat(fd, &st) != 0) {
+		dE("Can't stat %s: %s", path, strerror(errno));
+		close(fd);
+		free(path);
+		return -1;
+	}
+
+	if (st.st_size > 0) {
+		data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			dE("Can't map %s: %s", path, strerror(errno));
+			close(fd);
+			free(path);
+			return -1;
+		}
+		ret = dpkg_parse_status(data, st.st_size);
+		munmap(data, st.st_size);
+		if (ret != 0) {
+			close(fd);
+			free(path);
+			dpkginfo_fini();
+			return -1;
+		}
+	}
+	close(fd);
+	free(path);
+
+	qsort(dpkg_packages, dpkg_count, sizeof(struct dpkginfo_reply_t), dpkg_package_cmp);
+	dD("Read %zu installed packages.", dpkg_count);
+
+	return 0;
+}
+
+int dpkginfo_fini(void)
+{
+	for (size_t i = 0; i < dpkg_count; i++)
+		dpkg_free_package(&dpkg_packages[i]);
+	free(dpkg_packages);
+	dpkg_packages = NULL;
+	dpkg_count = 0;
+
+	return 0;
+}
+
+const struct dpkginfo_reply_t *dpkginfo_get_all(size_t *count)
+{
+	*count = dpkg_count;
+	return dpkg_packages;
+}
+
+const struct dpkginfo_reply_t *dpkginfo_get_by_name(const char *name, size_t *count)
+{
+	const char *arch = NULL;
+	size_t name_len = strlen(name), first = 0, last = dpkg_count;
+
+	/* Package names can't contain a colon, the rest is an architecture */
+	const char *colon = strchr(name, ':');
+	if (colon != NULL) {
+		name_len = colon - name;
+		arch = colon + 1;
+	}
+
+	/* Find the range of the packages of the name */
+	while (first < last) {
+		size_t mid = first + (last - first) / 2;
+		int cmp = strncmp(dpkg_packages[mid].name, name, name_len);
+
+		if (cmp < 0)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+	for (last = first; last < dpkg_count; last++) {
+		if (strncmp(dpkg_packages[last].name, name, name_len) != 0 ||
+		    dpkg_packages[last].name[name_len] != '\0')
+			break;
+	}
+
+	if (arch != NULL) {
+		while (first < last && strcmp(dpkg_packages[first].arch, arch) != 0)
+			first++;
+		if (first < last)
+			last = first + 1;
+	}
+
+	*count = last - first;
+	return *count > 0 ? &dpkg_packages[first] : NULL;
+}
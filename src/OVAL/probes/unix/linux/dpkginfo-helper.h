@@ -22,10 +22,16 @@
 #ifndef __DPKGINFO_HELPER__
 #define __DPKGINFO_HELPER__
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+ * Installed package of the dpkg status database. The version is split
+ * when the database is read, the strings are owned by the database.
+ */
 struct dpkginfo_reply_t {
         char *name;
         char *arch;
@@ -35,12 +41,21 @@ struct dpkginfo_reply_t {
         char *evr;
 };
 
-int dpkginfo_init();
-int dpkginfo_fini();
+/*
+ * Read the dpkg status database of the scanned system, it's kept until
+ * dpkginfo_fini(). The packages can be looked up from any thread then.
+ */
+int dpkginfo_init(void);
+int dpkginfo_fini(void);
 
-struct dpkginfo_reply_t * dpkginfo_get_by_name(const char *name, int *err);
+/* Get all the installed packages, sorted by name and architecture */
+const struct dpkginfo_reply_t *dpkginfo_get_all(size_t *count);
 
-void dpkginfo_free_reply(struct dpkginfo_reply_t *reply);
+/*
+ * Get the installed packages of the given name, NULL if there are none.
+ * The name may be qualified by an architecture as in "name:arch".
+ */
+const struct dpkginfo_reply_t *dpkginfo_get_by_name(const char *name, size_t *count);
 
 #ifdef __cplusplus
 }
@@ -49,6 +49,7 @@
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
+#include <stdbool.h>
 
 /* SEAP */
 #include "_seap.h"
@@ -58,6 +59,7 @@
 #include "public/oval_schema_version.h"
 
 #include <probe/probe.h>
+#include "probe/entcmp.h"
 
 #include "dpkginfo-helper.h"
 
@@ -65,7 +67,6 @@
 
 struct dpkginfo_global {
         int init_done;
-        pthread_mutex_t mutex;
 };
 
 static struct dpkginfo_global g_dpkg = {
@@ -78,8 +79,6 @@ int dpkginfo_probe_offline_mode_supported(void) {
 
 void *dpkginfo_probe_init(void)
 {
-        pthread_mutex_init (&(g_dpkg.mutex), NULL);
-
         g_dpkg.init_done = dpkginfo_init();
         if (g_dpkg.init_done < 0) {
                 dE("dpkginfo_init has failed.");
@@ -90,20 +89,35 @@ void *dpkginfo_probe_init(void)
 
 void dpkginfo_probe_fini (void *ptr)
 {
-        struct dpkginfo_global *d = (struct dpkginfo_global *)ptr;
-
         dpkginfo_fini();
-        pthread_mutex_destroy (&(d->mutex));
 
         return;
 }
 
+static void dpkginfo_collect(probe_ctx *ctx, const struct dpkginfo_reply_t *dpkginfo_reply,
+		oval_datatype_t evr_string_type)
+{
+	SEXP_t *item;
+
+	dD("%s: element found version %s", dpkginfo_reply->name, dpkginfo_reply->evr);
+	item = probe_item_create (OVAL_LINUX_DPKG_INFO, NULL,
+			"name", OVAL_DATATYPE_STRING, dpkginfo_reply->name,
+			"arch", OVAL_DATATYPE_STRING, dpkginfo_reply->arch,
+			"epoch", OVAL_DATATYPE_STRING, dpkginfo_reply->epoch,
+			"release", OVAL_DATATYPE_STRING, dpkginfo_reply->release,
+			"version", OVAL_DATATYPE_STRING, dpkginfo_reply->version,
+			"evr", evr_string_type, dpkginfo_reply->evr,
+			NULL);
+
+	probe_item_collect(ctx, item);
+}
+
 int dpkginfo_probe_main (probe_ctx *ctx, void *arg)
 {
-	SEXP_t *val, *item, *ent, *obj;
-        char *request_st = NULL;
-        struct dpkginfo_reply_t *dpkginfo_reply = NULL;
-        int errflag;
+	SEXP_t *val, *vals, *ent, *obj;
+	const struct dpkginfo_reply_t *dpkginfo_reply, **found = NULL;
+	size_t count, found_cnt = 0, i, j;
+	oval_datatype_t evr_string_type;
 
 	if (arg == NULL) {
 		return PROBE_EINIT;
@@ -121,85 +135,69 @@ int dpkginfo_probe_main (probe_ctx *ctx, void *arg)
                 return (PROBE_ENOENT);
         }
 
-        val = probe_ent_getval (ent);
-
-        if (val == NULL) {
-                dD("%s: no value", "name");
-                SEXP_free (ent);
-                return (PROBE_ENOVAL);
-        }
-
-        request_st = SEXP_string_cstr (val);
-        SEXP_free (val);
-
-        if (request_st == NULL) {
-                switch (errno) {
-                case EINVAL:
-                        dD("%s: invalid value type", "name");
-			return PROBE_EINVAL;
-                        break;
-                case EFAULT:
-                        dD("%s: element not found", "name");
-			return PROBE_ENOELM;
-                        break;
-		default:
-			return PROBE_EUNKNOWN;
-                }
-        }
+	oval_schema_version_t oval_version = probe_obj_get_platform_schema_version(obj);
+	if (oval_schema_version_cmp(oval_version, OVAL_SCHEMA_VERSION(5.11.1)) >= 0) {
+		evr_string_type = OVAL_DATATYPE_DEBIAN_EVR_STRING;
+	} else {
+		evr_string_type = OVAL_DATATYPE_EVR_STRING;
+	}
 
-        /* get info from debian apt cache */
-        pthread_mutex_lock (&(g_dpkg.mutex));
-        dpkginfo_reply = dpkginfo_get_by_name(request_st, &errflag);
-        pthread_mutex_unlock (&(g_dpkg.mutex));
-
-        if (dpkginfo_reply == NULL) {
-                switch (errflag) {
-		case 0: /* Not found */
-		{
-			dD("Package \"%s\" not found.", request_st);
-			break;
+	/*
+	 * The packages of the given names are looked up in the index of the
+	 * status database, other operations are compared with every package.
+	 * The database doesn't change during the scan, no locking is needed.
+	 */
+	if (probe_entobj_equals_values(ent)) {
+		if (probe_ent_getvals(ent, &vals) == 0) {
+			dD("%s: no value", "name");
+			SEXP_free(vals);
+			SEXP_free(ent);
+			return (PROBE_ENOVAL);
 		}
-		case -1: /* Error */
-		{
-			dD("dpkginfo_get_by_name failed.");
-			item = probe_item_create(OVAL_LINUX_DPKG_INFO, NULL,
-					"name", OVAL_DATATYPE_STRING, request_st,
-					NULL);
-			probe_item_setstatus (item, SYSCHAR_STATUS_ERROR);
-			probe_item_collect(ctx, item);
-			break;
+		SEXP_list_foreach(val, vals) {
+			char *request_st;
+
+			/* A name given more times doesn't match only_one */
+			if (!SEXP_stringp(val) || probe_entobj_cmp(ent, val) != OVAL_RESULT_TRUE)
+				continue;
+			request_st = SEXP_string_cstr(val);
+			dpkginfo_reply = dpkginfo_get_by_name(request_st, &count);
+			if (dpkginfo_reply == NULL)
+				dD("Package \"%s\" not found.", request_st);
+			for (i = 0; i < count; ++i) {
+				/* A variable may give the same name more times */
+				for (j = 0; j < found_cnt && found[j] != &dpkginfo_reply[i]; ++j)
+					;
+				if (j < found_cnt)
+					continue;
+				void *new_found = realloc(found, (found_cnt + 1) * sizeof(*found));
+				if (new_found == NULL) {
+					dE("Can't allocate memory for found packages.");
+					free(request_st);
+					SEXP_free(vals);
+					SEXP_free(ent);
+					free(found);
+					return (PROBE_ENOMEM);
+				}
+				found = new_found;
+				found[found_cnt++] = &dpkginfo_reply[i];
+				dpkginfo_collect(ctx, &dpkginfo_reply[i], evr_string_type);
+			}
+			free(request_st);
 		}
-                }
-        } else { /* Ok */
-                int i;
-                int num_items = 1; /* FIXME */
-		oval_datatype_t evr_string_type;
-		oval_schema_version_t oval_version = probe_obj_get_platform_schema_version(obj);
-		if (oval_schema_version_cmp(oval_version, OVAL_SCHEMA_VERSION(5.11.1)) >= 0) {
-			evr_string_type = OVAL_DATATYPE_DEBIAN_EVR_STRING;
-		} else {
-			evr_string_type = OVAL_DATATYPE_EVR_STRING;
+		SEXP_free(vals);
+		free(found);
+	} else {
+		dpkginfo_reply = dpkginfo_get_all(&count);
+		for (i = 0; i < count; ++i) {
+			val = SEXP_string_newf("%s", dpkginfo_reply[i].name);
+			if (probe_entobj_cmp(ent, val) == OVAL_RESULT_TRUE)
+				dpkginfo_collect(ctx, &dpkginfo_reply[i], evr_string_type);
+			SEXP_free(val);
 		}
-
-                for (i = 0; i < num_items; ++i) {
-                        dD("%s: element found version %s", dpkginfo_reply->name, dpkginfo_reply->evr);
-                        item = probe_item_create (OVAL_LINUX_DPKG_INFO, NULL,
-                                        "name", OVAL_DATATYPE_STRING, dpkginfo_reply->name,
-                                        "arch", OVAL_DATATYPE_STRING, dpkginfo_reply->arch,
-                                        "epoch", OVAL_DATATYPE_STRING, dpkginfo_reply->epoch,
-                                        "release", OVAL_DATATYPE_STRING, dpkginfo_reply->release,
-                                        "version", OVAL_DATATYPE_STRING, dpkginfo_reply->version,
-					"evr", evr_string_type, dpkginfo_reply->evr,
-                                        NULL);
-
-			probe_item_collect(ctx, item);
-
-                        dpkginfo_free_reply(dpkginfo_reply);
-                }
-        }
+	}
 
 	SEXP_free(ent);
-        free(request_st);
 
         return (0);
 }
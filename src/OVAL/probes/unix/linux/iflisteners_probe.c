@@ -63,6 +63,7 @@
 
 #include "iflisteners-proto.h"
 #include "iflisteners_probe.h"
+#include "sock-diag.h"
 
 /* Convenience structure for the results being reported */
 struct result_info {
@@ -71,235 +72,14 @@ struct result_info {
 	const char *hw_address;
 };
 
-/* This structure is used to store information from scanning all runnning
- * processes. It will be used later to augment server info */
-typedef struct _lnode {
-  pid_t pid;            // process ID
-  uid_t uid;            // effective user ID
-  char *cmd;            // command run by user
-  unsigned long inode;  // inode of socket
-  struct _lnode* next;  // Next node pointer
-} lnode;
-
-/* This is the linked list head. Only data elements go here. */
-typedef struct {
-  lnode *head;          // List head
-  lnode *cur;           // Pointer to current node
-} llist;
-
 struct interface_t {
   char interface_name[255];
   char hw_address[255];
 };
 
-/* Local data */
-static int perm_warn = 0;
-
-/* Function prototypes */
-static inline lnode *list_get_cur(llist *l) { return l->cur; }
-static void list_create(llist *l);
-static void list_append(llist *l, lnode *node);
-static void list_clear(llist* l);
-static lnode *list_find_inode(llist *l, unsigned long i);
-
-
-static void list_create(llist *l)
-{
-	l->head = NULL;
-	l->cur = NULL;
-}
-
-static void list_append(llist *l, lnode *node)
-{
-	lnode* newnode;
-
-	if (node == NULL || l == NULL)
-		return;
-
-	newnode = malloc(sizeof(lnode));
-	if (newnode == NULL)
-		return;
-
-	newnode->pid = node->pid;
-	newnode->uid = node->uid;
-	newnode->inode = node->inode;
-	// Take custody of the memory
-	newnode->cmd = node->cmd;
-	newnode->next = NULL;
-
-	// if we are at top, fix this up
-	if (l->head == NULL)
-		l->head = newnode;
-	else	// Otherwise add pointer to newnode
-		l->cur->next = newnode;
-
-	// make newnode current
-	l->cur = newnode;
-}
-
-static void list_clear(llist* l)
-{
-	lnode* nextnode;
-	register lnode* cur;
-
-	cur = l->head;
-	while (cur) {
-		nextnode=cur->next;
-		free(cur->cmd);
-		free(cur);
-		cur=nextnode;
-	}
-	l->head = NULL;
-	l->cur = NULL;
-}
-
-static lnode *list_find_inode(llist *l, unsigned long i)
-{
-        register lnode* cur;
-
-	cur = l->head;	/* start at the beginning */
-	while (cur) {
-		if (cur->inode == i) {
-			l->cur = cur;
-			return cur;
-		} else
-			cur = cur->next;
-	}
-	return NULL;
-}
-
-static int collect_process_info(llist *l)
-{
-	DIR *d, *f;
-	struct dirent *ent;
-
-	d = opendir("/proc");
-	if (d == NULL)
-		return 1;
-
-	while (( ent = readdir(d) )) {
-		FILE *sf;
-		int pid, ppid;
-		char buf[100];
-		char *tmp, cmd[16], state, *text = NULL;
-		int fd, len, euid = 0;
-
-		// Skip non-process dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno)
-			continue;
-
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd, 0, sizeof(cmd));
-		sscanf(buf, "%d (%15c", &ppid, cmd);
-		sscanf(tmp+2, "%c %d", &state, &ppid);
-
-		// Skip kthreads
-		if (pid == 2 || ppid == 2)
-			continue;
-
-		// Get the effective uid
-		snprintf(buf, 32, "/proc/%d/status", pid);
-		sf = fopen(buf, "rt");
-		if (sf) {
-			int line = 0;
-			__fsetlocking(sf, FSETLOCKING_BYCALLER);
-			while (fgets(buf, sizeof(buf), sf)) {
-				if (line == 0) {
-					line++;
-					continue;
-				}
-				if (memcmp(buf, "Uid:", 4) == 0) {
-					int id;
-					sscanf(buf, "Uid: %d %d",
-						&id, &euid);
-					break;
-				}
-			}
-			fclose(sf);
-		}
-
-		// Now lets get the inodes each process has open
-		snprintf(buf, 32, "/proc/%d/fd", pid);
-		f = opendir(buf);
-		if (f == NULL) {
-			if (errno == EACCES && perm_warn == 0) {
-				/* Need DAC_OVERRIDE permission */
-				perm_warn = 1;
-			}
-			// Process might have ended or something - ignore it
-			free(text);
-			continue;
-		}
-		// For each file in the fd dir...
-		while (( ent = readdir(f) )) {
-			char line[PATH_MAX], ln[PATH_MAX], *s, *e;
-			unsigned long inode;
-			lnode node;
-			int lnlen;
-
-			if (ent->d_name[0] == '.')
-				continue;
-			snprintf(ln, PATH_MAX, "%s/%s", buf, ent->d_name);
-			if ((lnlen = readlink(ln, line, sizeof(line)-1)) < 0)
-				continue;
-			line[lnlen] = 0;
-
-			// Only look at the socket entries
-			if (memcmp(line, "socket:", 7) == 0) {
-				// Type 1 sockets
-				s = strchr(line+7, '[');
-				if (s == NULL)
-					continue;
-				s++;
-				e = strchr(s, ']');
-				if (e == NULL)
-					continue;
-				*e = 0;
-			} else if (memcmp(line, "[0000]:", 7) == 0) {
-				// Type 2 sockets
-				s = line + 8;
-			} else
-				continue;
-			errno = 0;
-			inode = strtoul(s, NULL, 10);
-			if (errno)
-				continue;
-			node.pid = pid;
-			node.uid = euid;
-			node.cmd = strdup(cmd);
-			node.inode = inode;
-			// We make one entry for each socket inode
-			list_append(l, &node);
-		}
-		closedir(f);
-		free(text);
-	}
-	closedir(d);
-	return 0;
-}
-
-static void report_finding(struct result_info *res, llist *l, probe_ctx *ctx, oval_schema_version_t over)
+static void report_finding(struct result_info *res, const struct sock_owner *n, probe_ctx *ctx, oval_schema_version_t over)
 {
         SEXP_t *item, *user_id;
-	lnode *n = list_get_cur(l);
 
 	if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) < 0)
 		user_id = SEXP_string_newf("%d", n->uid);
@@ -375,7 +155,34 @@ static int get_interface(const int ent_ifindex, struct interface_t *interface) {
 	return 0;
 }
 
-static int read_packet(llist *l, probe_ctx *ctx, oval_schema_version_t over, SEXP_t *interface_name_ent)
+static void report_packet(const struct sock_owners *owners, probe_ctx *ctx, oval_schema_version_t over,
+	SEXP_t *interface_name_ent, unsigned long inode, int ifindex, unsigned proto_num)
+{
+	const struct sock_owner *n;
+	struct interface_t interface;
+
+	n = sock_owners_find(owners, inode);
+	if (n && get_interface(ifindex, &interface)) {
+		struct result_info r;
+		SEXP_t *r0;
+		dI("Have interface_name: %s, hw_address: %s",
+				interface.interface_name, interface.hw_address);
+
+		r0 = SEXP_string_newf("%s", interface.interface_name);
+		if (probe_entobj_cmp(interface_name_ent, r0) != OVAL_RESULT_TRUE) {
+			SEXP_free(r0);
+			return;
+		}
+		SEXP_free(r0);
+
+		r.interface_name = interface.interface_name;
+		r.protocol = oscap_enum_to_string(ProtocolType, proto_num);
+		r.hw_address = interface.hw_address;
+		report_finding(&r, n, ctx, over);
+	}
+}
+
+static int read_packet(const struct sock_owners *owners, probe_ctx *ctx, oval_schema_version_t over, SEXP_t *interface_name_ent)
 {
 	int line = 0;
 	FILE *f;
@@ -385,8 +192,6 @@ static int read_packet(llist *l, probe_ctx *ctx, oval_schema_version_t over, SEX
 	int refcnt, sk_type, ifindex, running;
 	unsigned long inode;
 	unsigned rmem, uid, proto_num;
-	struct interface_t interface;
-
 
 	f = fopen("/proc/net/packet", "rt");
 	if (f == NULL) {
@@ -406,34 +211,45 @@ static int read_packet(llist *l, probe_ctx *ctx, oval_schema_version_t over, SEX
 			"%p %d %d %04x %d %d %u %u %lu\n",
 			&s, &refcnt, &sk_type, &proto_num, &ifindex, &running, &rmem, &uid, &inode
 		);
-		if (list_find_inode(l, inode) && get_interface(ifindex, &interface)) {
-			struct result_info r;
-			SEXP_t *r0;
-			dI("Have interface_name: %s, hw_address: %s",
-					interface.interface_name, interface.hw_address);
-
-			r0 = SEXP_string_newf("%s", interface.interface_name);
-			if (probe_entobj_cmp(interface_name_ent, r0) != OVAL_RESULT_TRUE) {
-				SEXP_free(r0);
-				continue;
-			}
-			SEXP_free(r0);
-
-			r.interface_name = interface.interface_name;
-			r.protocol = oscap_enum_to_string(ProtocolType, proto_num);
-			r.hw_address = interface.hw_address;
-			report_finding(&r, l, ctx, over);
-		}
+		report_packet(owners, ctx, over, interface_name_ent, inode, ifindex, proto_num);
 	}
 	fclose(f);
 	return 0;
 }
 
+struct diag_info {
+	const struct sock_owners *owners;
+	probe_ctx *ctx;
+	oval_schema_version_t over;
+	SEXP_t *interface_name_ent;
+};
+
+static void diag_packet(const struct packet_diag_msg *msg, const struct packet_diag_info *pinfo, void *arg)
+{
+	struct diag_info *info = arg;
+
+	if (pinfo == NULL)
+		return;
+	report_packet(info->owners, info->ctx, info->over, info->interface_name_ent,
+		msg->pdiag_ino, pinfo->pdi_index, msg->pdiag_num);
+}
+
+void *iflisteners_probe_init(void)
+{
+	sock_owners_acquire();
+	return NULL;
+}
+
+void iflisteners_probe_fini(void *arg)
+{
+	sock_owners_release();
+}
+
 int iflisteners_probe_main(probe_ctx *ctx, void *arg)
 {
         SEXP_t *object;
 	int err;
-	llist ll;
+	const struct sock_owners *owners;
 	oval_schema_version_t over;
 
         object = probe_ctx_getobject(ctx);
@@ -446,8 +262,8 @@ int iflisteners_probe_main(probe_ctx *ctx, void *arg)
 	}
 
 	// Now start collecting the info
-	list_create(&ll);
-	if (collect_process_info(&ll) || perm_warn) {
+	owners = sock_owners_get();
+	if (owners == NULL || owners->denied) {
 		SEXP_t *msg;
 
 		msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_ERROR, "Permission error.");
@@ -459,9 +275,15 @@ int iflisteners_probe_main(probe_ctx *ctx, void *arg)
 		goto cleanup;
 	}
 
-	read_packet(&ll, ctx, over, interface_name_ent);
-
-	list_clear(&ll);
+	struct diag_info info = {
+		.owners = owners,
+		.ctx = ctx,
+		.over = over,
+		.interface_name_ent = interface_name_ent,
+	};
+	// Enumerate the packet sockets, fall back to /proc/net/packet
+	if (sock_diag_packet(diag_packet, &info) != 0)
+		read_packet(owners, ctx, over, interface_name_ent);
 
 	err = 0;
  cleanup:
@@ -50,10 +50,6 @@
 #endif
 
 
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-#include <blkid/blkid.h>
-#endif
-
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
@@ -66,16 +62,13 @@
 #include <pcre.h>
 
 #include "common/debug_priv.h"
+#include "fsdev.h"
 #include "partition_probe.h"
 
 #ifndef MTAB_PATH
 # define MTAB_PATH "/proc/mounts"
 #endif
 
-#ifndef MTAB_LINE_MAX
-# define MTAB_LINE_MAX 4096
-#endif
-
 const char *__OVAL_fs_types[][2] = {
 	{ "adfs",       "ADFS_SUPER_MAGIC" },
 	{ "affs",       "AFFS_SUPER_MAGIC" },
@@ -150,25 +143,22 @@ static uint8_t add_mnt_opt(char ***mnt_opts, uint8_t mnt_ocnt, char *opt)
 	return mnt_ocnt + 1;
 }
 
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-static int collect_item(probe_ctx *ctx, oval_schema_version_t over, struct mntent *mnt_ent, blkid_cache blkcache)
-#else
-static int collect_item(probe_ctx *ctx, oval_schema_version_t over, struct mntent *mnt_ent)
-#endif
+static int collect_item(probe_ctx *ctx, oval_schema_version_t over, fsmounts_t *mounts, size_t index)
 {
         SEXP_t *item;
-        char   *uuid = "", *tok, *save = NULL, **mnt_opts = NULL;
-        char path[PATH_MAX];
+        const fsmount_t *mnt_ent = fsmounts_entry(mounts, index);
+        const char *uuid = "", *fs_type = mnt_ent->type;
+        char   *uuid_buf = NULL;
+        char   *tok, *save = NULL, **mnt_opts = NULL, *opts;
         uint8_t mnt_ocnt;
         struct statvfs stvfs;
 
         /*
          * Get FS stats
          */
-        const char *prefix = getenv("OSCAP_PROBE_ROOT");
-        snprintf(path, PATH_MAX, "%s%s", prefix ? prefix : "", mnt_ent->mnt_dir);
-        if (statvfs(path, &stvfs) != 0) {
-                dE("Can't statvfs %s: errno=%d, %s.", path, errno, strerror(errno));
+        if (fsmounts_statvfs(mounts, index, &stvfs) != 0) {
+                const char *prefix = getenv("OSCAP_PROBE_ROOT");
+                dE("Can't statvfs %s%s: errno=%d, %s.", prefix ? prefix : "", mnt_ent->dir, errno, strerror(errno));
                 return (-1);
         }
 
@@ -176,17 +166,21 @@ static int collect_item(probe_ctx *ctx, oval_schema_version_t over, struct mnten
          * Get UUID
          */
 #if defined(HAVE_BLKID_GET_TAG_VALUE)
-        uuid = blkid_get_tag_value(blkcache, "UUID", mnt_ent->mnt_fsname);
-        if (uuid == NULL) {
-	        uuid = "";
+        if (fsmounts_uuid(mounts, index, &uuid_buf) != 0) {
+                dE("Can't copy the UUID of %s: errno=%d, %s.", mnt_ent->fsname, errno, strerror(errno));
+                return (-1);
+        }
+        if (uuid_buf != NULL) {
+	        uuid = uuid_buf;
         }
 #endif
         /*
          * Create a NULL-terminated array from the mount options
          */
         mnt_ocnt = 0;
+        opts = strdup(mnt_ent->opts);
 
-        tok = strtok_r(mnt_ent->mnt_opts, ",", &save);
+        tok = strtok_r(opts, ",", &save);
 
         do {
             mnt_ocnt = add_mnt_opt(&mnt_opts, mnt_ocnt, tok);
@@ -214,16 +208,16 @@ static int collect_item(probe_ctx *ctx, oval_schema_version_t over, struct mnten
 	 * of OVAL)
 	 */
         if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) < 0)
-	        mnt_ent->mnt_type = (char *)correct_fstype(mnt_ent->mnt_type);
+	        fs_type = correct_fstype(mnt_ent->type);
 
         /*
          * Create the item
          */
         item = probe_item_create(OVAL_LINUX_PARTITION, NULL,
-                                 "mount_point",   OVAL_DATATYPE_STRING,   mnt_ent->mnt_dir,
-                                 "device",        OVAL_DATATYPE_STRING,   mnt_ent->mnt_fsname,
+                                 "mount_point",   OVAL_DATATYPE_STRING,   mnt_ent->dir,
+                                 "device",        OVAL_DATATYPE_STRING,   mnt_ent->fsname,
                                  "uuid",          OVAL_DATATYPE_STRING,   uuid,
-                                 "fs_type",       OVAL_DATATYPE_STRING,   mnt_ent->mnt_type,
+                                 "fs_type",       OVAL_DATATYPE_STRING,   fs_type,
                                  "mount_options", OVAL_DATATYPE_STRING_M, mnt_opts,
                                  "total_space",   OVAL_DATATYPE_INTEGER, (int64_t)stvfs.f_blocks,
                                  "space_used",    OVAL_DATATYPE_INTEGER, (int64_t)(stvfs.f_blocks - stvfs.f_bfree),
@@ -252,6 +246,8 @@ static int collect_item(probe_ctx *ctx, oval_schema_version_t over, struct mnten
 
         probe_item_collect(ctx, item);
         free(mnt_opts);
+        free(opts);
+        free(uuid_buf);
 
         return (0);
 }
@@ -267,7 +263,7 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
         SEXP_t *mnt_entity, *mnt_opval, *mnt_entval, *probe_in;
         char    mnt_path[PATH_MAX];
         oval_operation_t mnt_op;
-        FILE *mnt_fp;
+        fsmounts_t *mounts;
         oval_schema_version_t obj_over;
 
         const char *prefix = getenv("OSCAP_PROBE_ROOT");
@@ -290,33 +286,29 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
                 return (prefix ? PROBE_ESUCCESS : PROBE_ESYSTEM);
         }
 
+        close(mnt_fd);
+
         if (stfs.f_type != PROC_SUPER_MAGIC) {
-                close(mnt_fd);
                 return (prefix ? PROBE_ESUCCESS : PROBE_EFATAL);
         }
+#endif
+        /*
+         * The mount table is read once and shared with the other objects
+         * and probes of the scan
+         */
+        mounts = fsmounts_get(mnt_path, prefix ? prefix : "");
 
-        mnt_fp = fdopen(mnt_fd, "r");
-
-        if (mnt_fp == NULL) {
-                close(mnt_fd);
-                return (prefix ? PROBE_ESUCCESS : PROBE_ESYSTEM);
-        }
-#else
-        mnt_fp = fopen(mnt_path, "r");
-
-        if (mnt_fp == NULL) {
+        if (mounts == NULL) {
                 if (!prefix)
                         dE("Can't open %s: errno=%d, %s.", mnt_path, errno, strerror(errno));
                 return (prefix ? PROBE_ESUCCESS : PROBE_ESYSTEM);
         }
-#endif
 
         probe_in   = probe_ctx_getobject(ctx);
         obj_over   = probe_obj_get_platform_schema_version(probe_in);
         mnt_entity = probe_obj_getent(probe_in, "mount_point", 1);
 
         if (mnt_entity == NULL) {
-                fclose(mnt_fp);
                 return (PROBE_ENOENT);
         }
 
@@ -333,7 +325,6 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
         if (!SEXP_stringp(mnt_entval)) {
                 SEXP_free(mnt_entval);
                 SEXP_free(mnt_entity);
-		fclose(mnt_fp);
                 return (PROBE_EINVAL);
         }
 
@@ -341,87 +332,50 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
         SEXP_free(mnt_entval);
         SEXP_free(mnt_entity);
 
-        if (mnt_fp != NULL) {
-                char buffer[MTAB_LINE_MAX];
-                struct mntent mnt_ent, *mnt_entp;
+        pcre *re = NULL;
+        const char *estr = NULL;
+        int eoff = -1;
 
-                pcre *re = NULL;
-                const char *estr = NULL;
-                int eoff = -1;
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-                blkid_cache blkcache;
+        if (mnt_op == OVAL_OPERATION_PATTERN_MATCH) {
+                re = pcre_compile(mnt_path, PCRE_UTF8, &estr, &eoff, NULL);
 
-                if (blkid_get_cache(&blkcache, NULL) != 0) {
-                        endmntent(mnt_fp);
-                        return (PROBE_EUNKNOWN);
+                if (re == NULL) {
+                        return (PROBE_EINVAL);
                 }
-#endif
-                if (mnt_op == OVAL_OPERATION_PATTERN_MATCH) {
-                        re = pcre_compile(mnt_path, PCRE_UTF8, &estr, &eoff, NULL);
+        }
 
-                        if (re == NULL) {
-                                endmntent(mnt_fp);
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-                                blkid_put_cache(blkcache);
-#endif
-                                return (PROBE_EINVAL);
-                        }
-                }
+        for (size_t i = 0; i < fsmounts_count(mounts); ++i) {
+                const fsmount_t *mnt_entp = fsmounts_entry(mounts, i);
 
-                while ((mnt_entp = getmntent_r(mnt_fp, &mnt_ent,
-                                               buffer, sizeof buffer)) != NULL)
-                {
-			if (strcmp(mnt_entp->mnt_type, "rootfs") == 0)
-			    continue;
+                if (strcmp(mnt_entp->type, "rootfs") == 0)
+                        continue;
 
-                        if (mnt_op == OVAL_OPERATION_EQUALS) {
-                                if (strcmp(mnt_entp->mnt_dir, mnt_path) == 0) {
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-	                                collect_item(ctx, obj_over, mnt_entp, blkcache);
-#else
-	                                collect_item(ctx, obj_over, mnt_entp);
-#endif
+                if (mnt_op == OVAL_OPERATION_EQUALS) {
+                        if (strcmp(mnt_entp->dir, mnt_path) == 0) {
+                                collect_item(ctx, obj_over, mounts, i);
+                                break;
+                        }
+                } else if (mnt_op == OVAL_OPERATION_NOT_EQUAL) {
+                        if (strcmp(mnt_entp->dir, mnt_path) != 0) {
+                                if (collect_item(ctx, obj_over, mounts, i) != 0)
                                         break;
-                                }
-			} else if (mnt_op == OVAL_OPERATION_NOT_EQUAL) {
-				if (strcmp(mnt_entp->mnt_dir, mnt_path) != 0) {
-					if (
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-						collect_item(ctx, obj_over, mnt_entp, blkcache)
-#else
-						collect_item(ctx, obj_over, mnt_entp)
-#endif
-					!= 0)
-						break;
-                                }
-                        } else if (mnt_op == OVAL_OPERATION_PATTERN_MATCH) {
-                                int rc;
+                        }
+                } else if (mnt_op == OVAL_OPERATION_PATTERN_MATCH) {
+                        int rc;
 
-                                rc = pcre_exec(re, NULL, mnt_entp->mnt_dir,
-                                               strlen(mnt_entp->mnt_dir), 0, 0, NULL, 0);
+                        rc = pcre_exec(re, NULL, mnt_entp->dir,
+                                       strlen(mnt_entp->dir), 0, 0, NULL, 0);
 
-                                if (rc == 0) {
-	                                if (
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-		                                collect_item(ctx, obj_over, mnt_entp, blkcache)
-#else
-		                                collect_item(ctx, obj_over, mnt_entp)
-#endif
-                                        != 0)
-		                                break;
-                                }
-                                /* XXX: check for pcre_exec error */
+                        if (rc == 0) {
+                                if (collect_item(ctx, obj_over, mounts, i) != 0)
+                                        break;
                         }
+                        /* XXX: check for pcre_exec error */
                 }
-
-                endmntent(mnt_fp);
-
-                if (mnt_op == OVAL_OPERATION_PATTERN_MATCH)
-                        pcre_free(re);
-#if defined(HAVE_BLKID_GET_TAG_VALUE)
-                blkid_put_cache(blkcache);
-#endif
         }
 
+        if (mnt_op == OVAL_OPERATION_PATTERN_MATCH)
+                pcre_free(re);
+
         return (probe_ret);
 }
@@ -24,6 +24,40 @@
 #include <config.h>
 #endif
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "common/list.h"
+#include "oscap_helpers.h"
+
+/* First line of the verification cache file */
+#define RPMVERIFY_CACHE_MAGIC "# oscap rpmverify cache 1"
+
+/* Result of the digest check of a file in the given state */
+struct rpmverify_cache_entry {
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	struct timespec mtime;
+	struct timespec ctime;
+	char *digest;         // digest of the file in the package
+	int digest_differs;
+	bool used;            // looked up or stored during this scan
+};
+
+static pthread_mutex_t rpmverify_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int rpmverify_cache_refs = 0;
+static struct oscap_htable *rpmverify_cache = NULL; // path -> entry
+static char *rpmverify_cache_path = NULL;
+static bool rpmverify_cache_dirty = false;
+static size_t rpmverify_cache_loaded = 0;
+static size_t rpmverify_cache_used = 0;
+
 #ifdef RPM46_FOUND
 int rpmErrorCb (rpmlogRec rec, rpmlogCallbackData data)
 {
@@ -51,3 +85,260 @@ void rpmLibsPreload()
 	const char* rcfiles = "";
 	rpmReadConfigFiles(rcfiles, NULL);
 }
+
+static void rpmverify_cache_entry_free(void *ptr)
+{
+	struct rpmverify_cache_entry *entry = ptr;
+
+	if (entry == NULL)
+		return;
+	free(entry->digest);
+	free(entry);
+}
+
+static size_t rpmverify_cache_load(struct oscap_htable *cache, const char *path)
+{
+	size_t count = 0;
+	char line[PATH_MAX + 512];
+	struct stat st;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (fp == NULL) {
+		if (errno != ENOENT)
+			dW("Can't open rpmverify cache %s: %s", path, strerror(errno));
+		return 0;
+	}
+	/* Anybody who can write the cache can hide changed files */
+	if (fstat(fileno(fp), &st) != 0 || st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH))) {
+		dW("Ignoring rpmverify cache %s, it is not owned by us or it is writable by others", path);
+		fclose(fp);
+		return 0;
+	}
+	if (fgets(line, sizeof line, fp) == NULL || strncmp(line, RPMVERIFY_CACHE_MAGIC "\n", sizeof line) != 0) {
+		dW("Ignoring rpmverify cache %s, unknown format", path);
+		fclose(fp);
+		return 0;
+	}
+
+	while (fgets(line, sizeof line, fp) != NULL) {
+		unsigned long long dev, ino;
+		long long size, mtime_s, ctime_s;
+		long mtime_ns, ctime_ns;
+		int differs, digest_off = 0, digest_end = 0, path_off = 0;
+		size_t len = strlen(line);
+
+		if (len == 0 || line[len - 1] != '\n')
+			continue;
+		line[len - 1] = '\0';
+		if (sscanf(line, "%llu %llu %lld %lld %ld %lld %ld %d %n%*s%n %n",
+		           &dev, &ino, &size, &mtime_s, &mtime_ns, &ctime_s, &ctime_ns, &differs,
+		           &digest_off, &digest_end, &path_off) < 8 || path_off == 0)
+			continue;
+
+		struct rpmverify_cache_entry *entry = malloc(sizeof(struct rpmverify_cache_entry));
+		if (entry == NULL)
+			break;
+		entry->dev = (dev_t)dev;
+		entry->ino = (ino_t)ino;
+		entry->size = (off_t)size;
+		entry->mtime.tv_sec = (time_t)mtime_s;
+		entry->mtime.tv_nsec = mtime_ns;
+		entry->ctime.tv_sec = (time_t)ctime_s;
+		entry->ctime.tv_nsec = ctime_ns;
+		entry->digest = strndup(line + digest_off, digest_end - digest_off);
+		entry->digest_differs = differs != 0;
+		entry->used = false;
+		if (entry->digest == NULL || !oscap_htable_add(cache, line + path_off, entry))
+			rpmverify_cache_entry_free(entry);
+		else
+			count++;
+	}
+	fclose(fp);
+
+	return count;
+}
+
+static void rpmverify_cache_save(struct oscap_htable *cache, const char *path)
+{
+	struct oscap_htable_iterator *it;
+	char *tmp_path;
+	FILE *fp;
+	int fd;
+
+	tmp_path = oscap_sprintf("%s.XXXXXX", path);
+	fd = mkstemp(tmp_path);
+	if (fd == -1 || (fp = fdopen(fd, "w")) == NULL) {
+		dW("Can't save rpmverify cache %s: %s", path, strerror(errno));
+		if (fd != -1) {
+			close(fd);
+			unlink(tmp_path);
+		}
+		free(tmp_path);
+		return;
+	}
+
+	fprintf(fp, "%s\n", RPMVERIFY_CACHE_MAGIC);
+	it = oscap_htable_iterator_new(cache);
+	while (oscap_htable_iterator_has_more(it)) {
+		const char *file;
+		void *value;
+
+		oscap_htable_iterator_next_kv(it, &file, &value);
+		struct rpmverify_cache_entry *entry = value;
+		/* Files of packages which weren't verified any more are dropped */
+		if (!entry->used)
+			continue;
+		fprintf(fp, "%llu %llu %lld %lld %ld %lld %ld %d %s %s\n",
+		        (unsigned long long)entry->dev, (unsigned long long)entry->ino,
+		        (long long)entry->size,
+		        (long long)entry->mtime.tv_sec, (long)entry->mtime.tv_nsec,
+		        (long long)entry->ctime.tv_sec, (long)entry->ctime.tv_nsec,
+		        entry->digest_differs, entry->digest, file);
+	}
+	oscap_htable_iterator_free(it);
+
+	if (fclose(fp) != 0 || rename(tmp_path, path) != 0) {
+		dW("Can't save rpmverify cache %s: %s", path, strerror(errno));
+		unlink(tmp_path);
+	}
+	free(tmp_path);
+}
+
+void rpmverify_cache_acquire(void)
+{
+	pthread_mutex_lock(&rpmverify_cache_lock);
+	if (rpmverify_cache_refs++ == 0) {
+		const char *path = getenv("OSCAP_RPMVERIFY_CACHE");
+
+		if (path != NULL && *path != '\0') {
+			rpmverify_cache_path = strdup(path);
+			rpmverify_cache = oscap_htable_new();
+			rpmverify_cache_loaded = rpmverify_cache_load(rpmverify_cache, path);
+			rpmverify_cache_used = 0;
+			rpmverify_cache_dirty = false;
+		}
+	}
+	pthread_mutex_unlock(&rpmverify_cache_lock);
+}
+
+void rpmverify_cache_release(void)
+{
+	pthread_mutex_lock(&rpmverify_cache_lock);
+	if (rpmverify_cache_refs > 0 && --rpmverify_cache_refs == 0 && rpmverify_cache != NULL) {
+		/* A scan which didn't look at the cache keeps it as it is */
+		if (rpmverify_cache_dirty ||
+		    (rpmverify_cache_used > 0 && rpmverify_cache_used < rpmverify_cache_loaded))
+			rpmverify_cache_save(rpmverify_cache, rpmverify_cache_path);
+		oscap_htable_free(rpmverify_cache, rpmverify_cache_entry_free);
+		rpmverify_cache = NULL;
+		free(rpmverify_cache_path);
+		rpmverify_cache_path = NULL;
+	}
+	pthread_mutex_unlock(&rpmverify_cache_lock);
+}
+
+static bool rpmverify_cache_entry_matches(const struct rpmverify_cache_entry *entry,
+		const struct stat *st, const char *digest)
+{
+	return entry->dev == st->st_dev && entry->ino == st->st_ino &&
+	       entry->size == st->st_size &&
+	       entry->mtime.tv_sec == st->st_mtim.tv_sec && entry->mtime.tv_nsec == st->st_mtim.tv_nsec &&
+	       entry->ctime.tv_sec == st->st_ctim.tv_sec && entry->ctime.tv_nsec == st->st_ctim.tv_nsec &&
+	       strcmp(entry->digest, digest) == 0;
+}
+
+int rpmverify_file_cached(const rpmts ts, const rpmfi fi,
+		rpmVerifyAttrs * res, rpmVerifyAttrs omitMask)
+{
+	const char *root = rpmtsRootDir(ts);
+	struct rpmverify_cache_entry *entry;
+	rpmVerifyAttrs vflags;
+	struct stat st;
+	char *path, *digest;
+	int ret, differs;
+
+	if (rpmverify_cache == NULL || (omitMask & RPMVERIFY_FILEDIGEST))
+		return rpmVerifyFile(ts, fi, res, omitMask);
+
+	/* Ghost files aren't hashed, only regular files are worth caching */
+	digest = rpmfiFDigestHex(fi, NULL);
+	if (digest == NULL || *digest == '\0' || strchr(digest, ' ') != NULL) {
+		free(digest);
+		return rpmVerifyFile(ts, fi, res, omitMask);
+	}
+	path = oscap_sprintf("%s%s", root != NULL && strcmp(root, "/") != 0 ? root : "", rpmfiFN(fi));
+	if (lstat(path, &st) != 0 || !S_ISREG(st.st_mode) || strchr(path, '\n') != NULL) {
+		free(path);
+		free(digest);
+		return rpmVerifyFile(ts, fi, res, omitMask);
+	}
+
+	pthread_mutex_lock(&rpmverify_cache_lock);
+	entry = oscap_htable_get(rpmverify_cache, path);
+	differs = -1;
+	if (entry != NULL && rpmverify_cache_entry_matches(entry, &st, digest)) {
+		differs = entry->digest_differs;
+		if (!entry->used) {
+			entry->used = true;
+			rpmverify_cache_used++;
+		}
+	}
+	pthread_mutex_unlock(&rpmverify_cache_lock);
+
+	if (differs != -1) {
+		/* The file wasn't touched since its digest was checked */
+		ret = rpmVerifyFile(ts, fi, &vflags, omitMask | RPMVERIFY_FILEDIGEST);
+		if (ret == 0 && differs)
+			vflags |= RPMVERIFY_FILEDIGEST;
+		if (res)
+			*res = vflags;
+		free(path);
+		free(digest);
+		return ret;
+	}
+
+	ret = rpmVerifyFile(ts, fi, &vflags, omitMask);
+	if (res)
+		*res = vflags;
+
+	/* Remember the result only if the file didn't change during the check */
+	struct stat st_after;
+	if (ret == 0 && !(vflags & RPMVERIFY_FAILURES) &&
+	    lstat(path, &st_after) == 0 && st_after.st_ino == st.st_ino &&
+	    st_after.st_ctim.tv_sec == st.st_ctim.tv_sec && st_after.st_ctim.tv_nsec == st.st_ctim.tv_nsec) {
+		entry = malloc(sizeof(struct rpmverify_cache_entry));
+		if (entry == NULL) {
+			free(path);
+			free(digest);
+			return ret;
+		}
+		entry->dev = st.st_dev;
+		entry->ino = st.st_ino;
+		entry->size = st.st_size;
+		entry->mtime = st.st_mtim;
+		entry->ctime = st.st_ctim;
+		entry->digest = digest;
+		entry->digest_differs = (vflags & RPMVERIFY_FILEDIGEST) != 0;
+		entry->used = true;
+		digest = NULL;
+
+		pthread_mutex_lock(&rpmverify_cache_lock);
+		if (rpmverify_cache != NULL) {
+			struct rpmverify_cache_entry *old = oscap_htable_detach(rpmverify_cache, path);
+			if (old != NULL && old->used)
+				rpmverify_cache_used--;
+			rpmverify_cache_entry_free(old);
+			oscap_htable_add(rpmverify_cache, path, entry);
+			rpmverify_cache_used++;
+			rpmverify_cache_dirty = true;
+			entry = NULL;
+		}
+		pthread_mutex_unlock(&rpmverify_cache_lock);
+		rpmverify_cache_entry_free(entry);
+	}
+	free(path);
+	free(digest);
+
+	return ret;
+}
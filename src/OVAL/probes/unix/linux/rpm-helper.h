@@ -92,6 +92,27 @@ int rpmVerifyFile(const rpmts ts, const rpmfi fi,
                 rpmVerifyAttrs * res, rpmVerifyAttrs omitMask);
 #endif
 
+/**
+ * Take a reference of the file verification cache, the first reference
+ * loads it from the file named by OSCAP_RPMVERIFY_CACHE if it is set.
+ */
+void rpmverify_cache_acquire(void);
+
+/**
+ * Drop a reference of the file verification cache, the last reference
+ * saves it if it changed.
+ */
+void rpmverify_cache_release(void);
+
+/**
+ * rpmVerifyFile() which doesn't hash a regular file again if its inode,
+ * size, mtime and ctime are the same as when its digest was verified
+ * before, the previous result of the digest check is used instead.
+ * Without the cache all the files are verified by rpmVerifyFile().
+ */
+int rpmverify_file_cached(const rpmts ts, const rpmfi fi,
+                rpmVerifyAttrs * res, rpmVerifyAttrs omitMask);
+
 /**
  * Preload libraries required by rpm
  * It destroy error callback!
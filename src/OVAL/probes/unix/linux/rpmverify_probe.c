@@ -198,7 +198,7 @@ static int rpmverify_collect(probe_ctx *ctx,
 		    }
 		    SEXP_free(filepath_sexp);
 
-		    if (rpmVerifyFile(g_rpm->rpmts, fi, &res.vflags, omit) != 0)
+		    if (rpmverify_file_cached(g_rpm->rpmts, fi, &res.vflags, omit) != 0)
 		      res.vflags = RPMVERIFY_FAILURES;
 
 		    callback(ctx, &res);
@@ -227,6 +227,7 @@ int rpmverify_probe_offline_mode_supported()
 
 void *rpmverify_probe_init(void)
 {
+	rpmverify_cache_acquire();
 #ifdef RPM46_FOUND
 	rpmlogSetCallback(rpmErrorCb, NULL);
 #endif
@@ -245,6 +246,7 @@ void rpmverify_probe_fini(void *ptr)
 {
         struct rpm_probe_global *r = (struct rpm_probe_global *)ptr;
 
+	rpmverify_cache_release();
 	rpmFreeCrypto();
 	rpmFreeRpmrc();
 	rpmFreeMacros(NULL);
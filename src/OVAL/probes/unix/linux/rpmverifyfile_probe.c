@@ -41,10 +41,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <stdbool.h>
 #include <pcre.h>
 
 #include "rpm-helper.h"
 #include "oscap_helpers.h"
+#include "common/oscap_parallel.h"
 
 /* Individual RPM headers */
 #include <rpm/rpmfi.h>
@@ -190,51 +192,211 @@ cleanup:
 	return ret;
 }
 
-static int rpmverify_collect_package_files_or_directories(
-		struct rpm_probe_global *g_rpm, probe_ctx *ctx, Header pkgh,
-		const char *file, oval_operation_t file_op, rpmTag tag,
-		struct rpmverify_res *res, uint64_t flags)
+/* File of a package which matches the object */
+struct rpmverify_match {
+	rpmTag tag;                   /**< RPMTAG_BASENAMES or RPMTAG_DIRNAMES */
+	int fx;                       /**< index of the file in the package */
+	char *file;
+	rpmVerifyAttrs digest_flags;  /**< result of the digest check */
+	int digest_ret;
+};
+
+struct rpmverify_pkg {
+	Header pkgh;
+	struct rpmverify_res res;
+	struct rpmverify_match *matches;
+	size_t count;
+	bool error;                   /**< file matching failed after the last match */
+};
+
+struct rpmverify_job {
+	struct rpmverify_pkg *pkgs;   /**< the current batch of packages */
+	size_t count;
+	size_t batch;                 /**< maximum number of packages of a batch */
+	rpmts *ts;                    /**< transaction set of every chunk */
+	size_t chunks;
+	size_t max_chunks;
+	const char *file;
+	oval_operation_t file_op;
+	uint64_t flags;
+};
+
+static void rpmverify_res_free(struct rpmverify_res *res)
+{
+	free(res->name);
+	free(res->epoch);
+	free(res->version);
+	free(res->release);
+	free(res->arch);
+}
+
+static int rpmverify_match_package_files_or_directories(rpmts ts,
+		struct rpmverify_pkg *pkg, const char *file, oval_operation_t file_op,
+		rpmTag tag, uint64_t flags)
 {
 	int ret = 0;
 	rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
-	rpmfi fi = rpmfiNew(g_rpm->rpmts, pkgh, tag, 1);
+	rpmfi fi = rpmfiNew(ts, pkg->pkgh, tag, 1);
 
 	while (rpmfiNext(fi) != -1) {
 		const char *current_file = rpmfiFN(fi);
-		res->fflags = rpmfiFFlags(fi);
-		res->oflags = omit;
+		rpmfileAttrs fflags = rpmfiFFlags(fi);
+		char *result_file = NULL;
 
-		if (((res->fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
-				((res->fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST))) {
+		if (((fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
+				((fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST))) {
 			continue;
 		}
-		int cmp_res = _compare_file_with_current_file(file_op, file, current_file, &res->file);
+		int cmp_res = _compare_file_with_current_file(file_op, file, current_file, &result_file);
 		if (cmp_res == 1) {
 			/* no match */
 			continue;
 		}
 		if (cmp_res == -1) {
 			ret = -1;
-			goto cleanup;
+			break;
 		}
 
-		if (rpmVerifyFile(g_rpm->rpmts, fi, &res->vflags, omit) != 0) {
-			res->vflags = RPMVERIFY_FAILURES;
+		pkg->matches = realloc(pkg->matches, (pkg->count + 1) * sizeof(struct rpmverify_match));
+		struct rpmverify_match *match = &pkg->matches[pkg->count++];
+		match->tag = tag;
+		match->fx = rpmfiFX(fi);
+		match->file = result_file;
+		match->digest_flags = 0;
+		match->digest_ret = 0;
+
+		/* Only the digest is checked here, it's the expensive part */
+		if (!(omit & RPMVERIFY_FILEDIGEST)) {
+			match->digest_ret = rpmverify_file_cached(ts, fi, &match->digest_flags,
+					(rpmVerifyAttrs)~RPMVERIFY_FILEDIGEST);
+		}
+	}
+
+	rpmfiFree(fi);
+	return ret;
+}
+
+static void rpmverify_match_chunk(size_t index, void *arg)
+{
+	struct rpmverify_job *job = arg;
+	size_t first = index * job->count / job->chunks;
+	size_t last = (index + 1) * job->count / job->chunks;
+
+	for (size_t i = first; i < last; i++) {
+		struct rpmverify_pkg *pkg = &job->pkgs[i];
+
+		if (rpmverify_match_package_files_or_directories(job->ts[index], pkg,
+				job->file, job->file_op, RPMTAG_BASENAMES, job->flags) != 0 ||
+				rpmverify_match_package_files_or_directories(job->ts[index], pkg,
+				job->file, job->file_op, RPMTAG_DIRNAMES, job->flags) != 0) {
+			pkg->error = true;
+		}
+	}
+}
+
+static int rpmverify_collect_package(struct rpm_probe_global *g_rpm, probe_ctx *ctx,
+		struct rpmverify_pkg *pkg, uint64_t flags)
+{
+	rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
+	rpmfi fi = NULL;
+	rpmTag fi_tag = 0;
+	int ret = 0;
+
+	for (size_t i = 0; i < pkg->count; i++) {
+		struct rpmverify_match *match = &pkg->matches[i];
+
+		if (fi == NULL || fi_tag != match->tag) {
+			rpmfiFree(fi);
+			fi = rpmfiNew(g_rpm->rpmts, pkg->pkgh, match->tag, 1);
+			fi_tag = match->tag;
+		}
+		while (rpmfiFX(fi) != match->fx) {
+			if (rpmfiNext(fi) == -1) {
+				ret = -1;
+				goto cleanup;
+			}
+		}
+
+		pkg->res.file = match->file;
+		pkg->res.fflags = rpmfiFFlags(fi);
+		pkg->res.oflags = omit;
+
+		/*
+		 * The rest of the attributes is checked in this thread, the user
+		 * and group lookups of librpm aren't thread-safe.
+		 */
+		if (rpmVerifyFile(g_rpm->rpmts, fi, &pkg->res.vflags, omit | RPMVERIFY_FILEDIGEST) != 0 ||
+				match->digest_ret != 0) {
+			pkg->res.vflags = RPMVERIFY_FAILURES;
+		} else {
+			pkg->res.vflags |= match->digest_flags & (RPMVERIFY_FILEDIGEST | RPMVERIFY_FAILURES);
 		}
 
-		if (rpmverify_additem(ctx, res) != 0) {
+		if (rpmverify_additem(ctx, &pkg->res) != 0) {
 			ret = -1;
-			free(res->file);
 			goto cleanup;
 		}
-		free(res->file);
 	}
+	if (pkg->error)
+		ret = -1;
 
 cleanup:
+	pkg->res.file = NULL;
 	rpmfiFree(fi);
 	return ret;
 }
 
+/* Number of the chunks per thread, packages differ a lot in size */
+#define RPMVERIFY_CHUNKS_PER_THREAD 4
+/* Number of the packages of a chunk, their headers and matches are kept until they are collected */
+#define RPMVERIFY_PKGS_PER_CHUNK 8
+
+static void rpmverify_job_clear(struct rpmverify_job *job)
+{
+	for (size_t i = 0; i < job->count; i++) {
+		struct rpmverify_pkg *pkg = &job->pkgs[i];
+
+		for (size_t j = 0; j < pkg->count; j++)
+			free(pkg->matches[j].file);
+		free(pkg->matches);
+		rpmverify_res_free(&pkg->res);
+		headerFree(pkg->pkgh);
+	}
+	job->count = 0;
+}
+
+/*
+ * The files of a batch of packages are matched and hashed in parallel, every
+ * chunk of packages has its own transaction set. The items are added
+ * afterwards in the order of the packages and the batch is freed.
+ */
+static int rpmverify_job_run(struct rpmverify_job *job, struct rpm_probe_global *g_rpm, probe_ctx *ctx)
+{
+	const char *root = rpmtsRootDir(g_rpm->rpmts);
+	int ret = 0;
+
+	job->chunks = job->count < job->max_chunks ? job->count : job->max_chunks;
+	for (size_t i = 0; i < job->chunks; i++) {
+		if (job->ts[i] == NULL) {
+			job->ts[i] = rpmtsCreate();
+			if (root != NULL)
+				rpmtsSetRootDir(job->ts[i], root);
+		}
+	}
+
+	oscap_parallel_run(job->chunks, rpmverify_match_chunk, job);
+
+	for (size_t i = 0; i < job->count; i++) {
+		if (rpmverify_collect_package(g_rpm, ctx, &job->pkgs[i], job->flags) != 0) {
+			ret = -1;
+			break;
+		}
+	}
+	rpmverify_job_clear(job);
+
+	return ret;
+}
+
 static int rpmverify_collect(probe_ctx *ctx,
 			     const char *file, oval_operation_t file_op,
 			     SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent,
@@ -244,6 +406,12 @@ static int rpmverify_collect(probe_ctx *ctx,
 	rpmdbMatchIterator match;
 	Header pkgh;
 	int  ret = -1;
+	struct rpmverify_job job;
+
+	memset(&job, 0, sizeof(job));
+	job.file = file;
+	job.file_op = file_op;
+	job.flags = flags;
 
 	RPMVERIFY_LOCK;
 
@@ -283,11 +451,23 @@ static int rpmverify_collect(probe_ctx *ctx,
 		goto ret;
 	}
 
+	job.max_chunks = (size_t)oscap_parallel_get_max_threads() * RPMVERIFY_CHUNKS_PER_THREAD;
+	job.batch = job.max_chunks * RPMVERIFY_PKGS_PER_CHUNK;
+	job.pkgs = malloc(job.batch * sizeof(struct rpmverify_pkg));
+	job.ts = calloc(job.max_chunks, sizeof(rpmts));
+	if (job.pkgs == NULL || job.ts == NULL) {
+		dE("Can't allocate memory for a batch of %zu packages", job.batch);
+		ret = -1;
+		goto ret;
+	}
+
 	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
 		SEXP_t *ent;
 		struct rpmverify_res res;
 		errmsg_t rpmerr;
 
+		memset(&res, 0, sizeof(res));
+
 #define COMPARE_ENT(XXX) \
 		if (XXX ## _ent != NULL) { \
 			ent = probe_entval_from_cstr( \
@@ -295,6 +475,7 @@ static int rpmverify_collect(probe_ctx *ctx,
 			); \
 			if (ent != NULL && probe_entobj_cmp(XXX ## _ent, ent) != OVAL_RESULT_TRUE) { \
 				SEXP_free(ent); \
+				rpmverify_res_free(&res); \
 				continue; \
 			} \
 			SEXP_free(ent); \
@@ -316,23 +497,30 @@ static int rpmverify_collect(probe_ctx *ctx,
 			oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
 			res.version, res.release, res.arch);
 
-		if (rpmverify_collect_package_files_or_directories(g_rpm, ctx, pkgh, file, file_op, RPMTAG_BASENAMES, &res, flags) != 0 ||
-				rpmverify_collect_package_files_or_directories(g_rpm, ctx, pkgh, file, file_op, RPMTAG_DIRNAMES, &res, flags) != 0) {
-			ret = -1;
-		}
+		/* The header stays valid after the iterator moves on */
+		memset(&job.pkgs[job.count], 0, sizeof(struct rpmverify_pkg));
+		job.pkgs[job.count].pkgh = headerLink(pkgh);
+		job.pkgs[job.count].res = res;
+		job.count++;
 
-		free(res.name);
-		free(res.epoch);
-		free(res.version);
-		free(res.release);
-		free(res.arch);
-		if (ret == -1) {
+		if (job.count == job.batch && rpmverify_job_run(&job, g_rpm, ctx) != 0) {
+			ret = -1;
 			goto ret;
 		}
 	}
 
-	ret   = 0;
+	ret = job.count > 0 ? rpmverify_job_run(&job, g_rpm, ctx) : 0;
+
 ret:
+	rpmverify_job_clear(&job);
+	if (job.ts != NULL) {
+		for (size_t i = 0; i < job.max_chunks; i++) {
+			if (job.ts[i] != NULL)
+				rpmtsFree(job.ts[i]);
+		}
+		free(job.ts);
+	}
+	free(job.pkgs);
 	match = rpmdbFreeIterator(match);
 	RPMVERIFY_UNLOCK;
 	return (ret);
@@ -346,6 +534,7 @@ int rpmverifyfile_probe_offline_mode_supported()
 
 void *rpmverifyfile_probe_init(void)
 {
+	rpmverify_cache_acquire();
 #ifdef RPM46_FOUND
 	rpmlogSetCallback(rpmErrorCb, NULL);
 #endif
@@ -366,6 +555,7 @@ void rpmverifyfile_probe_fini(void *ptr)
 {
 	struct rpm_probe_global *r = (struct rpm_probe_global *)ptr;
 
+	rpmverify_cache_release();
 	rpmFreeCrypto();
 	rpmFreeRpmrc();
 	rpmFreeMacros(NULL);
@@ -0,0 +1,453 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+
+#include "common/debug_priv.h"
+#include "sock-diag.h"
+#include "procsnap.h"
+
+/* Size of the buffer for netlink replies, the kernel fills up to a page */
+#define SOCK_DIAG_BUFSIZE 32768
+
+struct sock_owner_entry {
+	struct sock_owner owner;
+	size_t seq;
+};
+
+static pthread_mutex_t sock_owners_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int sock_owners_refs = 0;
+static struct sock_owners *sock_owners_map = NULL;
+
+static void sock_owners_free(struct sock_owners *map)
+{
+	if (map == NULL)
+		return;
+	free(map->owners);
+	free(map);
+}
+
+void sock_owners_acquire(void)
+{
+	procsnap_acquire();
+	pthread_mutex_lock(&sock_owners_lock);
+	sock_owners_refs++;
+	pthread_mutex_unlock(&sock_owners_lock);
+}
+
+void sock_owners_release(void)
+{
+	pthread_mutex_lock(&sock_owners_lock);
+	if (sock_owners_refs > 0 && --sock_owners_refs == 0) {
+		sock_owners_free(sock_owners_map);
+		sock_owners_map = NULL;
+	}
+	pthread_mutex_unlock(&sock_owners_lock);
+	procsnap_release();
+}
+
+static int sock_owner_cmp(const void *a, const void *b)
+{
+	const struct sock_owner_entry *ea = a, *eb = b;
+
+	if (ea->owner.inode != eb->owner.inode)
+		return ea->owner.inode < eb->owner.inode ? -1 : 1;
+	/* Keep the order of /proc for owners of the same socket */
+	return ea->seq < eb->seq ? -1 : (ea->seq > eb->seq);
+}
+
+/*
+ * Add the sockets open by the process to the entries.
+ * Returns 0 on success and -1 if there isn't enough memory.
+ */
+static int collect_process_sockets(int pid, uid_t euid, const char *cmd,
+		struct sock_owner_entry **entries, size_t *count, size_t *alloc, int *denied)
+{
+	const struct procsnap_blob *fds;
+	const char *line;
+
+	// Now lets get the inodes each process has open
+	fds = procsnap_file(NULL, pid, PROCSNAP_FD);
+	if (fds == NULL)
+		return 0;
+	if (fds->error != 0) {
+		if (fds->error == EACCES) {
+			/* Need DAC_OVERRIDE permission */
+			*denied = 1;
+		}
+		// Process might have ended or something - ignore it
+		return 0;
+	}
+	// For each target of a link in the fd dir...
+	for (line = fds->data; line < fds->data + fds->size; line += strlen(line) + 1) {
+		const char *s;
+		unsigned long inode;
+
+		// Only look at the socket entries
+		if (strncmp(line, "socket:", 7) == 0) {
+			// Type 1 sockets
+			s = strchr(line+7, '[');
+			if (s == NULL || strchr(s, ']') == NULL)
+				continue;
+			s++;
+		} else if (strncmp(line, "[0000]:", 7) == 0) {
+			// Type 2 sockets
+			s = line + 8;
+		} else
+			continue;
+		errno = 0;
+		inode = strtoul(s, NULL, 10);
+		if (errno)
+			continue;
+
+		if (*count == *alloc) {
+			size_t new_alloc = *alloc == 0 ? 256 : *alloc * 2;
+			struct sock_owner_entry *new_entries = realloc(*entries, new_alloc * sizeof(struct sock_owner_entry));
+			if (new_entries == NULL)
+				return -1;
+			*entries = new_entries;
+			*alloc = new_alloc;
+		}
+		// We make one entry for each socket inode
+		struct sock_owner_entry *entry = &(*entries)[*count];
+		entry->owner.inode = inode;
+		entry->owner.pid = pid;
+		entry->owner.uid = euid;
+		memcpy(entry->owner.cmd, cmd, sizeof entry->owner.cmd);
+		entry->seq = (*count)++;
+	}
+	return 0;
+}
+
+static struct sock_owners *sock_owners_build(void)
+{
+	struct sock_owners *map;
+	struct sock_owner_entry *entries = NULL;
+	size_t count = 0, alloc = 0;
+	int denied = 0;
+	const pid_t *pids;
+	size_t pid_cnt;
+
+	if (procsnap_pids(NULL, &pids, &pid_cnt) != 0)
+		return NULL;
+
+	procsnap_prefetch(NULL, PROCSNAP_MASK(PROCSNAP_STAT) | PROCSNAP_MASK(PROCSNAP_STATUS) |
+	                  PROCSNAP_MASK(PROCSNAP_FD));
+
+	for (size_t i = 0; i < pid_cnt; i++) {
+		const struct procsnap_blob *file;
+		int pid = pids[i], ppid;
+		char buf[100];
+		char *tmp, cmd[16], state;
+		size_t len;
+		int euid = 0;
+
+		// Parse up the stat file for the proc
+		file = procsnap_file(NULL, pid, PROCSNAP_STAT);
+		if (file == NULL || file->error != 0 || file->size < 40)
+			continue;
+		len = file->size < sizeof buf - 1 ? file->size : sizeof buf - 1;
+		memcpy(buf, file->data, len);
+		buf[len] = 0;
+		tmp = strrchr(buf, ')');
+		if (tmp)
+			*tmp = 0;
+		else
+			continue;
+		memset(cmd, 0, sizeof(cmd));
+		sscanf(buf, "%d (%15c", &ppid, cmd);
+		sscanf(tmp+2, "%c %d", &state, &ppid);
+
+		// Skip kthreads
+		if (pid == 2 || ppid == 2)
+			continue;
+
+		// Get the effective uid
+		file = procsnap_file(NULL, pid, PROCSNAP_STATUS);
+		if (file != NULL && file->error == 0) {
+			const char *uid = strstr(file->data, "\nUid:");
+			if (uid != NULL) {
+				int id;
+				sscanf(uid + 1, "Uid: %d %d", &id, &euid);
+			}
+		}
+
+		if (collect_process_sockets(pid, euid, cmd, &entries, &count, &alloc, &denied) != 0) {
+			dE("Can't allocate memory for socket owners");
+			free(entries);
+			return NULL;
+		}
+	}
+
+	qsort(entries, count, sizeof(struct sock_owner_entry), sock_owner_cmp);
+
+	map = malloc(sizeof(struct sock_owners));
+	if (map == NULL) {
+		dE("Can't allocate memory for socket owners");
+		free(entries);
+		return NULL;
+	}
+	map->owners = malloc((count > 0 ? count : 1) * sizeof(struct sock_owner));
+	if (map->owners == NULL) {
+		dE("Can't allocate memory for socket owners");
+		free(map);
+		free(entries);
+		return NULL;
+	}
+	map->count = count;
+	map->denied = denied;
+	for (size_t i = 0; i < count; i++)
+		map->owners[i] = entries[i].owner;
+	free(entries);
+
+	dD("Found %zu sockets open by running processes", count);
+	return map;
+}
+
+const struct sock_owners *sock_owners_get(void)
+{
+	struct sock_owners *map;
+
+	pthread_mutex_lock(&sock_owners_lock);
+	if (sock_owners_map == NULL)
+		sock_owners_map = sock_owners_build();
+	map = sock_owners_map;
+	pthread_mutex_unlock(&sock_owners_lock);
+
+	return map;
+}
+
+const struct sock_owner *sock_owners_find(const struct sock_owners *map, unsigned long inode)
+{
+	size_t lo = 0, hi = map->count;
+
+	/* Lower bound, the first owner of the socket */
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (map->owners[mid].inode < inode)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < map->count && map->owners[lo].inode == inode)
+		return &map->owners[lo];
+	return NULL;
+}
+
+typedef void (*sock_diag_msg_cb)(const struct nlmsghdr *nlh, void *arg);
+
+/* Reply of the kernel as received by one recv() call */
+struct sock_diag_reply {
+	struct sock_diag_reply *next;
+	ssize_t len;
+	long data[SOCK_DIAG_BUFSIZE / sizeof(long)];
+};
+
+static void sock_diag_replies_free(struct sock_diag_reply *reply)
+{
+	while (reply != NULL) {
+		struct sock_diag_reply *next = reply->next;
+		free(reply);
+		reply = next;
+	}
+}
+
+/*
+ * Send a SOCK_DIAG_BY_FAMILY dump request and call cb for every reply.
+ * The replies are passed to cb only after the whole dump was received, so
+ * the caller can fall back to another source if the dump fails midway.
+ */
+static int sock_diag_dump(void *req, size_t req_len, sock_diag_msg_cb cb, void *arg)
+{
+	struct sockaddr_nl nladdr = { .nl_family = AF_NETLINK };
+	struct nlmsghdr nlh = {
+		.nlmsg_len = NLMSG_LENGTH(req_len),
+		.nlmsg_type = SOCK_DIAG_BY_FAMILY,
+		.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP,
+		.nlmsg_seq = 1,
+	};
+	struct iovec iov[2] = {
+		{ .iov_base = &nlh, .iov_len = sizeof nlh },
+		{ .iov_base = req, .iov_len = req_len },
+	};
+	struct msghdr msg = {
+		.msg_name = &nladdr,
+		.msg_namelen = sizeof nladdr,
+		.msg_iov = iov,
+		.msg_iovlen = 2,
+	};
+	struct sock_diag_reply *replies = NULL, **tail = &replies;
+	int fd, done = 0;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+	if (fd < 0) {
+		dD("Can't open NETLINK_SOCK_DIAG socket: %s", strerror(errno));
+		return -1;
+	}
+	if (sendmsg(fd, &msg, 0) < 0) {
+		dD("Can't send sock_diag request: %s", strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	while (!done) {
+		struct sock_diag_reply *reply = malloc(sizeof(struct sock_diag_reply));
+		if (reply == NULL) {
+			dD("Can't allocate memory for sock_diag reply");
+			goto fail;
+		}
+		reply->next = NULL;
+		*tail = reply;
+		tail = &reply->next;
+
+		do {
+			reply->len = recv(fd, reply->data, sizeof reply->data, 0);
+		} while (reply->len < 0 && errno == EINTR);
+		if (reply->len < 0) {
+			dD("Can't receive sock_diag reply: %s", strerror(errno));
+			goto fail;
+		}
+		if (reply->len == 0) {
+			dD("sock_diag dump ended unexpectedly");
+			goto fail;
+		}
+
+		ssize_t len = reply->len;
+		for (struct nlmsghdr *h = (struct nlmsghdr *)reply->data; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+			if (h->nlmsg_type == NLMSG_DONE) {
+				/* Errors of the dump are reported in the last message */
+				const int *err = NLMSG_DATA(h);
+				if (h->nlmsg_len >= NLMSG_LENGTH(sizeof(int)) && *err < 0) {
+					dD("sock_diag dump failed: %s", strerror(-*err));
+					goto fail;
+				}
+				done = 1;
+				break;
+			}
+			if (h->nlmsg_type == NLMSG_ERROR) {
+				const struct nlmsgerr *err = NLMSG_DATA(h);
+				dD("sock_diag request failed: %s", strerror(-err->error));
+				goto fail;
+			}
+		}
+	}
+	close(fd);
+
+	for (struct sock_diag_reply *reply = replies; reply != NULL; reply = reply->next) {
+		ssize_t len = reply->len;
+		for (struct nlmsghdr *h = (struct nlmsghdr *)reply->data; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+			if (h->nlmsg_type == NLMSG_DONE)
+				break;
+			cb(h, arg);
+		}
+	}
+	sock_diag_replies_free(replies);
+	return 0;
+fail:
+	sock_diag_replies_free(replies);
+	close(fd);
+	return -1;
+}
+
+struct sock_diag_inet_arg {
+	sock_diag_inet_cb cb;
+	void *arg;
+};
+
+static void sock_diag_inet_msg(const struct nlmsghdr *nlh, void *arg)
+{
+	struct sock_diag_inet_arg *a = arg;
+
+	if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY || nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct inet_diag_msg)))
+		return;
+	a->cb(NLMSG_DATA(nlh), a->arg);
+}
+
+int sock_diag_inet(int family, int protocol, sock_diag_inet_cb cb, void *arg)
+{
+	struct sock_diag_inet_arg a = { .cb = cb, .arg = arg };
+	struct inet_diag_req_raw req;
+
+	memset(&req, 0, sizeof req);
+	req.sdiag_family = family;
+	req.sdiag_protocol = protocol;
+	/* Raw sockets of all protocols */
+	if (protocol == IPPROTO_RAW)
+		req.sdiag_raw_protocol = IPPROTO_RAW;
+	req.idiag_states = ~0U;
+
+	return sock_diag_dump(&req, sizeof req, sock_diag_inet_msg, &a);
+}
+
+struct sock_diag_packet_arg {
+	sock_diag_packet_cb cb;
+	void *arg;
+};
+
+static void sock_diag_packet_msg(const struct nlmsghdr *nlh, void *arg)
+{
+	struct sock_diag_packet_arg *a = arg;
+	const struct packet_diag_msg *msg = NLMSG_DATA(nlh);
+	const struct packet_diag_info *info = NULL;
+	const struct nlattr *attr;
+	int len;
+
+	if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY || nlh->nlmsg_len < NLMSG_LENGTH(sizeof(struct packet_diag_msg)))
+		return;
+
+	attr = (const struct nlattr *)((const char *)msg + NLMSG_ALIGN(sizeof(struct packet_diag_msg)));
+	len = nlh->nlmsg_len - NLMSG_LENGTH(NLMSG_ALIGN(sizeof(struct packet_diag_msg)));
+	while (len >= (int)sizeof(struct nlattr) && attr->nla_len >= sizeof(struct nlattr) && attr->nla_len <= len) {
+		if ((attr->nla_type & NLA_TYPE_MASK) == PACKET_DIAG_INFO &&
+		    attr->nla_len >= NLA_HDRLEN + sizeof(struct packet_diag_info)) {
+			info = (const struct packet_diag_info *)((const char *)attr + NLA_HDRLEN);
+			break;
+		}
+		len -= NLA_ALIGN(attr->nla_len);
+		attr = (const struct nlattr *)((const char *)attr + NLA_ALIGN(attr->nla_len));
+	}
+
+	a->cb(msg, info, a->arg);
+}
+
+int sock_diag_packet(sock_diag_packet_cb cb, void *arg)
+{
+	struct sock_diag_packet_arg a = { .cb = cb, .arg = arg };
+	struct packet_diag_req req;
+
+	memset(&req, 0, sizeof req);
+	req.sdiag_family = AF_PACKET;
+	req.pdiag_show = PACKET_SHOW_INFO;
+
+	return sock_diag_dump(&req, sizeof req, sock_diag_packet_msg, &a);
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+#ifndef OPENSCAP_SOCK_DIAG_H
+#define OPENSCAP_SOCK_DIAG_H
+
+#include <sys/types.h>
+#include <linux/inet_diag.h>
+#include <linux/packet_diag.h>
+
+/*
+ * Socket enumeration and socket owner lookup shared by the iflisteners
+ * and inetlisteningservers probes.
+ */
+
+/* A process which has the socket open */
+struct sock_owner {
+	unsigned long inode; // inode of the socket
+	pid_t pid;           // process ID
+	uid_t uid;           // effective user ID
+	char cmd[16];        // command name
+};
+
+/*
+ * Owners of all the sockets open by running processes, sorted by the
+ * socket inode. The map is built on the first use and shared by all
+ * probes which hold a reference, it's freed when the last one drops it.
+ */
+struct sock_owners {
+	struct sock_owner *owners;
+	size_t count;
+	int denied;          // fds of some process couldn't be read
+};
+
+void sock_owners_acquire(void);
+void sock_owners_release(void);
+
+/*
+ * Get the map of socket owners, build it if needed.
+ * Returns NULL if the running processes can't be listed or there isn't
+ * enough memory.
+ */
+const struct sock_owners *sock_owners_get(void);
+
+/*
+ * Find the owner of the socket with the given inode. If more processes
+ * have the socket open, the one found first in /proc is returned.
+ */
+const struct sock_owner *sock_owners_find(const struct sock_owners *map, unsigned long inode);
+
+typedef void (*sock_diag_inet_cb)(const struct inet_diag_msg *msg, void *arg);
+typedef void (*sock_diag_packet_cb)(const struct packet_diag_msg *msg, const struct packet_diag_info *info, void *arg);
+
+/*
+ * Call cb for every socket of the family and protocol in all states using
+ * the NETLINK_SOCK_DIAG interface. Returns 0 on success and -1 if the
+ * kernel doesn't support the query or the dump fails, cb is not called then.
+ */
+int sock_diag_inet(int family, int protocol, sock_diag_inet_cb cb, void *arg);
+
+/*
+ * Call cb for every packet socket, info is NULL if the kernel didn't
+ * provide it. Returns 0 on success and -1 if the kernel doesn't support
+ * the query or the dump fails, cb is not called then.
+ */
+int sock_diag_packet(sock_diag_packet_cb cb, void *arg);
+
+#endif /* OPENSCAP_SOCK_DIAG_H */
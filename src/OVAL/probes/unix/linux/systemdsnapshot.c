@@ -0,0 +1,913 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "common/list.h"
+#include "common/util.h"
+#include "systemdshared.h"
+#include "systemdsnapshot.h"
+
+/* Maximal number of D-Bus requests waiting for a reply */
+#define SYSTEMD_PIPELINE 64
+
+struct systemd_snapshot {
+	DBusConnection *conn;          // NULL if read from unit files
+	struct oscap_htable *units;    // name -> struct systemd_unit
+	struct systemd_unit **all;     // every unit, for cleanup
+	size_t all_count;
+	size_t all_alloc;
+	char **listed;                 // names of listed units
+	size_t listed_count;
+	size_t listed_alloc;
+};
+
+static pthread_mutex_t systemd_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int systemd_snapshot_refs = 0;
+static struct systemd_snapshot *systemd_snapshot_current = NULL;
+
+static void systemd_unit_free(struct systemd_unit *unit)
+{
+	for (size_t i = 0; i < unit->count; ++i) {
+		for (size_t j = 0; j < unit->properties[i].count; ++j)
+			free(unit->properties[i].values[j]);
+		free(unit->properties[i].values);
+		free(unit->properties[i].name);
+	}
+	free(unit->properties);
+	free(unit->name);
+	free(unit->path);
+	free(unit);
+}
+
+static void systemd_snapshot_free(struct systemd_snapshot *snap)
+{
+	if (snap == NULL)
+		return;
+
+	for (size_t i = 0; i < snap->all_count; ++i)
+		systemd_unit_free(snap->all[i]);
+	free(snap->all);
+	free(snap->listed);
+	oscap_htable_free0(snap->units);
+	disconnect_dbus(snap->conn);
+	free(snap);
+}
+
+void systemd_snapshot_acquire(void)
+{
+	pthread_mutex_lock(&systemd_snapshot_lock);
+	systemd_snapshot_refs++;
+	pthread_mutex_unlock(&systemd_snapshot_lock);
+}
+
+void systemd_snapshot_release(void)
+{
+	pthread_mutex_lock(&systemd_snapshot_lock);
+	if (systemd_snapshot_refs > 0 && --systemd_snapshot_refs == 0) {
+		systemd_snapshot_free(systemd_snapshot_current);
+		systemd_snapshot_current = NULL;
+	}
+	pthread_mutex_unlock(&systemd_snapshot_lock);
+}
+
+static struct systemd_unit *systemd_snapshot_add(struct systemd_snapshot *snap, const char *name, const char *path)
+{
+	struct systemd_unit *unit;
+
+	if (snap->all_count == snap->all_alloc) {
+		size_t all_alloc = snap->all_alloc == 0 ? 256 : snap->all_alloc * 2;
+		void *new_all = realloc(snap->all, all_alloc * sizeof(struct systemd_unit *));
+		if (new_all == NULL) {
+			dE("Can't allocate memory for systemd unit '%s'", name);
+			return NULL;
+		}
+		snap->all = new_all;
+		snap->all_alloc = all_alloc;
+	}
+	unit = calloc(1, sizeof(struct systemd_unit));
+	if (unit == NULL) {
+		dE("Can't allocate memory for systemd unit '%s'", name);
+		return NULL;
+	}
+	unit->name = oscap_strdup(name);
+	unit->path = oscap_strdup(path);
+	if (!oscap_htable_add(snap->units, unit->name, unit)) {
+		systemd_unit_free(unit);
+		return NULL;
+	}
+	snap->all[snap->all_count++] = unit;
+	return unit;
+}
+
+static int systemd_snapshot_list(struct systemd_snapshot *snap, struct systemd_unit *unit)
+{
+	if (snap->listed_count == snap->listed_alloc) {
+		size_t listed_alloc = snap->listed_alloc == 0 ? 256 : snap->listed_alloc * 2;
+		void *new_listed = realloc(snap->listed, listed_alloc * sizeof(char *));
+		if (new_listed == NULL) {
+			dE("Can't allocate memory for systemd unit '%s'", unit->name);
+			return -1;
+		}
+		snap->listed = new_listed;
+		snap->listed_alloc = listed_alloc;
+	}
+	snap->listed[snap->listed_count++] = unit->name;
+	return 0;
+}
+
+static struct systemd_property *systemd_unit_property(struct systemd_unit *unit, const char *name)
+{
+	struct systemd_property *property;
+	void *new_properties;
+
+	new_properties = realloc(unit->properties, (unit->count + 1) * sizeof(struct systemd_property));
+	if (new_properties == NULL) {
+		dE("Can't allocate memory for property '%s' of systemd unit '%s'", name, unit->name);
+		return NULL;
+	}
+	unit->properties = new_properties;
+	property = &unit->properties[unit->count++];
+	property->name = oscap_strdup(name);
+	property->values = NULL;
+	property->count = 0;
+	return property;
+}
+
+/* The property takes the value, it's freed if it can't be added */
+static int systemd_property_add(struct systemd_property *property, char *value)
+{
+	void *new_values;
+
+	if (property == NULL) {
+		free(value);
+		return -1;
+	}
+	new_values = realloc(property->values, (property->count + 1) * sizeof(char *));
+	if (new_values == NULL) {
+		dE("Can't allocate memory for a value of property '%s'", property->name);
+		free(value);
+		return -1;
+	}
+	property->values = new_values;
+	property->values[property->count++] = value;
+	return 0;
+}
+
+static int systemd_unit_listed(const char *name, const char *path, void *arg)
+{
+	struct systemd_snapshot *snap = arg;
+	struct systemd_unit *unit = systemd_snapshot_add(snap, name, path);
+
+	/* Units listed more times are added once */
+	if (unit != NULL && systemd_snapshot_list(snap, unit) != 0)
+		return 1;
+	return 0;
+}
+
+typedef DBusMessage *(*systemd_request_func)(struct systemd_unit *unit);
+typedef void (*systemd_reply_func)(struct systemd_unit *unit, DBusMessage *reply);
+
+/*
+ * Send the requests for the units without waiting for the replies,
+ * at most SYSTEMD_PIPELINE of them are pending at once.
+ */
+static void systemd_call_units(DBusConnection *conn, struct systemd_unit **units, size_t count,
+                               systemd_request_func request, systemd_reply_func reply)
+{
+	DBusPendingCall *pending[SYSTEMD_PIPELINE];
+
+	for (size_t start = 0; start < count; start += SYSTEMD_PIPELINE) {
+		size_t n = count - start < SYSTEMD_PIPELINE ? count - start : SYSTEMD_PIPELINE;
+
+		for (size_t i = 0; i < n; ++i) {
+			DBusMessage *msg = request(units[start + i]);
+
+			pending[i] = NULL;
+			if (msg == NULL) {
+				dD("Failed to create dbus_message via dbus_message_new_method_call!");
+				continue;
+			}
+			if (!dbus_connection_send_with_reply(conn, msg, &pending[i], -1)) {
+				dD("Failed to send message via dbus!");
+				pending[i] = NULL;
+			}
+			dbus_message_unref(msg);
+		}
+		dbus_connection_flush(conn);
+
+		for (size_t i = 0; i < n; ++i) {
+			DBusMessage *msg;
+
+			if (pending[i] == NULL)
+				continue;
+			dbus_pending_call_block(pending[i]);
+			msg = dbus_pending_call_steal_reply(pending[i]);
+			dbus_pending_call_unref(pending[i]);
+			if (msg == NULL) {
+				dD("Failed to steal dbus pending call reply.");
+				continue;
+			}
+			if (dbus_message_get_type(msg) == DBUS_MESSAGE_TYPE_ERROR)
+				dD("Request for unit '%s' failed: %s", units[start + i]->name, dbus_message_get_error_name(msg));
+			else
+				reply(units[start + i], msg);
+			dbus_message_unref(msg);
+		}
+	}
+}
+
+static DBusMessage *load_unit_request(struct systemd_unit *unit)
+{
+	DBusMessage *msg = dbus_message_new_method_call(
+		"org.freedesktop.systemd1",
+		"/org/freedesktop/systemd1",
+		"org.freedesktop.systemd1.Manager",
+		// LoadUnit is similar to GetUnit except it will load the unit file
+		// if it hasn't been loaded yet.
+		"LoadUnit"
+	);
+	const char *name = unit->name;
+
+	if (msg != NULL && !dbus_message_append_args(msg, DBUS_TYPE_STRING, &name, DBUS_TYPE_INVALID)) {
+		dD("Failed to append unit '%s' string parameter to dbus message!", name);
+		dbus_message_unref(msg);
+		msg = NULL;
+	}
+	return msg;
+}
+
+static void load_unit_reply(struct systemd_unit *unit, DBusMessage *reply)
+{
+	DBusMessageIter args;
+	_DBusBasicValue path;
+
+	if (!dbus_message_iter_init(reply, &args)) {
+		dD("Failed to initialize iterator over received dbus message.");
+		return;
+	}
+	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_OBJECT_PATH) {
+		dD("Expected string argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
+		return;
+	}
+	dbus_message_iter_get_basic(&args, &path);
+	unit->path = oscap_strdup(path.str);
+}
+
+static DBusMessage *get_all_request(struct systemd_unit *unit)
+{
+	DBusMessage *msg = dbus_message_new_method_call(
+		"org.freedesktop.systemd1",
+		unit->path,
+		"org.freedesktop.DBus.Properties",
+		"GetAll"
+	);
+	const char *interface = "org.freedesktop.systemd1.Unit";
+
+	if (msg != NULL && !dbus_message_append_args(msg, DBUS_TYPE_STRING, &interface, DBUS_TYPE_INVALID)) {
+		dD("Failed to append interface '%s' string parameter to dbus message!", interface);
+		dbus_message_unref(msg);
+		msg = NULL;
+	}
+	return msg;
+}
+
+static void get_all_reply(struct systemd_unit *unit, DBusMessage *reply)
+{
+	DBusMessageIter args, property_iter;
+
+	if (!dbus_message_iter_init(reply, &args)) {
+		dD("Failed to initialize iterator over received dbus message.");
+		return;
+	}
+
+	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_ARRAY || dbus_message_iter_get_element_type(&args) != DBUS_TYPE_DICT_ENTRY) {
+		dD("Expected array of dict_entry argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
+		return;
+	}
+
+	dbus_message_iter_recurse(&args, &property_iter);
+	do {
+		DBusMessageIter dict_entry, value_variant;
+		dbus_message_iter_recurse(&property_iter, &dict_entry);
+
+		if (dbus_message_iter_get_arg_type(&dict_entry) != DBUS_TYPE_STRING) {
+			dD("Expected string as key in dict_entry. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&dict_entry)));
+			return;
+		}
+
+		_DBusBasicValue value;
+		dbus_message_iter_get_basic(&dict_entry, &value);
+		const char *property_name = value.str;
+
+		if (dbus_message_iter_next(&dict_entry) == false) {
+			dW("Expected another field in dict_entry.");
+			return;
+		}
+
+		if (dbus_message_iter_get_arg_type(&dict_entry) != DBUS_TYPE_VARIANT) {
+			dD("Expected variant as value in dict_entry. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&dict_entry)));
+			return;
+		}
+
+		dbus_message_iter_recurse(&dict_entry, &value_variant);
+
+		struct systemd_property *property = systemd_unit_property(unit, property_name);
+		if (property == NULL)
+			return;
+		// DBUS_TYPE_ARRAY is a special case, each element is one value
+		if (dbus_message_iter_get_arg_type(&value_variant) == DBUS_TYPE_ARRAY) {
+			DBusMessageIter array;
+			dbus_message_iter_recurse(&value_variant, &array);
+
+			do {
+				char *element = dbus_value_to_string(&array);
+				if (element == NULL)
+					continue;
+				systemd_property_add(property, element);
+			}
+			while (dbus_message_iter_next(&array));
+		}
+		else {
+			systemd_property_add(property, dbus_value_to_string(&value_variant));
+		}
+	}
+	while (dbus_message_iter_next(&property_iter));
+}
+
+static void systemd_snapshot_fetch_unlocked(struct systemd_snapshot *snap, const char **names, size_t count)
+{
+	struct systemd_unit **fetch = malloc((count > 0 ? count : 1) * sizeof(struct systemd_unit *));
+	struct systemd_unit **load = malloc((count > 0 ? count : 1) * sizeof(struct systemd_unit *));
+	size_t fetch_count = 0, load_count = 0;
+
+	if (fetch == NULL || load == NULL) {
+		dE("Can't allocate memory for %zu systemd units", count);
+		free(fetch);
+		free(load);
+		return;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		struct systemd_unit *unit = oscap_htable_get(snap->units, names[i]);
+
+		/* The unit files are read at once, there is nothing to load */
+		if (snap->conn == NULL)
+			continue;
+		if (unit == NULL) {
+			if (names[i] == NULL || strcmp(names[i], "(null)") == 0)
+				continue;
+			unit = systemd_snapshot_add(snap, names[i], NULL);
+			if (unit == NULL)
+				continue;
+			load[load_count++] = unit;
+		}
+		if (!unit->fetched) {
+			unit->fetched = 1;
+			fetch[fetch_count++] = unit;
+		}
+	}
+
+	if (load_count > 0)
+		systemd_call_units(snap->conn, load, load_count, load_unit_request, load_unit_reply);
+
+	/* Units which couldn't be loaded have no path and no properties */
+	size_t n = 0;
+	for (size_t i = 0; i < fetch_count; ++i) {
+		if (fetch[i]->path != NULL)
+			fetch[n++] = fetch[i];
+	}
+	if (n > 0) {
+		dD("Fetching properties of %zu systemd units", n);
+		systemd_call_units(snap->conn, fetch, n, get_all_request, get_all_reply);
+	}
+
+	free(fetch);
+	free(load);
+}
+
+void systemd_snapshot_fetch(struct systemd_snapshot *snap, const char **names, size_t count)
+{
+	pthread_mutex_lock(&systemd_snapshot_lock);
+	systemd_snapshot_fetch_unlocked(snap, names, count);
+	pthread_mutex_unlock(&systemd_snapshot_lock);
+}
+
+const struct systemd_unit *systemd_snapshot_unit(struct systemd_snapshot *snap, const char *name)
+{
+	struct systemd_unit *unit;
+
+	pthread_mutex_lock(&systemd_snapshot_lock);
+	systemd_snapshot_fetch_unlocked(snap, &name, 1);
+	unit = oscap_htable_get(snap->units, name);
+	if (unit != NULL && unit->path == NULL && snap->conn != NULL)
+		unit = NULL;
+	pthread_mutex_unlock(&systemd_snapshot_lock);
+
+	return unit;
+}
+
+size_t systemd_snapshot_count(const struct systemd_snapshot *snap)
+{
+	return snap->listed_count;
+}
+
+const char *systemd_snapshot_name(const struct systemd_snapshot *snap, size_t index)
+{
+	return snap->listed[index];
+}
+
+/*
+ * Offline mode, the units are read from unit files. Only properties which
+ * can be derived from the files are provided, ie. dependencies, description
+ * and the load and enablement state.
+ */
+
+/* Unit directories in the order of their priority */
+static const char *systemd_unit_dirs[] = {
+	"/etc/systemd/system",
+	"/run/systemd/system",
+	"/usr/local/lib/systemd/system",
+	"/usr/lib/systemd/system",
+	"/lib/systemd/system",
+	NULL
+};
+
+static const char *systemd_unit_suffixes[] = {
+	".service", ".socket", ".target", ".device", ".mount", ".automount",
+	".swap", ".timer", ".path", ".slice", ".scope",
+	NULL
+};
+
+/* Dependency properties read from the [Unit] section */
+static const char *systemd_dependencies[] = {
+	"Requires", "Requisite", "Wants", "BindsTo", "PartOf",
+	"Conflicts", "Before", "After", "OnFailure",
+	NULL
+};
+
+#define SYSTEMD_DEPENDENCIES 9
+
+struct systemd_unit_file {
+	char *description;
+	struct systemd_property deps[SYSTEMD_DEPENDENCIES];
+	bool install;   // has an [Install] section
+	bool masked;
+	bool enabled;
+	char *fragment;
+};
+
+static const char *systemd_unit_suffix(const char *name)
+{
+	const char *dot = strrchr(name, '.');
+
+	if (dot == NULL || dot == name)
+		return NULL;
+	for (int i = 0; systemd_unit_suffixes[i] != NULL; ++i) {
+		if (strcmp(dot, systemd_unit_suffixes[i]) == 0)
+			return dot;
+	}
+	return NULL;
+}
+
+static bool systemd_unit_name_valid(const char *name)
+{
+	const char *suffix = systemd_unit_suffix(name);
+
+	/* Templates without an instance are not units */
+	return suffix != NULL && suffix[-1] != '@';
+}
+
+/*
+ * Resolve symbolic links of the path inside the offline root.
+ * Returns the resolved path without the root or NULL.
+ */
+static char *systemd_resolve(const char *root, const char *path)
+{
+	char *cur = oscap_strdup(path);
+
+	for (int depth = 0; depth < 8; ++depth) {
+		char full[PATH_MAX], target[PATH_MAX];
+		ssize_t len;
+
+		snprintf(full, sizeof full, "%s%s", root, cur);
+		len = readlink(full, target, sizeof target - 1);
+		if (len < 0)
+			return cur;
+		target[len] = '\0';
+
+		if (target[0] == '/') {
+			free(cur);
+			cur = oscap_strdup(target);
+		} else {
+			char *slash = strrchr(cur, '/');
+			char *next = oscap_sprintf("%.*s/%s", (int)(slash - cur), cur, target);
+			free(cur);
+			cur = next;
+		}
+	}
+	free(cur);
+	return NULL;
+}
+
+static void systemd_dep_add_list(struct systemd_property *dep, const char *list)
+{
+	char *copy = oscap_strdup(list);
+	char *saveptr = NULL;
+
+	/* An empty assignment resets the list */
+	if (*list == '\0') {
+		for (size_t i = 0; i < dep->count; ++i)
+			free(dep->values[i]);
+		dep->count = 0;
+	}
+	for (char *tok = strtok_r(copy, " \t", &saveptr); tok != NULL; tok = strtok_r(NULL, " \t", &saveptr))
+		systemd_property_add(dep, oscap_strdup(tok));
+	free(copy);
+}
+
+static void systemd_unit_file_parse(const char *root, const char *path, struct systemd_unit_file *uf)
+{
+	char full[PATH_MAX];
+	char *line = NULL, *logical = NULL;
+	size_t line_size = 0;
+	ssize_t len;
+	enum { SECTION_OTHER, SECTION_UNIT, SECTION_INSTALL } section = SECTION_OTHER;
+	FILE *fp;
+
+	snprintf(full, sizeof full, "%s%s", root, path);
+	fp = fopen(full, "r");
+	if (fp == NULL) {
+		dD("Can't open unit file '%s': %s", full, strerror(errno));
+		return;
+	}
+
+	while ((len = getline(&line, &line_size, fp)) != -1) {
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+			line[--len] = '\0';
+
+		/* Join continuation lines */
+		bool cont = len > 0 && line[len - 1] == '\\';
+		if (cont)
+			line[--len] = '\0';
+		char *joined = logical == NULL ? oscap_strdup(line) : oscap_sprintf("%s %s", logical, line);
+		free(logical);
+		logical = joined;
+		if (cont)
+			continue;
+
+		char *s = logical;
+		while (*s == ' ' || *s == '\t')
+			++s;
+
+		if (*s == '[') {
+			if (strncmp(s, "[Unit]", 6) == 0)
+				section = SECTION_UNIT;
+			else if (strncmp(s, "[Install]", 9) == 0) {
+				section = SECTION_INSTALL;
+				uf->install = true;
+			} else
+				section = SECTION_OTHER;
+		} else if (*s != '#' && *s != ';' && *s != '\0' && section == SECTION_UNIT) {
+			char *eq = strchr(s, '=');
+			if (eq != NULL) {
+				char *key_end = eq, *value = eq + 1;
+				while (key_end > s && (key_end[-1] == ' ' || key_end[-1] == '\t'))
+					--key_end;
+				*key_end = '\0';
+				while (*value == ' ' || *value == '\t')
+					++value;
+
+				if (strcmp(s, "Description") == 0) {
+					free(uf->description);
+					uf->description = oscap_strdup(value);
+				}
+				for (int i = 0; systemd_dependencies[i] != NULL; ++i) {
+					if (strcmp(s, systemd_dependencies[i]) == 0)
+						systemd_dep_add_list(&uf->deps[i], value);
+				}
+			}
+		}
+		free(logical);
+		logical = NULL;
+	}
+
+	free(logical);
+	free(line);
+	fclose(fp);
+}
+
+static int systemd_strcmp_p(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Parse the drop-in files of the unit, files in directories of higher priority win */
+static void systemd_unit_dropins_parse(const char *root, const char *name, struct systemd_unit_file *uf)
+{
+	struct oscap_htable *seen = oscap_htable_new();
+	char **files = NULL;
+	size_t count = 0;
+
+	for (int i = 0; systemd_unit_dirs[i] != NULL; ++i) {
+		char dir[PATH_MAX];
+		struct dirent *ent;
+		DIR *d;
+
+		snprintf(dir, sizeof dir, "%s%s/%s.d", root, systemd_unit_dirs[i], name);
+		d = opendir(dir);
+		if (d == NULL)
+			continue;
+		while ((ent = readdir(d)) != NULL) {
+			size_t len = strlen(ent->d_name);
+			if (len < 6 || strcmp(ent->d_name + len - 5, ".conf") != 0)
+				continue;
+			if (oscap_htable_get(seen, ent->d_name) != NULL)
+				continue;
+			char *path = oscap_sprintf("%s/%s.d/%s", systemd_unit_dirs[i], name, ent->d_name);
+			void *new_files = realloc(files, (count + 1) * sizeof(char *));
+			if (new_files == NULL) {
+				dE("Can't allocate memory for drop-in '%s'", path);
+				free(path);
+				continue;
+			}
+			files = new_files;
+			files[count++] = path;
+			oscap_htable_add(seen, ent->d_name, path);
+		}
+		closedir(d);
+	}
+
+	/* Drop-ins are applied in the order of their file names */
+	char **names = malloc((count > 0 ? count : 1) * sizeof(char *));
+	if (names == NULL) {
+		dE("Can't allocate memory for drop-ins of '%s'", name);
+		count = 0;
+	}
+	for (size_t i = 0; i < count; ++i)
+		names[i] = strrchr(files[i], '/') + 1;
+	qsort(names, count, sizeof(char *), systemd_strcmp_p);
+	for (size_t i = 0; i < count; ++i)
+		systemd_unit_file_parse(root, oscap_htable_get(seen, names[i]), uf);
+
+	free(names);
+	free(files);
+	oscap_htable_free(seen, free);
+}
+
+static void systemd_unit_file_add_props(struct systemd_unit *unit, struct systemd_unit_file *uf)
+{
+	struct systemd_property *property;
+
+	property = systemd_unit_property(unit, "Id");
+	systemd_property_add(property, oscap_strdup(unit->name));
+
+	property = systemd_unit_property(unit, "Description");
+	systemd_property_add(property, oscap_strdup(uf->description != NULL ? uf->description : ""));
+
+	property = systemd_unit_property(unit, "LoadState");
+	systemd_property_add(property, oscap_strdup(uf->masked ? "masked" : "loaded"));
+
+	property = systemd_unit_property(unit, "UnitFileState");
+	systemd_property_add(property, oscap_strdup(uf->masked ? "masked" :
+	                                            uf->enabled ? "enabled" :
+	                                            uf->install ? "disabled" : "static"));
+
+	property = systemd_unit_property(unit, "FragmentPath");
+	systemd_property_add(property, oscap_strdup(uf->masked || uf->fragment == NULL ? "" : uf->fragment));
+
+	for (int i = 0; systemd_dependencies[i] != NULL; ++i) {
+		property = systemd_unit_property(unit, systemd_dependencies[i]);
+		if (property == NULL)
+			return;
+		property->values = uf->deps[i].values;
+		property->count = uf->deps[i].count;
+		uf->deps[i].values = NULL;
+		uf->deps[i].count = 0;
+	}
+}
+
+/*
+ * Add the units from the .wants and .requires directories of the units to
+ * their dependencies. Units linked from /etc are enabled.
+ */
+static void systemd_unit_dirs_deps(const char *root, struct oscap_htable *files)
+{
+	for (int i = 0; systemd_unit_dirs[i] != NULL; ++i) {
+		char dir[PATH_MAX];
+		struct dirent *ent;
+		DIR *d;
+
+		snprintf(dir, sizeof dir, "%s%s", root, systemd_unit_dirs[i]);
+		d = opendir(dir);
+		if (d == NULL)
+			continue;
+		while ((ent = readdir(d)) != NULL) {
+			size_t len = strlen(ent->d_name);
+			const char *kind;
+			int dep;
+
+			if (len > 6 && strcmp(ent->d_name + len - 6, ".wants") == 0) {
+				kind = ".wants";
+				dep = 2; // Wants
+			} else if (len > 9 && strcmp(ent->d_name + len - 9, ".requires") == 0) {
+				kind = ".requires";
+				dep = 0; // Requires
+			} else
+				continue;
+
+			char *owner = oscap_sprintf("%.*s", (int)(len - strlen(kind)), ent->d_name);
+			struct systemd_unit_file *owner_uf = oscap_htable_get(files, owner);
+			char *sub = oscap_sprintf("%s/%s", dir, ent->d_name);
+			struct dirent *link;
+			DIR *sd;
+
+			sd = opendir(sub);
+			while (sd != NULL && (link = readdir(sd)) != NULL) {
+				if (!systemd_unit_name_valid(link->d_name))
+					continue;
+				if (owner_uf != NULL)
+					systemd_property_add(&owner_uf->deps[dep], oscap_strdup(link->d_name));
+				struct systemd_unit_file *linked = oscap_htable_get(files, link->d_name);
+				if (linked != NULL && i == 0)
+					linked->enabled = true;
+			}
+			if (sd != NULL)
+				closedir(sd);
+			free(sub);
+			free(owner);
+		}
+		closedir(d);
+	}
+}
+
+static void systemd_unit_file_free(void *ptr)
+{
+	struct systemd_unit_file *uf = ptr;
+
+	for (int i = 0; i < SYSTEMD_DEPENDENCIES; ++i) {
+		for (size_t j = 0; j < uf->deps[i].count; ++j)
+			free(uf->deps[i].values[j]);
+		free(uf->deps[i].values);
+	}
+	free(uf->description);
+	free(uf->fragment);
+	free(uf);
+}
+
+static struct systemd_snapshot *systemd_snapshot_read_files(const char *root)
+{
+	struct systemd_snapshot *snap;
+	struct oscap_htable *files = oscap_htable_new();
+	char **names = NULL;
+	size_t count = 0;
+	bool found = false;
+
+	for (int i = 0; systemd_unit_dirs[i] != NULL; ++i) {
+		char dir[PATH_MAX];
+		struct dirent *ent;
+		DIR *d;
+
+		snprintf(dir, sizeof dir, "%s%s", root, systemd_unit_dirs[i]);
+		d = opendir(dir);
+		if (d == NULL)
+			continue;
+		found = true;
+		while ((ent = readdir(d)) != NULL) {
+			char path[PATH_MAX], full[PATH_MAX];
+			struct stat st;
+
+			if (!systemd_unit_name_valid(ent->d_name) || oscap_htable_get(files, ent->d_name) != NULL)
+				continue;
+			snprintf(path, sizeof path, "%s/%s", systemd_unit_dirs[i], ent->d_name);
+			char *resolved = systemd_resolve(root, path);
+			if (resolved == NULL)
+				continue;
+
+			struct systemd_unit_file *uf = calloc(1, sizeof(struct systemd_unit_file));
+			void *new_names = realloc(names, (count + 1) * sizeof(char *));
+			if (uf == NULL || new_names == NULL) {
+				dE("Can't allocate memory for unit file '%s'", path);
+				if (new_names != NULL)
+					names = new_names;
+				free(resolved);
+				free(uf);
+				continue;
+			}
+			names = new_names;
+			snprintf(full, sizeof full, "%s%s", root, resolved);
+			if (strcmp(resolved, "/dev/null") == 0 || (stat(full, &st) == 0 && st.st_size == 0))
+				uf->masked = true;
+			else if (stat(full, &st) != 0 || S_ISDIR(st.st_mode)) {
+				free(resolved);
+				free(uf);
+				continue;
+			}
+			uf->fragment = resolved;
+			oscap_htable_add(files, ent->d_name, uf);
+			names[count++] = oscap_strdup(ent->d_name);
+		}
+		closedir(d);
+	}
+
+	if (!found) {
+		dD("No systemd unit directories found in '%s'", root);
+		oscap_htable_free(files, systemd_unit_file_free);
+		free(names);
+		return NULL;
+	}
+
+	qsort(names, count, sizeof(char *), systemd_strcmp_p);
+	for (size_t i = 0; i < count; ++i) {
+		struct systemd_unit_file *uf = oscap_htable_get(files, names[i]);
+		if (!uf->masked) {
+			systemd_unit_file_parse(root, uf->fragment, uf);
+			systemd_unit_dropins_parse(root, names[i], uf);
+		}
+	}
+	systemd_unit_dirs_deps(root, files);
+
+	snap = calloc(1, sizeof(struct systemd_snapshot));
+	if (snap != NULL)
+		snap->units = oscap_htable_new();
+	for (size_t i = 0; i < count; ++i) {
+		struct systemd_unit *unit = snap != NULL ? systemd_snapshot_add(snap, names[i], NULL) : NULL;
+		if (unit != NULL) {
+			unit->fetched = 1;
+			systemd_unit_file_add_props(unit, oscap_htable_get(files, names[i]));
+			systemd_snapshot_list(snap, unit);
+		}
+		free(names[i]);
+	}
+	free(names);
+	oscap_htable_free(files, systemd_unit_file_free);
+
+	if (snap == NULL) {
+		dE("Can't allocate memory for systemd units");
+		return NULL;
+	}
+	dD("Read %zu systemd units from unit files", snap->listed_count);
+	return snap;
+}
+
+struct systemd_snapshot *systemd_snapshot_get(int offline)
+{
+	struct systemd_snapshot *snap;
+
+	pthread_mutex_lock(&systemd_snapshot_lock);
+	if (systemd_snapshot_current == NULL) {
+		DBusConnection *conn = connect_dbus();
+
+		if (conn != NULL) {
+			snap = calloc(1, sizeof(struct systemd_snapshot));
+			if (snap == NULL) {
+				dE("Can't allocate memory for systemd units");
+				disconnect_dbus(conn);
+				pthread_mutex_unlock(&systemd_snapshot_lock);
+				return NULL;
+			}
+			snap->conn = conn;
+			snap->units = oscap_htable_new();
+			if (get_all_systemd_units(conn, systemd_unit_listed, snap) != 0 && snap->listed_count == 0) {
+				systemd_snapshot_free(snap);
+				snap = NULL;
+			}
+			systemd_snapshot_current = snap;
+		} else if (offline) {
+			const char *root = getenv("OSCAP_PROBE_ROOT");
+			systemd_snapshot_current = systemd_snapshot_read_files(root != NULL ? root : "");
+		}
+	}
+	snap = systemd_snapshot_current;
+	pthread_mutex_unlock(&systemd_snapshot_lock);
+
+	return snap;
+}
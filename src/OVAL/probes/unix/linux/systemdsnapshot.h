@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef OPENSCAP_OVAL_PROBES_SYSTEMDSNAPSHOT_H_
+#define OPENSCAP_OVAL_PROBES_SYSTEMDSNAPSHOT_H_
+
+#include <stddef.h>
+
+/*
+ * Snapshot of systemd units shared by the systemdunitproperty and
+ * systemdunitdependency probes.
+ *
+ * The units are listed via D-Bus once, properties of the units are
+ * fetched when a probe asks for them. The requests for more units are
+ * sent at once and their replies are collected afterwards, the units
+ * don't wait for each other. If systemd can't be reached in offline
+ * mode, the units and a subset of their properties are read from the
+ * unit files below OSCAP_PROBE_ROOT.
+ *
+ * The snapshot lives while any of the probes holds a reference.
+ */
+
+/* A property of a unit, array properties have one value per element */
+struct systemd_property {
+	char *name;
+	char **values;
+	size_t count;
+};
+
+struct systemd_unit {
+	char *name;
+	char *path;     // D-Bus object path
+	int fetched;    // properties were requested
+	struct systemd_property *properties;
+	size_t count;
+};
+
+struct systemd_snapshot;
+
+void systemd_snapshot_acquire(void);
+void systemd_snapshot_release(void);
+
+/*
+ * Get the snapshot, list the units if it wasn't done yet. The unit files
+ * are used if D-Bus isn't available and offline is set.
+ * Returns NULL if the units can't be listed.
+ */
+struct systemd_snapshot *systemd_snapshot_get(int offline);
+
+/* Units listed by systemd, in the order of its reply */
+size_t systemd_snapshot_count(const struct systemd_snapshot *snap);
+const char *systemd_snapshot_name(const struct systemd_snapshot *snap, size_t index);
+
+/*
+ * Fetch properties of the units which weren't fetched yet. Units which
+ * weren't listed are loaded by systemd first.
+ */
+void systemd_snapshot_fetch(struct systemd_snapshot *snap, const char **names, size_t count);
+
+/*
+ * Get the unit with its properties, fetch them if needed.
+ * Returns NULL if the unit doesn't exist.
+ */
+const struct systemd_unit *systemd_snapshot_unit(struct systemd_snapshot *snap, const char *name);
+
+#endif
@@ -34,95 +34,12 @@
 #include <probe/probe.h>
 
 #include "probe/entcmp.h"
-#include "systemdshared.h"
+#include "systemdsnapshot.h"
 #include "common/list.h"
 #include <string.h>
 #include "systemdunitdependency_probe.h"
 
-static void get_all_dependencies_by_unit(DBusConnection *conn, const char *unit, SEXP_t *item, struct oscap_htable *visited_units);
-
-static char *get_property_by_unit_path(DBusConnection *conn, const char *unit_path, const char *property)
-{
-	DBusMessage *msg = NULL;
-	DBusPendingCall *pending = NULL;
-	char *ret = NULL;
-
-	msg = dbus_message_new_method_call(
-		"org.freedesktop.systemd1",
-		unit_path,
-		"org.freedesktop.DBus.Properties",
-		"Get"
-	);
-	if (msg == NULL) {
-		dD("Failed to create dbus_message via dbus_message_new_method_call!");
-		goto cleanup;
-	}
-
-	DBusMessageIter args, value_iter;
-
-	const char *interface = "org.freedesktop.systemd1.Unit";
-
-	dbus_message_iter_init_append(msg, &args);
-	if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &interface)) {
-		dD("Failed to append interface '%s' string parameter to dbus message!", interface);
-		goto cleanup;
-	}
-	if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &property)) {
-		dD("Failed to append property '%s' string parameter to dbus message!", property);
-		goto cleanup;
-	}
-
-	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1)) {
-		dD("Failed to send message via dbus!");
-		goto cleanup;
-	}
-	if (pending == NULL) {
-		dD("Invalid dbus pending call!");
-		goto cleanup;
-	}
-
-	dbus_connection_flush(conn);
-	dbus_message_unref(msg); msg = NULL;
-
-	dbus_pending_call_block(pending);
-	msg = dbus_pending_call_steal_reply(pending);
-	if (msg == NULL) {
-		dD("Failed to steal dbus pending call reply.");
-		goto cleanup;
-	}
-	dbus_pending_call_unref(pending); pending = NULL;
-
-	if (!dbus_message_iter_init(msg, &args)) {
-		dD("Failed to initialize iterator over received dbus message.");
-		goto cleanup;
-	}
-
-	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_VARIANT)
-	{
-		dD("Expected variant argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
-		goto cleanup;
-	}
-
-	dbus_message_iter_recurse(&args, &value_iter);
-	ret = dbus_value_to_string(&value_iter);
-
-	dbus_message_unref(msg); msg = NULL;
-
-cleanup:
-	if (pending != NULL)
-		dbus_pending_call_unref(pending);
-
-	if (msg != NULL)
-		dbus_message_unref(msg);
-
-	return ret;
-}
-
-struct unit_callback_vars {
-	DBusConnection *dbus_conn;
-	probe_ctx *ctx;
-	SEXP_t *unit_entity;
-};
+static void get_all_dependencies_by_unit(struct systemd_snapshot *snap, const char *unit, SEXP_t *item, struct oscap_htable *visited_units);
 
 static bool is_unit_name_a_target(const char *unit)
 {
@@ -151,26 +68,26 @@ static int add_unit_dependency(const char *dependency, SEXP_t *item, struct osca
 	return 0;
 }
 
-static void process_unit_property(const char *property, DBusConnection *conn, const char *path, SEXP_t *item, struct oscap_htable *visited_units)
+static void process_unit_property(const char *property, struct systemd_snapshot *snap, const struct systemd_unit *su, SEXP_t *item, struct oscap_htable *visited_units)
 {
-	char *values_s = get_property_by_unit_path(conn, path, property);
-	if (values_s) {
-		char **values = oscap_split(values_s, ", ");
-		for (int i = 0; values[i] != NULL; ++i) {
-			if (oscap_strcmp(values[i], "") == 0) {
+	for (size_t i = 0; i < su->count; ++i) {
+		if (strcmp(su->properties[i].name, property) != 0)
+			continue;
+
+		for (size_t j = 0; j < su->properties[i].count; ++j) {
+			const char *value = su->properties[i].values[j];
+			if (oscap_strcmp(value, "") == 0) {
 				continue;
 			}
 
-			if (add_unit_dependency(values[i], item, visited_units) == 0) {
-				get_all_dependencies_by_unit(conn, values[i], item, visited_units);
+			if (add_unit_dependency(value, item, visited_units) == 0) {
+				get_all_dependencies_by_unit(snap, value, item, visited_units);
 			}
 		}
-		free(values);
 	}
-	free(values_s);
 }
 
-static void get_all_dependencies_by_unit(DBusConnection *conn, const char *unit, SEXP_t *item, struct oscap_htable *visited_units)
+static void get_all_dependencies_by_unit(struct systemd_snapshot *snap, const char *unit, SEXP_t *item, struct oscap_htable *visited_units)
 {
 	if (!unit || strcmp(unit, "(null)") == 0)
 		return;
@@ -179,37 +96,68 @@ static void get_all_dependencies_by_unit(DBusConnection *conn, const char *unit,
 	if (!is_unit_name_a_target(unit))
 		return;
 
-	char *path = get_path_by_unit(conn, unit);
-
-	process_unit_property("Requires", conn, path, item, visited_units);
-	process_unit_property("Wants", conn, path, item, visited_units);
+	const struct systemd_unit *su = systemd_snapshot_unit(snap, unit);
+	if (su == NULL)
+		return;
 
-	free(path);
+	process_unit_property("Requires", snap, su, item, visited_units);
+	process_unit_property("Wants", snap, su, item, visited_units);
 }
 
-static int unit_callback(const char *unit, void *cbarg)
+/*
+ * Fetch the properties of the targets and of all the targets they depend
+ * on, one level of the dependency tree at a time.
+ */
+static void prefetch_targets(struct systemd_snapshot *snap, const char **units, size_t count)
 {
-	struct unit_callback_vars *vars = (struct unit_callback_vars *)cbarg;
-	SEXP_t *se_unit = SEXP_string_new(unit, strlen(unit));
+	struct oscap_htable *seen = oscap_htable_new();
+	const char **level = malloc((count > 0 ? count : 1) * sizeof(char *));
+	size_t level_count = 0;
 
-	if (probe_entobj_cmp(vars->unit_entity, se_unit) != OVAL_RESULT_TRUE) {
-		/* Do nothing, continue with the next unit */
-		SEXP_free(se_unit);
-		return 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (is_unit_name_a_target(units[i]) && oscap_htable_add(seen, units[i], (void *) true))
+			level[level_count++] = units[i];
 	}
 
-	SEXP_t *item = probe_item_create(OVAL_LINUX_SYSTEMDUNITDEPENDENCY, NULL,
-					 "unit", OVAL_DATATYPE_SEXP, se_unit,
-					 NULL);
+	while (level_count > 0) {
+		const char **next = NULL;
+		size_t next_count = 0;
 
-	struct oscap_htable *visited_units = oscap_htable_new();
-	get_all_dependencies_by_unit(vars->dbus_conn, unit, item, visited_units);
-	oscap_htable_free(visited_units, NULL);
+		systemd_snapshot_fetch(snap, level, level_count);
+		for (size_t i = 0; i < level_count; ++i) {
+			const struct systemd_unit *su = systemd_snapshot_unit(snap, level[i]);
+			if (su == NULL)
+				continue;
+			for (size_t j = 0; j < su->count; ++j) {
+				if (strcmp(su->properties[j].name, "Requires") != 0 && strcmp(su->properties[j].name, "Wants") != 0)
+					continue;
+				for (size_t k = 0; k < su->properties[j].count; ++k) {
+					const char *dep = su->properties[j].values[k];
+					if (!is_unit_name_a_target(dep) || !oscap_htable_add(seen, dep, (void *) true))
+						continue;
+					next = realloc(next, (next_count + 1) * sizeof(char *));
+					next[next_count++] = dep;
+				}
+			}
+		}
+		free(level);
+		level = next;
+		level_count = next_count;
+	}
 
-	probe_item_collect(vars->ctx, item);
-	SEXP_free(se_unit);
+	free(level);
+	oscap_htable_free(seen, NULL);
+}
 
-	return 0;
+void *systemdunitdependency_probe_init(void)
+{
+	systemd_snapshot_acquire();
+	return NULL;
+}
+
+void systemdunitdependency_probe_fini(void *probe_arg)
+{
+	systemd_snapshot_release();
 }
 
 int systemdunitdependency_probe_offline_mode_supported(void)
@@ -230,14 +178,9 @@ int systemdunitdependency_probe_main(probe_ctx *ctx, void *probe_arg)
 		return PROBE_EOPNOTSUPP;
 	}
 
-	DBusError dbus_error;
-	DBusConnection *dbus_conn;
+	struct systemd_snapshot *snap = systemd_snapshot_get(ctx->offline_mode != PROBE_OFFLINE_NONE);
 
-	dbus_error_init(&dbus_error);
-	dbus_conn = connect_dbus();
-
-	if (dbus_conn == NULL) {
-		dbus_error_free(&dbus_error);
+	if (snap == NULL) {
 		SEXP_t *msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_INFO, "DBus connection failed, could not identify systemd units.");
 		probe_cobj_set_flag(probe_ctx_getresult(ctx), ctx->offline_mode == PROBE_OFFLINE_NONE ? SYSCHAR_FLAG_ERROR : SYSCHAR_FLAG_NOT_COLLECTED);
 		probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
@@ -247,17 +190,37 @@ int systemdunitdependency_probe_main(probe_ctx *ctx, void *probe_arg)
 
 	unit_entity = probe_obj_getent(probe_in, "unit", 1);
 
-	struct unit_callback_vars vars;
+	size_t count = systemd_snapshot_count(snap);
+	const char **units = malloc((count > 0 ? count : 1) * sizeof(char *));
+	size_t matched = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		const char *unit = systemd_snapshot_name(snap, i);
+		SEXP_t *se_unit = SEXP_string_new(unit, strlen(unit));
+
+		if (probe_entobj_cmp(unit_entity, se_unit) == OVAL_RESULT_TRUE)
+			units[matched++] = unit;
+		SEXP_free(se_unit);
+	}
+
+	prefetch_targets(snap, units, matched);
 
-	vars.dbus_conn = dbus_conn;
-	vars.ctx = ctx;
-	vars.unit_entity = unit_entity;
+	for (size_t i = 0; i < matched; ++i) {
+		SEXP_t *se_unit = SEXP_string_new(units[i], strlen(units[i]));
+		SEXP_t *item = probe_item_create(OVAL_LINUX_SYSTEMDUNITDEPENDENCY, NULL,
+						 "unit", OVAL_DATATYPE_SEXP, se_unit,
+						 NULL);
 
-	get_all_systemd_units(dbus_conn, unit_callback, &vars);
+		struct oscap_htable *visited_units = oscap_htable_new();
+		get_all_dependencies_by_unit(snap, units[i], item, visited_units);
+		oscap_htable_free(visited_units, NULL);
+
+		probe_item_collect(ctx, item);
+		SEXP_free(se_unit);
+	}
 
+	free(units);
 	SEXP_free(unit_entity);
-	dbus_error_free(&dbus_error);
-	disconnect_dbus(dbus_conn);
 
         return 0;
 }
@@ -27,6 +27,10 @@
 
 int systemdunitdependency_probe_offline_mode_supported(void);
 
+void *systemdunitdependency_probe_init(void);
+
+void systemdunitdependency_probe_fini(void *arg);
+
 int systemdunitdependency_probe_main(probe_ctx *ctx, void *arg);
 
 #endif /* OPENSCAP_SYSTEMDUNITDEPENDENCY_PROBE_H */
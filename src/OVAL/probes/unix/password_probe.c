@@ -49,15 +49,6 @@
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
-#include <pwd.h>
-#include <paths.h>
-#if defined(OS_APPLE)
-#include <utmp.h>
-#elif defined(OS_FREEBSD)
-#include <utmpx.h>
-#else
-#include <lastlog.h>
-#endif
 
 #include "_seap.h"
 #include "probe-api.h"
@@ -66,6 +57,7 @@
 #include <probe/probe.h>
 #include <probe/option.h>
 #include "password_probe.h"
+#include "userdb.h"
 
 /* Convenience structure for the results being reported */
 struct result_info {
@@ -103,70 +95,44 @@ static void report_finding(struct result_info *res, probe_ctx *ctx, oval_schema_
         probe_item_collect(ctx, item);
 }
 
-#if defined(OS_FREEBSD)
-static time_t get_last_login(char *username) {
-        struct utmpx *ut;
-        time_t t = 0;
-
-        /* Iterate over the entries of the utx.log file */
-        while ((ut = getutxent()) != NULL) {
-                if (strcmp(username,ut->ut_user) == 0) {
-                        t = ut->ut_tv.tv_sec;
-                        break;
-                }
-        }
-
-        endutxent();
-
-        return t;
-}
-#endif
-
-
 static int read_password(SEXP_t *un_ent, probe_ctx *ctx, oval_schema_version_t over)
 {
-        struct passwd *pw;
-
-        while ((pw = getpwent())) {
+        const struct userdb_table *table;
+        const struct userdb_passwd *users;
+        size_t *positions, count;
+
+        table = userdb_passwd();
+        if (table == NULL)
+                return 0;
+        users = table->entries;
+
+        count = userdb_select(table, un_ent, &positions);
+        for (size_t i = 0; i < count; ++i) {
+                const struct userdb_passwd *pw = &users[positions[i]];
                 SEXP_t *un;
 
-                dI("Have user: %s", pw->pw_name);
-                un = SEXP_string_newf("%s", pw->pw_name);
+                dI("Have user: %s", pw->name);
+                un = SEXP_string_newf("%s", pw->name);
                 if (probe_entobj_cmp(un_ent, un) == OVAL_RESULT_TRUE) {
                         struct result_info r;
 
-                        r.username = pw->pw_name;
-                        r.password = pw->pw_passwd;
-                        r.user_id = pw->pw_uid;
-                        r.group_id = pw->pw_gid;
-                        r.gcos = pw->pw_gecos;
-                        r.home_dir = pw->pw_dir;
-                        r.login_shell = pw->pw_shell;
+                        r.username = pw->name;
+                        r.password = pw->passwd;
+                        r.user_id = pw->uid;
+                        r.group_id = pw->gid;
+                        r.gcos = pw->gecos;
+                        r.home_dir = pw->dir;
+                        r.login_shell = pw->shell;
                         r.last_login = -1;
 
-                        if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) >= 0) {
-
-#if defined(OS_FREEBSD)
-				r.last_login = get_last_login(pw->pw_name);
-#else
-				FILE *ll_fp = fopen(_PATH_LASTLOG, "r");
-
-	                        if (ll_fp != NULL) {
-		                        struct lastlog ll;
-
-		                        if (fseeko(ll_fp, (off_t)pw->pw_uid * sizeof(ll), SEEK_SET) == 0)
-			                        if (fread((char *)&ll, sizeof(ll), 1, ll_fp) == 1)
-				                        r.last_login = (int64_t)ll.ll_time;
-		                        fclose(ll_fp);
-	                        }
-#endif
-			}
+                        if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) >= 0)
+                                r.last_login = userdb_last_login(positions[i]);
 
                         report_finding(&r, ctx, over);
                 }
                 SEXP_free(un);
         }
-        endpwent();
+        free(positions);
         return 0;
 }
 
@@ -193,3 +159,14 @@ int password_probe_main(probe_ctx *ctx, void *arg)
 
         return 0;
 }
+
+void *password_probe_init(void)
+{
+	userdb_acquire();
+	return NULL;
+}
+
+void password_probe_fini(void *arg)
+{
+	userdb_release();
+}
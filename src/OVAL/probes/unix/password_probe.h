@@ -26,5 +26,7 @@
 #include "probe-api.h"
 
 int password_probe_main(probe_ctx *ctx, void *arg);
+void *password_probe_init(void);
+void password_probe_fini(void *arg);
 
 #endif /* OPENSCAP_PASSWORD_PROBE_H */
@@ -105,8 +105,8 @@ extern char const *_cap_names[];
 #include "common/oscap_buffer.h"
 #include "process58_probe.h"
 #include "oscap_helpers.h"
+#include "procsnap.h"
 
-#define CHUNK_SIZE 1024
 
 /* Convenience structure for the results being reported */
 struct result_info {
@@ -186,8 +186,8 @@ static void get_boot_time(void)
 
 static int get_uids(int pid, struct result_info *r)
 {
-	char buf[PATH_MAX];
-	FILE *sf;
+	const struct procsnap_blob *file;
+	const char *uid;
 
 	r->ruid = -1;
 	r->user_id = -1;
@@ -195,31 +195,18 @@ static int get_uids(int pid, struct result_info *r)
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 
-	snprintf(buf, sizeof(buf), "%s/proc/%d/status", prefix ? prefix : "", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		int line = 0;
-		__fsetlocking(sf, FSETLOCKING_BYCALLER);
-		while (fgets(buf, sizeof(buf), sf)) {
-			if (line == 0) {
-				line++;
-				continue;
-			}
-			if (memcmp(buf, "Uid:", 4) == 0) {
-				sscanf(buf, "Uid: %d %d", &r->ruid, &r->user_id);
-				break;
-			}
-		}
-		fclose(sf);
+	file = procsnap_file(prefix, pid, PROCSNAP_STATUS);
+	if (file != NULL && file->error == 0) {
+		uid = strstr(file->data, "\nUid:");
+		if (uid != NULL)
+			sscanf(uid + 1, "Uid: %d %d", &r->ruid, &r->user_id);
 	}
 
-	snprintf(buf, sizeof(buf), "%s/proc/%d/loginuid", prefix ? prefix : "", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		if (fscanf(sf, "%u", &r->loginuid) < 1) {
-			dW("fscanf failed from %s", buf);
+	file = procsnap_file(prefix, pid, PROCSNAP_LOGINUID);
+	if (file != NULL && file->error == 0) {
+		if (sscanf(file->data, "%u", &r->loginuid) < 1) {
+			dW("sscanf failed on loginuid of process %d", pid);
 		}
-		fclose(sf);
 	}
 
 	return 0;
@@ -359,8 +346,10 @@ exit:
 /* get exec shield status according to http://people.redhat.com/sgrubb/files/lsexec
  * return value: -1 - not detected, 0 - disabled, 1 - enabled */
 static int get_exec_shield_status(int pid) {
-	char buf[PATH_MAX];
-	FILE *sf;
+	const struct procsnap_blob *maps;
+	const char *line, *end;
+	char buf[500];
+	size_t len;
 	long unsigned low, high, inode;
 	long long unsigned offset;
 	int dev_min, dev_maj;
@@ -368,12 +357,20 @@ static int get_exec_shield_status(int pid) {
 	int ret = -1, read_items;
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
-	snprintf(buf, sizeof(buf), "%s/proc/%d/maps", prefix ? prefix : "", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		while (fgets(buf, 500, sf)) {
+	maps = procsnap_file(prefix, pid, PROCSNAP_MAPS);
+	if (maps != NULL && maps->error == 0) {
+		for (line = maps->data; line < maps->data + maps->size; line = end + 1) {
+			end = memchr(line, '\n', maps->data + maps->size - line);
+			if (end == NULL)
+				end = maps->data + maps->size;
+			// one line at a time, the path is optional
+			len = end - line;
+			if (len >= sizeof(buf))
+				len = sizeof(buf) - 1;
+			memcpy(buf, line, len);
+			buf[len] = '\0';
 			read_items = sscanf(
-				buf, "%lx-%lx rw%s %llx %x:%x %lu %c\n",
+				buf, "%lx-%lx rw%2s %llx %x:%x %lu %c\n",
 				&low, &high, perm, &offset, &dev_min,
 				&dev_maj, &inode, &trim
 			);
@@ -386,7 +383,6 @@ static int get_exec_shield_status(int pid) {
 				}
 			}
 		}
-		fclose(sf);
 	}
 
 	return ret;
@@ -394,39 +390,18 @@ static int get_exec_shield_status(int pid) {
 
 /**
  * Parse /proc/%d/cmdline file
- * @param filepath Path to file ~ use preallocated buffer for the path
+ * @param cmdline Contents of the file from the process snapshot
  * @param buffer output buffer with non-zero size
  * @return ps-like command info or NULL
  */
-static inline bool get_process_cmdline(const char* filepath, struct oscap_buffer* const buffer){
-
-	int fd = open(filepath, O_RDONLY, 0);
+static inline bool get_process_cmdline(const struct procsnap_blob *cmdline, struct oscap_buffer* const buffer){
 
-	if (fd < 0) {
+	if (cmdline == NULL || cmdline->error != 0) {
 		return false;
 	}
 
 	oscap_buffer_clear(buffer);
-
-
-
-	for(;;) {
-		char chunk[CHUNK_SIZE];
-		// Read data, store to buffer
-		ssize_t read_size = read(fd, chunk, CHUNK_SIZE);
-		if (read_size < 0) {
-			close(fd);
-			return false;
-		}
-		oscap_buffer_append_binary_data(buffer, chunk, read_size);
-
-		// If reach end of file, then end the loop
-		if (CHUNK_SIZE != read_size) {
-			break;
-		}
-	}
-
-	close(fd);
+	oscap_buffer_append_binary_data(buffer, cmdline->data, cmdline->size);
 
 	int length = oscap_buffer_get_length(buffer);
 	char* buffer_mem = oscap_buffer_get_raw(buffer);
@@ -473,14 +448,12 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 {
 	char buf[PATH_MAX];
 	int err = PROBE_EACCESS, max_cap_id;
-	DIR *d;
-	struct dirent *ent;
+	const pid_t *pids;
+	size_t count;
 	oval_schema_version_t oval_version;
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
-	snprintf(buf, PATH_MAX, "%s/proc", prefix ? prefix : "");
-	d = opendir(buf);
-	if (d == NULL) {
+	if (procsnap_pids(prefix, &pids, &count) != 0) {
 		return prefix ? PROBE_ESUCCESS : PROBE_EACCESS;
 	}
 
@@ -500,9 +473,13 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 	char cmd_buffer[1 + 15 + 11 + 1]; // Format:" [ cmd:15 ] <defunc>"
 	cmd_buffer[0] = '[';
 
-	// Scan the directories
-	while (( ent = readdir(d) )) {
-		int fd, len;
+	// Every process is matched by its stat and command line
+	procsnap_prefetch(prefix, PROCSNAP_MASK(PROCSNAP_STAT) | PROCSNAP_MASK(PROCSNAP_CMDLINE));
+
+	// Scan the processes
+	for (size_t i = 0; i < count; ++i) {
+		const struct procsnap_blob *stat_file;
+		size_t len;
 		char *tmp, state, tty_dev[128];
 		int pid, ppid, pgrp, session, tty_nr, tpgid;
 		unsigned flags, sched_policy;
@@ -511,23 +488,16 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		unsigned long long start;
 		SEXP_t *cmd_sexp = NULL, *pid_sexp = NULL;
 
-		// Skip non-process58 dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno || pid == 2) // skip err & kthreads
+		pid = pids[i];
+		if (pid == 2) // skip kthreads
 			continue;
 
 		// Parse up the stat file for the proc
-		snprintf(buf, PATH_MAX, "%s/proc/%d/stat", prefix ? prefix : "", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
+		stat_file = procsnap_file(prefix, pid, PROCSNAP_STAT);
+		if (stat_file == NULL || stat_file->error != 0 || stat_file->size < 40)
 			continue;
+		len = stat_file->size < sizeof buf - 1 ? stat_file->size : sizeof buf - 1;
+		memcpy(buf, stat_file->data, len);
 		buf[len] = 0;
 		tmp = strrchr(buf, ')');
 		if (tmp)
@@ -554,8 +524,7 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		if (state == 'Z') { // zombie
 			cmd = make_defunc_str(cmd_buffer);
 		} else {
-			snprintf(buf, PATH_MAX, "%s/proc/%d/cmdline", prefix ? prefix : "", pid);
-			if (get_process_cmdline(buf, cmdline_buffer)) {
+			if (get_process_cmdline(procsnap_file(prefix, pid, PROCSNAP_CMDLINE), cmdline_buffer)) {
 				cmd = oscap_buffer_get_raw(cmdline_buffer); // use full cmdline
 			} else {
 				cmd = cmd_buffer + 1;
@@ -660,7 +629,6 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		SEXP_free(cmd_sexp);
 		SEXP_free(pid_sexp);
 	}
-        closedir(d);
 	oscap_buffer_free(cmdline_buffer);
 	return err;
 }
@@ -850,3 +818,18 @@ int process58_probe_main(probe_ctx *ctx, void *arg)
 	return 0;
 }
 #endif /* __linux */
+
+void *process58_probe_init(void)
+{
+#if defined(OS_LINUX)
+	procsnap_acquire();
+#endif
+	return NULL;
+}
+
+void process58_probe_fini(void *arg)
+{
+#if defined(OS_LINUX)
+	procsnap_release();
+#endif
+}
@@ -57,6 +57,7 @@
 #include "common/debug_priv.h"
 #include "process_probe.h"
 #include "oscap_helpers.h"
+#include "procsnap.h"
 
 #if defined(OS_FREEBSD)
 #include <kvm.h>
@@ -150,28 +151,17 @@ static void get_boot_time(void)
 
 static int get_uids(int pid, struct result_info *r)
 {
-	char buf[100];
-	FILE *sf;
+	const struct procsnap_blob *status;
+	const char *uid;
 
 	r->ruid = -1;
 	r->user_id = -1;
 
-	snprintf(buf, sizeof(buf), "/proc/%d/status", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		int line = 0;
-		__fsetlocking(sf, FSETLOCKING_BYCALLER);
-		while (fgets(buf, sizeof(buf), sf)) {
-			if (line == 0) {
-				line++;
-				continue;
-			}
-			if (memcmp(buf, "Uid:", 4) == 0) {
-				sscanf(buf, "Uid: %d %d", &r->ruid, &r->user_id);
-				break;
-			}
-		}
-		fclose(sf);
+	status = procsnap_file(NULL, pid, PROCSNAP_STATUS);
+	if (status != NULL && status->error == 0) {
+		uid = strstr(status->data, "\nUid:");
+		if (uid != NULL)
+			sscanf(uid + 1, "Uid: %d %d", &r->ruid, &r->user_id);
 	}
 
 	return 0;
@@ -198,20 +188,22 @@ static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 {
 	int err = 1;
-	DIR *d;
-	struct dirent *ent;
+	const pid_t *pids;
+	size_t count;
 
-	d = opendir("/proc");
-	if (d == NULL)
+	if (procsnap_pids(NULL, &pids, &count) != 0)
 		return err;
 
 	// Get the time tick hertz
 	ticks = (unsigned long)sysconf(_SC_CLK_TCK);
 	get_boot_time();
 
-	// Scan the directories
-	while (( ent = readdir(d) )) {
-		int fd, len;
+	procsnap_prefetch(NULL, PROCSNAP_MASK(PROCSNAP_STAT));
+
+	// Scan the processes
+	for (size_t i = 0; i < count; ++i) {
+		const struct procsnap_blob *stat_file;
+		size_t len;
 		char buf[256];
 		char *tmp, cmd[16], state, tty_dev[128];
 		int pid, ppid, pgrp, session, tty_nr, tpgid;
@@ -221,23 +213,16 @@ static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 		unsigned long long start;
 		SEXP_t *cmd_sexp;
 
-		// Skip non-process dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno || pid == 2) // skip err & kthreads
+		pid = pids[i];
+		if (pid == 2) // skip kthreads
 			continue;
 
 		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
+		stat_file = procsnap_file(NULL, pid, PROCSNAP_STAT);
+		if (stat_file == NULL || stat_file->error != 0 || stat_file->size < 40)
 			continue;
+		len = stat_file->size < sizeof buf - 1 ? stat_file->size : sizeof buf - 1;
+		memcpy(buf, stat_file->data, len);
 		buf[len] = 0;
 		tmp = strrchr(buf, ')');
 		if (tmp)
@@ -333,7 +318,6 @@ static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 		}
 		SEXP_free(cmd_sexp);
 	}
-        closedir(d);
 
 	return err;
 }
@@ -675,3 +659,18 @@ int process_probe_main(probe_ctx *ctx, void *arg)
 	return 0;
 }
 #endif /* __linux */
+
+void *process_probe_init(void)
+{
+#if defined(OS_LINUX)
+	procsnap_acquire();
+#endif
+	return NULL;
+}
+
+void process_probe_fini(void *arg)
+{
+#if defined(OS_LINUX)
+	procsnap_release();
+#endif
+}
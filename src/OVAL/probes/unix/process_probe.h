@@ -26,5 +26,7 @@
 #include "probe-api.h"
 
 int process_probe_main(probe_ctx *ctx, void *arg);
+void *process_probe_init(void);
+void process_probe_fini(void *arg);
 
 #endif /* OPENSCAP_PROCESS_PROBE_H */
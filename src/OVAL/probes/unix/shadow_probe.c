@@ -60,6 +60,7 @@
 #include <probe/probe.h>
 #include <probe/option.h>
 #include "shadow_probe.h"
+#include "userdb.h"
 
 #ifndef HAVE_SHADOW_H
 int shadow_probe_main(probe_ctx *ctx, void *arg)
@@ -179,34 +180,41 @@ static void report_finding(struct result_info *res, probe_ctx *ctx)
 
 static int read_shadow(SEXP_t *un_ent, probe_ctx *ctx)
 {
-	int err = 1;
-	struct spwd *pw;
-
-	while ((pw = getspent())) {
+	const struct userdb_table *table;
+	const struct userdb_shadow *users;
+	size_t *positions, count;
+
+	table = userdb_shadow();
+	if (table == NULL)
+		return 1;
+	users = table->entries;
+
+	count = userdb_select(table, un_ent, &positions);
+	for (size_t i = 0; i < count; ++i) {
+		const struct userdb_shadow *pw = &users[positions[i]];
 		SEXP_t *un;
 
-		dI("Have user: %s", pw->sp_namp);
-		err = 0;
-		un = SEXP_string_newf("%s", pw->sp_namp);
+		dI("Have user: %s", pw->name);
+		un = SEXP_string_newf("%s", pw->name);
 		if (probe_entobj_cmp(un_ent, un) == OVAL_RESULT_TRUE) {
 			struct result_info r;
 
-			r.username = pw->sp_namp;
-			r.password = pw->sp_pwdp;
-			r.chg_lst = pw->sp_lstchg;
-			r.chg_allow = pw->sp_min;
-			r.chg_req = pw->sp_max;
-			r.exp_warn = pw->sp_warn;
-			r.exp_inact = pw->sp_inact;
-			r.exp_date = pw->sp_expire;
-			r.flag = pw->sp_flag;
+			r.username = pw->name;
+			r.password = pw->passwd;
+			r.chg_lst = pw->lstchg;
+			r.chg_allow = pw->min;
+			r.chg_req = pw->max;
+			r.exp_warn = pw->warn;
+			r.exp_inact = pw->inact;
+			r.exp_date = pw->expire;
+			r.flag = pw->flag;
 
 			report_finding(&r, ctx);
 		}
 		SEXP_free(un);
 	}
-	endspent();
-	return err;
+	free(positions);
+	return table->count > 0 ? 0 : 1;
 }
 
 int shadow_probe_main(probe_ctx *ctx, void *arg)
@@ -227,3 +235,14 @@ int shadow_probe_main(probe_ctx *ctx, void *arg)
 	return 0;
 }
 #endif /* HAVE_SHADOW_H */
+
+void *shadow_probe_init(void)
+{
+	userdb_acquire();
+	return NULL;
+}
+
+void shadow_probe_fini(void *arg)
+{
+	userdb_release();
+}
@@ -26,5 +26,7 @@
 #include "probe-api.h"
 
 int shadow_probe_main(probe_ctx *ctx, void *arg);
+void *shadow_probe_init(void);
+void shadow_probe_fini(void *arg);
 
 #endif /* OPENSCAP_SHADOW_PROBE_H */
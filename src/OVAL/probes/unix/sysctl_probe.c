@@ -49,237 +49,554 @@
 #if defined(OS_LINUX)
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
 #include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include "oval_fts.h"
 #include "common/debug_priv.h"
+#include "common/oscap_parallel.h"
 
 #define PROC_SYS_DIR "/proc/sys"
 #define PROC_SYS_MAXDEPTH 7
+#define PROC_SYS_IPV6_CONF PROC_SYS_DIR "/net/ipv6/conf/"
+
+/* Maximal size of a sysctl value we read */
+#define SYSCTL_VALUE_MAX 8192
+/* Number of snapshot entries read by one parallel task */
+#define SYSCTL_SNAPSHOT_CHUNK 64
+
+#define SYSCTL_VALUE_OK    0
+#define SYSCTL_VALUE_SKIP  1
+#define SYSCTL_VALUE_ERROR 2
+/* The value was read, but there was no memory to keep it in the snapshot */
+#define SYSCTL_VALUE_NOMEM 3
+
+struct sysctl_entry {
+	char *mib;
+	char *path;
+	char *value;
+	long  len;
+	int   status;
+};
 
-int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
+/*
+ * Values of all readable sysctls, read once per probe session when the
+ * first object which can't use direct access is queried. The snapshot is
+ * immutable once built, objects are matched against it in memory.
+ */
+struct sysctl_snapshot {
+	pthread_mutex_t lock;
+	int built;
+	struct sysctl_entry *entries;
+	size_t count;
+};
+
+void *sysctl_probe_init(void)
 {
-        OVAL_FTS    *ofts;
-        OVAL_FTSENT *ofts_ent;
+	struct sysctl_snapshot *snap = calloc(1, sizeof(struct sysctl_snapshot));
 
-        SEXP_t *name_entity, *probe_in;
-        SEXP_t *r0, *r1, *r2, *r3;
-        SEXP_t *ent_attrs, *bh_entity, *path_entity, *filename_entity;
-        oval_schema_version_t over;
-        int over_cmp;
+	if (snap == NULL)
+		return NULL;
+	pthread_mutex_init(&snap->lock, NULL);
+	return snap;
+}
 
-	const char *ipv6_conf_path = "/proc/sys/net/ipv6/conf/";
-	size_t ipv6_conf_path_len = strlen(ipv6_conf_path);
+static void sysctl_snapshot_clear(struct sysctl_snapshot *snap)
+{
+	for (size_t i = 0; i < snap->count; i++) {
+		free(snap->entries[i].mib);
+		free(snap->entries[i].path);
+		free(snap->entries[i].value);
+	}
+	free(snap->entries);
+	snap->entries = NULL;
+	snap->count = 0;
+}
 
-        probe_in    = probe_ctx_getobject(ctx);
-        name_entity = probe_obj_getent(probe_in, "name", 1);
-        over        = probe_obj_get_platform_schema_version(probe_in);
-        over_cmp    = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10));
+void sysctl_probe_fini(void *probe_arg)
+{
+	struct sysctl_snapshot *snap = probe_arg;
 
-        if (name_entity == NULL) {
-                dE("Missing \"name\" entity in the input object");
-                return (PROBE_ENOENT);
-        }
+	if (snap == NULL)
+		return;
+
+	sysctl_snapshot_clear(snap);
+	pthread_mutex_destroy(&snap->lock);
+	free(snap);
+}
+
+static char *sysctl_path_to_mib(const char *mibpath)
+{
+	char *mib = strdup(mibpath + strlen(PROC_SYS_DIR) + 1);
+
+	if (mib == NULL)
+		return NULL;
+
+	for (char *c = mib; *c != '\0'; ++c) {
+		if (*c == '/')
+			*c = '.';
+	}
+	return mib;
+}
+
+/*
+ * Read the value of the sysctl at mibpath into sysval, which has to have
+ * at least SYSCTL_VALUE_MAX bytes. Returns SYSCTL_VALUE_SKIP for values
+ * the sysctl tool doesn't show either.
+ */
+static int sysctl_read_value(const char *mibpath, char *sysval, long *len)
+{
+	FILE *fp;
+	long l;
+
+	fp = fopen(mibpath, "r");
+
+	if (fp == NULL) {
+		dE("Can't read sysctl value from \"%s\": %u, %s",
+		   mibpath, errno, strerror(errno));
+		return SYSCTL_VALUE_ERROR;
+	}
+
+	l = fread(sysval, 1, SYSCTL_VALUE_MAX - 1, fp);
+
+	if (ferror(fp)) {
+		const char *file = strrchr(mibpath, '/') + 1;
+
+		fclose(fp);
+		/* Linux 4.1.0 introduced a per-NIC IPv6 stable_secret file.
+		 * The stable_secret file cannot be read until it is set,
+		 * so we skip it when it is not readable. Otherwise we collect it.
+		 */
+		if (strncmp(mibpath, PROC_SYS_IPV6_CONF, strlen(PROC_SYS_IPV6_CONF)) == 0 &&
+		    strcmp(file, "stable_secret") == 0) {
+			dD("Skipping file %s", mibpath);
+			return SYSCTL_VALUE_SKIP;
+		}
+		dE("An error ocured when reading from \"%s\": l=%ld, %u, %s",
+		   mibpath, l, errno, strerror(errno));
+		return SYSCTL_VALUE_ERROR;
+	}
+
+	fclose(fp);
+
+	/* Skip empty values as sysctl tool does.
+	 * See https://bugzilla.redhat.com/show_bug.cgi?id=1473207
+	 */
+	if (l == 0) {
+		dD("Skipping file '%s' because it has no value.", mibpath);
+		return SYSCTL_VALUE_SKIP;
+	}
+
+	*len = l;
+	return SYSCTL_VALUE_OK;
+}
+
+/*
+ * Collect an item of the sysctl. The value in sysval is sanitized in place,
+ * so the buffer has to have at least l + 1 bytes.
+ */
+static void sysctl_collect(probe_ctx *ctx, SEXP_t *se_mib, int status, char *sysval, long l, int over_cmp)
+{
+	SEXP_t *item;
+	char   *sysvals[512];
+	long    i;
+	size_t  s;
+
+	if (status == SYSCTL_VALUE_SKIP)
+		return;
+
+	if (status == SYSCTL_VALUE_ERROR) {
+		item = probe_item_create(OVAL_UNIX_SYSCTL, NULL, NULL);
+		probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
+		probe_item_collect(ctx, item);
+		return;
+	}
+
+	/*
+	 * sanitize the value
+	 *  - only printable and whitespace chars allowed
+	 *  - remove the last '\n'
+	 */
+	sysvals[0] = sysval;
+
+	for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
+		if ((!isprint(sysval[i]) && !isspace(sysval[i]))
+		    || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
+		{
+			sysval[i] = '\0';
+			sysvals[++s] = sysval + i + 1;
+		}
+	}
+
+	if (sysval[l - 1] == '\n')
+		sysval[l - 1] = '\0';
+	else
+		sysval[l] = '\0';
+
+	if (strlen(sysvals[s]) == 0)
+		sysvals[s] = NULL;
+	else
+		sysvals[++s] = NULL;
+
+	if (over_cmp >= 0) {
+		/* Only in OVAL 5.10 and above */
+		item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+		                         "name",  OVAL_DATATYPE_SEXP,   se_mib,
+		                         "value", OVAL_DATATYPE_STRING_M, sysvals,
+		                         NULL);
+	} else {
+		item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+		                         "name",  OVAL_DATATYPE_SEXP,   se_mib,
+		                         "value", OVAL_DATATYPE_STRING, sysval,
+		                         NULL);
+	}
+
+	probe_item_collect(ctx, item);
+}
+
+/* Same conditions as the sysctl utility uses in sysctl.c in ReadSetting() */
+static int sysctl_readable(const char *mibpath)
+{
+	struct stat file_stat;
+
+	if (stat(mibpath, &file_stat) == -1) {
+		dE("Stat failed on %s: %u, %s", mibpath, errno, strerror(errno));
+		return 0;
+	}
+	/* Skip write-only files, eg. /proc/sys/net/ipv4/route/flush */
+	if ((file_stat.st_mode & S_IRUSR) == 0) {
+		dD("Skipping write-only file %s", mibpath);
+		return 0;
+	}
+	return 1;
+}
+
+static int sysctl_probe_file(probe_ctx *ctx, SEXP_t *name_entity, const char *mibpath, int over_cmp)
+{
+	SEXP_t *se_mib;
+	char   *mib, sysval[SYSCTL_VALUE_MAX];
+	long    l = 0;
+
+	if (!sysctl_readable(mibpath))
+		return (0);
+
+	mib = sysctl_path_to_mib(mibpath);
+	if (mib == NULL) {
+		dE("Can't allocate the MIB name of %s", mibpath);
+		return (PROBE_ENOMEM);
+	}
+	dD("MIB: %s", mib);
+	se_mib = SEXP_string_new(mib, strlen(mib));
+	free(mib);
+
+	if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE) {
+		dD("MIB match");
+		int status = sysctl_read_value(mibpath, sysval, &l);
+		sysctl_collect(ctx, se_mib, status, sysval, l, over_cmp);
+	}
+
+	SEXP_free(se_mib);
+	return (0);
+}
+
+/*
+ * Find the files of the sysctl named name below the directory in path.
+ * Dots in the name separate the path components, but they can be also
+ * a part of a component, eg. in net.ipv4.conf.eth0.100.forwarding, so
+ * every split of the name is tried.
+ */
+static int sysctl_probe_resolve(probe_ctx *ctx, SEXP_t *name_entity, char *path, size_t path_len,
+                                const char *name, int depth, int over_cmp)
+{
+	struct stat st;
+	int ret = 0;
+
+	for (size_t k = 1; ; ++k) {
+		if (name[k] != '.' && name[k] != '\0')
+			continue;
+		if (path_len + 1 + k >= PATH_MAX)
+			break;
+
+		path[path_len] = '/';
+		memcpy(path + path_len + 1, name, k);
+		path[path_len + 1 + k] = '\0';
+
+		if ((k == 1 && name[0] == '.') || (k == 2 && name[0] == '.' && name[1] == '.')) {
+			/* "." and ".." are not sysctls */
+		} else if (name[k] == '\0') {
+			if (stat(path, &st) == 0 && !S_ISDIR(st.st_mode))
+				ret = sysctl_probe_file(ctx, name_entity, path, over_cmp);
+			break;
+		} else if (depth < PROC_SYS_MAXDEPTH && stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+			ret = sysctl_probe_resolve(ctx, name_entity, path, path_len + 1 + k,
+			                           name + k + 1, depth + 1, over_cmp);
+			if (ret != 0)
+				break;
+		}
+	}
+	path[path_len] = '\0';
+	return ret;
+}
+
+/*
+ * Collect sysctls of an object with the "equals" operation. Only the files
+ * of the names listed in the object are read.
+ */
+static int sysctl_probe_direct(probe_ctx *ctx, SEXP_t *name_entity, int over_cmp)
+{
+	SEXP_t *vals, *val;
+	char path[PATH_MAX];
+	char **seen;
+	size_t seen_cnt = 0;
+	int ret = 0;
+
+	if (probe_ent_getvals(name_entity, &vals) == 0) {
+		SEXP_free(vals);
+		return (0);
+	}
+
+	seen = malloc(SEXP_list_length(vals) * sizeof(char *));
+	if (seen == NULL) {
+		dE("Can't allocate the list of sysctl names");
+		SEXP_free(vals);
+		return (PROBE_ENOMEM);
+	}
+
+	SEXP_list_foreach(val, vals) {
+		char *name;
+		size_t i;
+
+		/* SEXP_list_foreach() can't be left with a break */
+		if (ret != 0)
+			continue;
+
+		name = SEXP_string_cstr(val);
+		if (name == NULL)
+			continue;
+
+		for (i = 0; i < seen_cnt; ++i) {
+			if (strcmp(seen[i], name) == 0)
+				break;
+		}
+		/* Names can't be empty, contain a '/' or start with a '.' */
+		if (i < seen_cnt || name[0] == '\0' || name[0] == '.' || strchr(name, '/') != NULL) {
+			free(name);
+			continue;
+		}
+		seen[seen_cnt++] = name;
+
+		strcpy(path, PROC_SYS_DIR);
+		ret = sysctl_probe_resolve(ctx, name_entity, path, strlen(PROC_SYS_DIR), name, 0, over_cmp);
+	}
 
-        /*
-         * prepare behaviors
-         */
-        ent_attrs = probe_attr_creat("max_depth",           r0 = SEXP_string_newf("%d", PROC_SYS_MAXDEPTH),
-                                     "recurse_direction",   r1 = SEXP_string_new("down", 4),
-                                     "recurse_file_system", r2 = SEXP_string_new("all", 3),
-                                     "recurse", r3 = SEXP_string_new("symlinks and directories", 24),
-                                     NULL);
-        bh_entity = probe_ent_creat1("behaviors", ent_attrs, NULL);
+	for (size_t i = 0; i < seen_cnt; ++i)
+		free(seen[i]);
+	free(seen);
+	SEXP_free(vals);
+
+	return (ret);
+}
+
+static void sysctl_snapshot_read(size_t index, void *arg)
+{
+	struct sysctl_snapshot *snap = arg;
+	size_t end = (index + 1) * SYSCTL_SNAPSHOT_CHUNK;
+	char sysval[SYSCTL_VALUE_MAX];
+
+	if (end > snap->count)
+		end = snap->count;
+
+	for (size_t i = index * SYSCTL_SNAPSHOT_CHUNK; i < end; ++i) {
+		struct sysctl_entry *entry = &snap->entries[i];
+
+		entry->status = sysctl_read_value(entry->path, sysval, &entry->len);
+		if (entry->status != SYSCTL_VALUE_OK)
+			continue;
+		/* One more byte for sysctl_collect() */
+		entry->value = malloc(entry->len + 1);
+		if (entry->value == NULL) {
+			entry->status = SYSCTL_VALUE_NOMEM;
+			continue;
+		}
+		memcpy(entry->value, sysval, entry->len);
+	}
+}
+
+/*
+ * List the readable sysctls and read their values in parallel.
+ */
+static int sysctl_snapshot_build(struct sysctl_snapshot *snap, SEXP_t *result)
+{
+	OVAL_FTS    *ofts;
+	OVAL_FTSENT *ofts_ent;
+	SEXP_t *r0, *r1, *r2, *r3;
+	SEXP_t *ent_attrs, *bh_entity, *path_entity, *filename_entity;
+	struct sysctl_entry *entry;
+	size_t alloc = 0;
+
+	/*
+	 * prepare behaviors
+	 */
+	ent_attrs = probe_attr_creat("max_depth",           r0 = SEXP_string_newf("%d", PROC_SYS_MAXDEPTH),
+	                             "recurse_direction",   r1 = SEXP_string_new("down", 4),
+	                             "recurse_file_system", r2 = SEXP_string_new("all", 3),
+	                             "recurse", r3 = SEXP_string_new("symlinks and directories", 24),
+	                             NULL);
+	bh_entity = probe_ent_creat1("behaviors", ent_attrs, NULL);
 	SEXP_free(r0);
 	SEXP_free(r1);
 	SEXP_free(r2);
 	SEXP_free(r3);
 	SEXP_free(ent_attrs);
 
-        /*
-         * prepare path, filename
-         */
-        ent_attrs = probe_attr_creat("operation", r0 = SEXP_number_newi(OVAL_OPERATION_EQUALS),
-                                     NULL);
-        path_entity = probe_ent_creat1("path", ent_attrs, r1 = SEXP_string_new(PROC_SYS_DIR, strlen(PROC_SYS_DIR)));
+	/*
+	 * prepare path, filename
+	 */
+	ent_attrs = probe_attr_creat("operation", r0 = SEXP_number_newi(OVAL_OPERATION_EQUALS),
+	                             NULL);
+	path_entity = probe_ent_creat1("path", ent_attrs, r1 = SEXP_string_new(PROC_SYS_DIR, strlen(PROC_SYS_DIR)));
 	SEXP_free(r0);
 	SEXP_free(r1);
 	SEXP_free(ent_attrs);
 
-        ent_attrs = probe_attr_creat("operation", r0 = SEXP_number_newi(OVAL_OPERATION_PATTERN_MATCH),
-                                     NULL);
-        filename_entity = probe_ent_creat1("filename", ent_attrs, r1 = SEXP_string_new(".*", 2));
+	ent_attrs = probe_attr_creat("operation", r0 = SEXP_number_newi(OVAL_OPERATION_PATTERN_MATCH),
+	                             NULL);
+	filename_entity = probe_ent_creat1("filename", ent_attrs, r1 = SEXP_string_new(".*", 2));
 	SEXP_free(r0);
 	SEXP_free(r1);
 	SEXP_free(ent_attrs);
 
-        /*
-         * collect sysctls
-         *  XXX: use direct access for the "equals" op
-         */
-        ofts = oval_fts_open_prefixed(NULL, path_entity, filename_entity, NULL, bh_entity, probe_ctx_getresult(ctx));
-
-        if (ofts == NULL) {
-                dE("oval_fts_open_prefixed(%s, %s) failed", PROC_SYS_DIR, ".\\+");
-		SEXP_free(path_entity);
-		SEXP_free(filename_entity);
-		SEXP_free(bh_entity);
-		SEXP_free(name_entity);
+	ofts = oval_fts_open_prefixed(NULL, path_entity, filename_entity, NULL, bh_entity, result);
+	SEXP_free(path_entity);
+	SEXP_free(filename_entity);
+	SEXP_free(bh_entity);
 
-                return (PROBE_EFATAL);
-        }
+	if (ofts == NULL) {
+		dE("oval_fts_open_prefixed(%s, %s) failed", PROC_SYS_DIR, ".\\+");
+		return (PROBE_EFATAL);
+	}
 
-        while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-                SEXP_t *se_mib;
-                char    mibpath[PATH_MAX], *mib;
-                size_t  miblen;
-		struct stat file_stat;
+	while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
+		char mibpath[PATH_MAX];
 
-                snprintf(mibpath, sizeof mibpath, "%s/%s", ofts_ent->path, ofts_ent->file);
+		snprintf(mibpath, sizeof mibpath, "%s/%s", ofts_ent->path, ofts_ent->file);
+		oval_ftsent_free(ofts_ent);
 
-		/* Skip write-only files, eg. /proc/sys/net/ipv4/route/flush */
-		if (stat(mibpath, &file_stat) == -1) {
-			dE("Stat failed on %s: %u, %s", mibpath, errno, strerror(errno));
-			oval_ftsent_free(ofts_ent);
+		if (!sysctl_readable(mibpath))
 			continue;
+
+		if (snap->count == alloc) {
+			size_t new_alloc = alloc == 0 ? 1024 : alloc * 2;
+			struct sysctl_entry *new_entries;
+
+			new_entries = realloc(snap->entries, new_alloc * sizeof(struct sysctl_entry));
+			if (new_entries == NULL)
+				goto nomem;
+			snap->entries = new_entries;
+			alloc = new_alloc;
+		}
+		entry = &snap->entries[snap->count];
+		entry->mib = sysctl_path_to_mib(mibpath);
+		entry->path = strdup(mibpath);
+		entry->value = NULL;
+		entry->len = 0;
+		snap->count++;
+		if (entry->mib == NULL || entry->path == NULL)
+			goto nomem;
+	}
+
+	oval_fts_close(ofts);
+
+	oscap_parallel_run((snap->count + SYSCTL_SNAPSHOT_CHUNK - 1) / SYSCTL_SNAPSHOT_CHUNK,
+	                   sysctl_snapshot_read, snap);
+
+	for (size_t i = 0; i < snap->count; ++i) {
+		if (snap->entries[i].status == SYSCTL_VALUE_NOMEM) {
+			dE("Can't allocate the value of %s", snap->entries[i].path);
+			sysctl_snapshot_clear(snap);
+			return (PROBE_ENOMEM);
+		}
+	}
+	dD("Sysctl snapshot of %zu entries built", snap->count);
+
+	return (0);
+nomem:
+	dE("Can't allocate the sysctl snapshot entries");
+	oval_fts_close(ofts);
+	sysctl_snapshot_clear(snap);
+	return (PROBE_ENOMEM);
+}
+
+/*
+ * Collect sysctls of an object with other operation than "equals" from
+ * the snapshot, which is built on the first use.
+ */
+static int sysctl_probe_snapshot(probe_ctx *ctx, struct sysctl_snapshot *snap, SEXP_t *name_entity, int over_cmp)
+{
+	char sysval[SYSCTL_VALUE_MAX];
+
+	if (snap == NULL)
+		return (PROBE_ENOMEM);
+
+	pthread_mutex_lock(&snap->lock);
+	if (!snap->built) {
+		int ret = sysctl_snapshot_build(snap, probe_ctx_getresult(ctx));
+		if (ret != 0) {
+			pthread_mutex_unlock(&snap->lock);
+			return ret;
 		}
-		/* the sysctl utility uses same condition in sysctl.c in ReadSetting() */
-		if ((file_stat.st_mode & S_IRUSR) == 0) {
-			dD("Skipping write-only file %s", mibpath);
-			oval_ftsent_free(ofts_ent);
+		snap->built = 1;
+	}
+	pthread_mutex_unlock(&snap->lock);
+
+	for (size_t i = 0; i < snap->count; ++i) {
+		const struct sysctl_entry *entry = &snap->entries[i];
+		SEXP_t *se_mib;
+
+		if (entry->status == SYSCTL_VALUE_SKIP)
 			continue;
+
+		se_mib = SEXP_string_new(entry->mib, strlen(entry->mib));
+		if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE) {
+			dD("MIB match: %s", entry->mib);
+			if (entry->status == SYSCTL_VALUE_OK)
+				memcpy(sysval, entry->value, entry->len);
+			sysctl_collect(ctx, se_mib, entry->status, sysval, entry->len, over_cmp);
 		}
+		SEXP_free(se_mib);
+	}
 
-                mib    = strdup(mibpath + strlen(PROC_SYS_DIR) + 1);
-                miblen = strlen(mib);
-
-                while (miblen > 0) {
-                        if(mib[miblen - 1] == '/')
-                                mib[miblen - 1] = '.';
-                        --miblen;
-                }
-
-                dD("MIB: %s", mib);
-                se_mib = SEXP_string_new(mib, strlen(mib));
-                free(mib);
-
-                if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE) {
-                        FILE   *fp;
-                        SEXP_t *item;
-                        char    sysval[8192];
-                        char   *sysvals[512];
-                        long i, l;
-                        size_t s;
-
-                        dD("MIB match");
-
-                        /*
-                         * read sysctl value
-                         */
-                        fp = fopen(mibpath, "r");
-
-                        if (fp == NULL) {
-                                dE("Can't read sysctl value from \"%s\": %u, %s",
-                                   mibpath, errno, strerror(errno));
-                                goto fail_item;
-                        }
-
-                        l = fread(sysval, 1, sizeof sysval - 1, fp);
-
-                        if (ferror(fp)) {
-				/* Linux 4.1.0 introduced a per-NIC IPv6 stable_secret file.
-				 * The stable_secret file cannot be read until it is set,
-				 * so we skip it when it is not readable. Otherwise we collect it.
-				 */
-				if (strncmp(ofts_ent->path, ipv6_conf_path, ipv6_conf_path_len) == 0 &&
-						strcmp(ofts_ent->file, "stable_secret") == 0) {
-					dD("Skipping file %s", mibpath);
-					oval_ftsent_free(ofts_ent);
-					SEXP_free(se_mib);
-					fclose(fp);
-					continue;
-				} else {
-					dE("An error ocured when reading from \"%s\" (fp=%p): l=%ld, %u, %s",
-						mibpath, fp, l, errno, strerror(errno));
-					goto fail_item;
-				}
-                        }
-
-                        fclose(fp);
-
-			/* Skip empty values as sysctl tool does.
-			 * See https://bugzilla.redhat.com/show_bug.cgi?id=1473207
-			 */
-			if (l == 0) {
-				dD("Skipping file '%s' because it has no value.", mibpath);
-				oval_ftsent_free(ofts_ent);
-				SEXP_free(se_mib);
-				continue;
-			}
+	return (0);
+}
 
-                        /*
-                         * sanitize the value
-                         *  - only printable and whitespace chars allowed
-                         *  - remove the last '\n'
-                         */
-                        sysvals[0] = sysval;
-
-                        for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
-	                        if ((!isprint(sysval[i]) && !isspace(sysval[i]))
-	                            || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
-                                {
-                                        sysval[i] = '\0';
-                                        sysvals[++s] = sysval + i + 1;
-                                }
-                        }
-
-                        if (sysval[l - 1] == '\n')
-                                sysval[l - 1] = '\0';
-                        else
-                                sysval[l] = '\0';
-
-                        if (strlen(sysvals[s]) == 0)
-                                sysvals[s] = NULL;
-                        else
-                                sysvals[++s] = NULL;
-
-                        if (over_cmp >= 0) {
-	                        /* Only in OVAL 5.10 and above */
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING_M, sysvals,
-	                                                 NULL);
-                        } else {
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING, sysval,
-	                                                 NULL);
-                        }
-
-                        goto add_item;
-                fail_item:
-                        if (fp != NULL)
-                                fclose(fp);
-
-			item = probe_item_create(OVAL_UNIX_SYSCTL, NULL, NULL);
-                        probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
-                add_item:
-                        probe_item_collect(ctx, item);
-                }
-
-                oval_ftsent_free(ofts_ent);
-                SEXP_free(se_mib);
+int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
+{
+        SEXP_t *name_entity, *probe_in;
+        oval_schema_version_t over;
+        int over_cmp, ret;
+
+        probe_in    = probe_ctx_getobject(ctx);
+        name_entity = probe_obj_getent(probe_in, "name", 1);
+        over        = probe_obj_get_platform_schema_version(probe_in);
+        over_cmp    = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10));
+
+        if (name_entity == NULL) {
+                dE("Missing \"name\" entity in the input object");
+                return (PROBE_ENOENT);
         }
 
-        oval_fts_close(ofts);
-	SEXP_free(path_entity);
-	SEXP_free(filename_entity);
-	SEXP_free(bh_entity);
+        if (probe_ent_getoperation(name_entity, OVAL_OPERATION_EQUALS) == OVAL_OPERATION_EQUALS)
+                ret = sysctl_probe_direct(ctx, name_entity, over_cmp);
+        else
+                ret = sysctl_probe_snapshot(ctx, probe_arg, name_entity, over_cmp);
+
 	SEXP_free(name_entity);
 
-        return (0);
+        return (ret);
 }
 
 #elif defined(OS_FREEBSD)
@@ -366,3 +683,14 @@ int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
         return(PROBE_EOPNOTSUPP);
 }
 #endif
+
+#if !defined(OS_LINUX)
+void *sysctl_probe_init(void)
+{
+	return NULL;
+}
+
+void sysctl_probe_fini(void *probe_arg)
+{
+}
+#endif
@@ -0,0 +1,523 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <paths.h>
+#if defined(OS_APPLE)
+#include <utmp.h>
+#elif defined(OS_FREEBSD)
+#include <utmpx.h>
+#else
+#include <lastlog.h>
+#endif
+#ifdef HAVE_SHADOW_H
+#include <shadow.h>
+#endif
+
+#include "_seap.h"
+#include "probe-api.h"
+#include "probe/entcmp.h"
+#include "common/debug_priv.h"
+#include "userdb.h"
+
+#define USERDB_PASSWD_PATH "/etc/passwd"
+#define USERDB_SHADOW_PATH "/etc/shadow"
+
+/* Marks a last login time which wasn't read yet */
+#define USERDB_LAST_LOGIN_UNKNOWN INT64_MIN
+
+static pthread_mutex_t userdb_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int userdb_refs = 0;
+static struct userdb_table *userdb_passwd_table = NULL;
+static struct userdb_table *userdb_shadow_table = NULL;
+static int64_t *userdb_last_logins = NULL;
+#if !defined(OS_FREEBSD)
+static FILE *userdb_lastlog = NULL;
+#endif
+
+static bool userdb_local_only(void)
+{
+#if defined(OS_LINUX)
+	const char *env = getenv("OSCAP_PROBE_LOCAL_USERS");
+
+	return env != NULL && strcmp(env, "1") == 0;
+#else
+	/* fgetpwent() isn't available everywhere */
+	return false;
+#endif
+}
+
+struct userdb_name {
+	const char *name;
+	size_t position;
+};
+
+static int userdb_name_cmp(const void *a, const void *b)
+{
+	const struct userdb_name *na = a, *nb = b;
+	int ret = strcmp(na->name, nb->name);
+
+	if (ret != 0)
+		return ret;
+	return (na->position > nb->position) - (na->position < nb->position);
+}
+
+/* Index the names of the entries, names[i] is the name of the i-th entry */
+static int userdb_index(struct userdb_table *table, const char **names)
+{
+	struct userdb_name *sorted;
+	size_t count = table->count > 0 ? table->count : 1;
+
+	sorted = malloc(count * sizeof(struct userdb_name));
+	table->names = malloc(count * sizeof(const char *));
+	table->by_name = malloc(count * sizeof(size_t));
+	if (sorted == NULL || table->names == NULL || table->by_name == NULL) {
+		free(sorted);
+		return (-1);
+	}
+
+	for (size_t i = 0; i < table->count; ++i) {
+		sorted[i].name = names[i];
+		sorted[i].position = i;
+	}
+	qsort(sorted, table->count, sizeof(struct userdb_name), userdb_name_cmp);
+	for (size_t i = 0; i < table->count; ++i) {
+		table->names[i] = sorted[i].name;
+		table->by_name[i] = sorted[i].position;
+	}
+	free(sorted);
+
+	return (0);
+}
+
+static void userdb_passwd_free(struct userdb_table *table)
+{
+	struct userdb_passwd *users;
+
+	if (table == NULL)
+		return;
+	users = table->entries;
+	for (size_t i = 0; i < table->count; ++i) {
+		free(users[i].name);
+		free(users[i].passwd);
+		free(users[i].gecos);
+		free(users[i].dir);
+		free(users[i].shell);
+	}
+	free(table->entries);
+	free(table->names);
+	free(table->by_name);
+	free(table);
+}
+
+static struct userdb_table *userdb_passwd_read(void)
+{
+	struct userdb_table *table;
+	struct userdb_passwd *users = NULL;
+	const char **names;
+	size_t alloc = 0;
+	struct passwd *pw;
+	FILE *fp = NULL;
+
+	if (userdb_local_only()) {
+		fp = fopen(USERDB_PASSWD_PATH, "r");
+		if (fp == NULL) {
+			dE("Can't open %s: %s", USERDB_PASSWD_PATH, strerror(errno));
+			return (NULL);
+		}
+	} else {
+		setpwent();
+	}
+
+	table = calloc(1, sizeof(struct userdb_table));
+	if (table == NULL)
+		goto fail;
+	for (;;) {
+#if defined(OS_LINUX)
+		pw = fp != NULL ? fgetpwent(fp) : getpwent();
+#else
+		pw = getpwent();
+#endif
+		if (pw == NULL)
+			break;
+
+		if (table->count == alloc) {
+			size_t new_alloc = alloc == 0 ? 64 : alloc * 2;
+			struct userdb_passwd *new_users;
+
+			new_users = realloc(users, new_alloc * sizeof(struct userdb_passwd));
+			if (new_users == NULL)
+				goto fail;
+			users = table->entries = new_users;
+			alloc = new_alloc;
+		}
+		struct userdb_passwd *user = &users[table->count++];
+		user->name = strdup(pw->pw_name);
+		user->passwd = strdup(pw->pw_passwd);
+		user->uid = pw->pw_uid;
+		user->gid = pw->pw_gid;
+		user->gecos = strdup(pw->pw_gecos);
+		user->dir = strdup(pw->pw_dir);
+		user->shell = strdup(pw->pw_shell);
+		if (user->name == NULL || user->passwd == NULL || user->gecos == NULL
+		    || user->dir == NULL || user->shell == NULL)
+			goto fail;
+	}
+	if (fp != NULL)
+		fclose(fp);
+	else
+		endpwent();
+	fp = NULL;
+
+	names = malloc((table->count > 0 ? table->count : 1) * sizeof(const char *));
+	if (names == NULL)
+		goto fail_index;
+	for (size_t i = 0; i < table->count; ++i)
+		names[i] = users[i].name;
+	if (userdb_index(table, names) != 0) {
+		free(names);
+		goto fail_index;
+	}
+	free(names);
+
+	userdb_last_logins = malloc((table->count > 0 ? table->count : 1) * sizeof(int64_t));
+	if (userdb_last_logins == NULL)
+		goto fail_index;
+	for (size_t i = 0; i < table->count; ++i)
+		userdb_last_logins[i] = USERDB_LAST_LOGIN_UNKNOWN;
+
+	dD("Read %zu passwd entries", table->count);
+	return (table);
+fail:
+	if (fp != NULL)
+		fclose(fp);
+	else
+		endpwent();
+fail_index:
+	dE("Can't allocate the passwd entries");
+	userdb_passwd_free(table);
+	return (NULL);
+}
+
+#ifdef HAVE_SHADOW_H
+static void userdb_shadow_free(struct userdb_table *table)
+{
+	struct userdb_shadow *users;
+
+	if (table == NULL)
+		return;
+	users = table->entries;
+	for (size_t i = 0; i < table->count; ++i) {
+		free(users[i].name);
+		free(users[i].passwd);
+	}
+	free(table->entries);
+	free(table->names);
+	free(table->by_name);
+	free(table);
+}
+
+static struct userdb_table *userdb_shadow_read(void)
+{
+	struct userdb_table *table;
+	struct userdb_shadow *users = NULL;
+	const char **names;
+	size_t alloc = 0;
+	struct spwd *sp;
+	FILE *fp = NULL;
+
+	if (userdb_local_only()) {
+		fp = fopen(USERDB_SHADOW_PATH, "r");
+		if (fp == NULL) {
+			dE("Can't open %s: %s", USERDB_SHADOW_PATH, strerror(errno));
+			return (NULL);
+		}
+	} else {
+		setspent();
+	}
+
+	table = calloc(1, sizeof(struct userdb_table));
+	if (table == NULL)
+		goto fail;
+	while ((sp = fp != NULL ? fgetspent(fp) : getspent()) != NULL) {
+		if (table->count == alloc) {
+			size_t new_alloc = alloc == 0 ? 64 : alloc * 2;
+			struct userdb_shadow *new_users;
+
+			new_users = realloc(users, new_alloc * sizeof(struct userdb_shadow));
+			if (new_users == NULL)
+				goto fail;
+			users = table->entries = new_users;
+			alloc = new_alloc;
+		}
+		struct userdb_shadow *user = &users[table->count++];
+		user->name = strdup(sp->sp_namp);
+		user->passwd = strdup(sp->sp_pwdp);
+		user->lstchg = sp->sp_lstchg;
+		user->min = sp->sp_min;
+		user->max = sp->sp_max;
+		user->warn = sp->sp_warn;
+		user->inact = sp->sp_inact;
+		user->expire = sp->sp_expire;
+		user->flag = sp->sp_flag;
+		if (user->name == NULL || user->passwd == NULL)
+			goto fail;
+	}
+	if (fp != NULL)
+		fclose(fp);
+	else
+		endspent();
+	fp = NULL;
+
+	names = malloc((table->count > 0 ? table->count : 1) * sizeof(const char *));
+	if (names == NULL)
+		goto fail_index;
+	for (size_t i = 0; i < table->count; ++i)
+		names[i] = users[i].name;
+	if (userdb_index(table, names) != 0) {
+		free(names);
+		goto fail_index;
+	}
+	free(names);
+
+	dD("Read %zu shadow entries", table->count);
+	return (table);
+fail:
+	if (fp != NULL)
+		fclose(fp);
+	else
+		endspent();
+fail_index:
+	dE("Can't allocate the shadow entries");
+	userdb_shadow_free(table);
+	return (NULL);
+}
+#endif /* HAVE_SHADOW_H */
+
+void userdb_acquire(void)
+{
+	pthread_mutex_lock(&userdb_lock);
+	userdb_refs++;
+	pthread_mutex_unlock(&userdb_lock);
+}
+
+void userdb_release(void)
+{
+	pthread_mutex_lock(&userdb_lock);
+	if (userdb_refs > 0 && --userdb_refs == 0) {
+		userdb_passwd_free(userdb_passwd_table);
+		userdb_passwd_table = NULL;
+		free(userdb_last_logins);
+		userdb_last_logins = NULL;
+#if !defined(OS_FREEBSD)
+		if (userdb_lastlog != NULL) {
+			fclose(userdb_lastlog);
+			userdb_lastlog = NULL;
+		}
+#endif
+#ifdef HAVE_SHADOW_H
+		userdb_shadow_free(userdb_shadow_table);
+		userdb_shadow_table = NULL;
+#endif
+	}
+	pthread_mutex_unlock(&userdb_lock);
+}
+
+const struct userdb_table *userdb_passwd(void)
+{
+	struct userdb_table *table;
+
+	pthread_mutex_lock(&userdb_lock);
+	if (userdb_passwd_table == NULL)
+		userdb_passwd_table = userdb_passwd_read();
+	table = userdb_passwd_table;
+	pthread_mutex_unlock(&userdb_lock);
+
+	return table;
+}
+
+const struct userdb_table *userdb_shadow(void)
+{
+	struct userdb_table *table = NULL;
+
+#ifdef HAVE_SHADOW_H
+	pthread_mutex_lock(&userdb_lock);
+	if (userdb_shadow_table == NULL)
+		userdb_shadow_table = userdb_shadow_read();
+	table = userdb_shadow_table;
+	pthread_mutex_unlock(&userdb_lock);
+#endif
+
+	return table;
+}
+
+static int position_cmp(const void *a, const void *b)
+{
+	size_t pa = *(const size_t *)a, pb = *(const size_t *)b;
+
+	return (pa > pb) - (pa < pb);
+}
+
+static int name_cmp(const void *a, const void *b)
+{
+	return strcmp(a, *(const char * const *)b);
+}
+
+size_t userdb_select(const struct userdb_table *table, SEXP_t *name_ent, size_t **positions)
+{
+	SEXP_t *vals, *val;
+	size_t count = 0, alloc, i, j;
+
+	if (!probe_entobj_equals_values(name_ent)) {
+		*positions = malloc((table->count > 0 ? table->count : 1) * sizeof(size_t));
+		if (*positions == NULL) {
+			dE("Can't allocate the positions of %zu entries", table->count);
+			return 0;
+		}
+		for (i = 0; i < table->count; ++i)
+			(*positions)[i] = i;
+		return table->count;
+	}
+
+	alloc = 16;
+	*positions = malloc(alloc * sizeof(size_t));
+	if (*positions == NULL) {
+		dE("Can't allocate the positions of the entries");
+		return 0;
+	}
+	probe_ent_getvals(name_ent, &vals);
+	SEXP_list_foreach(val, vals) {
+		const char **found;
+		char *name;
+
+		/* SEXP_list_foreach() can't be left with a break */
+		if (*positions == NULL || !SEXP_stringp(val))
+			continue;
+		name = SEXP_string_cstr(val);
+		if (name == NULL)
+			continue;
+		found = bsearch(name, table->names, table->count, sizeof(const char *), name_cmp);
+		if (found != NULL) {
+			/* The same name may be there more times */
+			i = found - table->names;
+			while (i > 0 && strcmp(table->names[i - 1], name) == 0)
+				i--;
+			for (; i < table->count && strcmp(table->names[i], name) == 0; ++i) {
+				if (count == alloc) {
+					size_t *new_positions = realloc(*positions, alloc * 2 * sizeof(size_t));
+					if (new_positions == NULL) {
+						dE("Can't allocate the positions of the entries");
+						free(*positions);
+						*positions = NULL;
+						count = 0;
+						break;
+					}
+					*positions = new_positions;
+					alloc *= 2;
+				}
+				(*positions)[count++] = table->by_name[i];
+			}
+		}
+		free(name);
+	}
+	SEXP_free(vals);
+	if (*positions == NULL)
+		return 0;
+
+	/* Report the entries in the order of the enumeration, once */
+	qsort(*positions, count, sizeof(size_t), position_cmp);
+	for (i = j = 0; i < count; ++i) {
+		if (j == 0 || (*positions)[j - 1] != (*positions)[i])
+			(*positions)[j++] = (*positions)[i];
+	}
+
+	return j;
+}
+
+#if defined(OS_FREEBSD)
+static int64_t get_last_login(const char *username)
+{
+	struct utmpx *ut;
+	int64_t t = 0;
+
+	/* Iterate over the entries of the utx.log file */
+	while ((ut = getutxent()) != NULL) {
+		if (strcmp(username, ut->ut_user) == 0) {
+			t = ut->ut_tv.tv_sec;
+			break;
+		}
+	}
+
+	endutxent();
+
+	return t;
+}
+#else
+/* Has to be called with the lock held */
+static int64_t get_last_login(uid_t uid)
+{
+	struct lastlog ll;
+
+	if (userdb_lastlog == NULL) {
+		userdb_lastlog = fopen(_PATH_LASTLOG, "r");
+		if (userdb_lastlog == NULL)
+			return -1;
+	}
+
+	if (fseeko(userdb_lastlog, (off_t)uid * sizeof(ll), SEEK_SET) == 0)
+		if (fread((char *)&ll, sizeof(ll), 1, userdb_lastlog) == 1)
+			return (int64_t)ll.ll_time;
+
+	return -1;
+}
+#endif
+
+int64_t userdb_last_login(size_t position)
+{
+	const struct userdb_passwd *user;
+	int64_t t;
+
+	pthread_mutex_lock(&userdb_lock);
+	if (userdb_passwd_table == NULL || position >= userdb_passwd_table->count) {
+		pthread_mutex_unlock(&userdb_lock);
+		return -1;
+	}
+	if (userdb_last_logins[position] == USERDB_LAST_LOGIN_UNKNOWN) {
+		user = (const struct userdb_passwd *)userdb_passwd_table->entries + position;
+#if defined(OS_FREEBSD)
+		userdb_last_logins[position] = get_last_login(user->name);
+#else
+		userdb_last_logins[position] = get_last_login(user->uid);
+#endif
+	}
+	t = userdb_last_logins[position];
+	pthread_mutex_unlock(&userdb_lock);
+
+	return t;
+}
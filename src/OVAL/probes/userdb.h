@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef OPENSCAP_USERDB_H
+#define OPENSCAP_USERDB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "sexp-types.h"
+
+/*
+ * Snapshot of the user databases shared by the password and shadow probes.
+ *
+ * Each database is enumerated once, when it is asked for the first time,
+ * and kept until the last probe drops its reference. The functions below
+ * may be called only while a reference is held.
+ *
+ * The entries come from the name service by default. With the
+ * OSCAP_PROBE_LOCAL_USERS=1 environment variable only /etc/passwd and
+ * /etc/shadow are read, so that directory services with many users
+ * aren't enumerated.
+ */
+
+struct userdb_passwd {
+	char *name;
+	char *passwd;
+	uid_t uid;
+	gid_t gid;
+	char *gecos;
+	char *dir;
+	char *shell;
+};
+
+struct userdb_shadow {
+	char *name;
+	char *passwd;
+	long lstchg;
+	long min;
+	long max;
+	long warn;
+	long inact;
+	long expire;
+	unsigned long flag;
+};
+
+/* Entries of a database and an index of their names */
+struct userdb_table {
+	void *entries;          // in the order of the enumeration
+	size_t count;
+	const char **names;     // sorted, names[i] is the name of by_name[i]
+	size_t *by_name;        // positions of the entries sorted by the name
+};
+
+void userdb_acquire(void);
+void userdb_release(void);
+
+/* Get the passwd database, NULL if it couldn't be read */
+const struct userdb_table *userdb_passwd(void);
+
+/* Get the shadow database, NULL if it couldn't be read */
+const struct userdb_table *userdb_shadow(void);
+
+/*
+ * Get the positions of the entries whose name can match the entity, in
+ * the order of the enumeration. The positions are looked up in the index
+ * if the entity compares for equality, otherwise all the entries are
+ * returned. The caller frees the array and still has to compare the names.
+ * If the array can't be allocated, *positions is NULL and 0 is returned.
+ */
+size_t userdb_select(const struct userdb_table *table, SEXP_t *name_ent, size_t **positions);
+
+/*
+ * Get the time of the last login of the user at the given position of
+ * the passwd database, -1 if it isn't known.
+ */
+int64_t userdb_last_login(size_t position);
+
+#endif /* OPENSCAP_USERDB_H */
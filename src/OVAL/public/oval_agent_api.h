@@ -103,6 +103,14 @@ OSCAP_API int oval_agent_abort_session(oval_agent_session_t *ag_sess);
 
 typedef int (*agent_reporter)(const struct oval_result_definition * res_def, void *arg);
 
+/**
+ * Collect the objects of all the definitions first and evaluate their tests
+ * in parallel in \ref oval_agent_eval_system. The callback is then called only
+ * after the collection, its non-zero return value doesn't prevent collection
+ * of the objects of the remaining definitions. Disabled by default.
+ */
+OSCAP_API void oval_agent_set_parallel_eval(oval_agent_session_t *ag_sess, bool parallel);
+
 /**
  * Probe and evaluate all definitions from the content, call the callback functions upon single evaluation
  * @return 0 on success; -1 error; 1 warning
@@ -231,6 +231,18 @@ OSCAP_API int oval_session_export(struct oval_session *session);
  */
 OSCAP_API void oval_session_set_export_system_characteristics(struct oval_session *session, bool export);
 
+/**
+ * Set parallel evaluation of OVAL definitions by \ref oval_session_evaluate
+ *
+ * Objects of all the definitions are then collected before the reporter
+ * function is called for the first one, see \ref oval_agent_set_parallel_eval.
+ *
+ * @memberof oval_session
+ * @param session an \ref oval_session
+ * @param parallel true to evaluate the tests in parallel (defaults to false)
+ */
+OSCAP_API void oval_session_set_parallel_eval(struct oval_session *session, bool parallel);
+
 /**
  * Set property of remote content.
  * @memberof oval_session
@@ -94,19 +94,77 @@ __attribute__((nonnull(1,2))) static bool cstr_to_double(const char *cstr, doubl
 	return true;
 }
 
-oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type, const char *sys_data, oval_operation_t operation)
+void oval_operand_init(struct oval_operand *operand, const char *state_data, oval_datatype_t state_data_type, oval_operation_t operation)
 {
-	// finally, we have gotten to the point of comparing system data with a state
+	memset(operand, 0, sizeof(*operand));
+	operand->text = state_data;
+	operand->datatype = state_data_type;
+	operand->operation = operation;
+
+	switch (state_data_type) {
+	case OVAL_DATATYPE_STRING:
+		if (operation == OVAL_OPERATION_PATTERN_MATCH)
+			operand->value.re = oval_pattern_compile(state_data);
+		break;
+	case OVAL_DATATYPE_INTEGER:
+		if (!cstr_to_intmax(state_data, &operand->value.i))
+			operand->parse_errno = errno;
+		break;
+	case OVAL_DATATYPE_FLOAT:
+		if (!cstr_to_double(state_data, &operand->value.f))
+			operand->parse_errno = errno;
+		break;
+	case OVAL_DATATYPE_BOOLEAN:
+		operand->value.b = ((strcmp(state_data, "true")) == 0) || ((strcmp(state_data, "1")) == 0);
+		break;
+	case OVAL_DATATYPE_EVR_STRING:
+	case OVAL_DATATYPE_DEBIAN_EVR_STRING:
+		oval_evr_parse(state_data, &operand->value.evr);
+		break;
+	case OVAL_DATATYPE_IPV4ADDR:
+	case OVAL_DATATYPE_IPV6ADDR:
+		if (oval_ipaddr_parse(state_data_type == OVAL_DATATYPE_IPV4ADDR ? AF_INET : AF_INET6, state_data, &operand->value.ip))
+			operand->parse_errno = EINVAL;
+		break;
+	default:
+		break;
+	}
+}
+
+void oval_operand_clear(struct oval_operand *operand)
+{
+	switch (operand->datatype) {
+	case OVAL_DATATYPE_STRING:
+		if (operand->value.re != NULL)
+			pcre_free(operand->value.re);
+		break;
+	case OVAL_DATATYPE_EVR_STRING:
+	case OVAL_DATATYPE_DEBIAN_EVR_STRING:
+		oval_evr_clear(&operand->value.evr);
+		break;
+	default:
+		break;
+	}
+	memset(operand, 0, sizeof(*operand));
+}
+
+oval_result_t oval_operand_cmp(const struct oval_operand *operand, const char *sys_data)
+{
+	oval_datatype_t state_data_type = operand->datatype;
+	oval_operation_t operation = operand->operation;
+	const char *state_data = operand->text;
 
 	if (state_data_type == OVAL_DATATYPE_STRING) {
+		if (operation == OVAL_OPERATION_PATTERN_MATCH)
+			return oval_pattern_match(operand->value.re, state_data, sys_data);
 		return oval_string_cmp(state_data, sys_data, operation);
 	} else if (state_data_type == OVAL_DATATYPE_INTEGER) {
-		intmax_t state_val, syschar_val;
+		intmax_t syschar_val;
 
-		if (!cstr_to_intmax(state_data, &state_val)) {
+		if (operand->parse_errno) {
 			oscap_seterr(OSCAP_EFAMILY_OVAL,
 				"Conversion of the string \"%s\" to an integer (%zu bits) failed: %s",
-				state_data, sizeof(intmax_t)*8, strerror(errno));
+				state_data, sizeof(intmax_t)*8, strerror(operand->parse_errno));
 			return OVAL_RESULT_ERROR;
 		}
 
@@ -116,14 +174,14 @@ oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type
 				sys_data, sizeof(intmax_t)*8, strerror(errno));
 			return OVAL_RESULT_ERROR;
 		}
-		return oval_int_cmp(state_val, syschar_val, operation);
+		return oval_int_cmp(operand->value.i, syschar_val, operation);
 	} else if (state_data_type == OVAL_DATATYPE_FLOAT) {
-		double state_val, sys_val;
+		double sys_val;
 
-		if (!cstr_to_double(state_data, &state_val)) {
+		if (operand->parse_errno) {
 			oscap_seterr(OSCAP_EFAMILY_OVAL,
 				"Conversion of the string \"%s\" to a floating type (double) failed: %s",
-				state_data, strerror(errno));
+				state_data, strerror(operand->parse_errno));
 			return OVAL_RESULT_ERROR;
 		}
 
@@ -133,25 +191,24 @@ oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type
 				sys_data, strerror(errno));
 			return OVAL_RESULT_ERROR;
 		}
-		return oval_float_cmp(state_val, sys_val, operation);
+		return oval_float_cmp(operand->value.f, sys_val, operation);
 	} else if (state_data_type == OVAL_DATATYPE_BOOLEAN) {
-		int state_int;
 		int sys_int;
-		state_int = (((strcmp(state_data, "true")) == 0) || ((strcmp(state_data, "1")) == 0)) ? 1 : 0;
 		sys_int = (((strcmp(sys_data, "true")) == 0) || ((strcmp(sys_data, "1")) == 0)) ? 1 : 0;
-		return oval_boolean_cmp(state_int, sys_int, operation);
+		return oval_boolean_cmp(operand->value.b, sys_int, operation);
 	} else if (state_data_type == OVAL_DATATYPE_BINARY) {
 		return oval_binary_cmp(state_data, sys_data, operation);
 	} else if (state_data_type == OVAL_DATATYPE_EVR_STRING) {
-		return oval_evr_string_cmp(state_data, sys_data, operation);
+		return oval_evr_parsed_cmp(&operand->value.evr, sys_data, operation);
 	} else if (state_data_type == OVAL_DATATYPE_DEBIAN_EVR_STRING) {
-		return oval_evr_string_cmp(state_data, sys_data, operation);
+		return oval_evr_parsed_cmp(&operand->value.evr, sys_data, operation);
 	} else if (state_data_type == OVAL_DATATYPE_VERSION) {
 		return oval_versiontype_cmp(state_data, sys_data, operation);
-	} else if (state_data_type == OVAL_DATATYPE_IPV4ADDR) {
-		return oval_ipaddr_cmp(AF_INET, state_data, sys_data, operation);
-	} else if (state_data_type == OVAL_DATATYPE_IPV6ADDR) {
-		return oval_ipaddr_cmp(AF_INET6, state_data, sys_data, operation);
+	} else if (state_data_type == OVAL_DATATYPE_IPV4ADDR
+			|| state_data_type == OVAL_DATATYPE_IPV6ADDR) {
+		if (operand->parse_errno)
+			return OVAL_RESULT_ERROR;
+		return oval_ipaddr_parsed_cmp(&operand->value.ip, sys_data, operation);
 	} else if (state_data_type == OVAL_DATATYPE_FILESET_REVISION
 			|| state_data_type == OVAL_DATATYPE_IOS_VERSION) {
 		dW("Unsupported data type: %s.", oval_datatype_get_text(state_data_type));
@@ -161,3 +218,14 @@ oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type
 	oscap_seterr(OSCAP_EFAMILY_OVAL, "Invalid OVAL data type: %d.", state_data_type);
 	return OVAL_RESULT_ERROR;
 }
+
+oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type, const char *sys_data, oval_operation_t operation)
+{
+	// finally, we have gotten to the point of comparing system data with a state
+	struct oval_operand operand;
+
+	oval_operand_init(&operand, state_data, state_data_type, operation);
+	oval_result_t result = oval_operand_cmp(&operand, sys_data);
+	oval_operand_clear(&operand);
+	return result;
+}
@@ -120,10 +120,8 @@ static int istrcmp(const char *st1, const char *st2)
 	return oscap_strcasecmp(st1, st2);
 }
 
-static oval_result_t strregcomp(const char *pattern, const char *test_str)
+pcre *oval_pattern_compile(const char *pattern)
 {
-	int ret;
-	oval_result_t result = OVAL_RESULT_ERROR;
 	pcre *re;
 	const char *err;
 	int errofs;
@@ -132,8 +130,18 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 	if (re == NULL) {
 		dE("Unable to compile regex pattern '%s', "
 				"pcre_compile() returned error (offset: %d): '%s'.\n", pattern, errofs, err);
-		return OVAL_RESULT_ERROR;
 	}
+	return re;
+}
+
+oval_result_t oval_pattern_match(pcre *re, const char *pattern, const char *test_str)
+{
+	int ret;
+	oval_result_t result = OVAL_RESULT_ERROR;
+
+	if (re == NULL)
+		return OVAL_RESULT_ERROR;
+	test_str = test_str ? test_str : "";
 
 	ret = pcre_exec(re, NULL, test_str, strlen(test_str), 0, 0, NULL, 0);
 	if (ret > -1 ) {
@@ -146,6 +154,16 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 		result = OVAL_RESULT_ERROR;
 	}
 
+	return result;
+}
+
+static oval_result_t strregcomp(const char *pattern, const char *test_str)
+{
+	pcre *re = oval_pattern_compile(pattern);
+	if (re == NULL)
+		return OVAL_RESULT_ERROR;
+
+	oval_result_t result = oval_pattern_match(re, pattern, test_str);
 	pcre_free(re);
 	return result;
 }
@@ -23,6 +23,7 @@
 #ifndef OSCAP_OVAL_CMP_BASIC_IMPL_H_
 #define OSCAP_OVAL_CMP_BASIC_IMPL_H_
 
+#include <pcre.h>
 #include "../common/util.h"
 #include "oval_definitions.h"
 #include "oval_types.h"
@@ -38,5 +39,18 @@ oval_result_t oval_string_cmp(const char *state, const char *syschar, oval_opera
 
 oval_result_t oval_binary_cmp(const char *state, const char *syschar, oval_operation_t operation);
 
+/**
+ * Compile regular expression of a pattern match operation.
+ * @returns compiled pattern to be released by pcre_free(), NULL on error
+ */
+pcre *oval_pattern_compile(const char *pattern);
+
+/**
+ * Match compiled pattern against data collected from system.
+ * @param re compiled pattern, NULL results in OVAL_RESULT_ERROR
+ * @param pattern source of the pattern used in messages
+ */
+oval_result_t oval_pattern_match(pcre *re, const char *pattern, const char *syschar);
+
 
 #endif
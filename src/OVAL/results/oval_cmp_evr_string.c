@@ -51,14 +51,11 @@ static int risdigit(int c) {
 }
 #endif
 
-static inline int rpmevrcmp(const char *a, const char *b);
 static int compare_values(const char *str1, const char *str2);
 static void parseEVR(char *evr, const char **ep, const char **vp, const char **rp);
 
-oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_operation_t operation)
+static oval_result_t evr_result(int result, oval_operation_t operation)
 {
-	int result = rpmevrcmp(sys, state);
-
 	if (operation == OVAL_OPERATION_EQUALS) {
 		return ((result == 0) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
 	} else if (operation == OVAL_OPERATION_NOT_EQUAL) {
@@ -77,30 +74,58 @@ oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_opera
 	return OVAL_RESULT_ERROR;
 }
 
-static inline int rpmevrcmp(const char *a, const char *b)
+void oval_evr_parse(const char *evr_string, struct oval_evr *evr)
+{
+	evr->buffer = oscap_strdup(evr_string);
+	parseEVR(evr->buffer, &evr->epoch, &evr->version, &evr->release);
+}
+
+void oval_evr_clear(struct oval_evr *evr)
+{
+	free(evr->buffer);
+	evr->buffer = NULL;
+}
+
+static inline int rpmevrcmp_parsed(const char *a, const struct oval_evr *b)
 {
 	/* This mimics rpmevrcmp which is not exported by rpmlib version 4.
 	 * Code inspired by rpm.labelCompare() from rpm4/python/header-py.c
 	 */
 	const char *a_epoch, *a_version, *a_release;
-	const char *b_epoch, *b_version, *b_release;
-	char *a_copy, *b_copy;
+	char a_stack[128];
+	char *a_copy;
 	int result;
 
-	a_copy = oscap_strdup(a);
-	b_copy = oscap_strdup(b);
+	/* Most EVRs are short, avoid the heap for them */
+	size_t a_len = strlen(a) + 1;
+	a_copy = a_len <= sizeof(a_stack) ? a_stack : malloc(a_len);
+	memcpy(a_copy, a, a_len);
 	parseEVR(a_copy, &a_epoch, &a_version, &a_release);
-	parseEVR(b_copy, &b_epoch, &b_version, &b_release);
 
-	result = compare_values(a_epoch, b_epoch);
+	result = compare_values(a_epoch, b->epoch);
 	if (!result) {
-		result = compare_values(a_version, b_version);
+		result = compare_values(a_version, b->version);
 		if (!result)
-			result = compare_values(a_release, b_release);
+			result = compare_values(a_release, b->release);
 	}
 
-	free(a_copy);
-	free(b_copy);
+	if (a_copy != a_stack)
+		free(a_copy);
+	return result;
+}
+
+oval_result_t oval_evr_parsed_cmp(const struct oval_evr *state, const char *sys, oval_operation_t operation)
+{
+	return evr_result(rpmevrcmp_parsed(sys, state), operation);
+}
+
+oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_operation_t operation)
+{
+	struct oval_evr state_evr;
+
+	oval_evr_parse(state, &state_evr);
+	oval_result_t result = oval_evr_parsed_cmp(&state_evr, sys, operation);
+	oval_evr_clear(&state_evr);
 	return result;
 }
 
@@ -47,6 +47,27 @@
  */
 oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_operation_t operation);
 
+/**
+ * EVR string split into its epoch, version and release parts.
+ */
+struct oval_evr {
+	char *buffer;           ///< Copy of the EVR string, the parts point into it
+	const char *epoch;      ///< NULL if not present
+	const char *version;
+	const char *release;    ///< NULL if not present
+};
+
+/**
+ * Split EVR string, the result has to be released by oval_evr_clear().
+ */
+void oval_evr_parse(const char *evr_string, struct oval_evr *evr);
+void oval_evr_clear(struct oval_evr *evr);
+
+/**
+ * Same as oval_evr_string_cmp() with the state EVR already split.
+ */
+oval_result_t oval_evr_parsed_cmp(const struct oval_evr *state, const char *sys, oval_operation_t operation);
+
 oval_result_t oval_versiontype_cmp(const char *state, const char *syschar, oval_operation_t operation);
 
 
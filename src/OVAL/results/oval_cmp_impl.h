@@ -23,10 +23,14 @@
 #ifndef OSCAP_OVAL_CMP_IMPL_H_
 #define OSCAP_OVAL_CMP_IMPL_H_
 
+#include <stdint.h>
+#include <pcre.h>
 #include "../common/util.h"
 #include "oval_definitions.h"
 #include "oval_types.h"
 #include "oval_system_characteristics.h"
+#include "oval_cmp_evr_string_impl.h"
+#include "oval_cmp_ip_address_impl.h"
 
 
 /**
@@ -40,5 +44,38 @@
  */
 oval_result_t oval_str_cmp_str(char *state_data, oval_datatype_t state_data_type, const char *sys_data, oval_operation_t operation);
 
+/**
+ * Value of a state entity (or variable/value) prepared for repeated comparisons.
+ * Integers, floats and booleans are converted, EVR strings split, IP addresses
+ * parsed and regular expressions compiled only once.
+ */
+struct oval_operand {
+	const char *text;               ///< Value as written in the content, not owned
+	oval_datatype_t datatype;
+	oval_operation_t operation;
+	int parse_errno;                ///< Non-zero if the value could not be converted
+	union {
+		intmax_t i;
+		double f;
+		bool b;
+		struct oval_evr evr;
+		struct oval_ipaddr ip;
+		pcre *re;               ///< Pattern match only, NULL if it did not compile
+	} value;
+};
+
+/**
+ * Prepare the operand. The text has to outlive the operand.
+ * Conversion errors are reported by oval_operand_cmp().
+ */
+void oval_operand_init(struct oval_operand *operand, const char *state_data, oval_datatype_t state_data_type, oval_operation_t operation);
+
+/**
+ * Compare prepared operand to data collected from system, equivalent to oval_str_cmp_str().
+ */
+oval_result_t oval_operand_cmp(const struct oval_operand *operand, const char *sys_data);
+
+void oval_operand_clear(struct oval_operand *operand);
+
 
 #endif
@@ -31,6 +31,7 @@
 #ifndef OSCAP_OVAL_IP_ADDRESS_IMPL_H_
 #define OSCAP_OVAL_IP_ADDRESS_IMPL_H_
 
+#include <stdint.h>
 #include "common/util.h"
 
 #include "oval_definitions.h"
@@ -49,5 +50,25 @@
  */
 oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_operation_t op);
 
+/**
+ * Parsed IP address or address set (CIDR).
+ */
+struct oval_ipaddr {
+	int af;                 ///< AF_INET or AF_INET6
+	uint32_t mask;          ///< Netmask (IPv4) or prefix length (IPv6)
+	uint32_t addr[4];       ///< struct in_addr or struct in6_addr
+};
+
+/**
+ * Parse IP address as defined by state element.
+ * @returns 0 on success, -1 if the string is not a valid address
+ */
+int oval_ipaddr_parse(int af, const char *s, struct oval_ipaddr *out);
+
+/**
+ * Same as oval_ipaddr_cmp() with the state address already parsed.
+ */
+oval_result_t oval_ipaddr_parsed_cmp(const struct oval_ipaddr *ip1, const char *s2, oval_operation_t op);
+
 
 #endif
@@ -62,6 +62,7 @@ struct oval_results_model {
 	struct oval_probe_session *probe_session;
 #endif
 	bool   export_sys_chars;
+	bool   short_circuit;
 };
 
 struct oval_results_model *oval_results_model_new(struct oval_definition_model *definition_model,
@@ -97,6 +98,7 @@ struct oval_results_model *oval_results_model_new_with_probe_session(struct oval
 	model->probe_session = probe_session;
 #endif
 	model->export_sys_chars = true;
+	model->short_circuit = oscap_streq(getenv("OSCAP_OVAL_SHORT_CIRCUIT"), "1");
 	return model;
 }
 
@@ -126,6 +128,11 @@ bool oval_results_model_get_export_system_characteristics(struct oval_results_mo
 	return model->export_sys_chars;
 }
 
+bool oval_results_model_get_short_circuit(struct oval_results_model *model)
+{
+	return model->short_circuit;
+}
+
 void oval_results_model_free(struct oval_results_model *model)
 {
 	__attribute__nonnull__(model);
@@ -350,6 +350,8 @@ static oval_result_t _oval_result_criteria_node_result(struct oval_result_criter
 			struct oval_result_criteria_node_iterator *subnodes
 			    = oval_result_criteria_node_get_subnodes(node);
 			oval_operator_t operator = oval_result_criteria_node_get_operator(node);
+			struct oval_results_model *model = oval_result_system_get_results_model(oval_result_criteria_get_system(node));
+			bool short_circuit = oval_results_model_get_short_circuit(model);
 			struct oresults node_res;
 			ores_clear(&node_res);
 			while (oval_result_criteria_node_iterator_has_more(subnodes)) {
@@ -357,6 +359,12 @@ static oval_result_t _oval_result_criteria_node_result(struct oval_result_criter
 				    = oval_result_criteria_node_iterator_next(subnodes);
 				oval_result_t subres = oval_result_criteria_node_eval(subnode);
 				ores_add_res(&node_res, subres);
+				/* The remaining criteria stay not evaluated */
+				if (short_circuit && ores_is_decided_byopr(&node_res, operator)
+						&& oval_result_criteria_node_iterator_has_more(subnodes)) {
+					dI("Result of criteria is decided, skipping the remaining criteria.");
+					break;
+				}
 			}
 			oval_result_criteria_node_iterator_free(subnodes);
 			result = ores_get_result_byopr(&node_res, operator);
@@ -40,17 +40,21 @@
 #include "oval_system_characteristics_impl.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
+#include "common/oscap_arena.h"
 
 typedef struct oval_result_item {
 	struct oval_result_system *sys;
 	oval_result_t result;
-	struct oval_collection *messages;
+	struct oval_collection *messages;	///< Created with the first message, most items have none
 	struct oval_sysitem *sysitem;
+	bool in_arena;				///< The item is owned by the arena of its test
 } oval_result_item_t;
 
-struct oval_result_item *oval_result_item_new(struct oval_result_system *sys, char *item_id) {
-	oval_result_item_t *item = (oval_result_item_t *)
-	    malloc(sizeof(oval_result_item_t));
+static struct oval_result_item *_oval_result_item_new(struct oval_result_system *sys, char *item_id, struct oscap_arena *arena)
+{
+	oval_result_item_t *item = (oval_result_item_t *) (arena != NULL ?
+		oscap_arena_alloc(arena, sizeof(oval_result_item_t)) :
+		malloc(sizeof(oval_result_item_t)));
 	if (item == NULL)
 		return NULL;
 
@@ -58,13 +62,23 @@ struct oval_result_item *oval_result_item_new(struct oval_result_system *sys, ch
 	struct oval_sysitem *sysitem = oval_syschar_model_get_new_sysitem(syschar_model, item_id);
 
 	item->sysitem = sysitem;
-	item->messages = oval_collection_new();
+	item->messages = NULL;
 	item->result = OVAL_RESULT_NOT_EVALUATED;
 	item->sys = sys;
+	item->in_arena = arena != NULL;
 
 	return item;
 }
 
+struct oval_result_item *oval_result_item_new(struct oval_result_system *sys, char *item_id) {
+	return _oval_result_item_new(sys, item_id, NULL);
+}
+
+struct oval_result_item *oval_result_item_new_arena(struct oval_result_system *sys, char *item_id, struct oscap_arena *arena)
+{
+	return _oval_result_item_new(sys, item_id, arena);
+}
+
 struct oval_result_item *oval_result_item_clone
     (struct oval_result_system *new_system, struct oval_result_item *old_item) {
 	struct oval_sysitem *old_sysitem = oval_result_item_get_sysitem(old_item);
@@ -94,7 +108,8 @@ void oval_result_item_free(struct oval_result_item *item)
 	item->result = OVAL_RESULT_NOT_EVALUATED;
 	item->sysitem = NULL;
 
-	free(item);
+	if (!item->in_arena)
+		free(item);
 }
 
 bool oval_result_item_iterator_has_more(struct oval_result_item_iterator * oc_result_item)
@@ -137,6 +152,8 @@ oval_result_t oval_result_item_get_result(struct oval_result_item * item)
 struct oval_message_iterator *oval_result_item_get_messages(struct oval_result_item *item) {
 	__attribute__nonnull__(item);
 
+	if (item->messages == NULL)
+		return (struct oval_message_iterator *) oval_collection_iterator_new();
 	return (struct oval_message_iterator *)
 	    oval_collection_iterator(item->messages);
 }
@@ -150,6 +167,10 @@ void oval_result_item_set_result(struct oval_result_item *item, oval_result_t re
 void oval_result_item_add_message(struct oval_result_item *item, struct oval_message *message) 
 {
 	__attribute__nonnull__(item);
+	/* Items of a test may be evaluated by several threads, messages
+	 * are not allocated from the arena of the test */
+	if (item->messages == NULL)
+		item->messages = oval_collection_new();
 	oval_collection_add(item->messages, message);
 }
 
@@ -33,6 +33,7 @@
 #include <config.h>
 #endif
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -41,6 +42,7 @@
 #include "oval_agent_api.h"
 #include "oval_agent_api_impl.h"
 #include "results/oval_results_impl.h"
+#include "results/oval_state_matcher.h"
 #include "adt/oval_collection_impl.h"
 #include "adt/oval_smc_impl.h"
 #include "adt/oval_smc_iterator_impl.h"
@@ -51,12 +53,15 @@
 #include "common/_error.h"
 #include "common/util.h"
 #include "common/list.h"
+#include "common/elements.h"
+#include "common/oscap_parallel.h"
 
 typedef struct oval_result_system {
 	struct oval_results_model *model;
 	struct oval_smc *definitions;			///< Map contains lists of oval_result_definition
 	struct oval_smc *tests;				///< Map contains lists of oval_result_test
 	struct oval_syschar_model *syschar_model;
+	struct oscap_htable *state_matchers;		///< Compiled states by state id
 } oval_result_system_t;
 
 
@@ -117,6 +122,7 @@ struct oval_result_system *oval_result_system_new(struct oval_results_model *mod
 	sys->tests = oval_smc_new();
 	sys->syschar_model = syschar_model;
 	sys->model = model;
+	sys->state_matchers = oscap_htable_new();
 
 	oval_results_model_add_system(model, sys);
 
@@ -145,10 +151,12 @@ void oval_result_system_free(struct oval_result_system *sys)
 
 	oval_smc_free(sys->definitions, (oscap_destruct_func) oval_result_definition_free);
 	oval_smc_free(sys->tests, (oscap_destruct_func) oval_result_test_free);
+	oscap_htable_free(sys->state_matchers, (oscap_destruct_func) oval_state_matcher_free);
 
 	sys->definitions = NULL;
 	sys->syschar_model = NULL;
 	sys->tests = NULL;
+	sys->state_matchers = NULL;
 
 	free(sys);
 }
@@ -194,6 +202,21 @@ struct oval_result_test *oval_result_system_get_test(struct oval_result_system *
 	return oval_smc_get_last(sys->tests, id);
 }
 
+struct oval_state_matcher *oval_result_system_get_state_matcher(struct oval_result_system *sys, struct oval_state *state)
+{
+	__attribute__nonnull__(sys);
+
+	const char *id = oval_state_get_id(state);
+	struct oval_state_matcher *matcher = oscap_htable_get(sys->state_matchers, id);
+	if (matcher == NULL) {
+		matcher = oval_state_matcher_new(state);
+		if (sys->syschar_model != NULL)
+			oval_state_matcher_intern_names(matcher, sys->syschar_model);
+		oscap_htable_add(sys->state_matchers, id, matcher);
+	}
+	return matcher;
+}
+
 struct oval_result_definition *oval_result_system_get_new_definition
     (struct oval_result_system *sys, struct oval_definition *oval_definition, int variable_instance) {
 
@@ -341,11 +364,228 @@ int oval_result_system_parse_tag(xmlTextReaderPtr reader, struct oval_parser_con
 	return return_code;
 }
 
+struct oval_result_tests {
+	struct oscap_htable *visited;
+	struct oval_result_test **tests;
+	size_t count;
+	size_t alloc;
+	uintptr_t round;
+};
+
+static bool _oval_result_tests_visit(struct oval_result_tests *tests, const char *id, int instance)
+{
+	char key[1024];
+	snprintf(key, sizeof(key), "%s#%d", id, instance);
+	return oscap_htable_add(tests->visited, key, (void *) tests->round);
+}
+
+static uintptr_t _oval_result_tests_visited_round(struct oval_result_tests *tests, const char *id, int instance)
+{
+	char key[1024];
+	snprintf(key, sizeof(key), "%s#%d", id, instance);
+	return (uintptr_t) oscap_htable_get(tests->visited, key);
+}
+
+static void _oval_result_tests_add(struct oval_result_tests *tests, struct oval_result_test *test)
+{
+	if (tests->count == tests->alloc) {
+		tests->alloc = tests->alloc ? tests->alloc * 2 : 64;
+		tests->tests = realloc(tests->tests, tests->alloc * sizeof(struct oval_result_test *));
+	}
+	tests->tests[tests->count++] = test;
+}
+
+static void _oval_result_tests_gather(struct oval_result_tests *tests, struct oval_result_criteria_node *node)
+{
+	if (node == NULL)
+		return;
+
+	switch (oval_result_criteria_node_get_type(node)) {
+	case OVAL_NODETYPE_CRITERIA: {
+		struct oval_result_criteria_node_iterator *subnodes = oval_result_criteria_node_get_subnodes(node);
+		while (oval_result_criteria_node_iterator_has_more(subnodes))
+			_oval_result_tests_gather(tests, oval_result_criteria_node_iterator_next(subnodes));
+		oval_result_criteria_node_iterator_free(subnodes);
+		} break;
+	case OVAL_NODETYPE_CRITERION: {
+		struct oval_result_test *test = oval_result_criteria_node_get_test(node);
+		if (test == NULL || oval_result_test_get_result(test) != OVAL_RESULT_NOT_EVALUATED)
+			break;
+		if (_oval_result_tests_visit(tests, oval_result_test_get_id(test), oval_result_test_get_instance(test)))
+			_oval_result_tests_add(tests, test);
+		} break;
+	case OVAL_NODETYPE_EXTENDDEF: {
+		struct oval_result_definition *extends = oval_result_criteria_node_get_extends(node);
+		if (extends == NULL || oval_result_definition_get_result(extends) != OVAL_RESULT_NOT_EVALUATED)
+			break;
+		if (!_oval_result_tests_visit(tests, oval_result_definition_get_id(extends), oval_result_definition_get_instance(extends)))
+			break;
+		_oval_result_tests_gather(tests, oval_result_definition_get_criteria(extends));
+		} break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Short-circuit counterpart of _oval_result_tests_gather(). Find the result
+ * of the node from the tests evaluated so far, the same way the criteria
+ * are evaluated. Gather the tests the result depends on otherwise.
+ * @returns false if the result depends on tests which were gathered
+ */
+static bool _oval_result_tests_gather_next(struct oval_result_tests *tests, struct oval_result_criteria_node *node, oval_result_t *result)
+{
+	oval_result_t res = oval_result_criteria_node_get_result(node);
+	if (res != OVAL_RESULT_NOT_EVALUATED) {
+		*result = res;
+		return true;
+	}
+
+	switch (oval_result_criteria_node_get_type(node)) {
+	case OVAL_NODETYPE_CRITERIA: {
+		oval_operator_t operator = oval_result_criteria_node_get_operator(node);
+		struct oval_result_criteria_node_iterator *subnodes = oval_result_criteria_node_get_subnodes(node);
+		struct oresults node_res;
+		bool known = true;
+		ores_clear(&node_res);
+		while (known && oval_result_criteria_node_iterator_has_more(subnodes)) {
+			oval_result_t subres;
+			known = _oval_result_tests_gather_next(tests, oval_result_criteria_node_iterator_next(subnodes), &subres);
+			if (known) {
+				ores_add_res(&node_res, subres);
+				if (ores_is_decided_byopr(&node_res, operator))
+					break;
+			}
+		}
+		oval_result_criteria_node_iterator_free(subnodes);
+		if (!known)
+			return false;
+		res = ores_get_result_byopr(&node_res, operator);
+		} break;
+	case OVAL_NODETYPE_CRITERION: {
+		struct oval_result_test *test = oval_result_criteria_node_get_test(node);
+		res = oval_result_test_get_result(test);
+		if (res == OVAL_RESULT_NOT_EVALUATED) {
+			const char *id = oval_result_test_get_id(test);
+			int instance = oval_result_test_get_instance(test);
+			uintptr_t round = _oval_result_tests_visited_round(tests, id, instance);
+			/* Tests of previous rounds can't be evaluated any further */
+			if (round == 0) {
+				_oval_result_tests_visit(tests, id, instance);
+				_oval_result_tests_add(tests, test);
+				return false;
+			} else if (round == tests->round) {
+				return false;
+			}
+		}
+		} break;
+	case OVAL_NODETYPE_EXTENDDEF: {
+		struct oval_result_definition *extends = oval_result_criteria_node_get_extends(node);
+		struct oval_result_criteria_node *criteria = oval_result_definition_get_criteria(extends);
+		res = oval_result_definition_get_result(extends);
+		if (res == OVAL_RESULT_NOT_EVALUATED && criteria != NULL
+				&& !_oval_result_tests_gather_next(tests, criteria, &res))
+			return false;
+		} break;
+	default:
+		break;
+	}
+
+	*result = oval_result_criteria_node_negate(node, res);
+	return true;
+}
+
+static void _oval_result_system_eval_test(size_t index, void *arg)
+{
+	struct oval_result_test **tests = arg;
+	oval_result_test_eval_prepared(tests[index]);
+}
+
+static void _oval_result_tests_eval(struct oval_result_tests *tests)
+{
+	/* Probes and variables are not thread safe, everything the tests
+	 * depend on is collected in this thread. Tests which can't be prepared
+	 * are evaluated right away to get the same results as before. */
+	size_t small_count = 0, big_count = 0;
+	struct oval_result_test **big_tests = malloc((tests->count + 1) * sizeof(struct oval_result_test *));
+	if (big_tests == NULL) {
+		for (size_t i = 0; i < tests->count; i++)
+			oval_result_test_eval(tests->tests[i]);
+		return;
+	}
+	for (size_t i = 0; i < tests->count; i++) {
+		struct oval_result_test *test = tests->tests[i];
+		if (oval_result_test_prepare(test) != 0)
+			oval_result_test_eval(test);
+		else if (oval_result_test_get_collected_items_count(test) >= OVAL_PARALLEL_ITEMS_MIN)
+			big_tests[big_count++] = test;
+		else
+			tests->tests[small_count++] = test;
+	}
+
+	/* Each test owns its result and items, tests don't depend on each other */
+	oscap_parallel_run(small_count, _oval_result_system_eval_test, tests->tests);
+	/* Big tests spread their items over the threads instead */
+	for (size_t i = 0; i < big_count; i++)
+		oval_result_test_eval_prepared(big_tests[i]);
+
+	for (size_t i = 0; i < small_count; i++)
+		oval_result_test_mask_items(tests->tests[i]);
+	for (size_t i = 0; i < big_count; i++)
+		oval_result_test_mask_items(big_tests[i]);
+
+	free(big_tests);
+}
+
+void oval_result_system_eval_tests(struct oval_result_system *sys, struct oval_result_definition **definitions, size_t count)
+{
+	struct oval_results_model *model = oval_result_system_get_results_model(sys);
+	struct oval_result_tests tests = {
+		.visited = oscap_htable_new2(0, OSCAP_HTABLE_POOL_KEYS),
+		.round = 1,
+	};
+
+	if (oval_results_model_get_short_circuit(model)) {
+		/* Only tests which decide the results are evaluated, in rounds.
+		 * Each round evaluates the next undecided criterion of every
+		 * definition. */
+		for (;; tests.round++) {
+			tests.count = 0;
+			for (size_t i = 0; i < count; i++) {
+				struct oval_result_criteria_node *criteria = oval_result_definition_get_criteria(definitions[i]);
+				oval_result_t result;
+				if (criteria != NULL && oval_result_definition_get_result(definitions[i]) == OVAL_RESULT_NOT_EVALUATED)
+					_oval_result_tests_gather_next(&tests, criteria, &result);
+			}
+			if (tests.count == 0)
+				break;
+			dI("Evaluating %zu tests in round %zu of short-circuit evaluation.", tests.count, (size_t) tests.round);
+			_oval_result_tests_eval(&tests);
+		}
+	} else {
+		/* Shared tests and extended definitions are gathered only once */
+		for (size_t i = 0; i < count; i++) {
+			struct oval_result_definition *definition = definitions[i];
+			if (oval_result_definition_get_result(definition) != OVAL_RESULT_NOT_EVALUATED)
+				continue;
+			if (!_oval_result_tests_visit(&tests, oval_result_definition_get_id(definition), oval_result_definition_get_instance(definition)))
+				continue;
+			_oval_result_tests_gather(&tests, oval_result_definition_get_criteria(definition));
+		}
+		_oval_result_tests_eval(&tests);
+	}
+
+	oscap_htable_free0(tests.visited);
+	free(tests.tests);
+}
+
 int oval_result_system_eval(struct oval_result_system *sys)
 {
 	struct oval_results_model *res_model;
 	struct oval_definition_model *definition_model;
 	struct oval_definition_iterator *definitions_itr;
+	struct oval_result_definition **rslt_definitions = NULL;
+	size_t count = 0, alloc = 0;
 
 	res_model = oval_result_system_get_results_model(sys);
 	definition_model = oval_results_model_get_definition_model(res_model);
@@ -353,14 +593,22 @@ int oval_result_system_eval(struct oval_result_system *sys)
 
 	while (oval_definition_iterator_has_more(definitions_itr)) {
 		struct oval_definition *definition;
-		struct oval_result_definition *rslt_definition;
 
 		definition = oval_definition_iterator_next(definitions_itr);
-		rslt_definition = oval_result_system_get_new_definition(sys, definition, 0);
-		oval_result_definition_eval(rslt_definition);
+		if (count == alloc) {
+			alloc = alloc ? alloc * 2 : 64;
+			rslt_definitions = realloc(rslt_definitions, alloc * sizeof(struct oval_result_definition *));
+		}
+		rslt_definitions[count++] = oval_result_system_get_new_definition(sys, definition, 0);
 	}
-
 	oval_definition_iterator_free(definitions_itr);
+
+	/* Tests are the expensive part, definitions then only combine their results */
+	oval_result_system_eval_tests(sys, rslt_definitions, count);
+	for (size_t i = 0; i < count; i++)
+		oval_result_definition_eval(rslt_definitions[i]);
+
+	free(rslt_definitions);
 	return 0;
 }
 
@@ -410,26 +658,15 @@ cleanup:
 	return rslt_definition;
 }
 
-static void _oval_result_definition_to_dom_based_on_directives(struct oval_result_definition *rslt_definition,
-						   struct oval_result_directives * directives,
-						   xmlDocPtr doc,
-						   xmlNode *definitions_node,
-						   struct oval_smc *tstmap)
+struct oval_result_definition_export {
+	struct oval_result_definition *rslt_definition;
+	oval_result_directive_content_t content;
+};
+
+static void _oval_result_definition_export_to_dom(size_t index, xmlDocPtr doc, xmlNode *definitions_node, void *arg)
 {
-	oval_result_t result = oval_result_definition_get_result(rslt_definition);
-	if (oval_result_directives_get_reported(directives, result)) {
-		oval_result_directive_content_t content = oval_result_directives_get_content(directives, result);
-		/* report definition according to directives settings */
-		oval_result_definition_to_dom(rslt_definition, content, doc, definitions_node);
-		if (content == OVAL_DIRECTIVE_CONTENT_FULL) {
-			struct oval_result_criteria_node *criteria = oval_result_definition_get_criteria(rslt_definition);
-			/* collect the tests that are referenced from reported definitions */
-			if (criteria)
-				_oval_result_system_scan_criteria_for_references(criteria, tstmap);
-		} else if (content == OVAL_DIRECTIVE_CONTENT_THIN) {
-			// NOOP
-		}
-	}
+	struct oval_result_definition_export *exports = arg;
+	oval_result_definition_to_dom(exports[index].rslt_definition, exports[index].content, doc, definitions_node);
 }
 
 xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
@@ -446,37 +683,80 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 
 	struct oval_smc *tstmap = oval_smc_new();
 
+	/* Select the reported result definitions first, this may create new
+	 * result definitions in the system, so it is done sequentially. */
+	size_t exports_count = 0;
+	size_t exports_size = 0;
+	struct oval_result_definition_export *exports = NULL;
+
 	struct oval_definition_model *definition_model = oval_results_model_get_definition_model(results_model);
 	struct oval_definition_iterator *oval_definitions = oval_definition_model_get_definitions(definition_model);
-	if(oval_definition_iterator_has_more(oval_definitions)) {
-		xmlNode *definitions_node = xmlNewTextChild(system_node, ns_results, BAD_CAST "definitions", NULL);
-		while(oval_definition_iterator_has_more(oval_definitions)) {
-			struct oval_definition *oval_definition = oval_definition_iterator_next(oval_definitions);
-
-			oval_definition_class_t def_class = oval_definition_get_class(oval_definition);
-			class_dirs = oval_directives_model_get_classdir(directives_model, def_class);
-			directives = class_dirs ? class_dirs : def_dirs;
-
-			bool exported = false;
-			struct oval_iterator *rslt_definitions_it = oval_smc_get_all_it(sys->definitions, oval_definition_get_id(oval_definition));
-			if (rslt_definitions_it != NULL) {
-				while (oval_collection_iterator_has_more(rslt_definitions_it)) {
-					struct oval_result_definition *rslt_definition = oval_collection_iterator_next(rslt_definitions_it);
-					_oval_result_definition_to_dom_based_on_directives(rslt_definition, directives, doc, definitions_node, tstmap);
-					exported = true;
-				}
-				oval_collection_iterator_free(rslt_definitions_it);
+	xmlNode *definitions_node = NULL;
+	if (oval_definition_iterator_has_more(oval_definitions))
+		definitions_node = xmlNewTextChild(system_node, ns_results, BAD_CAST "definitions", NULL);
+	while (oval_definition_iterator_has_more(oval_definitions)) {
+		struct oval_definition *oval_definition = oval_definition_iterator_next(oval_definitions);
+
+		oval_definition_class_t def_class = oval_definition_get_class(oval_definition);
+		class_dirs = oval_directives_model_get_classdir(directives_model, def_class);
+		directives = class_dirs ? class_dirs : def_dirs;
+
+		struct oscap_list *rslt_definitions = oscap_list_new();
+		struct oval_iterator *rslt_definitions_it = oval_smc_get_all_it(sys->definitions, oval_definition_get_id(oval_definition));
+		if (rslt_definitions_it != NULL) {
+			while (oval_collection_iterator_has_more(rslt_definitions_it))
+				oscap_list_add(rslt_definitions, oval_collection_iterator_next(rslt_definitions_it));
+			oval_collection_iterator_free(rslt_definitions_it);
+		}
+		if (oscap_list_get_itemcount(rslt_definitions) == 0) {
+			struct oval_result_definition *rslt_definition = oval_result_system_get_new_definition(sys, oval_definition, 1);
+			if (rslt_definition)
+				oscap_list_add(rslt_definitions, rslt_definition);
+		}
+
+		struct oscap_iterator *it = oscap_iterator_new(rslt_definitions);
+		while (oscap_iterator_has_more(it)) {
+			struct oval_result_definition *rslt_definition = oscap_iterator_next(it);
+			oval_result_t result = oval_result_definition_get_result(rslt_definition);
+			if (!oval_result_directives_get_reported(directives, result))
+				continue;
+
+			oval_result_directive_content_t content = oval_result_directives_get_content(directives, result);
+			if (content == OVAL_DIRECTIVE_CONTENT_FULL) {
+				struct oval_result_criteria_node *criteria = oval_result_definition_get_criteria(rslt_definition);
+				/* collect the tests that are referenced from reported definitions */
+				if (criteria)
+					_oval_result_system_scan_criteria_for_references(criteria, tstmap);
 			}
-			if (!exported) {
-				struct oval_result_definition *rslt_definition = oval_result_system_get_new_definition(sys, oval_definition, 1);
-				if (rslt_definition) {
-					_oval_result_definition_to_dom_based_on_directives(rslt_definition, directives, doc, definitions_node, tstmap);
+
+			if (exports_count == exports_size) {
+				size_t new_size = exports_size ? 2 * exports_size : 64;
+				struct oval_result_definition_export *new_exports = realloc(exports, new_size * sizeof(struct oval_result_definition_export));
+				if (new_exports == NULL) {
+					/* Export the selected definitions and this one right away */
+					oscap_xml_build_children_parallel(doc, definitions_node, exports_count, _oval_result_definition_export_to_dom, exports);
+					exports_count = 0;
+					oval_result_definition_to_dom(rslt_definition, content, doc, definitions_node);
+					continue;
 				}
+				exports = new_exports;
+				exports_size = new_size;
 			}
+			exports[exports_count].rslt_definition = rslt_definition;
+			exports[exports_count].content = content;
+			exports_count++;
 		}
+		oscap_iterator_free(it);
+		oscap_list_free0(rslt_definitions);
 	}
 	oval_definition_iterator_free(oval_definitions);
 
+	/* Definitions are independent of each other, their subtrees are built
+	 * concurrently and appended in the original order. */
+	if (definitions_node != NULL)
+		oscap_xml_build_children_parallel(doc, definitions_node, exports_count, _oval_result_definition_export_to_dom, exports);
+	free(exports);
+
 	struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(sys);
 	struct oval_string_map *sysmap = oval_string_map_new();
 	struct oval_string_map *objmap = oval_string_map_new();
@@ -41,6 +41,7 @@
 #endif
 #include "results/oval_results_impl.h"
 #include "results/oval_status_counter.h"
+#include "results/oval_state_matcher.h"
 #include "oval_cmp_impl.h"
 #include "adt/oval_collection_impl.h"
 #include "adt/oval_string_map_impl.h"
@@ -49,6 +50,8 @@
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/_error.h"
+#include "common/oscap_parallel.h"
+#include "common/oscap_arena.h"
 
 typedef struct oval_result_test {
 	struct oval_result_system *system;
@@ -59,8 +62,13 @@ typedef struct oval_result_test {
 	struct oval_collection *bindings;
 	int instance;
 	bool bindings_initialized;
+	bool mask_items;		///< Items were compared with the states, see oval_result_test_mask_items()
+	struct oscap_arena *arena;	///< Memory of the evaluated items, NULL before the evaluation
 } oval_result_test_t;
 
+/* Size of a result item and its frame in the collection of the test */
+#define OVAL_RESULT_ITEM_SIZE_ESTIMATE 64
+
 struct oval_result_test *oval_result_test_new(struct oval_result_system *sys, char *tstid)
 {
 	oval_result_test_t *test = (oval_result_test_t *)
@@ -78,6 +86,8 @@ struct oval_result_test *oval_result_test_new(struct oval_result_system *sys, ch
 	test->items = oval_collection_new();
 	test->bindings = oval_collection_new();
 	test->bindings_initialized = false;
+	test->mask_items = false;
+	test->arena = NULL;
 	return test;
 }
 
@@ -131,6 +141,8 @@ void oval_result_test_free(struct oval_result_test *test)
 	oval_collection_free_items(test->messages, (oscap_destruct_func) oval_message_free);
 	oval_collection_free_items(test->items, (oscap_destruct_func) oval_result_item_free);
 	oval_collection_free_items(test->bindings, (oscap_destruct_func) oval_variable_binding_free);
+	/* Items and their frames are released at once */
+	oscap_arena_free(test->arena);
 
 	test->system = NULL;
 	test->test = NULL;
@@ -381,6 +393,20 @@ oval_result_t ores_get_result_byopr(struct oresults *ores, oval_operator_t op)
 	return result;
 }
 
+bool ores_is_decided_byopr(struct oresults *ores, oval_operator_t op)
+{
+	switch (op) {
+	case OVAL_OPERATOR_AND:
+		return ores->false_cnt > 0;
+	case OVAL_OPERATOR_OR:
+		return ores->true_cnt > 0;
+	case OVAL_OPERATOR_ONE:
+		return ores->true_cnt >= 2;
+	default:
+		return false;
+	}
+}
+
 static inline oval_result_t _evaluate_sysent_with_variable(struct oval_syschar_model *syschar_model, struct oval_variable *state_entity_var, const char *sys_data, oval_operation_t state_entity_operation, oval_check_t var_check)
 {
 	oval_syschar_collection_flag_t flag;
@@ -509,106 +535,52 @@ static oval_result_t _evaluate_sysent_record(struct oval_syschar_model *syschar_
 	return ores_get_result_byopr(&record_ores, OVAL_OPERATOR_AND);
 }
 
-static inline oval_result_t _evaluate_sysent(struct oval_syschar_model *syschar_model, struct oval_sysent *item_entity, struct oval_entity *state_entity, oval_operation_t state_entity_operation, struct oval_state_content *content)
+static inline oval_result_t _evaluate_sysent(struct oval_syschar_model *syschar_model, struct oval_sysent *item_entity,
+		const struct oval_entity_matcher *em, struct oval_variable_operands *vo)
 {
 	if (oval_sysent_get_status(item_entity) == SYSCHAR_STATUS_DOES_NOT_EXIST) {
 		return OVAL_RESULT_FALSE;
-	} else if (oval_entity_get_varref_type(state_entity) == OVAL_ENTITY_VARREF_ATTRIBUTE) {
-		struct oval_variable *state_entity_var;
-		if ((state_entity_var = oval_entity_get_variable(state_entity)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL variable");
-			return -1;
-		}
+	} else if (em->value_error != NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "%s", em->value_error);
+		return -1;
+	} else if (em->variable != NULL) {
 		const char *sys_data = oval_sysent_get_value(item_entity);
-		oval_check_t var_check = oval_state_content_get_var_check(content);
-
-		return _evaluate_sysent_with_variable(syschar_model,
-				state_entity_var, sys_data,
-				state_entity_operation, var_check);
-	} else {
-		struct oval_value *state_entity_val;
-		char *state_entity_val_text;
-		oval_datatype_t state_entity_val_datatype;
-
-		oval_datatype_t state_entity_type = oval_entity_get_datatype(state_entity);
-		if (state_entity_type == OVAL_DATATYPE_RECORD) {
-			if (state_entity_operation != OVAL_OPERATION_EQUALS) {
-				dE("The only allowed operation for comparing record types is 'equals'.");
-				return OVAL_RESULT_ERROR;
-			}
-			return _evaluate_sysent_record(syschar_model, content, item_entity);
-		} else {
-			if ((state_entity_val = oval_entity_get_value(state_entity)) == NULL) {
-				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity value");
-				return -1;
-			}
-			if ((state_entity_val_text = oval_value_get_text(state_entity_val)) == NULL) {
-				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity value text");
-				return -1;
-			}
-			state_entity_val_datatype = oval_value_get_datatype(state_entity_val);
-
-			const char *sys_data = oval_sysent_get_value(item_entity);
-			return oval_str_cmp_str(state_entity_val_text, state_entity_val_datatype, sys_data, state_entity_operation);
+		return oval_variable_operands_cmp(vo, em, syschar_model, sys_data);
+	} else if (em->record) {
+		if (em->operation != OVAL_OPERATION_EQUALS) {
+			dE("The only allowed operation for comparing record types is 'equals'.");
+			return OVAL_RESULT_ERROR;
 		}
+		return _evaluate_sysent_record(syschar_model, em->content, item_entity);
+	} else {
+		const char *sys_data = oval_sysent_get_value(item_entity);
+		return oval_operand_cmp(&em->operand, sys_data);
 	}
 }
 
-static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct oval_sysitem *cur_sysitem, struct oval_state *state)
+static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct oval_sysitem *cur_sysitem,
+		const struct oval_state_matcher *matcher, struct oval_variable_operands *var_operands)
 {
-	struct oval_state_content_iterator *state_contents_itr;
+	struct oval_state *state = matcher->state;
 	struct oresults ste_ores;
-	oval_operator_t operator;
 	oval_result_t result = OVAL_RESULT_ERROR;
+	bool interned_names = matcher->names_model != NULL && matcher->names_model == syschar_model;
 
 	ores_clear(&ste_ores);
 
-	state_contents_itr = oval_state_get_contents(state);
-	while (oval_state_content_iterator_has_more(state_contents_itr)) {
-		struct oval_state_content *content;
-		struct oval_entity *state_entity;
-		char *state_entity_name;
-		oval_operation_t state_entity_operation;
-		oval_check_t entity_check;
-		oval_existence_t check_existence;
+	if (matcher->error != NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "%s", matcher->error);
+		return OVAL_RESULT_ERROR;
+	}
+
+	for (size_t i = 0; i < matcher->count; i++) {
+		const struct oval_entity_matcher *em = &matcher->entities[i];
 		oval_result_t ste_ent_res;
 		struct oval_sysent_iterator *item_entities_itr;
 		struct oresults ent_ores;
 		struct oval_status_counter counter;
 		bool found_matching_item;
 
-		if ((content = oval_state_content_iterator_next(state_contents_itr)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL state content");
-			goto fail;
-		}
-		if ((state_entity = oval_state_content_get_entity(content)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity");
-			goto fail;
-		}
-		if ((state_entity_name = oval_entity_get_name(state_entity)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity name");
-			goto fail;
-		}
-
-		if (oscap_streq(state_entity_name, "line") &&
-			oval_state_get_subtype(state) == (oval_subtype_t) OVAL_INDEPENDENT_TEXT_FILE_CONTENT) {
-			/* Hack: textfilecontent_state/line shall be compared against textfilecontent_item/text.
-			 *
-			 * textfilecontent_test and textfilecontent54_test share the same syschar
-			 * (textfilecontent_item). In OVAL 5.3 and below this syschar did not hold any usable
-			 * information ('text' ent). In OVAL 5.4 textfilecontent_test was deprecated. But the
-			 * 'text' ent has been added to textfilecontent_item, making it potentially usable. */
-			oval_schema_version_t over = oval_state_get_platform_schema_version(state);
-			if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.4)) >= 0) {
-				/* The OVAL-5.3 does not have textfilecontent_item/text */
-				state_entity_name = "text";
-			}
-		}
-
-		entity_check = oval_state_content_get_ent_check(content);
-		check_existence = oval_state_content_get_check_existence(content);
-		state_entity_operation = oval_entity_get_operation(state_entity);
-
 		ores_clear(&ent_ores);
 		found_matching_item = false;
 		oval_status_counter_clear(&counter);
@@ -624,23 +596,22 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 			if (item_entity == NULL) {
 				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL sysent");
 				oval_sysent_iterator_free(item_entities_itr);
-				goto fail;
+				return OVAL_RESULT_ERROR;
 			}
 			item_status = oval_sysent_get_status(item_entity);
 			oval_status_counter_add_status(&counter, item_status);
 
 			item_entity_name = oval_sysent_get_name(item_entity);
-			if (strcmp(item_entity_name, state_entity_name))
+			if (interned_names && oval_sysent_name_is_interned(item_entity, syschar_model)) {
+				if (item_entity_name != em->name)
+					continue;
+			} else if (strcmp(item_entity_name, em->name)) {
 				continue;
+			}
 
 			found_matching_item = true;
 
-			/* copy mask attribute from state to item */
-			if (oval_entity_get_mask(state_entity))
-				oval_sysent_set_mask(item_entity,1);
-
-			ent_val_res = _evaluate_sysent(syschar_model, item_entity, state_entity,
-					state_entity_operation, content);
+			ent_val_res = _evaluate_sysent(syschar_model, item_entity, em, &var_operands[i]);
 			if (ent_val_res == OVAL_RESULT_TRUE) {
 				dI("Entity '%s'='%s' of item '%s' matches corresponding entity in state '%s'.",
 						oval_sysent_get_name(item_entity),
@@ -655,7 +626,7 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 			}
 			if (((signed) ent_val_res) == -1) {
 				oval_sysent_iterator_free(item_entities_itr);
-				goto fail;
+				return OVAL_RESULT_ERROR;
 			}
 
 			ores_add_res(&ent_ores, ent_val_res);
@@ -664,33 +635,43 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 
 		if (!found_matching_item)
 			dW("Entity name '%s' from state (id: '%s') not found in item (id: '%s').",
-			   state_entity_name, oval_state_get_id(state), oval_sysitem_get_id(cur_sysitem));
+			   em->name, oval_state_get_id(state), oval_sysitem_get_id(cur_sysitem));
 
-		ste_ent_res = ores_get_result_bychk(&ent_ores, entity_check);
+		ste_ent_res = ores_get_result_bychk(&ent_ores, em->entity_check);
 		ores_add_res(&ste_ores, ste_ent_res);
-		oval_result_t cres = oval_status_counter_get_result(&counter, check_existence);
+		oval_result_t cres = oval_status_counter_get_result(&counter, em->check_existence);
 		ores_add_res(&ste_ores, cres);
 	}
-	oval_state_content_iterator_free(state_contents_itr);
 
-	operator = oval_state_get_operator(state);
-	result = ores_get_result_byopr(&ste_ores, operator);
+	result = ores_get_result_byopr(&ste_ores, matcher->operator);
 	dI("Item '%s' compared to state '%s' with result %s.",
 			   oval_sysitem_get_id(cur_sysitem), oval_state_get_id(state),
 			   oval_result_get_text(result));
 
 	return result;
-
- fail:
-	oval_state_content_iterator_free(state_contents_itr);
-
-	return OVAL_RESULT_ERROR;
 }
 
 #define ITEMMAP (struct oval_string_map    *)args[2]
 #define TEST    (struct oval_result_test   *)args[1]
 #define SYSTEM  (struct oval_result_system *)args[0]
 
+/* Create the arena of the test sized for the collected items. Items parsed
+ * from results or added by the API keep being allocated one by one. */
+static struct oscap_arena *_oval_result_test_reserve_items(struct oval_result_test *rtest, size_t count)
+{
+	if (rtest->arena != NULL)
+		return rtest->arena;
+	if (!oval_collection_is_empty(rtest->items))
+		return NULL;
+
+	rtest->arena = oscap_arena_new(count * OVAL_RESULT_ITEM_SIZE_ESTIMATE);
+	if (rtest->arena != NULL) {
+		oval_collection_free(rtest->items);
+		rtest->items = oval_collection_new_arena(rtest->arena);
+	}
+	return rtest->arena;
+}
+
 static void _oval_test_item_consumer(struct oval_result_item *item, void **args) {
 	struct oval_sysitem *oval_sysitem = oval_result_item_get_sysitem(item);
 	char *item_id = oval_sysitem_get_id(oval_sysitem);
@@ -703,6 +684,90 @@ static void _oval_test_item_consumer(struct oval_result_item *item, void **args)
 	}
 }
 
+static oval_result_t _eval_check_state_item(struct oval_syschar_model *syschar_model, struct oval_result_item *ritem,
+		struct oval_state_matcher **matchers, struct oval_variable_operands **var_operands, size_t ste_cnt,
+		oval_operator_t ste_opr)
+{
+	struct oval_sysitem *item;
+	struct oresults ste_ores;
+	oval_result_t item_res;
+
+	item = oval_result_item_get_sysitem(ritem);
+	switch (oval_sysitem_get_status(item)) {
+	case SYSCHAR_STATUS_ERROR:
+	case SYSCHAR_STATUS_NOT_COLLECTED:
+		item_res = OVAL_RESULT_ERROR;
+		oval_result_item_set_result(ritem, item_res);
+		return item_res;
+	case SYSCHAR_STATUS_DOES_NOT_EXIST:
+		item_res = OVAL_RESULT_FALSE;
+		oval_result_item_set_result(ritem, item_res);
+		return item_res;
+	default:
+		break;
+	}
+
+	ores_clear(&ste_ores);
+
+	for (size_t i = 0; i < ste_cnt; i++) {
+		oval_result_t ste_res;
+
+		ste_res = eval_item(syschar_model, item, matchers[i], var_operands[i]);
+		ores_add_res(&ste_ores, ste_res);
+	}
+
+	item_res = ores_get_result_byopr(&ste_ores, ste_opr);
+	oval_result_item_set_result(ritem, item_res);
+	return item_res;
+}
+
+/* Compute variables referenced by the state before its items are compared in parallel */
+static void _compute_state_variables(const struct oval_state_matcher *matcher, struct oval_syschar_model *syschar_model)
+{
+	for (size_t i = 0; i < matcher->count; i++) {
+		const struct oval_entity_matcher *em = &matcher->entities[i];
+		if (em->variable != NULL)
+			oval_syschar_model_compute_variable(syschar_model, em->variable);
+		if (!em->record)
+			continue;
+		struct oval_record_field_iterator *rf_itr = oval_state_content_get_record_fields(em->content);
+		while (oval_record_field_iterator_has_more(rf_itr)) {
+			struct oval_record_field *rf = oval_record_field_iterator_next(rf_itr);
+			if (oval_record_field_get_type(rf) != OVAL_RECORD_FIELD_STATE)
+				continue;
+			struct oval_variable *var = oval_record_field_get_variable(rf);
+			if (var != NULL)
+				oval_syschar_model_compute_variable(syschar_model, var);
+		}
+		oval_record_field_iterator_free(rf_itr);
+	}
+}
+
+#define OVAL_PARALLEL_ITEMS_CHUNK 1024
+
+struct eval_items_job {
+	struct oval_syschar_model *syschar_model;
+	struct oval_result_item **ritems;
+	size_t ritems_cnt;
+	struct oval_state_matcher **matchers;
+	struct oval_variable_operands **var_operands;
+	size_t ste_cnt;
+	oval_operator_t ste_opr;
+};
+
+static void _eval_check_state_chunk(size_t index, void *arg)
+{
+	struct eval_items_job *job = arg;
+	size_t end = (index + 1) * OVAL_PARALLEL_ITEMS_CHUNK;
+
+	if (end > job->ritems_cnt)
+		end = job->ritems_cnt;
+	for (size_t i = index * OVAL_PARALLEL_ITEMS_CHUNK; i < end; i++) {
+		_eval_check_state_item(job->syschar_model, job->ritems[i], job->matchers,
+				job->var_operands, job->ste_cnt, job->ste_opr);
+	}
+}
+
 static oval_result_t eval_check_state(struct oval_test *test, void **args)
 {
 	struct oval_syschar_model *syschar_model;
@@ -717,6 +782,10 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 	syschar_model = oval_result_system_get_syschar_model(SYSTEM);
 	ores_clear(&item_ores);
 
+	/* Items may be shared with tests compared by other threads */
+	struct oval_result_test *rtest = TEST;
+	rtest->mask_items = true;
+
 	char *state_names = oval_test_get_state_names(test);
 	if (state_names) {
 		dI("In test '%s' %s of the collected items must satisfy these states: %s.",
@@ -724,57 +793,118 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 		free(state_names);
 	}
 
+	/* Compile the states once for all the items */
+	size_t ste_cnt = 0, ste_alloc = 0;
+	struct oval_state_matcher **matchers = NULL;
+	struct oval_variable_operands **var_operands = NULL;
+	struct oval_state_iterator *ste_itr = oval_test_get_states(test);
+	while (oval_state_iterator_has_more(ste_itr)) {
+		struct oval_state *ste = oval_state_iterator_next(ste_itr);
+		if (ste_cnt == ste_alloc) {
+			ste_alloc = ste_alloc ? ste_alloc * 2 : 2;
+			matchers = realloc(matchers, ste_alloc * sizeof(*matchers));
+			var_operands = realloc(var_operands, ste_alloc * sizeof(*var_operands));
+		}
+		matchers[ste_cnt] = oval_result_system_get_state_matcher(SYSTEM, ste);
+		var_operands[ste_cnt] = oval_variable_operands_new(matchers[ste_cnt]);
+		ste_cnt++;
+	}
+	oval_state_iterator_free(ste_itr);
+
+	struct eval_items_job job = {
+		.syschar_model = syschar_model,
+		.ritems = NULL,
+		.ritems_cnt = 0,
+		.matchers = matchers,
+		.var_operands = var_operands,
+		.ste_cnt = ste_cnt,
+		.ste_opr = ste_opr,
+	};
+	size_t ritems_alloc = 0;
 	ritems_itr = oval_result_test_get_items(TEST);
 	while (oval_result_item_iterator_has_more(ritems_itr)) {
-		struct oval_result_item *ritem;
-		struct oval_sysitem *item;
-		oval_syschar_status_t item_status;
-		struct oresults ste_ores;
-		struct oval_state_iterator *ste_itr;
-		oval_result_t item_res;
-
-		ritem = oval_result_item_iterator_next(ritems_itr);
-		item = oval_result_item_get_sysitem(ritem);
+		if (job.ritems_cnt == ritems_alloc) {
+			ritems_alloc = ritems_alloc ? ritems_alloc * 2 : 16;
+			job.ritems = realloc(job.ritems, ritems_alloc * sizeof(struct oval_result_item *));
+		}
+		job.ritems[job.ritems_cnt++] = oval_result_item_iterator_next(ritems_itr);
+	}
+	oval_result_item_iterator_free(ritems_itr);
 
-		item_status = oval_sysitem_get_status(item);
-		switch (item_status) {
-		case SYSCHAR_STATUS_ERROR:
-		case SYSCHAR_STATUS_NOT_COLLECTED:
-			item_res = OVAL_RESULT_ERROR;
-			ores_add_res(&item_ores, item_res);
-			oval_result_item_set_result(ritem, item_res);
-			continue;
-		case SYSCHAR_STATUS_DOES_NOT_EXIST:
-			item_res = OVAL_RESULT_FALSE;
+	if (job.ritems_cnt >= OVAL_PARALLEL_ITEMS_MIN) {
+		/* Items are compared in chunks by several threads, the variables
+		 * have to be compiled before. Results are aggregated in the order
+		 * of the items afterwards. */
+		for (size_t i = 0; i < ste_cnt; i++) {
+			_compute_state_variables(matchers[i], syschar_model);
+			oval_variable_operands_bind(var_operands[i], matchers[i], syschar_model);
+		}
+		oscap_parallel_run((job.ritems_cnt + OVAL_PARALLEL_ITEMS_CHUNK - 1) / OVAL_PARALLEL_ITEMS_CHUNK,
+				_eval_check_state_chunk, &job);
+		for (size_t i = 0; i < job.ritems_cnt; i++)
+			ores_add_res(&item_ores, oval_result_item_get_result(job.ritems[i]));
+	} else {
+		for (size_t i = 0; i < job.ritems_cnt; i++) {
+			oval_result_t item_res = _eval_check_state_item(syschar_model, job.ritems[i],
+					matchers, var_operands, ste_cnt, ste_opr);
 			ores_add_res(&item_ores, item_res);
-			oval_result_item_set_result(ritem, item_res);
-			continue;
-		default:
-			break;
 		}
+	}
+	free(job.ritems);
 
-		ores_clear(&ste_ores);
+	for (size_t i = 0; i < ste_cnt; i++)
+		oval_variable_operands_free(var_operands[i], matchers[i]);
+	free(var_operands);
+	free(matchers);
 
-		ste_itr = oval_test_get_states(test);
-		while (oval_state_iterator_has_more(ste_itr)) {
-			struct oval_state *ste;
-			oval_result_t ste_res;
+	result = ores_get_result_bychk(&item_ores, ste_check);
 
-			ste = oval_state_iterator_next(ste_itr);
-			ste_res = eval_item(syschar_model, item, ste);
-			ores_add_res(&ste_ores, ste_res);
-		}
-		oval_state_iterator_free(ste_itr);
+	return result;
+}
 
-		item_res = ores_get_result_byopr(&ste_ores, ste_opr);
-		ores_add_res(&item_ores, item_res);
-		oval_result_item_set_result(ritem, item_res);
-	}
-	oval_result_item_iterator_free(ritems_itr);
+void oval_result_test_mask_items(struct oval_result_test *rtest)
+{
+	__attribute__nonnull__(rtest);
 
-	result = ores_get_result_bychk(&item_ores, ste_check);
+	if (!rtest->mask_items)
+		return;
+	rtest->mask_items = false;
 
-	return result;
+	/* Copy the mask attribute from the entities of the states to the
+	 * entities of the items which were compared with them */
+	struct oval_state_iterator *ste_itr = oval_test_get_states(rtest->test);
+	while (oval_state_iterator_has_more(ste_itr)) {
+		struct oval_state *ste = oval_state_iterator_next(ste_itr);
+		const struct oval_state_matcher *matcher = oval_result_system_get_state_matcher(rtest->system, ste);
+		if (matcher->error != NULL)
+			continue;
+		for (size_t i = 0; i < matcher->count; i++) {
+			const struct oval_entity_matcher *em = &matcher->entities[i];
+			if (!em->mask)
+				continue;
+			struct oval_result_item_iterator *ritems_itr = oval_result_test_get_items(rtest);
+			while (oval_result_item_iterator_has_more(ritems_itr)) {
+				struct oval_sysitem *item = oval_result_item_get_sysitem(oval_result_item_iterator_next(ritems_itr));
+				switch (oval_sysitem_get_status(item)) {
+				case SYSCHAR_STATUS_ERROR:
+				case SYSCHAR_STATUS_NOT_COLLECTED:
+				case SYSCHAR_STATUS_DOES_NOT_EXIST:
+					continue;
+				default:
+					break;
+				}
+				struct oval_sysent_iterator *item_entities_itr = oval_sysitem_get_sysents(item);
+				while (oval_sysent_iterator_has_more(item_entities_itr)) {
+					struct oval_sysent *item_entity = oval_sysent_iterator_next(item_entities_itr);
+					if (item_entity != NULL && !strcmp(oval_sysent_get_name(item_entity), em->name))
+						oval_sysent_set_mask(item_entity, 1);
+				}
+				oval_sysent_iterator_free(item_entities_itr);
+			}
+			oval_result_item_iterator_free(ritems_itr);
+		}
+	}
+	oval_state_iterator_free(ste_itr);
 }
 
 static oval_result_t eval_check_existence(oval_existence_t check_existence, int exists_cnt, int error_cnt)
@@ -857,6 +987,8 @@ _oval_result_test_evaluate_items(struct oval_test *test, struct oval_syschar *sy
 	exists_cnt = error_cnt = 0;
 	test_id = oval_test_get_id(test);
 	collected_items_itr = oval_syschar_get_sysitem(syschar_object);
+	struct oscap_arena *arena = _oval_result_test_reserve_items(TEST,
+		oval_collection_iterator_remaining((struct oval_iterator *) collected_items_itr));
 	while (oval_sysitem_iterator_has_more(collected_items_itr)) {
 		struct oval_sysitem *item;
 		char *item_id;
@@ -877,7 +1009,7 @@ _oval_result_test_evaluate_items(struct oval_test *test, struct oval_syschar *sy
 			error_cnt++;
 
 		item_id = oval_sysitem_get_id(item);
-		ritem = oval_result_item_new(SYSTEM, item_id);
+		ritem = oval_result_item_new_arena(SYSTEM, item_id, arena);
 		oval_result_item_set_result(ritem, OVAL_RESULT_NOT_EVALUATED);
 		_oval_test_item_consumer(ritem, args);
 	}
@@ -1003,7 +1135,7 @@ _oval_result_test_evaluate_items(struct oval_test *test, struct oval_syschar *sy
 }
 
 /* this function will gather all the necessary ingredients and call 'evaluate_items' when it finds them */
-static oval_result_t _oval_result_test_result(struct oval_result_test *rtest, void **args)
+static oval_result_t _oval_result_test_result(struct oval_result_test *rtest, void **args, bool collect)
 {
 	__attribute__nonnull__(rtest);
 
@@ -1022,7 +1154,7 @@ static oval_result_t _oval_result_test_result(struct oval_result_test *rtest, vo
 	struct oval_result_system *sys = oval_result_test_get_system(rtest);
 	struct oval_results_model *results_model = oval_result_system_get_results_model(sys);
 	struct oval_probe_session *probe_session = oval_results_model_get_probe_session(results_model);
-	if (probe_session != NULL) {
+	if (collect && probe_session != NULL) {
 		/* probe test */
 		int ret = oval_probe_query_test(probe_session, test);
 		if (ret != 0) {
@@ -1130,7 +1262,7 @@ static void _oval_result_test_initialize_bindings(struct oval_result_test *rslt_
 	rslt_test->bindings_initialized = true;
 }
 
-oval_result_t oval_result_test_eval(struct oval_result_test *rtest)
+static oval_result_t _oval_result_test_eval(struct oval_result_test *rtest, bool collect)
 {
 	__attribute__nonnull__(rtest);
 
@@ -1145,9 +1277,12 @@ oval_result_t oval_result_test_eval(struct oval_result_test *rtest)
 			struct oval_string_map *tmp_map = oval_string_map_new();
 			void *args[] = { rtest->system, rtest, tmp_map };
 			dIndent(1);
-			rtest->result = _oval_result_test_result(rtest, args);
+			rtest->result = _oval_result_test_result(rtest, args, collect);
 			dIndent(-1);
 			oval_string_map_free(tmp_map, NULL);
+			/* Prepared tests are masked by oval_result_system_eval_tests() */
+			if (collect)
+				oval_result_test_mask_items(rtest);
 
 			if (!rtest->bindings_initialized) {
 				_oval_result_test_initialize_bindings(rtest);
@@ -1162,6 +1297,64 @@ oval_result_t oval_result_test_eval(struct oval_result_test *rtest)
 	return rtest->result;
 }
 
+oval_result_t oval_result_test_eval(struct oval_result_test *rtest)
+{
+	return _oval_result_test_eval(rtest, true);
+}
+
+int oval_result_test_prepare(struct oval_result_test *rtest)
+{
+	__attribute__nonnull__(rtest);
+
+	struct oval_test *test = oval_result_test_get_test(rtest);
+	if (rtest->result != OVAL_RESULT_NOT_EVALUATED || oval_test_get_subtype(test) == OVAL_INDEPENDENT_UNKNOWN)
+		return 0;
+
+#if defined(OVAL_PROBES_ENABLED)
+	struct oval_results_model *results_model = oval_result_system_get_results_model(rtest->system);
+	struct oval_probe_session *probe_session = oval_results_model_get_probe_session(results_model);
+	if (probe_session != NULL) {
+		int ret = oval_probe_query_test(probe_session, test);
+		if (ret != 0)
+			return ret;
+	}
+#endif
+
+	/* Compile the states and compute the variables they reference */
+	struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(rtest->system);
+	struct oval_state_iterator *ste_itr = oval_test_get_states(test);
+	while (oval_state_iterator_has_more(ste_itr)) {
+		struct oval_state *ste = oval_state_iterator_next(ste_itr);
+		struct oval_state_matcher *matcher = oval_result_system_get_state_matcher(rtest->system, ste);
+		_compute_state_variables(matcher, syschar_model);
+	}
+	oval_state_iterator_free(ste_itr);
+
+	return 0;
+}
+
+oval_result_t oval_result_test_eval_prepared(struct oval_result_test *rtest)
+{
+	return _oval_result_test_eval(rtest, false);
+}
+
+size_t oval_result_test_get_collected_items_count(struct oval_result_test *rtest)
+{
+	__attribute__nonnull__(rtest);
+
+	struct oval_object *object = oval_test_get_object(rtest->test);
+	if (object == NULL)
+		return 0;
+	struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(rtest->system);
+	struct oval_syschar *syschar = oval_syschar_model_get_syschar(syschar_model, oval_object_get_id(object));
+	if (syschar == NULL)
+		return 0;
+	struct oval_sysitem_iterator *items = oval_syschar_get_sysitem(syschar);
+	size_t count = oval_collection_iterator_remaining((struct oval_iterator *) items);
+	oval_sysitem_iterator_free(items);
+	return count;
+}
+
 oval_result_t oval_result_test_get_result(struct oval_result_test * rtest)
 {
 	__attribute__nonnull__(rtest);
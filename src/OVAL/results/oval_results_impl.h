@@ -39,6 +39,7 @@
 
 #include "common/list.h"
 #include "common/util.h"
+#include "common/oscap_arena.h"
 #include "source/oscap_source_priv.h"
 
 
@@ -58,9 +59,31 @@ void oval_result_definition_set_variable_instance_hint(struct oval_result_defini
 struct oval_result_test *make_result_test_from_oval_test(struct oval_result_system *system, struct oval_test *oval_test, int variable_instance);
 
 int oval_result_test_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, void *);
+/*
+ * Collect the object of the test and compute the variables referenced by its
+ * states, so that oval_result_test_eval_prepared() only reads shared data and
+ * can be called for different tests at the same time.
+ * @returns 0 on success, the test has to be evaluated by oval_result_test_eval() otherwise
+ */
+int oval_result_test_prepare(struct oval_result_test *);
+oval_result_t oval_result_test_eval_prepared(struct oval_result_test *);
+/*
+ * Copy the mask attribute of the state entities to the entities of the compared
+ * items. Items are shared by tests, this is done after the parallel evaluation.
+ */
+void oval_result_test_mask_items(struct oval_result_test *);
+
+/* Tests with at least this many collected items compare them in parallel */
+#define OVAL_PARALLEL_ITEMS_MIN 4096
+size_t oval_result_test_get_collected_items_count(struct oval_result_test *);
 xmlNode *oval_result_test_to_dom(struct oval_result_test *, xmlDocPtr, xmlNode *);
 
 
+/*
+ * Create a result item owned by the arena, oval_result_item_free()
+ * releases only its messages.
+ */
+struct oval_result_item *oval_result_item_new_arena(struct oval_result_system *, char *item_id, struct oscap_arena *);
 int oval_result_item_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, struct oval_result_system *, oscap_consumer_func, void *);
 xmlNode *oval_result_item_to_dom(struct oval_result_item *, xmlDocPtr, xmlNode *);
 
@@ -79,6 +102,21 @@ struct oval_result_definition *oval_result_system_get_new_definition_with_check(
 
 struct oval_result_test *oval_result_system_get_test(struct oval_result_system *, char *);
 
+struct oval_state_matcher;
+/*
+ * Get the state compiled for evaluation, the matcher is owned by the result system.
+ * Matchers are created without locking, oval_result_test_prepare() creates them
+ * before tests are evaluated in parallel.
+ */
+struct oval_state_matcher *oval_result_system_get_state_matcher(struct oval_result_system *sys, struct oval_state *state);
+
+/*
+ * Evaluate tests of the definitions in parallel. Objects are collected in the
+ * calling thread first. The definitions can then be evaluated without
+ * further collection.
+ */
+void oval_result_system_eval_tests(struct oval_result_system *sys, struct oval_result_definition **definitions, size_t count);
+
 struct oresults {
 	int true_cnt;
 	int false_cnt;
@@ -92,11 +130,21 @@ int ores_add_res(struct oresults *ores, oval_result_t res);
 void ores_clear(struct oresults *ores);
 oval_result_t ores_get_result_bychk(struct oresults *ores, oval_check_t check);
 oval_result_t ores_get_result_byopr(struct oresults *ores, oval_operator_t op);
+/*
+ * Check whether more results can't change the result of the operator.
+ */
+bool ores_is_decided_byopr(struct oresults *ores, oval_operator_t op);
 
 #if defined(OVAL_PROBES_ENABLED)
 struct oval_results_model *oval_results_model_new_with_probe_session(struct oval_definition_model *definition_model, struct oval_syschar_model **syschar_models, struct oval_probe_session *probe_session);
 #endif
 struct oval_probe_session *oval_results_model_get_probe_session(struct oval_results_model *model);
+/*
+ * Short-circuit evaluation skips criteria once the result of their parent
+ * criteria is decided, objects of the skipped tests are not collected.
+ * Enabled by OSCAP_OVAL_SHORT_CIRCUIT=1.
+ */
+bool oval_results_model_get_short_circuit(struct oval_results_model *model);
 void oval_results_model_add_system(struct oval_results_model *, struct oval_result_system *);
 
 struct oval_result_definition_iterator *oval_result_definition_iterator_new(struct oval_smc *mapping);
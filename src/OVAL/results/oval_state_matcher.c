@@ -0,0 +1,228 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "oval_definitions_impl.h"
+#include "oval_system_characteristics_impl.h"
+#include "results/oval_results_impl.h"
+#include "oval_state_matcher.h"
+#include "common/debug_priv.h"
+#include "common/_error.h"
+
+static void _oval_entity_matcher_init(struct oval_entity_matcher *em, struct oval_state *state, struct oval_state_content *content, struct oval_entity *entity)
+{
+	em->content = content;
+	em->name = oval_entity_get_name(entity);
+
+	if (oscap_streq(em->name, "line") &&
+		oval_state_get_subtype(state) == (oval_subtype_t) OVAL_INDEPENDENT_TEXT_FILE_CONTENT) {
+		/* Hack: textfilecontent_state/line shall be compared against textfilecontent_item/text.
+		 *
+		 * textfilecontent_test and textfilecontent54_test share the same syschar
+		 * (textfilecontent_item). In OVAL 5.3 and below this syschar did not hold any usable
+		 * information ('text' ent). In OVAL 5.4 textfilecontent_test was deprecated. But the
+		 * 'text' ent has been added to textfilecontent_item, making it potentially usable. */
+		oval_schema_version_t over = oval_state_get_platform_schema_version(state);
+		if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.4)) >= 0) {
+			/* The OVAL-5.3 does not have textfilecontent_item/text */
+			em->name = "text";
+		}
+	}
+
+	em->entity_check = oval_state_content_get_ent_check(content);
+	em->var_check = oval_state_content_get_var_check(content);
+	em->check_existence = oval_state_content_get_check_existence(content);
+	em->operation = oval_entity_get_operation(entity);
+	em->mask = oval_entity_get_mask(entity);
+
+	if (oval_entity_get_varref_type(entity) == OVAL_ENTITY_VARREF_ATTRIBUTE) {
+		em->variable = oval_entity_get_variable(entity);
+		if (em->variable == NULL)
+			em->value_error = "OVAL internal error: found NULL variable";
+	} else if (oval_entity_get_datatype(entity) == OVAL_DATATYPE_RECORD) {
+		em->record = true;
+	} else {
+		struct oval_value *value = oval_entity_get_value(entity);
+		char *text;
+		if (value == NULL) {
+			em->value_error = "OVAL internal error: found NULL entity value";
+		} else if ((text = oval_value_get_text(value)) == NULL) {
+			em->value_error = "OVAL internal error: found NULL entity value text";
+		} else {
+			oval_operand_init(&em->operand, text, oval_value_get_datatype(value), em->operation);
+		}
+	}
+}
+
+struct oval_state_matcher *oval_state_matcher_new(struct oval_state *state)
+{
+	struct oval_state_matcher *matcher = calloc(1, sizeof(struct oval_state_matcher));
+	matcher->state = state;
+	matcher->operator = oval_state_get_operator(state);
+
+	size_t alloc = 0;
+	struct oval_state_content_iterator *contents = oval_state_get_contents(state);
+	while (oval_state_content_iterator_has_more(contents)) {
+		struct oval_state_content *content;
+		struct oval_entity *entity;
+
+		if ((content = oval_state_content_iterator_next(contents)) == NULL) {
+			matcher->error = "OVAL internal error: found NULL state content";
+			break;
+		}
+		if ((entity = oval_state_content_get_entity(content)) == NULL) {
+			matcher->error = "OVAL internal error: found NULL entity";
+			break;
+		}
+		if (oval_entity_get_name(entity) == NULL) {
+			matcher->error = "OVAL internal error: found NULL entity name";
+			break;
+		}
+
+		if (matcher->count == alloc) {
+			alloc = alloc ? alloc * 2 : 4;
+			matcher->entities = realloc(matcher->entities, alloc * sizeof(struct oval_entity_matcher));
+		}
+		struct oval_entity_matcher *em = &matcher->entities[matcher->count++];
+		memset(em, 0, sizeof(*em));
+		_oval_entity_matcher_init(em, state, content, entity);
+	}
+	oval_state_content_iterator_free(contents);
+
+	return matcher;
+}
+
+void oval_state_matcher_intern_names(struct oval_state_matcher *matcher, struct oval_syschar_model *model)
+{
+	for (size_t i = 0; i < matcher->count; i++)
+		matcher->entities[i].name = oval_syschar_model_intern(model, matcher->entities[i].name);
+	matcher->names_model = model;
+}
+
+void oval_state_matcher_free(struct oval_state_matcher *matcher)
+{
+	if (matcher == NULL)
+		return;
+	for (size_t i = 0; i < matcher->count; i++)
+		oval_operand_clear(&matcher->entities[i].operand);
+	free(matcher->entities);
+	free(matcher);
+}
+
+struct oval_variable_operands *oval_variable_operands_new(const struct oval_state_matcher *matcher)
+{
+	return calloc(matcher->count ? matcher->count : 1, sizeof(struct oval_variable_operands));
+}
+
+void oval_variable_operands_free(struct oval_variable_operands *operands, const struct oval_state_matcher *matcher)
+{
+	if (operands == NULL)
+		return;
+	for (size_t i = 0; i < matcher->count; i++) {
+		for (size_t j = 0; j < operands[i].count; j++)
+			oval_operand_clear(&operands[i].operands[j]);
+		free(operands[i].operands);
+	}
+	free(operands);
+}
+
+static void _oval_variable_operands_bind(struct oval_variable_operands *vo, const struct oval_entity_matcher *em, struct oval_syschar_model *syschar_model)
+{
+	vo->bound = true;
+
+	if (0 != oval_syschar_model_compute_variable(syschar_model, em->variable)) {
+		vo->status = -1;
+		return;
+	}
+
+	switch (oval_variable_get_collection_flag(em->variable)) {
+	case SYSCHAR_FLAG_COMPLETE:
+	case SYSCHAR_FLAG_INCOMPLETE:{
+		size_t alloc = 0;
+		struct oval_value_iterator *val_itr = oval_variable_get_values(em->variable);
+		while (oval_value_iterator_has_more(val_itr)) {
+			struct oval_value *var_val = oval_value_iterator_next(val_itr);
+			char *text = oval_value_get_text(var_val);
+			if (text == NULL) {
+				vo->null_text = true;
+				break;
+			}
+			if (vo->count == alloc) {
+				alloc = alloc ? alloc * 2 : 4;
+				vo->operands = realloc(vo->operands, alloc * sizeof(struct oval_operand));
+			}
+			oval_operand_init(&vo->operands[vo->count++], text, oval_value_get_datatype(var_val), em->operation);
+		}
+		oval_value_iterator_free(val_itr);
+		} break;
+	case SYSCHAR_FLAG_ERROR:
+	case SYSCHAR_FLAG_DOES_NOT_EXIST:
+	case SYSCHAR_FLAG_NOT_COLLECTED:
+	case SYSCHAR_FLAG_NOT_APPLICABLE:
+		vo->status = 1;
+		break;
+	default:
+		vo->status = -1;
+	}
+}
+
+void oval_variable_operands_bind(struct oval_variable_operands *operands, const struct oval_state_matcher *matcher,
+		struct oval_syschar_model *syschar_model)
+{
+	for (size_t i = 0; i < matcher->count; i++) {
+		const struct oval_entity_matcher *em = &matcher->entities[i];
+		if (em->variable != NULL && !operands[i].bound)
+			_oval_variable_operands_bind(&operands[i], em, syschar_model);
+	}
+}
+
+oval_result_t oval_variable_operands_cmp(struct oval_variable_operands *vo, const struct oval_entity_matcher *em,
+		struct oval_syschar_model *syschar_model, const char *sys_data)
+{
+	if (!vo->bound)
+		_oval_variable_operands_bind(vo, em, syschar_model);
+	if (vo->status == -1)
+		return -1;
+	if (vo->status == 1)
+		return OVAL_RESULT_ERROR;
+
+	struct oresults var_ores;
+	ores_clear(&var_ores);
+	for (size_t i = 0; i < vo->count; i++) {
+		oval_result_t var_val_res = oval_operand_cmp(&vo->operands[i], sys_data);
+		if (var_val_res == OVAL_RESULT_ERROR) {
+			dE("Error occured when comparing a variable '%s' value '%s' with collected item entity = '%s'",
+				oval_variable_get_id(em->variable), vo->operands[i].text, sys_data);
+		}
+		ores_add_res(&var_ores, var_val_res);
+	}
+	if (vo->null_text) {
+		dE("Found NULL variable value text.");
+		ores_add_res(&var_ores, OVAL_RESULT_ERROR);
+	}
+
+	return ores_get_result_bychk(&var_ores, em->var_check);
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef OSCAP_OVAL_STATE_MATCHER_H_
+#define OSCAP_OVAL_STATE_MATCHER_H_
+
+#include "../common/util.h"
+#include "oval_definitions.h"
+#include "oval_types.h"
+#include "oval_system_characteristics.h"
+#include "oval_cmp_impl.h"
+
+/*
+ * State matcher is an oval_state compiled for evaluation of many items.
+ * Everything which does not depend on the item is looked up once: names
+ * of entities, operations, checks and the values converted to oval_operand.
+ * Values of var_ref entities depend on the variable instance, they are
+ * compiled per test evaluation into oval_variable_operands.
+ */
+
+/*
+ * Compiled state entity.
+ */
+struct oval_entity_matcher {
+	struct oval_state_content *content;
+	const char *name;                       ///< Name of the item entity to compare with
+	oval_operation_t operation;
+	oval_check_t entity_check;
+	oval_check_t var_check;
+	oval_existence_t check_existence;
+	bool mask;
+	bool record;                            ///< Record datatype, compared field by field
+	struct oval_variable *variable;         ///< Referenced variable, NULL for a constant value
+	const char *value_error;                ///< Internal error reported when the entity is compared
+	struct oval_operand operand;            ///< Constant value
+};
+
+struct oval_state_matcher {
+	struct oval_state *state;
+	oval_operator_t operator;
+	const char *error;                      ///< Internal error reported for every item
+	struct oval_syschar_model *names_model; ///< Model with interned entity names, NULL if not interned
+	size_t count;
+	struct oval_entity_matcher *entities;
+};
+
+/*
+ * Values of the variable referenced by a state entity, compiled on the first comparison.
+ */
+struct oval_variable_operands {
+	bool bound;
+	int status;                             ///< -1 computation failed, 1 variable has no usable values
+	bool null_text;                         ///< A value without text follows the compiled ones
+	size_t count;
+	struct oval_operand *operands;
+};
+
+struct oval_state_matcher *oval_state_matcher_new(struct oval_state *state);
+void oval_state_matcher_free(struct oval_state_matcher *matcher);
+
+/*
+ * Intern the entity names in the string pool of the syschar model, so that
+ * they can be compared by pointer with names of the items of the model.
+ */
+void oval_state_matcher_intern_names(struct oval_state_matcher *matcher, struct oval_syschar_model *model);
+
+/*
+ * Allocate per-evaluation variable operands for each entity of the matcher.
+ */
+struct oval_variable_operands *oval_variable_operands_new(const struct oval_state_matcher *matcher);
+void oval_variable_operands_free(struct oval_variable_operands *operands, const struct oval_state_matcher *matcher);
+
+/*
+ * Compile the values of all referenced variables now instead of on the first
+ * comparison. Bound operands can be shared by threads comparing items.
+ */
+void oval_variable_operands_bind(struct oval_variable_operands *operands, const struct oval_state_matcher *matcher,
+		struct oval_syschar_model *syschar_model);
+
+/*
+ * Compare collected value with the variable referenced by the entity.
+ * @returns result of the comparison, -1 on internal error
+ */
+oval_result_t oval_variable_operands_cmp(struct oval_variable_operands *operands, const struct oval_entity_matcher *entity,
+		struct oval_syschar_model *syschar_model, const char *sys_data);
+
+#endif
@@ -224,6 +224,43 @@ OSCAP_API void sce_parameters_set_session(struct sce_parameters* v, struct sce_s
  */
 OSCAP_API struct sce_session* sce_parameters_get_session(struct sce_parameters* v);
 
+/**
+ * Sets how many scripts may run at the same time. Scripts of the following
+ * rules are started ahead of time, results are still reported in the order
+ * of rules. Defaults to the value of OSCAP_MAX_THREADS environment variable
+ * or to the number of online CPUs.
+ *
+ * @memberof sce_parameters
+ */
+OSCAP_API void sce_parameters_set_max_jobs(struct sce_parameters* v, unsigned int max_jobs);
+
+/**
+ * Sets the time limit in seconds after which a script is killed and its
+ * result is error. 0 means no limit, which is the default unless
+ * OSCAP_SCE_TIMEOUT environment variable is set.
+ *
+ * @memberof sce_parameters
+ */
+OSCAP_API void sce_parameters_set_timeout(struct sce_parameters* v, unsigned int seconds);
+
+/**
+ * Sets the CPU time limit (RLIMIT_CPU) of scripts in seconds. 0 means
+ * no limit, which is the default unless OSCAP_SCE_CPU_LIMIT environment
+ * variable is set.
+ *
+ * @memberof sce_parameters
+ */
+OSCAP_API void sce_parameters_set_cpu_limit(struct sce_parameters* v, unsigned int seconds);
+
+/**
+ * Sets the address space limit (RLIMIT_AS) of scripts in bytes. 0 means
+ * no limit, which is the default unless OSCAP_SCE_MEMORY_LIMIT environment
+ * variable (in MiB) is set.
+ *
+ * @memberof sce_parameters
+ */
+OSCAP_API void sce_parameters_set_memory_limit(struct sce_parameters* v, size_t bytes);
+
 /**
  * Just a convenience shortcut of setting a session to a newly allocated session
  *
@@ -35,9 +35,12 @@
 #include "common/oscap_acquire.h"
 #include "common/oscap_string.h"
 #include "common/debug_priv.h"
+#include "common/oscap_parallel.h"
 #include "sce_engine_api.h"
+#include "sce_executor_priv.h"
 #include "oscap_helpers.h"
 
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -273,13 +276,35 @@ struct sce_parameters
 {
 	char* xccdf_directory;
 	struct sce_session* session;
+	struct sce_limits limits;
+	struct sce_executor* executor;
 };
 
+static unsigned long _sce_limit_from_env(const char *name)
+{
+	const char *env = getenv(name);
+	if (env == NULL || *env == '\0')
+		return 0;
+	char *end = NULL;
+	errno = 0;
+	unsigned long value = strtoul(env, &end, 10);
+	if (errno != 0 || *end != '\0') {
+		dW("Ignoring invalid value of %s: '%s'", name, env);
+		return 0;
+	}
+	return value;
+}
+
 struct sce_parameters* sce_parameters_new(void)
 {
 	struct sce_parameters *ret = malloc(sizeof(struct sce_parameters));
 	ret->xccdf_directory = NULL;
 	ret->session = NULL;
+	ret->executor = NULL;
+	ret->limits.max_jobs = oscap_parallel_get_max_threads();
+	ret->limits.timeout = _sce_limit_from_env("OSCAP_SCE_TIMEOUT");
+	ret->limits.cpu_time = _sce_limit_from_env("OSCAP_SCE_CPU_LIMIT");
+	ret->limits.memory = (size_t) _sce_limit_from_env("OSCAP_SCE_MEMORY_LIMIT") * 1024 * 1024;
 
 	return ret;
 }
@@ -291,6 +316,7 @@ void sce_parameters_free(struct sce_parameters* v)
 
 	free(v->xccdf_directory);
 	sce_session_free(v->session);
+	sce_executor_free(v->executor);
 
 	free(v);
 }
@@ -324,119 +350,115 @@ void sce_parameters_allocate_session(struct sce_parameters* v)
 	sce_parameters_set_session(v, sce_session_new());
 }
 
-static void _pipe_try_read_into_string(int fd, struct oscap_string *string, bool *eof)
+void sce_parameters_set_max_jobs(struct sce_parameters* v, unsigned int max_jobs)
 {
-	// FIXME: Read by larger chunks in the future
-	char readbuf;
-	while (true) {
-		const int read_status = read(fd, &readbuf, 1);
-		if (read_status == 1) {  // successful read
-			if (readbuf == '&') {
-				// & is a special case, we have to "escape" it manually
-				// (all else will eventually get handled by libxml)
-				oscap_string_append_string(string, "&amp;");
-			} else {
-				oscap_string_append_char(string, readbuf);
-			}
-		}
-		else if (read_status == 0) {  // EOF
-			*eof = true;
-			break;
-		}
-		else {
-			if (errno == EAGAIN) {
-				// NOOP, we are waiting for more input
-				break;
-			}
-			else {
-				*eof = true;  // signal EOF to exit the loops
-				break;
-			}
-		}
-	}
+	v->limits.max_jobs = max_jobs > 0 ? max_jobs : 1;
+	// the limits are copied to the executor when it is created
+	sce_executor_free(v->executor);
+	v->executor = NULL;
 }
 
-
-static void free_env_values(char **env_values, size_t index_of_first_env_value_not_compiled_in, size_t real_env_values_count) {
-	for (size_t i = index_of_first_env_value_not_compiled_in; i < real_env_values_count; i++) {
-		free(env_values[i]);
-	}
-	free(env_values);
+void sce_parameters_set_timeout(struct sce_parameters* v, unsigned int seconds)
+{
+	v->limits.timeout = seconds;
+	sce_executor_free(v->executor);
+	v->executor = NULL;
 }
 
-
-xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const char *rule_id, const char *id, const char *href,
-		struct xccdf_value_binding_iterator *value_binding_it,
-		struct xccdf_check_import_iterator *check_import_it,
-		void *usr)
+void sce_parameters_set_cpu_limit(struct sce_parameters* v, unsigned int seconds)
 {
-	struct sce_parameters* parameters = (struct sce_parameters*)usr;
-	const char* xccdf_directory = parameters->xccdf_directory;
-	bool use_sce_wrapper = false; // use osca-run-sce-script ?
+	v->limits.cpu_time = seconds;
+	sce_executor_free(v->executor);
+	v->executor = NULL;
+}
 
-	char* tmp_href = oscap_sprintf("%s/%s", xccdf_directory, href);
+void sce_parameters_set_memory_limit(struct sce_parameters* v, size_t bytes)
+{
+	v->limits.memory = bytes;
+	sce_executor_free(v->executor);
+	v->executor = NULL;
+}
 
-	if (access(tmp_href, F_OK))
+static const char *_sce_operator_str(xccdf_operator_t operator)
+{
+	switch (operator)
 	{
-		// we only do this check to provide helpful error message
-		// there is an inherent race condition, the file might
-		// not exist anymore at the time we execve it!
-
-		// the script hasn't been found, perhaps another sce instance
-		// with a different XCCDF directory can find it?
-		oscap_seterr(OSCAP_EFAMILY_SCE, "SCE couldn't find script file '%s'. "
-				"Expected location: '%s'.", href, tmp_href);
-		free(tmp_href);
-		return XCCDF_RESULT_NOT_CHECKED;
+	case XCCDF_OPERATOR_EQUALS:
+		return "EQUALS";
+	case XCCDF_OPERATOR_NOT_EQUAL:
+		return "NOT_EQUAL";
+	case XCCDF_OPERATOR_GREATER:
+		return "GREATER";
+	case XCCDF_OPERATOR_GREATER_EQUAL:
+		return "GREATER_EQUAL";
+	case XCCDF_OPERATOR_LESS:
+		return "LESS";
+	case XCCDF_OPERATOR_LESS_EQUAL:
+		return "LESS_EQUAL";
+	case XCCDF_OPERATOR_PATTERN_MATCH:
+		return "PATTERN_MATCH";
+	default:
+		assert(0);
+		return NULL;
 	}
+}
 
-	if (access(tmp_href, F_OK | X_OK))
+static const char *_sce_type_str(xccdf_value_type_t type)
+{
+	switch (type)
 	{
-		// use the sce wrapper if it's not possible to acquire +x rights
-		use_sce_wrapper = true;
-		dI("%s isn't executable, oscap-run-sce-script will be used.", tmp_href);
+	case XCCDF_TYPE_BOOLEAN:
+		return "BOOLEAN";
+	case XCCDF_TYPE_NUMBER:
+		return "NUMBER";
+	case XCCDF_TYPE_STRING:
+		return "STRING";
+	default:
+		assert(0);
+		return NULL;
 	}
+}
 
-	// all the result codes are shifted by 100, because otherwise syntax errors in scripts
-	// or even their nonexistence would cause XCCDF_RESULT_PASS to be the result
-
-	char* argvp[3] = {
-		tmp_href,
-		tmp_href, // the second tmp_href is added in case we use the wrapper (oscap-run-sce-script)
-		NULL      // which need the path of the script to eval as first parameter.
+/*
+ * Bound values in KEY=VALUE form, ready to be passed as environment variables.
+ * Returns NULL terminated array of allocated strings.
+ */
+static char **_sce_env_new(struct xccdf_value_binding_iterator *value_binding_it)
+{
+	static const char *compiled_in[] = {
+		"PATH=/bin:/sbin:/usr/bin:/usr/local/bin:/usr/sbin",
+		"XCCDF_RESULT_PASS=101",
+		"XCCDF_RESULT_FAIL=102",
+		"XCCDF_RESULT_ERROR=103",
+		"XCCDF_RESULT_UNKNOWN=104",
+		"XCCDF_RESULT_NOT_APPLICABLE=105",
+		"XCCDF_RESULT_NOT_CHECKED=106",
+		"XCCDF_RESULT_NOT_SELECTED=107",
+		"XCCDF_RESULT_INFORMATIONAL=108",
+		"XCCDF_RESULT_FIXED=109",
 	};
+	const size_t compiled_in_count = sizeof(compiled_in) / sizeof(compiled_in[0]);
 
-	// bound values in KEY=VALUE form, ready to be passed as environment variables
-	char ** env_values = malloc(10 * sizeof(char * ));
-	size_t env_value_count = 10;
-	const size_t index_of_first_env_value_not_compiled_in = 10;
-
-	env_values[0] = "PATH=/bin:/sbin:/usr/bin:/usr/local/bin:/usr/sbin";
+	size_t env_value_count = 0;
+	char **env_values = malloc((compiled_in_count + 1) * sizeof(char *));
+	for (; env_value_count < compiled_in_count; env_value_count++)
+		env_values[env_value_count] = oscap_strdup(compiled_in[env_value_count]);
 
-	env_values[1] = "XCCDF_RESULT_PASS=101";
-	env_values[2] = "XCCDF_RESULT_FAIL=102";
-	env_values[3] = "XCCDF_RESULT_ERROR=103";
-	env_values[4] = "XCCDF_RESULT_UNKNOWN=104";
-	env_values[5] = "XCCDF_RESULT_NOT_APPLICABLE=105";
-	env_values[6] = "XCCDF_RESULT_NOT_CHECKED=106";
-	env_values[7] = "XCCDF_RESULT_NOT_SELECTED=107";
-	env_values[8] = "XCCDF_RESULT_INFORMATIONAL=108";
-	env_values[9] = "XCCDF_RESULT_FIXED=109";
-
-	while (xccdf_value_binding_iterator_has_more(value_binding_it))
+	while (value_binding_it != NULL && xccdf_value_binding_iterator_has_more(value_binding_it))
 	{
 		struct xccdf_value_binding* binding = xccdf_value_binding_iterator_next(value_binding_it);
 
-		void *new_env_values = realloc(env_values, (env_value_count + 3) * sizeof(char *));
+		void *new_env_values = realloc(env_values, (env_value_count + 3 + 1) * sizeof(char *));
 		if (new_env_values == NULL) {
 			dE("Unable to re-allocate memory");
-			free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-			return XCCDF_RESULT_ERROR;
+			for (size_t i = 0; i < env_value_count; i++)
+				free(env_values[i]);
+			free(env_values);
+			return NULL;
 		}
 		env_values = new_env_values;
 
 		char* name = xccdf_value_binding_get_name(binding);
-		xccdf_value_type_t type = xccdf_value_binding_get_type(binding);
 		char* value = xccdf_value_binding_get_setvalue(binding);
 		if (value == NULL)
 		{
@@ -445,287 +467,208 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 				value = "";
 			}
 		}
-		xccdf_operator_t operator = xccdf_value_binding_get_operator(binding);
-
-		char* type_str;
-		switch (type)
-		{
-		case XCCDF_TYPE_BOOLEAN:
-			type_str = "BOOLEAN";
-			break;
-		case XCCDF_TYPE_NUMBER:
-			type_str = "NUMBER";
-			break;
-		case XCCDF_TYPE_STRING:
-			type_str = "STRING";
-			break;
-		default:
-			assert(0);
-			type_str = NULL;
-			break;
-		}
-
-		char* env_type_entry = oscap_sprintf("XCCDF_TYPE_%s=%s", name, type_str);
-		char* env_value_entry = oscap_sprintf("XCCDF_VALUE_%s=%s", name, value);
-
-		char* operator_str;
-		switch (operator)
-		{
-		case XCCDF_OPERATOR_EQUALS:
-			operator_str = "EQUALS";
-			break;
-		case XCCDF_OPERATOR_NOT_EQUAL:
-			operator_str = "NOT_EQUAL";
-			break;
-		case XCCDF_OPERATOR_GREATER:
-			operator_str = "GREATER";
-			break;
-		case XCCDF_OPERATOR_GREATER_EQUAL:
-			operator_str = "GREATER_EQUAL";
-			break;
-		case XCCDF_OPERATOR_LESS:
-			operator_str = "LESS";
-			break;
-		case XCCDF_OPERATOR_LESS_EQUAL:
-			operator_str = "LESS_EQUAL";
-			break;
-		case XCCDF_OPERATOR_PATTERN_MATCH:
-			operator_str = "PATTERN_MATCH";
-			break;
-		default:
-			assert(0);
-			operator_str = NULL;
-			break;
-		}
-
-		char* env_operator_entry = oscap_sprintf("XCCDF_OPERATOR_%s=%s", name, operator_str);
-
-		env_values[env_value_count] = env_type_entry;
-		env_value_count++;
-		env_values[env_value_count] = env_value_entry;
-		env_value_count++;
-		env_values[env_value_count] = env_operator_entry;
-		env_value_count++;
-	}
 
-	void *new_env_values = realloc(env_values, (env_value_count + 1) * sizeof(char*));
-	if (new_env_values == NULL) {
-		dE("Unable to re-allocate memory");
-		free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-		return XCCDF_RESULT_ERROR;
+		env_values[env_value_count++] = oscap_sprintf("XCCDF_TYPE_%s=%s", name,
+				_sce_type_str(xccdf_value_binding_get_type(binding)));
+		env_values[env_value_count++] = oscap_sprintf("XCCDF_VALUE_%s=%s", name, value);
+		env_values[env_value_count++] = oscap_sprintf("XCCDF_OPERATOR_%s=%s", name,
+				_sce_operator_str(xccdf_value_binding_get_operator(binding)));
 	}
-	env_values = new_env_values;
 	env_values[env_value_count] = NULL;
+	return env_values;
+}
 
-	// We open a pipe for communication with the forked process
-	int stdout_pipefd[2];
-	int stderr_pipefd[2];
-	if (pipe(stdout_pipefd) == -1 || pipe(stderr_pipefd) == -1)
-	{
-		dE("Error in pipe");
-		free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-		return XCCDF_RESULT_ERROR;
-	}
-
-	// FIXME: We definitely want to impose security restrictions in the forked child process in the future.
-	//        This would prevent scripts from writing to files or deleting them.
+/*
+ * Path of the script, NULL if the script doesn't exist.
+ */
+static char *_sce_script_path(struct sce_parameters *parameters, const char *href, bool *use_sce_wrapper)
+{
+	char* tmp_href = oscap_sprintf("%s/%s", parameters->xccdf_directory, href);
 
-	int fork_result = fork();
-	if (fork_result >= 0)
+	if (access(tmp_href, F_OK))
 	{
-		// fork successful
-
-		if (fork_result == 0)
-		{
-			// we won't read from the pipes, so close the reading fd
-			close(stdout_pipefd[0]);
-			close(stderr_pipefd[0]);
-
-			// forward stdout and stderr to our custom opened pipes
-			dup2(stdout_pipefd[1], fileno(stdout));
-			dup2(stderr_pipefd[1], fileno(stderr));
-
-			// we duplicated the file descriptors twice, we can close the original
-			// ones now, stdout and stderr will be closed properly after the execved
-			// script/executable finishes
-			close(stdout_pipefd[1]);
-			close(stderr_pipefd[1]);
-
-			// before we execute the script, lets make sure we get SIGTERM when
-			// oscap is killed, crashes or otherwise terminates
-#if defined(PR_SET_PDEATHSIG)
-			// requires Linux 2.1.57 or later
-			prctl(PR_SET_PDEATHSIG, SIGTERM);
-#elif defined(OS_FREEBSD)
-			int sig = SIGTERM;
-			procctl(P_PID, getpid(), PROC_PDEATHSIG_CTL, &sig);
-#else
-			// TODO: Please provide alternatives
-#endif
-
-			// we are the child process
-			if(use_sce_wrapper) {
-#if defined(OS_FREEBSD)
-				size_t k;
+		// we only do this check to provide helpful error message
+		// there is an inherent race condition, the file might
+		// not exist anymore at the time we execve it!
+		free(tmp_href);
+		return NULL;
+	}
 
-				// Setup environment beforehand as FreeBSD does not have execvpe()
-				for (k = 0; k < env_value_count; k++) {
-					putenv(env_values[k]);
-				}
+	// use the sce wrapper if it's not possible to acquire +x rights
+	*use_sce_wrapper = access(tmp_href, F_OK | X_OK) != 0;
+	return tmp_href;
+}
 
-				execvp("oscap-run-sce-script", argvp);
-#else
-				execvpe("oscap-run-sce-script", argvp, env_values);
-#endif
-			} else {
-				execve(tmp_href, argvp, env_values);
-			}
+static struct sce_executor *_sce_parameters_get_executor(struct sce_parameters *parameters)
+{
+	if (parameters->executor == NULL) {
+		parameters->executor = sce_executor_new(&parameters->limits);
+		if (parameters->executor == NULL)
+			dE("Unable to allocate the SCE executor");
+	}
+	return parameters->executor;
+}
 
-			free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
+static void _sce_env_free(char **env_values)
+{
+	for (size_t i = 0; env_values[i] != NULL; i++)
+		free(env_values[i]);
+	free(env_values);
+}
 
-			// no need to check the return value of execve, if it returned at all we are in trouble
-			printf("Unexpected error when executing script '%s'. Error message follows.\n", href);
-			perror("execve");
+static void sce_engine_prefetch_rule(struct xccdf_policy *policy, const char *id, const char *href,
+		struct xccdf_value_binding_iterator *value_binding_it, void *usr)
+{
+	struct sce_parameters *parameters = (struct sce_parameters *) usr;
+	if (href == NULL) {
+		// new evaluation, drop scripts which were not asked for
+		if (parameters->executor != NULL)
+			sce_executor_discard(parameters->executor);
+		return;
+	}
+	// running one script at a time is done by sce_engine_eval_rule alone
+	if (parameters->limits.max_jobs <= 1)
+		return;
 
-			// the parent process considers us a script check, we have to return a value that will mean XCCDF_RESULT_ERROR
-			exit(103);
-		}
+	bool use_sce_wrapper = false;
+	char *tmp_href = _sce_script_path(parameters, href, &use_sce_wrapper);
+	if (tmp_href == NULL)
+		return;
+	struct sce_executor *executor = _sce_parameters_get_executor(parameters);
+	char **env_values = executor != NULL ? _sce_env_new(value_binding_it) : NULL;
+	if (env_values != NULL) {
+		// the script is just not prefetched if the job can't be allocated
+		struct sce_job *job = sce_job_new(tmp_href, use_sce_wrapper, env_values);
+		if (job != NULL)
+			sce_executor_submit(executor, job);
 		else
-		{
-			// we won't write to the pipes, so close the writing fd
-			close(stdout_pipefd[1]);
-			close(stderr_pipefd[1]);
-
-			const int flag_stdout = fcntl(stdout_pipefd[0], F_GETFL, 0);
-			if (flag_stdout == -1) {
-				oscap_seterr(OSCAP_EFAMILY_SCE, "Failed to obtain status of stdout pipe: %s",
-						strerror(errno));
-				free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-				return XCCDF_RESULT_ERROR;
-			}
-			int retval = fcntl(stdout_pipefd[0], F_SETFL, flag_stdout | O_NONBLOCK);
-			if (retval == -1) {
-				oscap_seterr(OSCAP_EFAMILY_SCE,
-						"Failed to set nonblocking flag on stdout pipe: %s",
-						strerror(errno));
-				free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-				return XCCDF_RESULT_ERROR;
-			}
-
-			const int flag_stderr = fcntl(stderr_pipefd[0], F_GETFL, 0);
-			if (flag_stderr == -1) {
-				oscap_seterr(OSCAP_EFAMILY_SCE,
-						"Failed to obtain status of stderr pipe: %s",
-						strerror(errno));
-				free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-				return XCCDF_RESULT_ERROR;
-			}
-			retval = fcntl(stderr_pipefd[0], F_SETFL, flag_stderr | O_NONBLOCK);
-			if (retval == -1) {
-				oscap_seterr(OSCAP_EFAMILY_SCE,
-						"Failed to set nonblocking flag on stderr pipe: %s",
-						strerror(errno));
-				free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-				return XCCDF_RESULT_ERROR;
-			}
+			_sce_env_free(env_values);
+	}
+	free(tmp_href);
+}
 
-			// we have to read from both pipes at the same time to avoid stalling
-			struct oscap_string *stdout_string = oscap_string_new();
-			struct oscap_string *stderr_string = oscap_string_new();
+xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const char *rule_id, const char *id, const char *href,
+		struct xccdf_value_binding_iterator *value_binding_it,
+		struct xccdf_check_import_iterator *check_import_it,
+		void *usr)
+{
+	struct sce_parameters* parameters = (struct sce_parameters*)usr;
+	bool use_sce_wrapper = false; // use osca-run-sce-script ?
 
-			bool stdout_eof = false;
-			bool stderr_eof = false;
+	char *tmp_href = _sce_script_path(parameters, href, &use_sce_wrapper);
+	if (tmp_href == NULL)
+	{
+		// the script hasn't been found, perhaps another sce instance
+		// with a different XCCDF directory can find it?
+		oscap_seterr(OSCAP_EFAMILY_SCE, "SCE couldn't find script file '%s'. "
+				"Expected location: '%s/%s'.", href, parameters->xccdf_directory, href);
+		return XCCDF_RESULT_NOT_CHECKED;
+	}
+	if (use_sce_wrapper)
+		dI("%s isn't executable, oscap-run-sce-script will be used.", tmp_href);
 
-			while (!stdout_eof || !stderr_eof) {
-				if (!stdout_eof)
-					_pipe_try_read_into_string(stdout_pipefd[0], stdout_string, &stdout_eof);
+	// all the result codes are shifted by 100, because otherwise syntax errors in scripts
+	// or even their nonexistence would cause XCCDF_RESULT_PASS to be the result
 
-				if (!stderr_eof)
-					_pipe_try_read_into_string(stderr_pipefd[0], stderr_string, &stderr_eof);
+	char **env_values = _sce_env_new(value_binding_it);
+	if (env_values == NULL) {
+		free(tmp_href);
+		return XCCDF_RESULT_ERROR;
+	}
 
-				// sleep for 10ms to avoid wasting CPU
-				usleep(10 * 1000);
-			}
+	// the script might have been started ahead of time by sce_engine_prefetch_rule
+	struct sce_executor *executor = _sce_parameters_get_executor(parameters);
+	if (executor == NULL) {
+		_sce_env_free(env_values);
+		free(tmp_href);
+		return XCCDF_RESULT_ERROR;
+	}
+	struct sce_job *job = sce_executor_find(executor, tmp_href, env_values);
+	if (job != NULL) {
+		_sce_env_free(env_values);
+	} else {
+		job = sce_job_new(tmp_href, use_sce_wrapper, env_values);
+		if (job == NULL) {
+			dE("Unable to allocate the SCE job of '%s'", tmp_href);
+			_sce_env_free(env_values);
+			free(tmp_href);
+			return XCCDF_RESULT_ERROR;
+		}
+		sce_executor_submit(executor, job);
+	}
+	sce_executor_wait(executor, job);
 
-			close(stdout_pipefd[0]);
-			close(stderr_pipefd[0]);
+	const int exit_code = sce_job_get_exit_code(job);
+	if (exit_code == -1) {
+		// the script could not be started at all
+		sce_job_free(job);
+		free(tmp_href);
+		return XCCDF_RESULT_ERROR;
+	}
 
-			char *stdout_buffer = oscap_string_bequeath(stdout_string);
-			char *stderr_buffer = oscap_string_bequeath(stderr_string);
+	char *stdout_buffer = sce_job_take_stdout(job);
+	char *stderr_buffer = sce_job_take_stderr(job);
 
-			// we are the parent process
-			int wstatus;
-			waitpid(fork_result, &wstatus, 0);
+	// we subtract 100 here to shift the exit code to xccdf_test_result_type_t enum range
+	int raw_result = exit_code - 100;
+	if (raw_result <= 0 || raw_result > XCCDF_RESULT_FIXED || sce_job_timed_out(job))
+	{
+		// the script returned invalid exit code, we need to safeguard us against that
+		raw_result = XCCDF_RESULT_ERROR;
+	}
 
-			// we subtract 100 here to shift the exit code to xccdf_test_result_type_t enum range
-			int raw_result = WEXITSTATUS(wstatus) - 100;
-			if (raw_result <= 0 || raw_result > XCCDF_RESULT_FIXED)
-			{
-				// the script returned invalid exit code, we need to safeguard us against that
-				raw_result = XCCDF_RESULT_ERROR;
-			}
+	struct sce_session* session = sce_parameters_get_session(parameters);
+	if (session)
+	{
+		struct sce_check_result* check_result = sce_check_result_new();
+		sce_check_result_set_href(check_result, tmp_href);
+		char *base_name = oscap_basename(tmp_href);
+		sce_check_result_set_basename(check_result, base_name);
+		free(base_name);
+		sce_check_result_set_stdout(check_result, stdout_buffer);
+		sce_check_result_set_stderr(check_result, stderr_buffer);
+		sce_check_result_set_exit_code(check_result, exit_code);
+		sce_check_result_set_xccdf_result(check_result, (xccdf_test_result_type_t)raw_result);
+
+		char **env = sce_job_get_env(job);
+		for (size_t i = 0; env[i] != NULL; ++i)
+		{
+			sce_check_result_add_environment_variable(check_result, env[i]);
+		}
 
-			struct sce_session* session = sce_parameters_get_session(parameters);
-			if (session)
-			{
-				struct sce_check_result* check_result = sce_check_result_new();
-				sce_check_result_set_href(check_result, tmp_href);
-				char *base_name = oscap_basename(tmp_href);
-				sce_check_result_set_basename(check_result, base_name);
-				free(base_name);
-				sce_check_result_set_stdout(check_result, stdout_buffer);
-				sce_check_result_set_stderr(check_result, stderr_buffer);
-				sce_check_result_set_exit_code(check_result, WEXITSTATUS(wstatus));
-				sce_check_result_set_xccdf_result(check_result, (xccdf_test_result_type_t)raw_result);
-
-				for (size_t i = 0; i < env_value_count; ++i)
-				{
-					sce_check_result_add_environment_variable(check_result, env_values[i]);
-				}
-
-				sce_session_add_check_result(session, check_result);
-			}
+		sce_session_add_check_result(session, check_result);
+	}
 
-			free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-
-			// lets interpret the check imports passed to us
-			xccdf_check_import_iterator_reset(check_import_it);
-			while (xccdf_check_import_iterator_has_more(check_import_it))
-			{
-				struct xccdf_check_import * check_import = xccdf_check_import_iterator_next(check_import_it);
-				const char *name = xccdf_check_import_get_name(check_import);
-
-				if (strcmp(name, "stdout") == 0)
-				{
-					xccdf_check_import_set_content(check_import, stdout_buffer);
-				}
-				else if (strcmp(name, "stderr") == 0)
-				{
-					xccdf_check_import_set_content(check_import, stderr_buffer);
-				}
-			}
+	sce_job_free(job);
 
-			free(tmp_href);
-			free(stdout_buffer);
-			free(stderr_buffer);
+	// lets interpret the check imports passed to us
+	xccdf_check_import_iterator_reset(check_import_it);
+	while (xccdf_check_import_iterator_has_more(check_import_it))
+	{
+		struct xccdf_check_import * check_import = xccdf_check_import_iterator_next(check_import_it);
+		const char *name = xccdf_check_import_get_name(check_import);
 
-			return (xccdf_test_result_type_t)raw_result;
+		if (strcmp(name, "stdout") == 0)
+		{
+			xccdf_check_import_set_content(check_import, stdout_buffer);
+		}
+		else if (strcmp(name, "stderr") == 0)
+		{
+			xccdf_check_import_set_content(check_import, stderr_buffer);
 		}
 	}
-	else
-	{
-		free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
 
-		close(stdout_pipefd[0]);
-		close(stdout_pipefd[1]);
-		close(stderr_pipefd[0]);
-		close(stderr_pipefd[1]);
-		return XCCDF_RESULT_ERROR;
-	}
+	free(tmp_href);
+	free(stdout_buffer);
+	free(stderr_buffer);
+
+	return (xccdf_test_result_type_t)raw_result;
 }
 
 bool xccdf_policy_model_register_engine_sce(struct xccdf_policy_model * model, struct sce_parameters *parameters)
 {
 	return xccdf_policy_model_register_engine_and_query_callback(model,
-		"http://open-scap.org/page/SCE", sce_engine_eval_rule, (void*)parameters, NULL);
+		"http://open-scap.org/page/SCE", sce_engine_eval_rule, (void*)parameters, NULL) &&
+		xccdf_policy_model_register_engine_prefetch_callback(model,
+		"http://open-scap.org/page/SCE", sce_engine_prefetch_rule, (void*)parameters);
 }
@@ -0,0 +1,572 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "common/_error.h"
+#include "common/util.h"
+#include "common/oscap_string.h"
+#include "common/debug_priv.h"
+#include "sce_executor_priv.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#if defined(OS_FREEBSD)
+#include <sys/procctl.h>
+#include <sys/wait.h>
+#else
+#include <wait.h>
+#endif
+#if defined(OS_LINUX)
+#include <sys/prctl.h>
+#endif
+
+#define SCE_READ_CHUNK 4096
+// poll interval when a script closed its output but has not exited yet
+#define SCE_REAP_INTERVAL_MS 10
+// how long the output of a killed script is read, processes which escaped
+// its process group may keep the pipes open forever
+#define SCE_KILL_GRACE_MS 100
+
+typedef enum {
+	SCE_JOB_QUEUED,
+	SCE_JOB_RUNNING,
+	SCE_JOB_DONE
+} sce_job_state_t;
+
+struct sce_job {
+	char *path;                     ///< Path of the script
+	bool use_wrapper;               ///< Run the script by oscap-run-sce-script
+	char **env;                     ///< NULL terminated environment of the script
+	sce_job_state_t state;
+	pid_t pid;
+	int stdout_fd;                  ///< Read end of the stdout pipe, -1 when closed
+	int stderr_fd;                  ///< Read end of the stderr pipe, -1 when closed
+	struct oscap_string *std_out;
+	struct oscap_string *std_err;
+	int wstatus;
+	bool failed;                    ///< The script could not be started
+	bool timed_out;                 ///< The script was killed after the timeout
+	struct timespec deadline;
+	struct timespec grace_deadline; ///< Pipes are closed then after a timeout kill
+	struct sce_job *next;
+};
+
+struct sce_executor {
+	struct sce_limits limits;
+	struct sce_job *head;           ///< Submitted jobs in the order of submission
+	struct sce_job *tail;
+	unsigned int running;
+};
+
+struct sce_executor *sce_executor_new(const struct sce_limits *limits)
+{
+	struct sce_executor *executor = calloc(1, sizeof(struct sce_executor));
+	if (executor == NULL)
+		return NULL;
+	executor->limits = *limits;
+	if (executor->limits.max_jobs == 0)
+		executor->limits.max_jobs = 1;
+	return executor;
+}
+
+struct sce_job *sce_job_new(const char *path, bool use_wrapper, char **env)
+{
+	struct sce_job *job = calloc(1, sizeof(struct sce_job));
+	if (job == NULL)
+		return NULL;
+	job->path = oscap_strdup(path);
+	if (job->path == NULL) {
+		free(job);
+		return NULL;
+	}
+	job->use_wrapper = use_wrapper;
+	job->env = env;
+	job->state = SCE_JOB_QUEUED;
+	job->pid = -1;
+	job->stdout_fd = -1;
+	job->stderr_fd = -1;
+	job->std_out = oscap_string_new();
+	job->std_err = oscap_string_new();
+	return job;
+}
+
+void sce_job_free(struct sce_job *job)
+{
+	if (job == NULL)
+		return;
+	for (size_t i = 0; job->env[i] != NULL; i++)
+		free(job->env[i]);
+	free(job->env);
+	free(job->path);
+	oscap_string_free(job->std_out);
+	oscap_string_free(job->std_err);
+	free(job);
+}
+
+char **sce_job_get_env(struct sce_job *job)
+{
+	return job->env;
+}
+
+char *sce_job_take_stdout(struct sce_job *job)
+{
+	char *ret = oscap_string_bequeath(job->std_out);
+	job->std_out = oscap_string_new();
+	return ret;
+}
+
+char *sce_job_take_stderr(struct sce_job *job)
+{
+	char *ret = oscap_string_bequeath(job->std_err);
+	job->std_err = oscap_string_new();
+	return ret;
+}
+
+int sce_job_get_exit_code(struct sce_job *job)
+{
+	if (job->failed)
+		return -1;
+	return WEXITSTATUS(job->wstatus);
+}
+
+bool sce_job_timed_out(struct sce_job *job)
+{
+	return job->timed_out;
+}
+
+static void _sce_job_close_fd(int *fd)
+{
+	if (*fd != -1) {
+		close(*fd);
+		*fd = -1;
+	}
+}
+
+static bool _sce_set_nonblocking(int fd, const char *name)
+{
+	const int flags = fcntl(fd, F_GETFL, 0);
+	if (flags == -1) {
+		oscap_seterr(OSCAP_EFAMILY_SCE, "Failed to obtain status of %s pipe: %s", name, strerror(errno));
+		return false;
+	}
+	if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+		oscap_seterr(OSCAP_EFAMILY_SCE, "Failed to set nonblocking flag on %s pipe: %s", name, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+static void _sce_child_exec(const struct sce_limits *limits, struct sce_job *job, int stdout_pipefd[2], int stderr_pipefd[2])
+{
+	char *argvp[3] = {
+		job->path,
+		job->path, // the second path is added in case we use the wrapper (oscap-run-sce-script)
+		NULL       // which need the path of the script to eval as first parameter.
+	};
+
+	// we won't read from the pipes, so close the reading fd
+	close(stdout_pipefd[0]);
+	close(stderr_pipefd[0]);
+
+	// forward stdout and stderr to our custom opened pipes
+	dup2(stdout_pipefd[1], fileno(stdout));
+	dup2(stderr_pipefd[1], fileno(stderr));
+
+	// we duplicated the file descriptors twice, we can close the original
+	// ones now, stdout and stderr will be closed properly after the execved
+	// script/executable finishes
+	close(stdout_pipefd[1]);
+	close(stderr_pipefd[1]);
+
+	// own process group allows to kill also the processes started by the script
+	if (limits->timeout > 0)
+		setpgid(0, 0);
+
+	if (limits->cpu_time > 0) {
+		struct rlimit rlim = { limits->cpu_time, limits->cpu_time };
+		setrlimit(RLIMIT_CPU, &rlim);
+	}
+	if (limits->memory > 0) {
+		struct rlimit rlim = { limits->memory, limits->memory };
+		setrlimit(RLIMIT_AS, &rlim);
+	}
+
+	// before we execute the script, lets make sure we get SIGTERM when
+	// oscap is killed, crashes or otherwise terminates
+#if defined(PR_SET_PDEATHSIG)
+	// requires Linux 2.1.57 or later
+	prctl(PR_SET_PDEATHSIG, SIGTERM);
+#elif defined(OS_FREEBSD)
+	int sig = SIGTERM;
+	procctl(P_PID, getpid(), PROC_PDEATHSIG_CTL, &sig);
+#else
+	// TODO: Please provide alternatives
+#endif
+
+	if (job->use_wrapper) {
+#if defined(OS_FREEBSD)
+		// Setup environment beforehand as FreeBSD does not have execvpe()
+		for (size_t k = 0; job->env[k] != NULL; k++) {
+			putenv(job->env[k]);
+		}
+
+		execvp("oscap-run-sce-script", argvp);
+#else
+		execvpe("oscap-run-sce-script", argvp, job->env);
+#endif
+	} else {
+		execve(job->path, argvp, job->env);
+	}
+
+	// no need to check the return value of execve, if it returned at all we are in trouble
+	printf("Unexpected error when executing script '%s'. Error message follows.\n", job->path);
+	perror("execve");
+
+	// the parent process considers us a script check, we have to return a value that will mean XCCDF_RESULT_ERROR
+	exit(103);
+}
+
+static void _sce_job_start(struct sce_executor *executor, struct sce_job *job)
+{
+	job->state = SCE_JOB_DONE;
+	job->failed = true;
+
+	// We open a pipe for communication with the forked process
+	int stdout_pipefd[2];
+	int stderr_pipefd[2];
+	if (pipe(stdout_pipefd) == -1) {
+		dE("Error in pipe");
+		return;
+	}
+	if (pipe(stderr_pipefd) == -1) {
+		dE("Error in pipe");
+		close(stdout_pipefd[0]);
+		close(stdout_pipefd[1]);
+		return;
+	}
+
+	// FIXME: We definitely want to impose security restrictions in the forked child process in the future.
+	//        This would prevent scripts from writing to files or deleting them.
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		dE("Failed to fork the SCE script '%s': %s", job->path, strerror(errno));
+		close(stdout_pipefd[0]);
+		close(stdout_pipefd[1]);
+		close(stderr_pipefd[0]);
+		close(stderr_pipefd[1]);
+		return;
+	}
+	if (pid == 0) {
+		_sce_child_exec(&executor->limits, job, stdout_pipefd, stderr_pipefd);
+	}
+
+	// we won't write to the pipes, so close the writing fd
+	close(stdout_pipefd[1]);
+	close(stderr_pipefd[1]);
+
+	job->pid = pid;
+	job->stdout_fd = stdout_pipefd[0];
+	job->stderr_fd = stderr_pipefd[0];
+	job->state = SCE_JOB_RUNNING;
+	job->failed = false;
+	executor->running++;
+
+	if (executor->limits.timeout > 0) {
+		// avoid the race with setpgid() in the child
+		setpgid(pid, pid);
+		clock_gettime(CLOCK_MONOTONIC, &job->deadline);
+		job->deadline.tv_sec += executor->limits.timeout;
+	}
+	dD("Started SCE script '%s' as pid %d.", job->path, (int) pid);
+
+	// we have to read from both pipes at the same time to avoid stalling
+	if (!_sce_set_nonblocking(job->stdout_fd, "stdout") || !_sce_set_nonblocking(job->stderr_fd, "stderr")) {
+		_sce_job_close_fd(&job->stdout_fd);
+		_sce_job_close_fd(&job->stderr_fd);
+	}
+}
+
+static void _sce_job_kill(struct sce_executor *executor, struct sce_job *job)
+{
+	// the script has its own process group only when there is a timeout
+	if (executor->limits.timeout > 0)
+		kill(-job->pid, SIGKILL);
+	else
+		kill(job->pid, SIGKILL);
+}
+
+/*
+ * Read available data from the pipe. Returns false on end of file.
+ */
+static bool _sce_pipe_read(int fd, struct oscap_string *string)
+{
+	char buffer[SCE_READ_CHUNK];
+	while (true) {
+		const ssize_t size = read(fd, buffer, sizeof(buffer));
+		if (size > 0) {
+			for (ssize_t i = 0; i < size; i++) {
+				if (buffer[i] == '&') {
+					// & is a special case, we have to "escape" it manually
+					// (all else will eventually get handled by libxml)
+					oscap_string_append_string(string, "&amp;");
+				} else {
+					oscap_string_append_char(string, buffer[i]);
+				}
+			}
+		} else if (size < 0 && errno == EINTR) {
+			continue;
+		} else if (size < 0 && errno == EAGAIN) {
+			// we are waiting for more input
+			return true;
+		} else {
+			return false;
+		}
+	}
+}
+
+static int _sce_ms_until(const struct timespec *deadline, const struct timespec *now)
+{
+	long ms = (deadline->tv_sec - now->tv_sec) * 1000 + (deadline->tv_nsec - now->tv_nsec) / 1000000;
+	return ms < 0 ? 0 : (ms > INT32_MAX ? INT32_MAX : (int) ms);
+}
+
+static void _sce_job_try_reap(struct sce_executor *executor, struct sce_job *job)
+{
+	if (job->stdout_fd != -1 || job->stderr_fd != -1)
+		return;
+	pid_t ret = waitpid(job->pid, &job->wstatus, WNOHANG);
+	if (ret == job->pid || (ret == -1 && errno == ECHILD)) {
+		job->state = SCE_JOB_DONE;
+		executor->running--;
+		if (job->timed_out) {
+			oscap_string_append_string(job->std_err, "\nThe script was killed because it exceeded the time limit.\n");
+		}
+		dD("SCE script '%s' finished with status %d.", job->path, job->wstatus);
+	}
+}
+
+/*
+ * Kill the scripts which exceeded the time limit and reap the finished ones.
+ */
+static void _sce_executor_check_jobs(struct sce_executor *executor)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	for (struct sce_job *job = executor->head; job != NULL; job = job->next) {
+		if (job->state != SCE_JOB_RUNNING)
+			continue;
+		if (executor->limits.timeout > 0 && !job->timed_out && _sce_ms_until(&job->deadline, &now) == 0) {
+			dW("SCE script '%s' exceeded the time limit of %u seconds, killing it.", job->path, executor->limits.timeout);
+			_sce_job_kill(executor, job);
+			job->timed_out = true;
+			job->grace_deadline = now;
+			job->grace_deadline.tv_nsec += SCE_KILL_GRACE_MS * 1000000L;
+			if (job->grace_deadline.tv_nsec >= 1000000000L) {
+				job->grace_deadline.tv_sec++;
+				job->grace_deadline.tv_nsec -= 1000000000L;
+			}
+		} else if (job->timed_out && _sce_ms_until(&job->grace_deadline, &now) == 0) {
+			// drop the rest of the output of processes which survived the kill
+			_sce_job_close_fd(&job->stdout_fd);
+			_sce_job_close_fd(&job->stderr_fd);
+		}
+		_sce_job_try_reap(executor, job);
+	}
+}
+
+/*
+ * Wait for output or termination of the running scripts and process it.
+ */
+static void _sce_executor_poll(struct sce_executor *executor)
+{
+	struct pollfd *fds = calloc(2 * executor->running, sizeof(struct pollfd));
+	struct sce_job **owners = calloc(2 * executor->running, sizeof(struct sce_job *));
+	nfds_t nfds = 0;
+	int timeout = -1;
+	struct timespec now;
+
+	if (fds == NULL || owners == NULL) {
+		// don't read the pipes this time, just check the deadlines again later
+		dE("Failed to allocate the poll set of %u SCE scripts.", executor->running);
+		free(fds);
+		free(owners);
+		poll(NULL, 0, SCE_REAP_INTERVAL_MS);
+		_sce_executor_check_jobs(executor);
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	for (struct sce_job *job = executor->head; job != NULL; job = job->next) {
+		if (job->state != SCE_JOB_RUNNING)
+			continue;
+		if (job->stdout_fd != -1) {
+			fds[nfds].fd = job->stdout_fd;
+			fds[nfds].events = POLLIN;
+			owners[nfds++] = job;
+		}
+		if (job->stderr_fd != -1) {
+			fds[nfds].fd = job->stderr_fd;
+			fds[nfds].events = POLLIN;
+			owners[nfds++] = job;
+		}
+		int job_timeout = -1;
+		if (job->stdout_fd == -1 && job->stderr_fd == -1)
+			job_timeout = SCE_REAP_INTERVAL_MS;
+		if (executor->limits.timeout > 0) {
+			int ms = _sce_ms_until(job->timed_out ? &job->grace_deadline : &job->deadline, &now);
+			if (job_timeout == -1 || ms < job_timeout)
+				job_timeout = ms;
+		}
+		if (job_timeout != -1 && (timeout == -1 || job_timeout < timeout))
+			timeout = job_timeout;
+	}
+
+	int ret = poll(fds, nfds, timeout);
+	if (ret == -1 && errno != EINTR)
+		dE("Failed to poll SCE script pipes: %s", strerror(errno));
+
+	for (nfds_t i = 0; ret > 0 && i < nfds; i++) {
+		if (fds[i].revents == 0)
+			continue;
+		struct sce_job *job = owners[i];
+		if (fds[i].fd == job->stdout_fd) {
+			if (!_sce_pipe_read(job->stdout_fd, job->std_out))
+				_sce_job_close_fd(&job->stdout_fd);
+		} else if (fds[i].fd == job->stderr_fd) {
+			if (!_sce_pipe_read(job->stderr_fd, job->std_err))
+				_sce_job_close_fd(&job->stderr_fd);
+		}
+	}
+	free(fds);
+	free(owners);
+
+	_sce_executor_check_jobs(executor);
+}
+
+/*
+ * Start queued jobs while there are free slots. The awaited job goes first.
+ */
+static void _sce_executor_start_jobs(struct sce_executor *executor, struct sce_job *wanted)
+{
+	if (wanted->state == SCE_JOB_QUEUED && executor->running < executor->limits.max_jobs)
+		_sce_job_start(executor, wanted);
+	for (struct sce_job *job = executor->head; job != NULL && executor->running < executor->limits.max_jobs; job = job->next) {
+		if (job->state == SCE_JOB_QUEUED)
+			_sce_job_start(executor, job);
+	}
+}
+
+static void _sce_executor_unlink(struct sce_executor *executor, struct sce_job *job)
+{
+	struct sce_job *prev = NULL;
+	for (struct sce_job *it = executor->head; it != NULL; prev = it, it = it->next) {
+		if (it != job)
+			continue;
+		if (prev == NULL)
+			executor->head = job->next;
+		else
+			prev->next = job->next;
+		if (executor->tail == job)
+			executor->tail = prev;
+		job->next = NULL;
+		return;
+	}
+}
+
+void sce_executor_submit(struct sce_executor *executor, struct sce_job *job)
+{
+	if (executor->tail == NULL)
+		executor->head = job;
+	else
+		executor->tail->next = job;
+	executor->tail = job;
+}
+
+static bool _sce_env_equal(char **a, char **b)
+{
+	size_t i = 0;
+	for (; a[i] != NULL && b[i] != NULL; i++) {
+		if (strcmp(a[i], b[i]) != 0)
+			return false;
+	}
+	return a[i] == NULL && b[i] == NULL;
+}
+
+struct sce_job *sce_executor_find(struct sce_executor *executor, const char *path, char **env)
+{
+	for (struct sce_job *job = executor->head; job != NULL; job = job->next) {
+		if (strcmp(job->path, path) == 0 && _sce_env_equal(job->env, env))
+			return job;
+	}
+	return NULL;
+}
+
+void sce_executor_wait(struct sce_executor *executor, struct sce_job *job)
+{
+	while (job->state != SCE_JOB_DONE) {
+		_sce_executor_start_jobs(executor, job);
+		if (job->state != SCE_JOB_DONE)
+			_sce_executor_poll(executor);
+	}
+	_sce_executor_unlink(executor, job);
+}
+
+void sce_executor_discard(struct sce_executor *executor)
+{
+	struct sce_job *job = executor->head;
+	while (job != NULL) {
+		struct sce_job *next = job->next;
+		if (job->state == SCE_JOB_RUNNING) {
+			_sce_job_kill(executor, job);
+			_sce_job_close_fd(&job->stdout_fd);
+			_sce_job_close_fd(&job->stderr_fd);
+			waitpid(job->pid, &job->wstatus, 0);
+			executor->running--;
+		}
+		sce_job_free(job);
+		job = next;
+	}
+	executor->head = NULL;
+	executor->tail = NULL;
+}
+
+void sce_executor_free(struct sce_executor *executor)
+{
+	if (executor == NULL)
+		return;
+	sce_executor_discard(executor);
+	free(executor);
+}
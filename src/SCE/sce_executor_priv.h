@@ -0,0 +1,100 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef OSCAP_SCE_EXECUTOR_PRIV_H
+#define OSCAP_SCE_EXECUTOR_PRIV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * SCE executor runs check scripts as child processes. Up to max_jobs scripts
+ * run at the same time, their stdout and stderr are captured. The executor
+ * has no thread of its own, the scripts make progress while the caller waits
+ * for a job in sce_executor_wait().
+ */
+struct sce_executor;
+
+/*
+ * Single script execution, created by sce_job_new() and queued by
+ * sce_executor_submit().
+ */
+struct sce_job;
+
+/*
+ * Limits of the executed scripts, 0 means unlimited.
+ */
+struct sce_limits {
+	unsigned int max_jobs;          ///< Number of scripts running at the same time
+	unsigned int timeout;           ///< Wall clock time in seconds, the script is killed after that
+	unsigned int cpu_time;          ///< RLIMIT_CPU in seconds
+	size_t memory;                  ///< RLIMIT_AS in bytes
+};
+
+/*
+ * Create a new executor, NULL if it can't be allocated.
+ */
+struct sce_executor *sce_executor_new(const struct sce_limits *limits);
+
+/*
+ * Kill scripts which are still running and free all jobs.
+ */
+void sce_executor_free(struct sce_executor *executor);
+
+/*
+ * Kill and free all jobs which have not been taken by sce_executor_wait().
+ */
+void sce_executor_discard(struct sce_executor *executor);
+
+/*
+ * Create a new job. The job takes ownership of env, a NULL terminated array
+ * of allocated KEY=VALUE strings. Returns NULL if the job can't be allocated,
+ * env is left to the caller then.
+ */
+struct sce_job *sce_job_new(const char *path, bool use_wrapper, char **env);
+void sce_job_free(struct sce_job *job);
+
+/*
+ * Queue the job, it will be started when there is a free slot.
+ */
+void sce_executor_submit(struct sce_executor *executor, struct sce_job *job);
+
+/*
+ * Find a submitted job with the same script and environment.
+ * Returns NULL if there is no such job.
+ */
+struct sce_job *sce_executor_find(struct sce_executor *executor, const char *path, char **env);
+
+/*
+ * Wait until the submitted job finishes and remove it from the executor.
+ * Other queued jobs run in the meantime. The caller owns the job afterwards.
+ */
+void sce_executor_wait(struct sce_executor *executor, struct sce_job *job);
+
+/*
+ * Accessors of a finished job. Output of the script has '&' characters escaped.
+ */
+char **sce_job_get_env(struct sce_job *job);
+char *sce_job_take_stdout(struct sce_job *job);
+char *sce_job_take_stderr(struct sce_job *job);
+int sce_job_get_exit_code(struct sce_job *job);
+bool sce_job_timed_out(struct sce_job *job);
+
+#endif
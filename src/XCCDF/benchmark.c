@@ -102,9 +102,9 @@ struct xccdf_benchmark *xccdf_benchmark_new(void)
 	bench->sub.benchmark.profiles = oscap_list_new();
 	bench->sub.benchmark.results = oscap_list_new();
     // hash tables
-	bench->sub.benchmark.items_dict = oscap_htable_new();
-	bench->sub.benchmark.profiles_dict = oscap_htable_new();
-	bench->sub.benchmark.results_dict = oscap_htable_new();
+	bench->sub.benchmark.items_dict = oscap_htable_new2(0, OSCAP_HTABLE_POOL_KEYS);
+	bench->sub.benchmark.profiles_dict = oscap_htable_new2(0, OSCAP_HTABLE_POOL_KEYS);
+	bench->sub.benchmark.results_dict = oscap_htable_new2(0, OSCAP_HTABLE_POOL_KEYS);
 	bench->sub.benchmark.clusters_dict = oscap_htable_new();
 
 	// add the implied default scoring model
@@ -1152,9 +1152,9 @@ struct xccdf_benchmark_item * xccdf_benchmark_item_clone(struct xccdf_item *pare
 
     clone->schema_version = item->schema_version;
 
-	clone->items_dict = oscap_htable_new();
-	clone->profiles_dict = oscap_htable_new();
-	clone->results_dict = oscap_htable_new();
+	clone->items_dict = oscap_htable_new2(0, OSCAP_HTABLE_POOL_KEYS);
+	clone->profiles_dict = oscap_htable_new2(0, OSCAP_HTABLE_POOL_KEYS);
+	clone->results_dict = oscap_htable_new2(0, OSCAP_HTABLE_POOL_KEYS);
 	clone->notices = oscap_list_clone(item->notices, (oscap_clone_func) xccdf_notice_clone);
 	clone->plain_texts = oscap_list_clone(item->plain_texts, (oscap_clone_func) xccdf_plain_text_clone);
 	
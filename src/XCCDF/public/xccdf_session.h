@@ -270,6 +270,16 @@ OSCAP_API void xccdf_session_set_without_sys_chars_export(struct xccdf_session *
  */
 OSCAP_API void xccdf_session_set_oval_results_export(struct xccdf_session *session, bool to_export_oval_results);
 
+/**
+ * Set compression of the exported OVAL result files. The files get
+ * ".gz" or ".zst" suffix and are compressed while they are written.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param compression "gzip", "zstd" or NULL for no compression
+ * @returns true on success, false if the compression is not known
+ */
+OSCAP_API bool xccdf_session_set_oval_results_compression(struct xccdf_session *session, const char *compression);
+
 /**
  * Set that check engine plugin's result files shall be exported.
  * @memberof xccdf_session
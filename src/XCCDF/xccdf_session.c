@@ -39,6 +39,7 @@
 #include "common/oscap_acquire.h"
 #include "common/util.h"
 #include "common/list.h"
+#include "common/oscap_parallel.h"
 #include "common/oscapxml.h"
 #include "common/_error.h"
 #include "common/debug_priv.h"
@@ -103,6 +104,7 @@ struct xccdf_session {
 		char *xccdf_stig_viewer_file;		///< Path to STIG Viewer XCCDF file to export
 		char *report_file;			///< Path to HTML file to eport
 		bool oval_results;			///< Shall be the OVAL results files exported?
+		const char *oval_results_suffix;	///< Suffix selecting compression of exported OVAL results files
 		bool oval_variables;			///< Shall be the OVAL variable files exported?
 		bool check_engine_plugins_results;	///< Shall the check engine plugins results be exported?
 		bool without_sys_chars;			///< Shall system characteristics be exported?
@@ -459,6 +461,21 @@ void xccdf_session_set_oval_results_export(struct xccdf_session *session, bool t
 	session->export.oval_results = to_export_oval_results;
 }
 
+bool xccdf_session_set_oval_results_compression(struct xccdf_session *session, const char *compression)
+{
+	if (compression == NULL) {
+		session->export.oval_results_suffix = NULL;
+	} else if (strcmp(compression, "gzip") == 0) {
+		session->export.oval_results_suffix = ".gz";
+	} else if (strcmp(compression, "zstd") == 0) {
+		session->export.oval_results_suffix = ".zst";
+	} else {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unknown compression '%s', use 'gzip' or 'zstd'.", compression);
+		return false;
+	}
+	return true;
+}
+
 void xccdf_session_set_oval_variables_export(struct xccdf_session *session, bool to_export_oval_variables)
 {
 	session->export.oval_variables = to_export_oval_variables;
@@ -1444,7 +1461,7 @@ static void _xccdf_session_free_oval_result_sources(struct xccdf_session *sessio
 	}
 }
 
-static char *_xccdf_session_get_unique_oval_result_filename(struct xccdf_session *session, struct oval_agent_session *oval_session, const char *oval_results_directory)
+static char *_xccdf_session_get_unique_oval_result_filename(struct xccdf_session *session, struct oval_agent_session *oval_session, const char *oval_results_directory, struct oscap_htable *assigned_names)
 {
 	char *escaped_url = NULL;
 	const char *filename = oval_agent_get_filename(oval_session);
@@ -1475,15 +1492,19 @@ static char *_xccdf_session_get_unique_oval_result_filename(struct xccdf_session
 		free(filename_cpy);
 	}
 
+	const char *compression_suffix = "";
+	if (session->export.oval_results && session->export.oval_results_suffix != NULL)
+		compression_suffix = session->export.oval_results_suffix;
+
 	char *name = NULL;
 	unsigned int suffix = 1;
 	while (suffix < UINT_MAX)
 	{
 		name = malloc(PATH_MAX * sizeof(char));
 		if (suffix == 1)
-			snprintf(name, PATH_MAX, "%s/%s.result.xml", oval_results_directory, escaped_url != NULL ? escaped_url : filename);
+			snprintf(name, PATH_MAX, "%s/%s.result.xml%s", oval_results_directory, escaped_url != NULL ? escaped_url : filename, compression_suffix);
 		else
-			snprintf(name, PATH_MAX, "%s/%s.result%i.xml", oval_results_directory, escaped_url != NULL ? escaped_url : filename, suffix);
+			snprintf(name, PATH_MAX, "%s/%s.result%i.xml%s", oval_results_directory, escaped_url != NULL ? escaped_url : filename, suffix, compression_suffix);
 
 		// Try to guess how the real path will look like. This should avoid us rewriting
 		// the results files if the OVAL happens to have the same name. We allow users
@@ -1496,7 +1517,7 @@ static char *_xccdf_session_get_unique_oval_result_filename(struct xccdf_session
 			free(escaped_url);
 			return NULL;
 		}
-		if (oscap_htable_get(session->oval.result_sources, name) == NULL) {
+		if (oscap_htable_get(assigned_names, name) == NULL) {
 			// Check if this export name conflicts with any other exported OVAL result.
 			//
 			// One example where a conflict can easily happen is if we have the
@@ -1518,7 +1539,14 @@ static char *_xccdf_session_get_unique_oval_result_filename(struct xccdf_session
 	return name;
 }
 
-static char *_xccdf_session_export_oval_result_file(struct xccdf_session *session, struct oval_agent_session *oval_session)
+struct oval_result_export {
+	struct oval_agent_session *oval_session;	///< OVAL session which results are exported
+	char *name;					///< Path of the exported OVAL results file
+	struct oscap_source *source;			///< oscap_source of the exported OVAL results
+	bool save_failed;				///< Saving of the source failed
+};
+
+static char *_xccdf_session_prepare_oval_result_export(struct xccdf_session *session, struct oval_agent_session *oval_session, struct oscap_htable *assigned_names)
 {
 	/* get result model and session name */
 	struct oval_results_model *res_model = oval_agent_get_results_model(oval_session);
@@ -1538,25 +1566,35 @@ static char *_xccdf_session_export_oval_result_file(struct xccdf_session *sessio
 		oval_results_directory = session->temp_dir;
 	}
 
-	char *name = _xccdf_session_get_unique_oval_result_filename(session, oval_session, oval_results_directory);
+	char *name = _xccdf_session_get_unique_oval_result_filename(session, oval_session, oval_results_directory, assigned_names);
 
 	if (name == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Can't figure out the right filename for OVAL result file. Can't export that file!");
 		return NULL;
 	}
+	oscap_htable_add(assigned_names, name, oval_session);
+	return name;
+}
+
+static void _xccdf_session_build_oval_result_source(size_t index, void *arg)
+{
+	struct oval_result_export *export = &((struct oval_result_export *) arg)[index];
+	struct oval_results_model *res_model = oval_agent_get_results_model(export->oval_session);
+	export->source = oval_results_model_export_source(res_model, NULL, export->name);
+}
 
-	struct oscap_source *source = oval_results_model_export_source(res_model, NULL, name);
+static int _xccdf_session_add_oval_result_source(struct xccdf_session *session, struct oval_agent_session *oval_session, char *name, struct oscap_source *source)
+{
 	if (source == NULL) {
-		free(name);
-		return NULL;
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not export OVAL Results to %s", name);
+		return 1;
 	}
 	if (oscap_htable_add(session->oval.result_sources, name, source) == false) {
 		// The source is already there, but it shouldn't be
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Internal error: attempted to export file %s twice", name);
 		oscap_source_free(source);
-		free(name);
 		abort(); // Let's make this visible in debug mode
-		return NULL;
+		return 1;
 	}
 
 	static int counter = 0;
@@ -1575,11 +1613,10 @@ static char *_xccdf_session_export_oval_result_file(struct xccdf_session *sessio
 		if (oscap_source_validate(source, _reporter, NULL)) {
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not export OVAL Results correctly to %s",
 				oscap_source_readable_origin(source));
-			free(name);
-			return NULL;
+			return 1;
 		}
 	}
-	return name;
+	return 0;
 }
 
 static int _build_oval_result_sources(struct xccdf_session *session)
@@ -1588,37 +1625,65 @@ static int _build_oval_result_sources(struct xccdf_session *session)
 		return 0;
 	}
 
-	/* Export OVAL results */
-	session->oval.result_sources = oscap_htable_new();
-	session->oval.results_mapping = oscap_htable_new();
-	session->oval.arf_report_mapping = oscap_htable_new();
+	/* Collect OVAL sessions for export, first the check ones, then CPE ones */
+	size_t exports_count = 0;
+	size_t exports_size = xccdf_session_get_oval_agents_count(session) + xccdf_session_get_cpe_oval_agents_count(session);
+	struct oval_result_export *exports = calloc(exports_size + 1, sizeof(struct oval_result_export));
 	if (session->oval.agents) {
-		for (int i = 0; session->oval.agents[i]; i++) {
-			char *filename = _xccdf_session_export_oval_result_file(session, session->oval.agents[i]);
-			if (filename == NULL) {
-				_xccdf_session_free_oval_result_sources(session);
-				return 1;
-			}
-			free(filename);
-		}
+		for (int i = 0; session->oval.agents[i]; i++)
+			exports[exports_count++].oval_session = session->oval.agents[i];
 	}
-
 	struct oscap_htable_iterator *cpe_it = xccdf_policy_model_get_cpe_oval_sessions(session->xccdf.policy_model);
-	while (oscap_htable_iterator_has_more(cpe_it)) {
+	while (oscap_htable_iterator_has_more(cpe_it) && exports_count < exports_size) {
 		const char *key = NULL;
 		struct oval_agent_session *value = NULL;
 		oscap_htable_iterator_next_kv(cpe_it, &key, (void*)&value);
+		exports[exports_count++].oval_session = value;
+	}
+	oscap_htable_iterator_free(cpe_it);
 
-		char *filename = _xccdf_session_export_oval_result_file(session, value);
-		if (filename == NULL) {
-			_xccdf_session_free_oval_result_sources(session);
-			oscap_htable_iterator_free(cpe_it);
-			return 1;
+	/* Result file names depend on each other, pick them sequentially */
+	int ret = 0;
+	size_t prepared = 0;
+	struct oscap_htable *assigned_names = oscap_htable_new();
+	for (; prepared < exports_count; prepared++) {
+		exports[prepared].name = _xccdf_session_prepare_oval_result_export(session, exports[prepared].oval_session, assigned_names);
+		if (exports[prepared].name == NULL) {
+			ret = 1;
+			break;
 		}
-		free(filename);
 	}
-	oscap_htable_iterator_free(cpe_it);
-	return 0;
+	oscap_htable_free0(assigned_names);
+
+	/* Each OVAL session has its own results model, so the DOMs of
+	 * the result documents can be built concurrently */
+	if (ret == 0)
+		oscap_parallel_run(exports_count, _xccdf_session_build_oval_result_source, exports);
+
+	/* Export OVAL results */
+	session->oval.result_sources = oscap_htable_new();
+	session->oval.results_mapping = oscap_htable_new();
+	session->oval.arf_report_mapping = oscap_htable_new();
+	for (size_t i = 0; i < exports_count && ret == 0; i++) {
+		struct oscap_source *source = exports[i].source;
+		exports[i].source = NULL;
+		ret = _xccdf_session_add_oval_result_source(session, exports[i].oval_session, exports[i].name, source);
+	}
+	for (size_t i = 0; i < prepared; i++) {
+		oscap_source_free(exports[i].source);
+		free(exports[i].name);
+	}
+	free(exports);
+
+	if (ret != 0)
+		_xccdf_session_free_oval_result_sources(session);
+	return ret;
+}
+
+static void _xccdf_session_save_oval_result_source(size_t index, void *arg)
+{
+	struct oval_result_export *export = &((struct oval_result_export *) arg)[index];
+	export->save_failed = oscap_source_save_as(export->source, NULL) != 0;
 }
 
 int xccdf_session_export_oval(struct xccdf_session *session)
@@ -1626,16 +1691,23 @@ int xccdf_session_export_oval(struct xccdf_session *session)
 	if (_build_oval_result_sources(session) != 0) {
 		return 1;
 	}
+	/* Result documents are independent, serialize them concurrently */
+	size_t sources_count = 0;
+	struct oval_result_export *saves = calloc(session->oval.result_sources->itemcount + 1, sizeof(struct oval_result_export));
 	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(session->oval.result_sources);
 	while (oscap_htable_iterator_has_more(hit)) {
-		struct oscap_source *source = oscap_htable_iterator_next_value(hit);
-		if (oscap_source_save_as(source, NULL) != 0) {
-			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not save file: %s", oscap_source_readable_origin(source));
-			oscap_htable_iterator_free(hit);
+		saves[sources_count++].source = oscap_htable_iterator_next_value(hit);
+	}
+	oscap_htable_iterator_free(hit);
+	oscap_parallel_run(sources_count, _xccdf_session_save_oval_result_source, saves);
+	for (size_t i = 0; i < sources_count; i++) {
+		if (saves[i].save_failed) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not save file: %s", oscap_source_readable_origin(saves[i].source));
+			free(saves);
 			return 1;
 		}
 	}
-	oscap_htable_iterator_free(hit);
+	free(saves);
 
 	/* Export variables */
 	if (session->export.oval_variables && session->oval.agents != NULL) {
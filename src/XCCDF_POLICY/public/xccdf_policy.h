@@ -102,6 +102,19 @@ typedef void *(*xccdf_policy_engine_query_fn) (void *, xccdf_policy_engine_query
  */
 typedef xccdf_test_result_type_t (*xccdf_policy_engine_eval_fn) (struct xccdf_policy *policy, const char *rule_id, const char *definition_id, const char *href_if, struct xccdf_value_binding_iterator *value_binding_it, struct xccdf_check_import_iterator *check_imports_it, void *user_data);
 
+/**
+ * Type of function which lets a checking engine start evaluation of checks ahead of time.
+ *
+ * Before the evaluation of rules, the registered function is called for every simple check
+ * of selected and applicable rules, in the order in which the rules will be evaluated.
+ * The arguments have the same meaning as the arguments of xccdf_policy_engine_eval_fn.
+ * The checking engine may evaluate the checks concurrently, but it still has to return
+ * their results from xccdf_policy_engine_eval_fn when they are asked for. At the beginning
+ * of each evaluation the function is called with NULL href, the checking engine shall drop
+ * checks prefetched before which have not been asked for.
+ */
+typedef void (*xccdf_policy_engine_prefetch_fn) (struct xccdf_policy *policy, const char *definition_id, const char *href, struct xccdf_value_binding_iterator *value_binding_it, void *user_data);
+
 /************************************************************/
 
 /**
@@ -239,6 +252,17 @@ OSCAP_API struct oscap_htable_iterator *xccdf_policy_model_get_cpe_oval_sessions
  */
 OSCAP_API bool xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn);
 
+/**
+ * Function to register prefetch callback for already registered checking system
+ * @param model XCCDF Policy Model
+ * @param sys String representing given checking system
+ * @param prefetch_fn Callback called before the evaluation, see xccdf_policy_engine_prefetch_fn
+ * @param usr user data of the checking engine given to xccdf_policy_model_register_engine_and_query_callback
+ * @memberof xccdf_policy_model
+ * @return true if the checking engine was found, false otherwise
+ */
+OSCAP_API bool xccdf_policy_model_register_engine_prefetch_callback(struct xccdf_policy_model *model, const char *sys, xccdf_policy_engine_prefetch_fn prefetch_fn, void *usr);
+
 typedef int (*policy_reporter_output)(struct xccdf_rule_result *, void *);
 
 /**
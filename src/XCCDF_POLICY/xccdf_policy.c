@@ -549,7 +549,7 @@ _xccdf_policy_is_engine_registered(struct xccdf_policy *policy, char *sysname)
 }
 
 static struct xccdf_check *
-_xccdf_policy_rule_get_applicable_check(struct xccdf_policy *policy, struct xccdf_item *rule)
+_xccdf_policy_rule_get_applicable_check(struct xccdf_policy *policy, struct xccdf_item *rule, bool verbose)
 {
 	// Citations inline come from NISTIR-7275r4.
 	struct xccdf_check *result = NULL;
@@ -584,9 +584,11 @@ _xccdf_policy_rule_get_applicable_check(struct xccdf_policy *policy, struct xccd
 			} else if (strcmp("http://oval.mitre.org/XMLSchema/oval-definitions-5", check->system) == 0) {
 				print_oval_warning = true;
 			} else if (strcmp("http://scap.nist.gov/schema/ocil/2", check->system) == 0) {
-				dI("This rule requires an OCIL check. OCIL checks are not supported by OpenSCAP.");
+				if (verbose)
+					dI("This rule requires an OCIL check. OCIL checks are not supported by OpenSCAP.");
 			} else if (strcmp("http://open-scap.org/page/SCE", check->system) == 0) {
-				dI("This rule requires a SCE check but the SCE plugin was disabled.");
+				if (verbose)
+					dI("This rule requires a SCE check but the SCE plugin was disabled.");
 			} else {
 				print_general_warning = true;
 				warning_check_system = check->system;
@@ -594,10 +596,10 @@ _xccdf_policy_rule_get_applicable_check(struct xccdf_policy *policy, struct xccd
 		}
 
 		// Only print a warning if we didn't select a check but could've otherwise.
-		if (print_oval_warning) {
+		if (verbose && print_oval_warning) {
 			dW("Skipping rule that uses OVAL but is possibly malformed; "
 			       "an incorrect content reference prevents this check from being evaluated.\n");
-		} else if (print_general_warning && result == NULL) {
+		} else if (verbose && print_general_warning && result == NULL) {
 			dW("Skipping rule that requires an unregistered check system "
 			       "or incorrect content reference to evaluate. "
 			       "Please consider providing a valid SCAP/OVAL instead of %s\n",
@@ -1016,7 +1018,7 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_APPLICABLE, NULL);
 	}
 
-	const struct xccdf_check *orig_check = _xccdf_policy_rule_get_applicable_check(policy, (struct xccdf_item *) rule);
+	const struct xccdf_check *orig_check = _xccdf_policy_rule_get_applicable_check(policy, (struct xccdf_item *) rule, true);
 	if (orig_check == NULL)
 		// No candidate or applicable check found.
 		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_CHECKED, "No candidate or applicable check found.");
@@ -1122,6 +1124,101 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	return _xccdf_policy_report_rule_result(policy, result, rule, check, ret, message);
 }
 
+/**
+ * Let the checking engines which support it start evaluation of the rule's check
+ * ahead of time. Only simple checks are prefetched, the conditions mirror the ones
+ * of _xccdf_policy_rule_evaluate. The evaluation itself will ask for the result later.
+ */
+static void _xccdf_policy_rule_prefetch(struct xccdf_policy *policy, const struct xccdf_rule *rule)
+{
+	const char *rule_id = xccdf_rule_get_id(rule);
+	if (policy->rule != NULL && strcmp(policy->rule, rule_id) != 0)
+		return;
+	if (!xccdf_policy_is_item_selected(policy, rule_id))
+		return;
+
+	struct xccdf_refine_rule_internal *r_rule = oscap_htable_get(policy->refine_rules_internal, rule_id);
+	if (xccdf_get_final_role(rule, r_rule) == XCCDF_ROLE_UNCHECKED)
+		return;
+
+	const struct xccdf_check *check = _xccdf_policy_rule_get_applicable_check(policy, (struct xccdf_item *) rule, false);
+	if (check == NULL || xccdf_check_get_complex(check))
+		return;
+
+	const char *system_name = xccdf_check_get_system(check);
+	bool can_prefetch = false;
+	struct oscap_iterator *cb_it = _xccdf_policy_get_engines_by_sysname(policy, system_name);
+	while (oscap_iterator_has_more(cb_it) && !can_prefetch)
+		can_prefetch = xccdf_policy_engine_can_prefetch(oscap_iterator_next(cb_it));
+	oscap_iterator_free(cb_it);
+	if (!can_prefetch)
+		return;
+
+	if (!xccdf_policy_model_item_is_applicable(policy->model, (struct xccdf_item *) rule))
+		return;
+
+	const bool had_error = oscap_err();
+	struct oscap_list *bindings = xccdf_policy_check_get_value_bindings(policy, xccdf_check_get_exports(check));
+	if (bindings == NULL) {
+		// The evaluation of the rule will report the error again
+		if (!had_error)
+			oscap_clearerr();
+		return;
+	}
+
+	// The content references are alternatives, the first one is evaluated in most cases
+	struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(check);
+	if (xccdf_check_content_ref_iterator_has_more(content_it)) {
+		struct xccdf_check_content_ref *content = xccdf_check_content_ref_iterator_next(content_it);
+		cb_it = _xccdf_policy_get_engines_by_sysname(policy, system_name);
+		while (oscap_iterator_has_more(cb_it)) {
+			struct xccdf_policy_engine *engine = (struct xccdf_policy_engine *) oscap_iterator_next(cb_it);
+			xccdf_policy_engine_prefetch(engine, policy, xccdf_check_content_ref_get_name(content),
+					xccdf_check_content_ref_get_href(content), bindings);
+		}
+		oscap_iterator_free(cb_it);
+	}
+	xccdf_check_content_ref_iterator_free(content_it);
+	oscap_list_free(bindings, (oscap_destruct_func) xccdf_value_binding_free);
+}
+
+static void _xccdf_policy_item_prefetch(struct xccdf_policy *policy, struct xccdf_item *item)
+{
+	if (xccdf_item_get_type(item) == XCCDF_RULE) {
+		_xccdf_policy_rule_prefetch(policy, (struct xccdf_rule *) item);
+	} else if (xccdf_item_get_type(item) == XCCDF_GROUP) {
+		struct xccdf_item_iterator *child_it = xccdf_group_get_content((const struct xccdf_group *) item);
+		while (xccdf_item_iterator_has_more(child_it))
+			_xccdf_policy_item_prefetch(policy, xccdf_item_iterator_next(child_it));
+		xccdf_item_iterator_free(child_it);
+	}
+}
+
+/**
+ * Announce checks of the whole benchmark to the checking engines with prefetch callback.
+ */
+static void _xccdf_policy_prefetch(struct xccdf_policy *policy, struct xccdf_benchmark *benchmark)
+{
+	bool can_prefetch = false;
+	struct oscap_iterator *cb_it = oscap_iterator_new(policy->model->engines);
+	while (oscap_iterator_has_more(cb_it)) {
+		struct xccdf_policy_engine *engine = (struct xccdf_policy_engine *) oscap_iterator_next(cb_it);
+		if (xccdf_policy_engine_can_prefetch(engine)) {
+			// drop checks left over from the previous evaluation
+			xccdf_policy_engine_prefetch(engine, policy, NULL, NULL, NULL);
+			can_prefetch = true;
+		}
+	}
+	oscap_iterator_free(cb_it);
+	if (!can_prefetch)
+		return;
+
+	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+	while (xccdf_item_iterator_has_more(item_it))
+		_xccdf_policy_item_prefetch(policy, xccdf_item_iterator_next(item_it));
+	xccdf_item_iterator_free(item_it);
+}
+
 /** 
  * Evaluate the XCCDF item. If it is group, start recursive cycle, otherwise get XCCDF check
  * and evaluate it.
@@ -1566,6 +1663,21 @@ xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model
 	return oscap_list_add(model->engines, engine);
 }
 
+bool
+xccdf_policy_model_register_engine_prefetch_callback(struct xccdf_policy_model *model, const char *sys, xccdf_policy_engine_prefetch_fn prefetch_fn, void *usr)
+{
+	__attribute__nonnull__(model);
+	bool found = false;
+	struct oscap_iterator *cb_it = oscap_iterator_new_filter(model->engines, (oscap_filter_func) xccdf_policy_engine_filter, (void *) sys);
+	while (oscap_iterator_has_more(cb_it)) {
+		struct xccdf_policy_engine *engine = (struct xccdf_policy_engine *) oscap_iterator_next(cb_it);
+		if (xccdf_policy_engine_set_prefetch(engine, prefetch_fn, usr))
+			found = true;
+	}
+	oscap_iterator_free(cb_it);
+	return found;
+}
+
 void xccdf_policy_model_unregister_engines(struct xccdf_policy_model *model, const char *sys)
 {
 	__attribute__nonnull__(model);
@@ -2037,6 +2149,8 @@ struct xccdf_result * xccdf_policy_evaluate(struct xccdf_policy * policy)
 
     free(id);
 
+	_xccdf_policy_prefetch(policy, benchmark);
+
 	/** We need to process document top-down order.
 	 * See conflicts/requires and Item Processing Algorithm */
 	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
@@ -76,5 +76,32 @@ xccdf_test_result_type_t xccdf_policy_engine_eval(struct xccdf_policy_engine *en
  */
 struct oscap_list *xccdf_policy_engine_query(struct xccdf_policy_engine *engine, xccdf_policy_engine_query_t query_type, void *query_data);
 
+/**
+ * Set the prefetch function of the given checking engine
+ * @memberof xccdf_policy_engine
+ * @param engine Checking engine
+ * @param prefetch_fn The prefetch function
+ * @param usr User data the checking engine was registered with
+ * @returns true if the user data matches and the function was set
+ */
+bool xccdf_policy_engine_set_prefetch(struct xccdf_policy_engine *engine, xccdf_policy_engine_prefetch_fn prefetch_fn, void *usr);
+
+/**
+ * Check whether the given checking engine has a prefetch function
+ * @memberof xccdf_policy_engine
+ */
+bool xccdf_policy_engine_can_prefetch(struct xccdf_policy_engine *engine);
+
+/**
+ * Execute the prefetch function of the given checking engine, if any
+ * @memberof xccdf_policy_engine
+ * @param engine Checking engine
+ * @param policy XCCDF Policy
+ * @param definition_id ID of definition to evaluate later
+ * @param href_id The @href attribute of check-content-ref, NULL to drop prefetched checks
+ * @param value_bindings Value binding
+ */
+void xccdf_policy_engine_prefetch(struct xccdf_policy_engine *engine, struct xccdf_policy *policy, const char *definition_id, const char *href_id, struct oscap_list *value_bindings);
+
 
 #endif
@@ -58,4 +58,18 @@ struct oscap_err_t {
 __attribute__((format (printf, 5, 6)))
 void __oscap_seterr(const char *file, uint32_t line, const char *func, oscap_errfamily_t family, const char *fmt, ...);
 
+struct err_queue;
+
+/**
+ * Take the errors of the calling thread, the thread has no errors afterwards.
+ * @returns the error queue or NULL if there are no errors
+ */
+struct err_queue *oscap_err_detach(void);
+
+/**
+ * Append errors taken by oscap_err_detach() to the errors of the calling
+ * thread. The queue is disposed.
+ */
+void oscap_err_attach(struct err_queue *errors);
+
 #endif				/* _OSCAP_ERROR_H */
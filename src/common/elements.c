@@ -44,6 +44,12 @@
 #include "debug_priv.h"
 #include "elements.h"
 #include "oscap_helpers.h"
+#include "oscap_parallel.h"
+#include "source/gz_priv.h"
+#include "source/zst_priv.h"
+
+/* Smallest number of subtrees worth handing over to a worker thread */
+#define OSCAP_XML_PARALLEL_MIN_CHUNK 64
 
 
 const struct oscap_string_map OSCAP_BOOL_MAP[] = {
@@ -218,6 +224,31 @@ const char *oscap_strlist_find_value(char ** const kvalues, const char *key)
 	return NULL;
 }
 
+/*
+ * Create output buffer for the given file. The ".gz" and ".zst" suffixes
+ * select a buffer which compresses the document as it is serialized.
+ */
+static xmlOutputBufferPtr oscap_xml_output_buffer_fd(const char *filename, int fd)
+{
+	if (oscap_str_endswith(filename, ".gz")) {
+#ifdef ZLIB_FOUND
+		return gz_fd_output_buffer(fd);
+#else
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to compress '%s'. Please compile OpenSCAP with zlib support.", filename);
+		return NULL;
+#endif
+	}
+	if (oscap_str_endswith(filename, ".zst")) {
+#ifdef ZSTD_FOUND
+		return zst_fd_output_buffer(fd);
+#else
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to compress '%s'. Please compile OpenSCAP with zstd support.", filename);
+		return NULL;
+#endif
+	}
+	return xmlOutputBufferCreateFd(fd, NULL);
+}
+
 int oscap_xml_save_filename(const char *filename, xmlDocPtr doc)
 {
 	xmlOutputBufferPtr buff;
@@ -238,7 +269,7 @@ int oscap_xml_save_filename(const char *filename, xmlDocPtr doc)
 			return -1;
 		}
 
-		buff = xmlOutputBufferCreateFd(fd, NULL);
+		buff = oscap_xml_output_buffer_fd(filename, fd);
 		if (buff == NULL) {
 			close(fd);
 			oscap_setxmlerr(xmlGetLastError());
@@ -275,3 +306,87 @@ xmlNs *lookup_xsi_ns(xmlDoc *doc)
 	}
 	return ns_xsi;
 }
+
+struct oscap_xml_children_job {
+	xmlDocPtr doc;
+	xmlNode **placeholders;
+	size_t count;
+	size_t chunk;
+	oscap_xml_child_builder builder;
+	void *arg;
+};
+
+static void _oscap_xml_build_children_chunk(size_t index, void *arg)
+{
+	struct oscap_xml_children_job *job = arg;
+	size_t begin = index * job->chunk;
+	size_t end = begin + job->chunk < job->count ? begin + job->chunk : job->count;
+
+	for (size_t i = begin; i < end; i++)
+		job->builder(i, job->doc, job->placeholders[index], job->arg);
+}
+
+void oscap_xml_build_children_parallel(xmlDocPtr doc, xmlNode *parent, size_t count, oscap_xml_child_builder builder, void *arg)
+{
+	unsigned int threads = oscap_parallel_get_max_threads();
+	if (threads <= 1 || count < 2 * OSCAP_XML_PARALLEL_MIN_CHUNK) {
+		for (size_t i = 0; i < count; i++)
+			builder(i, doc, parent, arg);
+		return;
+	}
+
+	/* Use more chunks than threads, subtrees may differ in size a lot */
+	size_t chunk = (count + 4 * threads - 1) / (4 * threads);
+	if (chunk < OSCAP_XML_PARALLEL_MIN_CHUNK)
+		chunk = OSCAP_XML_PARALLEL_MIN_CHUNK;
+	size_t nchunks = (count + chunk - 1) / chunk;
+
+	/* Every chunk is built under its own placeholder node. The placeholder
+	 * points to the real parent, so that namespace look-ups work as usual,
+	 * but it isn't linked among the parent's children, so the threads never
+	 * touch the same node. */
+	xmlNode **placeholders = malloc(nchunks * sizeof(xmlNode *));
+	size_t created = 0;
+	if (placeholders != NULL) {
+		for (; created < nchunks; created++) {
+			placeholders[created] = xmlNewDocNode(doc, parent->ns, parent->name, NULL);
+			if (placeholders[created] == NULL)
+				break;
+			placeholders[created]->parent = parent;
+		}
+	}
+	if (created < nchunks) {
+		dW("Failed to allocate memory for parallel building of XML, building %zu subtrees serially.", count);
+		for (size_t i = 0; i < created; i++) {
+			placeholders[i]->parent = NULL;
+			xmlFreeNode(placeholders[i]);
+		}
+		free(placeholders);
+		for (size_t i = 0; i < count; i++)
+			builder(i, doc, parent, arg);
+		return;
+	}
+
+	struct oscap_xml_children_job job = {
+		.doc = doc,
+		.placeholders = placeholders,
+		.count = count,
+		.chunk = chunk,
+		.builder = builder,
+		.arg = arg,
+	};
+	oscap_parallel_run(nchunks, _oscap_xml_build_children_chunk, &job);
+
+	for (size_t i = 0; i < nchunks; i++) {
+		xmlNode *child = placeholders[i]->children;
+		while (child != NULL) {
+			xmlNode *next = child->next;
+			xmlUnlinkNode(child);
+			xmlAddChild(parent, child);
+			child = next;
+		}
+		placeholders[i]->parent = NULL;
+		xmlFreeNode(placeholders[i]);
+	}
+	free(placeholders);
+}
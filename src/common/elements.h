@@ -62,6 +62,8 @@ xmlNode *oscap_xmlstr_to_dom(xmlNode *parent, const char *elname, const char *co
 
 /**
  * Save XML Document to the file of the given filename.
+ * Files with ".gz" or ".zst" suffix are written compressed with gzip
+ * or zstd respectively, the compression is done while serializing.
  * @param filename path to the file
  * @param doc the XML document content
  * @return 1 on success, -1 on failure (oscap_seterr is set appropriatly).
@@ -78,4 +80,24 @@ int oscap_xml_save_filename_free(const char *filename, xmlDocPtr doc);
 
 xmlNs *lookup_xsi_ns(xmlDoc *doc);
 
+/**
+ * Function building the index-th subtree of a parent node.
+ */
+typedef void (*oscap_xml_child_builder)(size_t index, xmlDocPtr doc, xmlNode *parent, void *arg);
+
+/**
+ * Build children of a node on worker threads.
+ * The builder is called for each index in range [0, count) and the subtrees
+ * are appended to the parent in the order of their indices, so the document
+ * is identical to the one built sequentially. The builder may be called
+ * concurrently with a different placeholder parent, it must only add nodes
+ * under the parent it was given and must not modify the rest of the document.
+ * @param doc the XML document
+ * @param parent node to which the children are appended
+ * @param count number of subtrees to build
+ * @param builder function building a single subtree
+ * @param arg user data passed to the builder
+ */
+void oscap_xml_build_children_parallel(xmlDocPtr doc, xmlNode *parent, size_t count, oscap_xml_child_builder builder, void *arg);
+
 #endif
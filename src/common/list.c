@@ -372,121 +372,367 @@ OSCAP_ITERATOR_REMOVE(oscap_stringlist, oscap_stringlist_free)
     /*OSCAP_ITERATOR_RESET(oscap_string)*/
 
 
-#define OSCAP_DEFAULT_HSIZE 389
-static inline unsigned int oscap_htable_hash(const char *str, size_t htable_size)
+/*
+ * Hash table
+ *
+ * Items are stored in an array in the order of insertion, an open addressing
+ * index with linear probing maps hashes of keys to positions in that array.
+ * The index is kept at most 3/4 full and doubles its size when it would get
+ * fuller, detached items leave holes in the array which are squeezed out when
+ * the array is reallocated.
+ */
+
+#define OSCAP_HTABLE_MIN_SLOTS 8
+#define OSCAP_HTABLE_POOL_CHUNK 4096
+
+/*
+ * Keys of the hash table are hashed by a variant of wyhash, reading the string
+ * 8 bytes at a time and mixing them by 64x64->128 bit multiplication.
+ */
+static const uint64_t _wyp0 = 0xa0761d6478bd642full;
+static const uint64_t _wyp1 = 0xe7037ed1a0b428dbull;
+static const uint64_t _wyp2 = 0x8ebc6af09c88c6e3ull;
+
+static inline uint64_t _wymix(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+	__uint128_t r = (__uint128_t) a * b;
+	return (uint64_t) r ^ (uint64_t) (r >> 64);
+#else
+	uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t) a, lb = (uint32_t) b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32), c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	c += lo < t;
+	uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+	return lo ^ hi;
+#endif
+}
+
+static inline uint64_t _wyr8(const unsigned char *p)
 {
-	unsigned h = 0;
-	unsigned char *p;
-	for (p = (unsigned char *)str; *p != '\0'; p++)
-		h = (97 * h) + *p;
-	return h % htable_size;
+	uint64_t v;
+	memcpy(&v, p, 8);
+	return v;
 }
 
-struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize)
+static inline uint64_t _wyr4(const unsigned char *p)
+{
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static uint32_t oscap_htable_hash(const char *str)
 {
-	struct oscap_htable *t;
-    
-    assert(hsize > 0);
+	const unsigned char *p = (const unsigned char *) str;
+	size_t len = strlen(str);
+	uint64_t seed = _wyp0, a, b;
+
+	if (len <= 16) {
+		if (len >= 4) {
+			a = (_wyr4(p) << 32) | _wyr4(p + ((len >> 3) << 2));
+			b = (_wyr4(p + len - 4) << 32) | _wyr4(p + len - 4 - ((len >> 3) << 2));
+		} else if (len > 0) {
+			a = ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = len;
+		while (i > 16) {
+			seed = _wymix(_wyr8(p) ^ _wyp1, _wyr8(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		a = _wyr8(p + i - 16);
+		b = _wyr8(p + i - 8);
+	}
+	uint64_t h = _wymix(_wyp1 ^ len, _wymix(a ^ _wyp1, b ^ seed ^ _wyp2));
+	return (uint32_t) (h ^ (h >> 32));
+}
+
+struct oscap_htable_pool {
+	struct oscap_htable_pool *next;	// Previous, already full, chunk
+	size_t used;			// Bytes used in data
+	size_t size;			// Size of data
+	char data[];
+};
+
+static char *oscap_htable_pool_strdup(struct oscap_htable *htable, const char *key)
+{
+	size_t len = strlen(key) + 1;
+	struct oscap_htable_pool *pool = htable->pool;
+	if (pool == NULL || pool->size - pool->used < len) {
+		size_t size = len > OSCAP_HTABLE_POOL_CHUNK ? len : OSCAP_HTABLE_POOL_CHUNK;
+		pool = malloc(sizeof(struct oscap_htable_pool) + size);
+		if (pool == NULL)
+			return NULL;
+		pool->size = size;
+		pool->used = 0;
+		/* Keep the chunk with more free space in front */
+		if (htable->pool != NULL && size == len) {
+			pool->next = htable->pool->next;
+			htable->pool->next = pool;
+		} else {
+			pool->next = htable->pool;
+			htable->pool = pool;
+		}
+	}
+	char *copy = pool->data + pool->used;
+	memcpy(copy, key, len);
+	pool->used += len;
+	return copy;
+}
+
+static char *oscap_htable_key_new(struct oscap_htable *htable, const char *key)
+{
+	switch (htable->flags) {
+	case OSCAP_HTABLE_BORROW_KEYS:
+		return (char *) key;
+	case OSCAP_HTABLE_POOL_KEYS:
+		return oscap_htable_pool_strdup(htable, key);
+	default:
+		return oscap_strdup(key);
+	}
+}
+
+static void oscap_htable_key_free(struct oscap_htable *htable, char *key)
+{
+	if (htable->flags == OSCAP_HTABLE_COPY_KEYS)
+		free(key);
+}
 
-	t = malloc(sizeof(struct oscap_htable));
+static int oscap_htable_cmp(const char *s1, const char *s2)
+{
+	if (s1 == NULL)
+		return -1;
+	if (s2 == NULL)
+		return 1;
+	return strcmp(s1, s2);
+}
+
+static struct oscap_htable *oscap_htable_alloc(oscap_compare_func cmp, size_t hsize, int flags)
+{
+	struct oscap_htable *t = calloc(1, sizeof(struct oscap_htable));
 	if (t == NULL)
 		return NULL;
-	t->hsize = hsize;
-	t->itemcount = 0;
-	t->table = calloc(hsize, sizeof(struct oscap_htable_item *));
-	if (t->table == NULL) {
-		free(t);
-		return NULL;
-	}
 	t->cmp = cmp;
+	t->flags = flags;
+	if (hsize > 0) {
+		/* Reserve room for hsize items */
+		size_t slots = OSCAP_HTABLE_MIN_SLOTS;
+		while (slots / 4 * 3 < hsize)
+			slots *= 2;
+		t->slots = calloc(slots, sizeof(struct oscap_htable_slot));
+		t->table = malloc(hsize * sizeof(struct oscap_htable_item));
+		if (t->slots == NULL || t->table == NULL) {
+			free(t->slots);
+			free(t->table);
+			free(t);
+			return NULL;
+		}
+		t->hsize = slots;
+		t->tablecap = hsize;
+	}
 	return t;
 }
 
+struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize)
+{
+	return oscap_htable_alloc(cmp, hsize, OSCAP_HTABLE_COPY_KEYS);
+}
+
+struct oscap_htable *oscap_htable_new2(size_t hsize, int flags)
+{
+	return oscap_htable_alloc(oscap_htable_cmp, hsize, flags);
+}
+
+struct oscap_htable *oscap_htable_new(void)
+{
+	return oscap_htable_alloc(oscap_htable_cmp, 0, OSCAP_HTABLE_COPY_KEYS);
+}
+
 struct oscap_htable * oscap_htable_clone(const struct oscap_htable * table, oscap_clone_func cloner)
 {
-	struct oscap_htable *t = oscap_htable_new();
+	struct oscap_htable *t = oscap_htable_new1(table->cmp, table->itemcount);
 	if (t == NULL)
 		return NULL;
 
-	for (size_t i = 0; i < table->hsize; ++i) {
-		struct oscap_htable_item *item = table->table[i];
-		while (item != NULL) {
+	for (size_t i = 0; i < table->tablesize; ++i) {
+		const struct oscap_htable_item *item = &table->table[i];
+		if (item->key != NULL)
 			oscap_htable_add(t, item->key, (void *) cloner(item->value));
-			item = item->next;
-		}
 	}
-	
+
 	return t;
 }
 
-static int oscap_htable_cmp(const char *s1, const char *s2)
+/*
+ * Find the slot of the key. Returns the slot holding the key, or the empty
+ * slot where the key belongs when the key is not present.
+ */
+static struct oscap_htable_slot *oscap_htable_find_slot(struct oscap_htable *htable, const char *key, uint32_t hash)
+{
+	size_t mask = htable->hsize - 1;
+	size_t i = hash & mask;
+	for (;;) {
+		struct oscap_htable_slot *slot = &htable->slots[i];
+		if (slot->index == 0)
+			return slot;
+		if (slot->hash == hash && htable->cmp(htable->table[slot->index - 1].key, key) == 0)
+			return slot;
+		i = (i + 1) & mask;
+	}
+}
+
+static void oscap_htable_reindex(struct oscap_htable *htable)
 {
-	if (s1 == NULL)
-		return -1;
-	if (s2 == NULL)
-		return 1;
-	return strcmp(s1, s2);
+	size_t mask = htable->hsize - 1;
+	memset(htable->slots, 0, htable->hsize * sizeof(struct oscap_htable_slot));
+	for (size_t pos = 0; pos < htable->tablesize; ++pos) {
+		const char *key = htable->table[pos].key;
+		if (key == NULL)
+			continue;
+		uint32_t hash = oscap_htable_hash(key);
+		size_t i = hash & mask;
+		while (htable->slots[i].index != 0)
+			i = (i + 1) & mask;
+		htable->slots[i].hash = hash;
+		htable->slots[i].index = pos + 1;
+	}
 }
 
-struct oscap_htable *oscap_htable_new(void)
+/*
+ * Make room for one more item, growing the index and the array of items if needed.
+ */
+static bool oscap_htable_reserve(struct oscap_htable *htable)
 {
-	return oscap_htable_new1(oscap_htable_cmp, OSCAP_DEFAULT_HSIZE);
+	bool reindex = false;
+
+	if (htable->tablesize == htable->tablecap && htable->itemcount < htable->tablesize) {
+		/* Squeeze out detached items */
+		size_t used = 0;
+		for (size_t pos = 0; pos < htable->tablesize; ++pos) {
+			if (htable->table[pos].key != NULL)
+				htable->table[used++] = htable->table[pos];
+		}
+		htable->tablesize = used;
+		reindex = true;
+	}
+	if (htable->tablesize == htable->tablecap) {
+		size_t cap = htable->tablecap ? htable->tablecap * 2 : OSCAP_HTABLE_MIN_SLOTS / 4 * 3;
+		struct oscap_htable_item *table = realloc(htable->table, cap * sizeof(struct oscap_htable_item));
+		if (table == NULL)
+			return false;
+		htable->table = table;
+		htable->tablecap = cap;
+	}
+	if ((htable->itemcount + 1) * 4 > htable->hsize * 3) {
+		size_t hsize = htable->hsize ? htable->hsize * 2 : OSCAP_HTABLE_MIN_SLOTS;
+		struct oscap_htable_slot *slots = realloc(htable->slots, hsize * sizeof(struct oscap_htable_slot));
+		if (slots == NULL)
+			return false;
+		htable->slots = slots;
+		htable->hsize = hsize;
+		reindex = true;
+	}
+	if (reindex)
+		oscap_htable_reindex(htable);
+	return true;
 }
 
 static struct oscap_htable_item *oscap_htable_lookup(struct oscap_htable *htable, const char *key)
 {
 	__attribute__nonnull__(htable);
-	if (key == NULL)
+	if (key == NULL || htable->itemcount == 0)
 		return NULL;
-	unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
-	struct oscap_htable_item *htitem = htable->table[hashcode];
-	while (htitem != NULL) {
-		if (htable->cmp(htitem->key, key) == 0)
-			return htitem;
-		htitem = htitem->next;
-	}
-	return NULL;
+	struct oscap_htable_slot *slot = oscap_htable_find_slot(htable, key, oscap_htable_hash(key));
+	return slot->index ? &htable->table[slot->index - 1] : NULL;
 }
 
-bool oscap_htable_add(struct oscap_htable * htable, const char *key, void *item)
+static struct oscap_htable_item *oscap_htable_insert(struct oscap_htable *htable, const char *key, void *item, bool *added)
 {
 	__attribute__nonnull__(htable);
-	/*
-	   unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
-	   struct oscap_htable_item* htitem = htable->table[hashcode];
-	   while(htitem != NULL)
-	   {
-	   if( (*(htable->cmp))(htitem->key, key) == 0) return false;
-	   if(htitem->next == NULL) break;
-	   htitem = htitem->next;
-	   }
-	   // htitem points to the last item
-	 */
-	if (oscap_htable_lookup(htable, key) != NULL)
-		return false;
-	unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
-	struct oscap_htable_item *newhtitem;
-	newhtitem = malloc(sizeof(struct oscap_htable_item));
-	newhtitem->key = oscap_strdup(key);
+	uint32_t hash = oscap_htable_hash(key);
+	struct oscap_htable_slot *slot;
+
+	*added = false;
+	if (htable->itemcount > 0) {
+		slot = oscap_htable_find_slot(htable, key, hash);
+		if (slot->index != 0)
+			return &htable->table[slot->index - 1];
+	}
+	if (!oscap_htable_reserve(htable))
+		return NULL;
+	char *newkey = oscap_htable_key_new(htable, key);
+	if (newkey == NULL)
+		return NULL;
+	/* The index could have been rebuilt */
+	slot = oscap_htable_find_slot(htable, key, hash);
+	struct oscap_htable_item *newhtitem = &htable->table[htable->tablesize];
+	newhtitem->key = newkey;
 	newhtitem->value = item;
-	newhtitem->next = htable->table[hashcode];
-	htable->table[hashcode] = newhtitem;
+	slot->hash = hash;
+	slot->index = ++htable->tablesize;
 	htable->itemcount++;
-	return true;
+	*added = true;
+	return newhtitem;
+}
+
+bool oscap_htable_add(struct oscap_htable * htable, const char *key, void *item)
+{
+	bool added;
+	if (key == NULL)
+		return false;
+	oscap_htable_insert(htable, key, item, &added);
+	return added;
+}
+
+const char *oscap_htable_intern(struct oscap_htable *htable, const char *key)
+{
+	bool added;
+	if (key == NULL)
+		return NULL;
+	struct oscap_htable_item *htitem = oscap_htable_insert(htable, key, NULL, &added);
+	return htitem ? htitem->key : NULL;
 }
 
 void *oscap_htable_detach(struct oscap_htable *htable, const char *key)
 {
-	struct oscap_htable_item *htitem = oscap_htable_lookup(htable, key);
-	if (htitem) {
-		void *val = htitem->value;
-		free(htitem->key);
-		htitem->key = NULL;
-		htitem->value = NULL;
-		htable->itemcount--;
-		return val;
+	__attribute__nonnull__(htable);
+	if (key == NULL || htable->itemcount == 0)
+		return NULL;
+	struct oscap_htable_slot *slot = oscap_htable_find_slot(htable, key, oscap_htable_hash(key));
+	if (slot->index == 0)
+		return NULL;
+
+	struct oscap_htable_item *htitem = &htable->table[slot->index - 1];
+	void *val = htitem->value;
+	oscap_htable_key_free(htable, htitem->key);
+	htitem->key = NULL;
+	htitem->value = NULL;
+	htable->itemcount--;
+
+	/* Backward shift deletion, move following slots of the probe sequence back */
+	size_t mask = htable->hsize - 1;
+	size_t hole = slot - htable->slots;
+	size_t i = hole;
+	for (;;) {
+		i = (i + 1) & mask;
+		struct oscap_htable_slot *next = &htable->slots[i];
+		if (next->index == 0)
+			break;
+		size_t home = next->hash & mask;
+		/* Move the slot unless its home lies cyclically in (hole, i] */
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			htable->slots[hole] = *next;
+			hole = i;
+		}
 	}
-	return NULL;
+	htable->slots[hole].index = 0;
+	return val;
 }
 
 void *oscap_htable_get(struct oscap_htable *htable, const char *key)
@@ -505,36 +751,35 @@ void oscap_htable_dump(struct oscap_htable *htable, oscap_dump_func dumper, int
 		return;
 	}
 	printf(" (hash table, %u item%s)\n", (unsigned)htable->itemcount, (htable->itemcount == 1 ? "" : "s"));
-	int i;
-	for (i = 0; i < (int)htable->hsize; ++i) {
-		struct oscap_htable_item *item = htable->table[i];
-		while (item) {
-			oscap_print_depth(depth);
-			printf("'%s':\n", item->key);
-			dumper(item->value, depth + 1);
-			item = item->next;
-		}
+	for (size_t i = 0; i < htable->tablesize; ++i) {
+		struct oscap_htable_item *item = &htable->table[i];
+		if (item->key == NULL)
+			continue;
+		oscap_print_depth(depth);
+		printf("'%s':\n", item->key);
+		dumper(item->value, depth + 1);
 	}
 }
 
 void oscap_htable_free(struct oscap_htable *htable, oscap_destruct_func destructor)
 {
 	if (htable) {
-		size_t ht;
-		struct oscap_htable_item *cur, *next;
-
-		for (ht = 0; ht < htable->hsize; ++ht) {
-			cur = htable->table[ht];
-			while (cur) {
-				next = cur->next;
-				free(cur->key);
-				if (destructor)
-					destructor(cur->value);
-				free(cur);
-				cur = next;
-			}
+		for (size_t i = 0; i < htable->tablesize; ++i) {
+			struct oscap_htable_item *item = &htable->table[i];
+			if (item->key == NULL)
+				continue;
+			oscap_htable_key_free(htable, item->key);
+			if (destructor)
+				destructor(item->value);
 		}
 
+		struct oscap_htable_pool *pool = htable->pool;
+		while (pool != NULL) {
+			struct oscap_htable_pool *next = pool->next;
+			free(pool);
+			pool = next;
+		}
+		free(htable->slots);
 		free(htable->table);
 		free(htable);
 	}
@@ -547,8 +792,7 @@ void oscap_htable_free0(struct oscap_htable *htable)
 
 struct oscap_htable_iterator {
 	struct oscap_htable *htable;	// Table we iterate through
-	struct oscap_htable_item *cur;	// The current item
-	size_t hpos;			// Line on which we are now
+	size_t hpos;			// Position of the next item
 };
 
 struct oscap_htable_iterator *
@@ -556,7 +800,6 @@ oscap_htable_iterator_new(struct oscap_htable *htable)
 {
 	struct oscap_htable_iterator *hit = calloc(1, sizeof(struct oscap_htable_iterator));
 	hit->htable = htable;
-	hit->cur = NULL;
 	hit->hpos = 0;
 	return hit;
 }
@@ -567,48 +810,20 @@ oscap_htable_iterator_has_more(struct oscap_htable_iterator *hit)
 	__attribute__nonnull__(hit);
 	if (hit->htable == NULL)
 		return false;
-	size_t i = hit->hpos;
-	if (hit->cur != NULL) {
-		if (hit->cur->next != NULL)
-			return true;
-		if (i + 1 >= hit->htable->hsize)
-			return false;
-		i++;
-	}
-	for (; i < hit->htable->hsize; i++) {
-		if (hit->htable->table[i] == NULL)
-			continue;
-		if (i != hit->hpos)
-			hit->hpos = i - 1;
-		return true;
-	}
-	hit->hpos = i;
-	return false;
+	while (hit->hpos < hit->htable->tablesize && hit->htable->table[hit->hpos].key == NULL)
+		hit->hpos++;
+	return hit->hpos < hit->htable->tablesize;
 }
 
 const struct oscap_htable_item *
 oscap_htable_iterator_next(struct oscap_htable_iterator *hit)
 {
 	__attribute__nonnull__(hit);
-	if (hit->cur != NULL) {
-		if (hit->cur->next != NULL) {
-			hit->cur = hit->cur->next;
-			return hit->cur;
-		}
-		if (hit->hpos + 1 >= hit->htable->hsize) {
-			assert(false);
-			return NULL;
-		}
-		hit->hpos++;
-	}
-	for (; hit->hpos < hit->htable->hsize; hit->hpos++) {
-		if (hit->htable->table[hit->hpos] == NULL)
-			continue;
-		hit->cur = hit->htable->table[hit->hpos];
-		return hit->cur;
+	if (!oscap_htable_iterator_has_more(hit)) {
+		assert(false); // no more item found
+		return NULL;
 	}
-	assert(false); // no more item found
-	return NULL;
+	return &hit->htable->table[hit->hpos++];
 }
 
 const char *
@@ -639,7 +854,6 @@ void
 oscap_htable_iterator_reset(struct oscap_htable_iterator *hit)
 {
 	__attribute__nonnull__(hit);
-	hit->cur = NULL;
 	hit->hpos = 0;
 }
 
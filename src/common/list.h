@@ -30,6 +30,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "util.h"
 #include "public/oscap.h"
@@ -169,28 +170,58 @@ void *oscap_list_find(struct oscap_list *list, void *what, oscap_cmp_func compar
 typedef int (*oscap_compare_func) (const char *, const char *);
 // Hash table item.
 struct oscap_htable_item {
-	struct oscap_htable_item *next;	// Next item.
-	char *key;		// Item key.
+	char *key;		// Item key, NULL if the item has been detached.
 	void *value;		// Item value.
 };
 
+// Slot of the open addressing index.
+struct oscap_htable_slot {
+	uint32_t hash;		// Hash of the key.
+	uint32_t index;		// Position of the item in the table plus one, 0 marks an empty slot.
+};
+
+// Ownership of hash table keys.
+enum oscap_htable_flags {
+	OSCAP_HTABLE_COPY_KEYS = 0,	// Every key is duplicated and freed with the item (default).
+	OSCAP_HTABLE_BORROW_KEYS = 1,	// Keys are not copied, the caller keeps them alive while they are in the table.
+	OSCAP_HTABLE_POOL_KEYS = 2,	// Keys are copied into a pool owned by the table and released all at once.
+};
+
+struct oscap_htable_pool;
+
 // Hash table.
 struct oscap_htable {
-	size_t hsize;		// Size of the hash table.
+	size_t hsize;		// Number of index slots, a power of two or 0 before the first insertion.
 	size_t itemcount;	// Number of elements in the hash table.
-	struct oscap_htable_item **table;	// The table itself.
+	struct oscap_htable_slot *slots;	// Open addressing index (linear probing).
+	struct oscap_htable_item *table;	// Items in the order of insertion.
+	size_t tablesize;	// Used positions of the table, including detached items.
+	size_t tablecap;	// Allocated positions of the table.
 	oscap_compare_func cmp;	// Funcion used to compare keys (e.g. strcmp).
+	int flags;		// Ownership of keys, see enum oscap_htable_flags.
+	struct oscap_htable_pool *pool;	// Storage of keys for OSCAP_HTABLE_POOL_KEYS.
 };
 
 /*
  * Create a new hash table.
+ * The table grows automatically, hsize is only a hint of the expected number of items.
+ * Keys are hashed as strings, so the comparator has to consider two keys equal
+ * only when they are equal strings.
  * @param cmp Pointer to a function used as the key comparator.
- * @hsize Size of the hash table.
+ * @hsize Expected number of items, 0 if unknown.
  * @internal
  * @return new hash table
  */
 struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize);
 
+/*
+ * Create a new hash table with the given ownership of keys.
+ * @param hsize Expected number of items, 0 if unknown.
+ * @param flags Ownership of keys, see enum oscap_htable_flags.
+ * @return new hash table
+ */
+struct oscap_htable *oscap_htable_new2(size_t hsize, int flags);
+
 /*
  * Create a new hash table.
  *
@@ -219,8 +250,20 @@ bool oscap_htable_add(struct oscap_htable *htable, const char *key, void *item);
  */
 void *oscap_htable_get(struct oscap_htable *htable, const char *key);
 
+/*
+ * Remove an item from the hash table without destroying it.
+ * @return The item, NULL if item with specified key is not present in the hash table.
+ */
 void *oscap_htable_detach(struct oscap_htable *htable, const char *key);
 
+/*
+ * Intern a string: return the copy of the key stored in the hash table,
+ * adding the key with a NULL value first if it is not present yet.
+ * The returned string lives as long as the table (or until it is detached).
+ * @return Interned string, NULL if key is NULL.
+ */
+const char *oscap_htable_intern(struct oscap_htable *htable, const char *key);
+
 void oscap_htable_dump(struct oscap_htable *htable, oscap_dump_func dumper, int depth);
 
 /*
@@ -242,7 +285,7 @@ void oscap_htable_free0(struct oscap_htable *htable);
 struct oscap_htable_iterator;
 
 /**
- * Create new iterator through hash table. No ordering is defined for items.
+ * Create new iterator through hash table. Items are visited in the order of insertion.
  * @param htable Hash table to iterate through.
  * @return the iterator
  */
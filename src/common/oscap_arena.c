@@ -0,0 +1,163 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "oscap_arena.h"
+
+#define OSCAP_ARENA_CHUNK 65536
+/* Chunks are capped so that a wrong hint doesn't allocate gigabytes at once */
+#define OSCAP_ARENA_CHUNK_MAX (64 * 1024 * 1024)
+
+typedef union {
+	long double d;
+	long long l;
+	void *p;
+	void (*f)(void);
+} oscap_arena_align_t;
+
+struct oscap_arena_align_probe {
+	char c;
+	oscap_arena_align_t u;
+};
+
+#define OSCAP_ARENA_ALIGN offsetof(struct oscap_arena_align_probe, u)
+#define OSCAP_ARENA_ROUND(size) (((size) + OSCAP_ARENA_ALIGN - 1) & ~(OSCAP_ARENA_ALIGN - 1))
+
+struct oscap_arena_chunk {
+	struct oscap_arena_chunk *next;	// Previous, already used, chunk
+	size_t size;
+	size_t used;
+	oscap_arena_align_t data[];
+};
+
+struct oscap_arena {
+	struct oscap_arena_chunk *chunk;	// Chunk the objects are allocated from
+	size_t chunk_size;			// Size of new chunks
+	size_t used;
+};
+
+static struct oscap_arena_chunk *oscap_arena_chunk_new(size_t size)
+{
+	struct oscap_arena_chunk *chunk = malloc(sizeof(struct oscap_arena_chunk) + size);
+	if (chunk == NULL)
+		return NULL;
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+	return chunk;
+}
+
+struct oscap_arena *oscap_arena_new(size_t size_hint)
+{
+	struct oscap_arena *arena = malloc(sizeof(struct oscap_arena));
+	if (arena == NULL)
+		return NULL;
+	arena->chunk = NULL;
+	arena->chunk_size = OSCAP_ARENA_CHUNK;
+	arena->used = 0;
+	if (size_hint > 0)
+		oscap_arena_reserve(arena, size_hint);
+	return arena;
+}
+
+void oscap_arena_reserve(struct oscap_arena *arena, size_t size)
+{
+	if (arena == NULL)
+		return;
+	size = OSCAP_ARENA_ROUND(size);
+	if (size > OSCAP_ARENA_CHUNK_MAX)
+		size = OSCAP_ARENA_CHUNK_MAX;
+	if (arena->chunk != NULL && arena->chunk->size - arena->chunk->used >= size)
+		return;
+	if (size < arena->chunk_size)
+		size = arena->chunk_size;
+
+	struct oscap_arena_chunk *chunk = oscap_arena_chunk_new(size);
+	if (chunk == NULL)
+		return;
+	chunk->next = arena->chunk;
+	arena->chunk = chunk;
+}
+
+void *oscap_arena_alloc(struct oscap_arena *arena, size_t size)
+{
+	size = OSCAP_ARENA_ROUND(size);
+	struct oscap_arena_chunk *chunk = arena->chunk;
+	if (chunk == NULL || chunk->size - chunk->used < size) {
+		if (size > arena->chunk_size / 4) {
+			/* Big objects get a chunk of their own, the current
+			 * chunk is still used for the following objects */
+			chunk = oscap_arena_chunk_new(size);
+			if (chunk == NULL)
+				return NULL;
+			if (arena->chunk != NULL) {
+				chunk->next = arena->chunk->next;
+				arena->chunk->next = chunk;
+			} else {
+				arena->chunk = chunk;
+			}
+		} else {
+			chunk = oscap_arena_chunk_new(arena->chunk_size);
+			if (chunk == NULL)
+				return NULL;
+			chunk->next = arena->chunk;
+			arena->chunk = chunk;
+		}
+	}
+
+	void *ptr = (char *) chunk->data + chunk->used;
+	chunk->used += size;
+	arena->used += size;
+	return ptr;
+}
+
+char *oscap_arena_strdup(struct oscap_arena *arena, const char *str)
+{
+	if (str == NULL)
+		return NULL;
+	size_t len = strlen(str) + 1;
+	char *copy = oscap_arena_alloc(arena, len);
+	if (copy != NULL)
+		memcpy(copy, str, len);
+	return copy;
+}
+
+size_t oscap_arena_get_used(const struct oscap_arena *arena)
+{
+	return arena == NULL ? 0 : arena->used;
+}
+
+void oscap_arena_free(struct oscap_arena *arena)
+{
+	if (arena == NULL)
+		return;
+	struct oscap_arena_chunk *chunk = arena->chunk;
+	while (chunk != NULL) {
+		struct oscap_arena_chunk *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	free(arena);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef OSCAP_ARENA_H
+#define OSCAP_ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Arena of memory with bump allocation. Objects allocated from the arena
+ * can't be freed one by one, all of them are released at once together
+ * with the arena. The arena is not thread safe.
+ */
+struct oscap_arena;
+
+/*
+ * Create a new arena.
+ * @param size_hint Expected number of bytes allocated from the arena,
+ * 0 for the default size of a chunk.
+ */
+struct oscap_arena *oscap_arena_new(size_t size_hint);
+
+/*
+ * Allocate size bytes aligned for any type from the arena.
+ * The memory is not initialized.
+ * @return Allocated memory, NULL if the memory is exhausted.
+ */
+void *oscap_arena_alloc(struct oscap_arena *arena, size_t size);
+
+/*
+ * Copy the string into the arena.
+ * @return Copy of the string, NULL if str is NULL.
+ */
+char *oscap_arena_strdup(struct oscap_arena *arena, const char *str);
+
+/*
+ * Make sure the next size bytes can be allocated from a single chunk.
+ * Used to pre-size the arena when the number of objects is known.
+ */
+void oscap_arena_reserve(struct oscap_arena *arena, size_t size);
+
+/*
+ * Get the number of bytes allocated from the arena.
+ */
+size_t oscap_arena_get_used(const struct oscap_arena *arena);
+
+/*
+ * Release all the memory of the arena.
+ */
+void oscap_arena_free(struct oscap_arena *arena);
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#ifndef OS_WINDOWS
+#include <unistd.h>
+#endif
+
+#include "oscap_parallel.h"
+#include "debug_priv.h"
+#include "_error.h"
+
+/* Upper bound for OSCAP_MAX_THREADS, protects against typos like 10000 */
+#define OSCAP_PARALLEL_THREADS_LIMIT 256
+
+struct oscap_parallel_ctx {
+	pthread_mutex_t lock;
+	size_t next;
+	size_t count;
+	oscap_parallel_task_func task;
+	void *arg;
+	struct err_queue **errors;
+};
+
+/* Set in threads which are running tasks, nested runs are serial */
+static pthread_key_t _oscap_parallel_key;
+static pthread_once_t _oscap_parallel_once = PTHREAD_ONCE_INIT;
+
+static void _oscap_parallel_key_init(void)
+{
+	(void)pthread_key_create(&_oscap_parallel_key, NULL);
+}
+
+unsigned int oscap_parallel_get_max_threads(void)
+{
+	const char *env = getenv("OSCAP_MAX_THREADS");
+	if (env != NULL && *env != '\0') {
+		char *end = NULL;
+		errno = 0;
+		long value = strtol(env, &end, 10);
+		if (errno == 0 && *end == '\0' && value > 0) {
+			return value > OSCAP_PARALLEL_THREADS_LIMIT ? OSCAP_PARALLEL_THREADS_LIMIT : (unsigned int) value;
+		}
+		dW("Ignoring invalid value of OSCAP_MAX_THREADS: '%s'", env);
+	}
+#if defined(_SC_NPROCESSORS_ONLN)
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus > 0) {
+		return cpus > OSCAP_PARALLEL_THREADS_LIMIT ? OSCAP_PARALLEL_THREADS_LIMIT : (unsigned int) cpus;
+	}
+#endif
+	return 1;
+}
+
+static void *_oscap_parallel_worker(void *arg)
+{
+	struct oscap_parallel_ctx *ctx = arg;
+	void *nested = pthread_getspecific(_oscap_parallel_key);
+	/* Errors raised before the run stay with the calling thread */
+	struct err_queue *saved_errors = oscap_err_detach();
+
+	(void)pthread_setspecific(_oscap_parallel_key, ctx);
+	for (;;) {
+		pthread_mutex_lock(&ctx->lock);
+		size_t index = ctx->next;
+		if (index < ctx->count)
+			ctx->next++;
+		pthread_mutex_unlock(&ctx->lock);
+
+		if (index >= ctx->count)
+			break;
+		ctx->task(index, ctx->arg);
+		ctx->errors[index] = oscap_err_detach();
+	}
+	(void)pthread_setspecific(_oscap_parallel_key, nested);
+	oscap_err_attach(saved_errors);
+	return NULL;
+}
+
+void oscap_parallel_run(size_t count, oscap_parallel_task_func task, void *arg)
+{
+	if (count == 0)
+		return;
+
+	(void)pthread_once(&_oscap_parallel_once, _oscap_parallel_key_init);
+
+	size_t nthreads = oscap_parallel_get_max_threads();
+	if (nthreads > count)
+		nthreads = count;
+	if (pthread_getspecific(_oscap_parallel_key) != NULL)
+		nthreads = 1;
+
+	struct err_queue **errors = NULL;
+	/* The calling thread works too, so spawn one thread less */
+	pthread_t *threads = NULL;
+	if (nthreads > 1) {
+		errors = calloc(count, sizeof(struct err_queue *));
+		threads = malloc((nthreads - 1) * sizeof(pthread_t));
+		if (errors == NULL || threads == NULL) {
+			dW("Failed to allocate memory for worker threads, running %zu tasks serially.", count);
+			free(errors);
+			free(threads);
+			nthreads = 1;
+		}
+	}
+
+	if (nthreads <= 1) {
+		for (size_t i = 0; i < count; i++)
+			task(i, arg);
+		return;
+	}
+
+	struct oscap_parallel_ctx ctx = {
+		.next = 0,
+		.count = count,
+		.task = task,
+		.arg = arg,
+		.errors = errors,
+	};
+	pthread_mutex_init(&ctx.lock, NULL);
+
+	size_t started = 0;
+	for (; started < nthreads - 1; started++) {
+		if (pthread_create(&threads[started], NULL, _oscap_parallel_worker, &ctx) != 0) {
+			dW("Failed to create worker thread, continuing with %zu threads.", started + 1);
+			break;
+		}
+	}
+
+	_oscap_parallel_worker(&ctx);
+
+	for (size_t i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	/* Pass errors of the tasks to the caller in the order of the tasks */
+	for (size_t i = 0; i < count; i++)
+		oscap_err_attach(ctx.errors[i]);
+
+	free(ctx.errors);
+	free(threads);
+	pthread_mutex_destroy(&ctx.lock);
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef OSCAP_PARALLEL_H
+#define OSCAP_PARALLEL_H
+
+#include <stddef.h>
+
+/*
+ * Task executed by oscap_parallel_run(), index is in range [0, count)
+ */
+typedef void (*oscap_parallel_task_func)(size_t index, void *arg);
+
+/*
+ * Get the maximum number of threads used for parallel work.
+ * The value is taken from the OSCAP_MAX_THREADS environment variable
+ * and defaults to the number of online CPUs. The result is at least 1.
+ */
+unsigned int oscap_parallel_get_max_threads(void);
+
+/*
+ * Run task for every index in range [0, count) using at most
+ * oscap_parallel_get_max_threads() threads, the calling thread included.
+ * The tasks are started in increasing order of their index, but they may
+ * finish in any order. The function returns after all tasks have finished.
+ * If threads can't be created the remaining tasks run in the calling thread.
+ * Errors raised by the tasks are passed to the calling thread in the order
+ * of the task indexes. Runs nested in a task use only the thread of the task.
+ */
+void oscap_parallel_run(size_t count, oscap_parallel_task_func task, void *arg);
+
+#endif
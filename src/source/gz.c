@@ -0,0 +1,250 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <libxml/tree.h>
+#include <libxml/xmlIO.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef OS_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "gz_priv.h"
+#include "common/_error.h"
+
+#ifdef ZLIB_FOUND
+
+#include <zlib.h>
+
+#define GZ_CHUNK_SIZE 65536
+
+struct gz_input {
+	z_stream stream;
+	int fd;                 ///< Source file descriptor, -1 if reading from memory
+	unsigned char *chunk;   ///< Buffer for compressed data read from fd
+	bool member_end;        ///< The last inflate() finished a gzip member
+	bool eof;
+};
+
+static struct gz_input *gz_input_open(int fd, const char *buffer, size_t size)
+{
+	struct gz_input *gz = calloc(1, sizeof(struct gz_input));
+	gz->fd = fd;
+	if (fd != -1) {
+		gz->chunk = malloc(GZ_CHUNK_SIZE);
+	} else {
+		gz->stream.next_in = (Bytef *) buffer;
+		gz->stream.avail_in = size;
+	}
+	// 16 + MAX_WBITS makes zlib expect the gzip header and trailer
+	int ret = inflateInit2(&gz->stream, 16 + MAX_WBITS);
+	if (ret != Z_OK) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not initialize gzip decompression: %s", zError(ret));
+		free(gz->chunk);
+		free(gz);
+		return NULL;
+	}
+	return gz;
+}
+
+static int gz_input_fill(struct gz_input *gz)
+{
+	if (gz->fd == -1) {
+		return 0;
+	}
+	ssize_t size;
+	do {
+		size = read(gz->fd, gz->chunk, GZ_CHUNK_SIZE);
+	} while (size < 0 && errno == EINTR);
+	if (size < 0) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Could not read gzip data: %s", strerror(errno));
+		return -1;
+	}
+	gz->stream.next_in = gz->chunk;
+	gz->stream.avail_in = size;
+	return size;
+}
+
+// xmlInputReadCallback
+static int gz_input_read(struct gz_input *gz, char *buffer, int len)
+{
+	if (gz->eof || len < 1) {
+		return 0;
+	}
+	gz->stream.next_out = (Bytef *) buffer;
+	gz->stream.avail_out = len;
+	while (gz->stream.avail_out > 0) {
+		if (gz->stream.avail_in == 0) {
+			int size = gz_input_fill(gz);
+			if (size < 0) {
+				return -1;
+			}
+			if (size == 0) {
+				if (!gz->member_end) {
+					oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unexpected end of gzip data");
+					return -1;
+				}
+				gz->eof = true;
+				break;
+			}
+		}
+		if (gz->member_end) {
+			// Concatenated gzip members form a single stream (as with zcat)
+			inflateReset(&gz->stream);
+			gz->member_end = false;
+		}
+		int ret = inflate(&gz->stream, Z_NO_FLUSH);
+		if (ret == Z_STREAM_END) {
+			gz->member_end = true;
+		} else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not inflate gzip data: %s",
+					gz->stream.msg != NULL ? gz->stream.msg : zError(ret));
+			return -1;
+		}
+	}
+	return len - gz->stream.avail_out;
+}
+
+// xmlInputCloseCallback
+static int gz_input_close(void *context)
+{
+	struct gz_input *gz = context;
+	int ret = inflateEnd(&gz->stream);
+	free(gz->chunk);
+	free(gz);
+	return ret == Z_OK ? 0 : -1;
+}
+
+xmlDoc *gz_fd_read_doc(int fd)
+{
+	struct gz_input *gz = gz_input_open(fd, NULL, 0);
+	if (gz == NULL) {
+		return NULL;
+	}
+	return xmlReadIO((xmlInputReadCallback) gz_input_read, gz_input_close, gz, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+xmlDoc *gz_mem_read_doc(const char *buffer, size_t size)
+{
+	struct gz_input *gz = gz_input_open(-1, buffer, size);
+	if (gz == NULL) {
+		return NULL;
+	}
+	return xmlReadIO((xmlInputReadCallback) gz_input_read, gz_input_close, gz, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+struct gz_output {
+	z_stream stream;
+	xmlOutputBuffer *sink;          ///< Plain output buffer writing to the file descriptor
+	unsigned char chunk[GZ_CHUNK_SIZE];
+};
+
+static int gz_output_deflate(struct gz_output *gz, int flush)
+{
+	int ret;
+	do {
+		gz->stream.next_out = gz->chunk;
+		gz->stream.avail_out = GZ_CHUNK_SIZE;
+		ret = deflate(&gz->stream, flush);
+		if (ret == Z_STREAM_ERROR) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not deflate gzip data");
+			return -1;
+		}
+		int size = GZ_CHUNK_SIZE - gz->stream.avail_out;
+		if (size > 0 && xmlOutputBufferWrite(gz->sink, size, (const char *) gz->chunk) < 0) {
+			return -1;
+		}
+	} while (gz->stream.avail_out == 0);
+	return 0;
+}
+
+// xmlOutputWriteCallback
+static int gz_output_write(void *context, const char *buffer, int len)
+{
+	struct gz_output *gz = context;
+	gz->stream.next_in = (Bytef *) buffer;
+	gz->stream.avail_in = len;
+	if (gz_output_deflate(gz, Z_NO_FLUSH) != 0) {
+		return -1;
+	}
+	return len;
+}
+
+// xmlOutputCloseCallback
+static int gz_output_close(void *context)
+{
+	struct gz_output *gz = context;
+	int ret = gz_output_deflate(gz, Z_FINISH);
+	deflateEnd(&gz->stream);
+	if (xmlOutputBufferClose(gz->sink) < 0) {
+		ret = -1;
+	}
+	free(gz);
+	return ret;
+}
+
+xmlOutputBuffer *gz_fd_output_buffer(int fd)
+{
+	struct gz_output *gz = calloc(1, sizeof(struct gz_output));
+	int ret = deflateInit2(&gz->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+	if (ret != Z_OK) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not initialize gzip compression: %s", zError(ret));
+		free(gz);
+		return NULL;
+	}
+	gz->sink = xmlOutputBufferCreateFd(fd, NULL);
+	if (gz->sink == NULL) {
+		deflateEnd(&gz->stream);
+		free(gz);
+		return NULL;
+	}
+	xmlOutputBuffer *buff = xmlOutputBufferCreateIO(gz_output_write, gz_output_close, gz, NULL);
+	if (buff == NULL) {
+		gz_output_close(gz);
+	}
+	return buff;
+}
+
+#endif
+
+static const unsigned char magic_number[] = {0x1f, 0x8b};
+
+bool gz_memory_is_gzip(const char* memory, const size_t size)
+{
+	if (size < 2) {
+		return false; // Cannot read magic number
+	}
+	return ((unsigned char) memory[0] == magic_number[0]) && ((unsigned char) memory[1] == magic_number[1]);
+}
+
+bool gz_fd_is_gzip(int fd)
+{
+	char header[2];
+	ssize_t size = read(fd, header, sizeof(header));
+	lseek(fd, 0, SEEK_SET);
+	return size == sizeof(header) && gz_memory_is_gzip(header, size);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+#ifndef OSCAP_SOURCE_GZIP_H
+#define OSCAP_SOURCE_GZIP_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "common/public/oscap.h"
+#include "common/util.h"
+#include <libxml/tree.h>
+
+
+#ifdef ZLIB_FOUND
+
+/**
+ * Parse *.xml.gz file to XML DOM. The data are inflated while
+ * they are parsed, the whole uncompressed document is never
+ * held in memory.
+ * @param fd The file descriptor to gzip file
+ * @returns DOM representation of the file
+ */
+xmlDoc *gz_fd_read_doc(int fd);
+
+/**
+ * Parse gzipped memory to XML DOM.
+ * @param buffer data in memory to process (contains gzipped XML)
+ * @param size length of data
+ * @returns DOM representation of the data
+ */
+xmlDoc *gz_mem_read_doc(const char *buffer, size_t size);
+
+/**
+ * Create libxml2 output buffer which deflates everything written to it
+ * and writes the gzip stream to the given file descriptor. The stream
+ * is finished when the buffer is closed. The file descriptor is not
+ * closed.
+ * @param fd file descriptor opened for writing
+ * @returns output buffer or NULL on error
+ */
+xmlOutputBuffer *gz_fd_output_buffer(int fd);
+
+#endif // ZLIB_FOUND
+
+/**
+ * Recognize whether the file can be parsed by this
+ * gzip parser. Do not close the file.
+ * @param file descriptor to opened file
+ * @returns true if can be parsed.
+ */
+bool gz_fd_is_gzip(int fd);
+
+/**
+ * @brief Recognize whether the file can be parsed by this
+ * gzip parser
+ * @param memory Raw memory with file content
+ * @param size Size of memory
+ * @return true if can be parsed
+ */
+bool gz_memory_is_gzip(const char* memory, const size_t size);
+
+
+#endif // OSCAP_SOURCE_GZIP_H
@@ -50,6 +50,8 @@
 #include "OVAL/oval_parser_impl.h"
 #include "OVAL/public/oval_definitions.h"
 #include "source/bz2_priv.h"
+#include "source/gz_priv.h"
+#include "source/zst_priv.h"
 #include "source/schematron_priv.h"
 #include "source/validate_priv.h"
 #include "XCCDF/elements.h"
@@ -264,6 +266,18 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 				source->xml.doc = bz2_mem_read_doc(source->origin.memory, source->origin.memory_size);
 #else
 				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack bz2 from buffer memory '%s'. Please compile OpenSCAP with bz2 support.", oscap_source_readable_origin(source));
+#endif
+			} else if (gz_memory_is_gzip(source->origin.memory, source->origin.memory_size)) {
+#ifdef ZLIB_FOUND
+				source->xml.doc = gz_mem_read_doc(source->origin.memory, source->origin.memory_size);
+#else
+				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack gzip from buffer memory '%s'. Please compile OpenSCAP with zlib support.", oscap_source_readable_origin(source));
+#endif
+			} else if (zst_memory_is_zstd(source->origin.memory, source->origin.memory_size)) {
+#ifdef ZSTD_FOUND
+				source->xml.doc = zst_mem_read_doc(source->origin.memory, source->origin.memory_size);
+#else
+				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack zstd from buffer memory '%s'. Please compile OpenSCAP with zstd support.", oscap_source_readable_origin(source));
 #endif
 			} else
 			{
@@ -293,6 +307,20 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 #else
 					source->xml.doc = NULL;
 					oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack bz2 file '%s'. Please compile OpenSCAP with bz2 support.", oscap_source_readable_origin(source));
+#endif
+				} else if (gz_fd_is_gzip(fd)) {
+#ifdef ZLIB_FOUND
+					source->xml.doc = gz_fd_read_doc(fd);
+#else
+					source->xml.doc = NULL;
+					oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack gzip file '%s'. Please compile OpenSCAP with zlib support.", oscap_source_readable_origin(source));
+#endif
+				} else if (zst_fd_is_zstd(fd)) {
+#ifdef ZSTD_FOUND
+					source->xml.doc = zst_fd_read_doc(fd);
+#else
+					source->xml.doc = NULL;
+					oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack zstd file '%s'. Please compile OpenSCAP with zstd support.", oscap_source_readable_origin(source));
 #endif
 				} else
 				{
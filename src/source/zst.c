@@ -0,0 +1,256 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <libxml/tree.h>
+#include <libxml/xmlIO.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef OS_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "zst_priv.h"
+#include "common/_error.h"
+
+#ifdef ZSTD_FOUND
+
+#include <zstd.h>
+
+struct zst_input {
+	ZSTD_DCtx *dctx;
+	ZSTD_inBuffer in;
+	int fd;                 ///< Source file descriptor, -1 if reading from memory
+	void *chunk;            ///< Buffer for compressed data read from fd
+	size_t chunk_size;
+	size_t pending;         ///< Last ZSTD_decompressStream() hint, 0 when a frame is complete
+	bool eof;
+};
+
+static struct zst_input *zst_input_open(int fd, const char *buffer, size_t size)
+{
+	struct zst_input *zst = calloc(1, sizeof(struct zst_input));
+	zst->dctx = ZSTD_createDCtx();
+	if (zst->dctx == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not initialize zstd decompression");
+		free(zst);
+		return NULL;
+	}
+	zst->fd = fd;
+	if (fd != -1) {
+		zst->chunk_size = ZSTD_DStreamInSize();
+		zst->chunk = malloc(zst->chunk_size);
+	} else {
+		zst->in.src = buffer;
+		zst->in.size = size;
+	}
+	return zst;
+}
+
+static int zst_input_fill(struct zst_input *zst)
+{
+	if (zst->fd == -1) {
+		return 0;
+	}
+	ssize_t size;
+	do {
+		size = read(zst->fd, zst->chunk, zst->chunk_size);
+	} while (size < 0 && errno == EINTR);
+	if (size < 0) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Could not read zstd data: %s", strerror(errno));
+		return -1;
+	}
+	zst->in.src = zst->chunk;
+	zst->in.size = size;
+	zst->in.pos = 0;
+	return size;
+}
+
+// xmlInputReadCallback
+static int zst_input_read(struct zst_input *zst, char *buffer, int len)
+{
+	if (zst->eof || len < 1) {
+		return 0;
+	}
+	ZSTD_outBuffer out = { buffer, len, 0 };
+	while (out.pos < out.size) {
+		if (zst->in.pos == zst->in.size) {
+			int size = zst_input_fill(zst);
+			if (size < 0) {
+				return -1;
+			}
+			if (size == 0) {
+				if (zst->pending == 0) {
+					zst->eof = true;
+					break;
+				}
+				/* The decoder may still hold output of the last block */
+				size_t flushed = out.pos;
+				size_t ret = ZSTD_decompressStream(zst->dctx, &out, &zst->in);
+				if (ZSTD_isError(ret)) {
+					oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not decompress zstd data: %s", ZSTD_getErrorName(ret));
+					return -1;
+				}
+				zst->pending = ret;
+				if (ret != 0 && out.pos == flushed) {
+					oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unexpected end of zstd data");
+					return -1;
+				}
+				continue;
+			}
+		}
+		size_t ret = ZSTD_decompressStream(zst->dctx, &out, &zst->in);
+		if (ZSTD_isError(ret)) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not decompress zstd data: %s", ZSTD_getErrorName(ret));
+			return -1;
+		}
+		zst->pending = ret;
+	}
+	return out.pos;
+}
+
+// xmlInputCloseCallback
+static int zst_input_close(void *context)
+{
+	struct zst_input *zst = context;
+	ZSTD_freeDCtx(zst->dctx);
+	free(zst->chunk);
+	free(zst);
+	return 0;
+}
+
+xmlDoc *zst_fd_read_doc(int fd)
+{
+	struct zst_input *zst = zst_input_open(fd, NULL, 0);
+	if (zst == NULL) {
+		return NULL;
+	}
+	return xmlReadIO((xmlInputReadCallback) zst_input_read, zst_input_close, zst, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+xmlDoc *zst_mem_read_doc(const char *buffer, size_t size)
+{
+	struct zst_input *zst = zst_input_open(-1, buffer, size);
+	if (zst == NULL) {
+		return NULL;
+	}
+	return xmlReadIO((xmlInputReadCallback) zst_input_read, zst_input_close, zst, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
+struct zst_output {
+	ZSTD_CCtx *cctx;
+	xmlOutputBuffer *sink;          ///< Plain output buffer writing to the file descriptor
+	void *chunk;
+	size_t chunk_size;
+};
+
+static int zst_output_compress(struct zst_output *zst, ZSTD_inBuffer *in, ZSTD_EndDirective mode)
+{
+	size_t remaining;
+	do {
+		ZSTD_outBuffer out = { zst->chunk, zst->chunk_size, 0 };
+		remaining = ZSTD_compressStream2(zst->cctx, &out, in, mode);
+		if (ZSTD_isError(remaining)) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not compress zstd data: %s", ZSTD_getErrorName(remaining));
+			return -1;
+		}
+		if (out.pos > 0 && xmlOutputBufferWrite(zst->sink, out.pos, zst->chunk) < 0) {
+			return -1;
+		}
+	} while (mode == ZSTD_e_end ? remaining != 0 : in->pos < in->size);
+	return 0;
+}
+
+// xmlOutputWriteCallback
+static int zst_output_write(void *context, const char *buffer, int len)
+{
+	struct zst_output *zst = context;
+	ZSTD_inBuffer in = { buffer, len, 0 };
+	if (zst_output_compress(zst, &in, ZSTD_e_continue) != 0) {
+		return -1;
+	}
+	return len;
+}
+
+// xmlOutputCloseCallback
+static int zst_output_close(void *context)
+{
+	struct zst_output *zst = context;
+	ZSTD_inBuffer in = { NULL, 0, 0 };
+	int ret = zst_output_compress(zst, &in, ZSTD_e_end);
+	if (xmlOutputBufferClose(zst->sink) < 0) {
+		ret = -1;
+	}
+	ZSTD_freeCCtx(zst->cctx);
+	free(zst->chunk);
+	free(zst);
+	return ret;
+}
+
+xmlOutputBuffer *zst_fd_output_buffer(int fd)
+{
+	struct zst_output *zst = calloc(1, sizeof(struct zst_output));
+	zst->cctx = ZSTD_createCCtx();
+	if (zst->cctx == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not initialize zstd compression");
+		free(zst);
+		return NULL;
+	}
+	ZSTD_CCtx_setParameter(zst->cctx, ZSTD_c_checksumFlag, 1);
+	zst->sink = xmlOutputBufferCreateFd(fd, NULL);
+	if (zst->sink == NULL) {
+		ZSTD_freeCCtx(zst->cctx);
+		free(zst);
+		return NULL;
+	}
+	zst->chunk_size = ZSTD_CStreamOutSize();
+	zst->chunk = malloc(zst->chunk_size);
+	xmlOutputBuffer *buff = xmlOutputBufferCreateIO(zst_output_write, zst_output_close, zst, NULL);
+	if (buff == NULL) {
+		zst_output_close(zst);
+	}
+	return buff;
+}
+
+#endif
+
+static const unsigned char magic_number[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+bool zst_memory_is_zstd(const char* memory, const size_t size)
+{
+	if (size < sizeof(magic_number)) {
+		return false; // Cannot read magic number
+	}
+	return memcmp(memory, magic_number, sizeof(magic_number)) == 0;
+}
+
+bool zst_fd_is_zstd(int fd)
+{
+	char header[sizeof(magic_number)];
+	ssize_t size = read(fd, header, sizeof(header));
+	lseek(fd, 0, SEEK_SET);
+	return size == sizeof(header) && zst_memory_is_zstd(header, size);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+#ifndef OSCAP_SOURCE_ZSTD_H
+#define OSCAP_SOURCE_ZSTD_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "common/public/oscap.h"
+#include "common/util.h"
+#include <libxml/tree.h>
+
+
+#ifdef ZSTD_FOUND
+
+/**
+ * Parse *.xml.zst file to XML DOM. The data are decompressed while
+ * they are parsed, the whole uncompressed document is never
+ * held in memory.
+ * @param fd The file descriptor to zstd file
+ * @returns DOM representation of the file
+ */
+xmlDoc *zst_fd_read_doc(int fd);
+
+/**
+ * Parse zstd compressed memory to XML DOM.
+ * @param buffer data in memory to process (contains zstd compressed XML)
+ * @param size length of data
+ * @returns DOM representation of the data
+ */
+xmlDoc *zst_mem_read_doc(const char *buffer, size_t size);
+
+/**
+ * Create libxml2 output buffer which compresses everything written to it
+ * and writes the zstd frame to the given file descriptor. The stream
+ * is finished when the buffer is closed. The file descriptor is not
+ * closed.
+ * @param fd file descriptor opened for writing
+ * @returns output buffer or NULL on error
+ */
+xmlOutputBuffer *zst_fd_output_buffer(int fd);
+
+#endif // ZSTD_FOUND
+
+/**
+ * Recognize whether the file can be parsed by this
+ * zstd parser. Do not close the file.
+ * @param file descriptor to opened file
+ * @returns true if can be parsed.
+ */
+bool zst_fd_is_zstd(int fd);
+
+/**
+ * @brief Recognize whether the file can be parsed by this
+ * zstd parser
+ * @param memory Raw memory with file content
+ * @param size Size of memory
+ * @return true if can be parsed
+ */
+bool zst_memory_is_zstd(const char* memory, const size_t size);
+
+
+#endif // OSCAP_SOURCE_ZSTD_H
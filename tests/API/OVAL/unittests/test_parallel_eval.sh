@@ -0,0 +1,53 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# Tests are evaluated by several threads and items of big tests are compared
+# in parallel. The results have to be the same as with a single thread.
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -d -t ${name}.XXXXXX)
+definitions=$tmpdir/$name.oval.xml
+syschar=$tmpdir/syschar.xml
+stderr=$(mktemp ${name}.err.XXXXXX)
+
+seq -f "value %g" 1 6000 > $tmpdir/values
+sed "s|@TMPDIR@|$tmpdir|" $srcdir/$name.oval.xml > $definitions
+
+for threads in 1 4; do
+	result=$tmpdir/results-$threads.xml
+	OSCAP_MAX_THREADS=$threads $OSCAP oval eval --results $result $definitions 2> $stderr
+	[ ! -s $stderr ]
+
+	assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"][@result="true"]'
+	assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:2"][@result="true"]'
+	assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:3"][@result="false"]'
+	assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"][@result="true"]'
+	assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:2"][@result="false"]'
+	assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:3"][@result="true"]'
+	assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:4"][@result="false"]'
+	assert_exists 6000 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/tested_item[@result="true"]'
+	assert_exists 5999 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:2"]/tested_item[@result="true"]'
+	assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:3"]/tested_item[@result="true"]'
+	assert_exists 111 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:4"]/tested_item[@result="true"]'
+	# Mask of the state is copied to the items shared by all the tests
+	assert_exists 6000 '/oval_results/results/system/oval_system_characteristics/system_data/*/*[local-name()="subexpression"][@mask="true"]'
+done
+# Item ids differ between runs
+normalize() {
+	grep -v "timestamp" $1 | sed -E 's/(id|item_ref)="[0-9]+"/\1=""/g'
+}
+diff <(normalize $tmpdir/results-1.xml) <(normalize $tmpdir/results-4.xml)
+
+# Evaluation of collected system characteristics
+OSCAP_MAX_THREADS=1 $OSCAP oval collect --syschar $syschar $definitions 2> $stderr
+[ ! -s $stderr ]
+result=$tmpdir/results-analyse.xml
+OSCAP_MAX_THREADS=4 $OSCAP oval analyse --results $result $definitions $syschar 2> $stderr
+[ ! -s $stderr ]
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:3"][@result="false"]'
+assert_exists 6000 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/tested_item[@result="true"]'
+assert_exists 111 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:4"]/tested_item[@result="true"]'
+
+rm -rf $tmpdir $stderr
@@ -0,0 +1,72 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# Results exported by several threads must be identical to the ones
+# exported sequentially. The content is generated, it needs to be large
+# enough to be split among the threads.
+
+name=$(basename $0 .sh)
+workdir=$(mktemp -d ${name}.XXXXXX)
+echo "work dir: $workdir"
+count=400
+
+oval=$workdir/$name.oval.xml
+{
+	echo '<?xml version="1.0" encoding="UTF-8"?>'
+	echo '<oval_definitions xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:ind="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">'
+	echo '<generator><oval:schema_version>5.10.1</oval:schema_version><oval:timestamp>2020-01-01T00:00:00</oval:timestamp></generator>'
+	echo '<definitions>'
+	for i in $(seq 1 $count); do
+		echo "<definition class=\"compliance\" id=\"oval:x:def:$i\" version=\"1\"><metadata><title>def $i</title><description>def $i</description></metadata>"
+		echo "<criteria operator=\"OR\"><criterion test_ref=\"oval:x:tst:$i\"/><criterion test_ref=\"oval:x:tst:$(( i % 7 + 1 ))\" negate=\"true\"/></criteria></definition>"
+	done
+	echo '</definitions><tests>'
+	for i in $(seq 1 $count); do
+		echo "<ind:variable_test check=\"all\" check_existence=\"at_least_one_exists\" comment=\"test $i\" id=\"oval:x:tst:$i\" version=\"1\"><ind:object object_ref=\"oval:x:obj:$i\"/><ind:state state_ref=\"oval:x:ste:1\"/></ind:variable_test>"
+	done
+	echo '</tests><objects>'
+	for i in $(seq 1 $count); do
+		echo "<ind:variable_object id=\"oval:x:obj:$i\" version=\"1\"><ind:var_ref>oval:x:var:$i</ind:var_ref></ind:variable_object>"
+	done
+	echo '</objects><states>'
+	echo '<ind:variable_state id="oval:x:ste:1" version="1"><ind:value operation="pattern match">^[0-9]*[02468]$</ind:value></ind:variable_state>'
+	echo '</states><variables>'
+	for i in $(seq 1 $count); do
+		echo "<constant_variable id=\"oval:x:var:$i\" version=\"1\" datatype=\"string\" comment=\"var $i\"><value>$i</value></constant_variable>"
+	done
+	echo '</variables></oval_definitions>'
+} > $oval
+
+syschar=$workdir/$name.syschar.xml
+{
+	echo '<?xml version="1.0" encoding="UTF-8"?>'
+	echo '<oval_system_characteristics xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:ind-sys="http://oval.mitre.org/XMLSchema/oval-system-characteristics-5#independent" xmlns="http://oval.mitre.org/XMLSchema/oval-system-characteristics-5">'
+	echo '<generator><oval:schema_version>5.10.1</oval:schema_version><oval:timestamp>2020-01-01T00:00:00</oval:timestamp></generator>'
+	echo '<system_info><os_name>Linux</os_name><os_version>1</os_version><architecture>x86_64</architecture><primary_host_name>localhost</primary_host_name><interfaces/></system_info>'
+	echo '<collected_objects>'
+	for i in $(seq 1 $count); do
+		echo "<object id=\"oval:x:obj:$i\" version=\"1\" flag=\"complete\"><reference item_ref=\"$i\"/></object>"
+	done
+	echo '</collected_objects><system_data>'
+	for i in $(seq 1 $count); do
+		echo "<ind-sys:variable_item id=\"$i\" status=\"exists\"><ind-sys:var_ref>oval:x:var:$i</ind-sys:var_ref><ind-sys:value>$i</ind-sys:value></ind-sys:variable_item>"
+	done
+	echo '</system_data></oval_system_characteristics>'
+} > $syschar
+
+for threads in 1 4; do
+	stderr=$workdir/stderr.$threads
+	OSCAP_MAX_THREADS=$threads $OSCAP oval analyse --skip-valid --results $workdir/results.$threads.xml $oval $syschar 2> $stderr
+	[ -f $stderr ]; [ ! -s $stderr ]
+done
+
+result=$workdir/results.4.xml
+assert_exists $count '/oval_results/results/system/definitions/definition'
+assert_exists $(( count / 2 )) '/oval_results/results/system/tests/test[@result="true"]'
+assert_exists $count '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:variable_item'
+
+diff <(grep -v "<oval:timestamp>" $workdir/results.1.xml) <(grep -v "<oval:timestamp>" $workdir/results.4.xml)
+
+rm -rf $workdir
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# Set objects and filters over collections of many items
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -d -t ${name}.XXXXXX)
+definitions=$tmpdir/$name.oval.xml
+result=$tmpdir/results.xml
+stderr=$(mktemp ${name}.err.XXXXXX)
+
+seq -f "value %g" 1 6000 > $tmpdir/values
+sed "s|@TMPDIR@|$tmpdir|" $srcdir/$name.oval.xml > $definitions
+
+$OSCAP oval eval --results $result $definitions 2> $stderr
+! grep -i "error" $stderr
+
+objects='/oval_results/results/system/oval_system_characteristics/collected_objects/object'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"][@result="true"]'
+assert_exists 6000 $objects'[@id="oval:x:obj:1"]/reference'
+assert_exists 5400 $objects'[@id="oval:x:obj:2"]/reference'
+assert_exists 6000 $objects'[@id="oval:x:obj:3"]/reference'
+assert_exists 600 $objects'[@id="oval:x:obj:4"]/reference'
+assert_exists 1000 $objects'[@id="oval:x:obj:5"]/reference'
+assert_exists 0 $objects'[@id="oval:x:obj:4"]/reference[@item_ref='$objects'[@id="oval:x:obj:2"]/reference/@item_ref]'
+
+rm -rf $tmpdir $stderr
@@ -0,0 +1,43 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# With OSCAP_OVAL_SHORT_CIRCUIT=1 criteria are skipped once the result of
+# their parent is decided. Tests of the skipped criteria are not evaluated
+# and their objects are not collected.
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+stderr=$(mktemp ${name}.err.XXXXXX)
+
+defs='/oval_results/results/system/definitions/definition'
+tests='/oval_results/results/system/tests/test'
+objects='/oval_results/results/system/oval_system_characteristics/collected_objects/object'
+
+assert_definitions() {
+	assert_exists 1 $defs'[@definition_id="oval:x:def:1"][@result="false"]'
+	assert_exists 1 $defs'[@definition_id="oval:x:def:2"][@result="true"]'
+	assert_exists 1 $defs'[@definition_id="oval:x:def:3"][@result="true"]'
+	assert_exists 1 $defs'[@definition_id="oval:x:def:4"][@result="true"]'
+}
+
+$OSCAP oval eval --results $result $srcdir/$name.oval.xml 2> $stderr
+[ ! -s $stderr ]
+assert_definitions
+assert_exists 6 $objects
+assert_exists 0 $tests'[@result="not evaluated"]'
+
+OSCAP_OVAL_SHORT_CIRCUIT=1 $OSCAP oval eval --results $result $srcdir/$name.oval.xml 2> $stderr
+[ ! -s $stderr ]
+assert_definitions
+assert_exists 4 $objects
+assert_exists 0 $objects'[@id="oval:x:obj:2" or @id="oval:x:obj:4"]'
+assert_exists 1 $tests'[@test_id="oval:x:tst:2"][@result="not evaluated"]'
+assert_exists 1 $tests'[@test_id="oval:x:tst:4"][@result="not evaluated"]'
+assert_exists 1 $tests'[@test_id="oval:x:tst:5"][@result="true"]'
+assert_exists 1 $tests'[@test_id="oval:x:tst:6"][@result="true"]'
+assert_exists 1 $defs'[@definition_id="oval:x:def:1"]/criteria/criterion[@test_ref="oval:x:tst:2"][@result="not evaluated"]'
+assert_exists 1 $defs'[@definition_id="oval:x:def:3"]/criteria/criteria/criterion[@test_ref="oval:x:tst:5"][@result="true"]'
+
+rm $result $stderr
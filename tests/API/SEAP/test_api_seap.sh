@@ -40,10 +40,13 @@ if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "test_api_seap_concurency"           test_api_seap_concurency
     test_run "test_api_seap_spb"                  ./test_api_seap_spb
     test_run "test_api_seap_list"                 ./test_api_seap_list
+    test_run "test_api_seap_alloc"                ./test_api_seap_alloc
     test_run "test_api_seap_number_expression"    ./test_api_seap_number
     test_run "test_api_seap_string_expression"    ./test_api_seap_string
     test_run "test_api_SEXP_deepcmp"              ./test_api_SEXP_deepcmp
     test_run "test_api_strto"                     ./test_api_strto
+    # Keep the run short, the full benchmark is ./test_api_seap_bench 100000
+    test_run "test_api_seap_bench"                ./test_api_seap_bench 1000
 fi
 
 test_exit
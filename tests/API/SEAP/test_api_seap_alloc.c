@@ -0,0 +1,158 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "_sexp-alloc.h"
+#include "oscap_assert.h"
+
+#define OBJ_COUNT 20000
+#define OBJ_SIZE(i) (1 + (i) * 7 % 700)
+
+static void *objs[OBJ_COUNT];
+
+static uint64_t slab_count(void)
+{
+	uint64_t count = 0;
+	for (size_t i = 0; i < OBJ_COUNT; i++) {
+		if (OBJ_SIZE(i) <= SEXP_SLAB_MAXOBJ)
+			count++;
+	}
+	return count;
+}
+
+static void fill(size_t from, size_t step)
+{
+	for (size_t i = from; i < OBJ_COUNT; i += step) {
+		objs[i] = SEXP_alloc(OBJ_SIZE(i));
+		oscap_assert(objs[i] != NULL);
+		oscap_assert(((uintptr_t)objs[i] & (sizeof(void *) - 1)) == 0);
+		memset(objs[i], i & 0xff, OBJ_SIZE(i));
+	}
+}
+
+static void check_and_free(size_t from, size_t step)
+{
+	for (size_t i = from; i < OBJ_COUNT; i += step) {
+		const unsigned char *p = objs[i];
+		for (size_t j = 0; j < OBJ_SIZE(i); j++)
+			oscap_assert(p[j] == (i & 0xff));
+		SEXP_dealloc(objs[i], OBJ_SIZE(i));
+		objs[i] = NULL;
+	}
+}
+
+static pthread_barrier_t barrier;
+
+static void *fill_thread(void *arg)
+{
+	fill(0, 1);
+	return NULL;
+}
+
+static void *fill_wait_thread(void *arg)
+{
+	fill(0, 1);
+	pthread_barrier_wait(&barrier);
+	/* The objects are freed by another thread now */
+	pthread_barrier_wait(&barrier);
+	return NULL;
+}
+
+static void *free_thread(void *arg)
+{
+	check_and_free(0, 1);
+	return NULL;
+}
+
+static void test_local(void)
+{
+	struct SEXP_alloc_stats stats;
+
+	fill(0, 1);
+	check_and_free(1, 2);
+	fill(1, 2);
+	check_and_free(0, 1);
+
+	SEXP_alloc_stats(&stats);
+	oscap_assert(stats.live == 0);
+	oscap_assert(stats.reused > 0);
+	oscap_assert(stats.allocated > stats.reused);
+}
+
+static void test_remote(void)
+{
+	struct SEXP_alloc_stats stats;
+	pthread_t thread, owner;
+
+	/* Objects of an exited thread are freed directly */
+	oscap_assert(pthread_create(&thread, NULL, fill_thread, NULL) == 0);
+	oscap_assert(pthread_join(thread, NULL) == 0);
+	oscap_assert(pthread_create(&thread, NULL, free_thread, NULL) == 0);
+	oscap_assert(pthread_join(thread, NULL) == 0);
+	SEXP_alloc_stats(&stats);
+	oscap_assert(stats.live == 0);
+
+	/* Objects of a running thread are returned to it */
+	oscap_assert(pthread_barrier_init(&barrier, NULL, 2) == 0);
+	oscap_assert(pthread_create(&owner, NULL, fill_wait_thread, NULL) == 0);
+	pthread_barrier_wait(&barrier);
+	oscap_assert(pthread_create(&thread, NULL, free_thread, NULL) == 0);
+	oscap_assert(pthread_join(thread, NULL) == 0);
+	/* They are counted when the owner takes them back */
+	SEXP_alloc_stats(&stats);
+	oscap_assert(stats.live == slab_count());
+	pthread_barrier_wait(&barrier);
+	oscap_assert(pthread_join(owner, NULL) == 0);
+	oscap_assert(pthread_barrier_destroy(&barrier) == 0);
+	SEXP_alloc_stats(&stats);
+	oscap_assert(stats.live == 0);
+}
+
+static void test_realloc(void)
+{
+	size_t sizes[] = { 8, 20, 100, 512, 513, 2000, 300, 24 };
+	size_t size = 4;
+	unsigned char *ptr = SEXP_alloc(size);
+
+	memset(ptr, 0xab, size);
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		ptr = SEXP_realloc(ptr, size, sizes[i]);
+		oscap_assert(ptr != NULL);
+		for (size_t j = 0; j < 4; j++)
+			oscap_assert(ptr[j] == 0xab);
+		size = sizes[i];
+	}
+	SEXP_dealloc(ptr, size);
+}
+
+int main(void)
+{
+	test_local();
+	test_remote();
+	test_realloc();
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+/*
+ * Microbenchmark of S-exp lists. Measures appending, random access,
+ * iteration and deep comparison of lists with growing numbers of
+ * members. Copies and rests of the lists are checked along the way
+ * because they share the members with the original list.
+ *
+ * Usage: test_api_seap_bench [max_items]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sexp.h>
+#include "oscap_assert.h"
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static SEXP_t *bench_append(uint32_t n, double *ns)
+{
+	SEXP_t *list = SEXP_list_new(NULL);
+	double t0 = now();
+	for (uint32_t i = 0; i < n; i++) {
+		SEXP_t *num = SEXP_number_newu_32(i);
+		SEXP_list_add(list, num);
+		SEXP_free(num);
+	}
+	*ns = (now() - t0) / n;
+	oscap_assert(SEXP_list_length(list) == n);
+	return list;
+}
+
+static double bench_nth(const SEXP_t *list, uint32_t n)
+{
+	uint32_t idx = 0;
+	double t0 = now();
+	for (uint32_t i = 0; i < n; i++) {
+		/* Pseudo random order, the step is a prime */
+		idx = (idx + 7919) % n;
+		SEXP_t *num = SEXP_list_nth(list, idx + 1);
+		oscap_assert(SEXP_number_getu_32(num) == idx);
+		SEXP_free(num);
+	}
+	return (now() - t0) / n;
+}
+
+static double bench_iterate(const SEXP_t *list, uint32_t n)
+{
+	SEXP_t *num;
+	uint32_t i = 0;
+	double t0 = now();
+	SEXP_list_it *it = SEXP_list_it_new(list);
+	while ((num = SEXP_list_it_next(it)) != NULL)
+		oscap_assert(SEXP_number_getu_32(num) == i++);
+	SEXP_list_it_free(it);
+	oscap_assert(i == n);
+	i = 0;
+	SEXP_list_foreach(num, list)
+		oscap_assert(SEXP_number_getu_32(num) == i++);
+	oscap_assert(i == n);
+	return (now() - t0) / (2 * n);
+}
+
+static double bench_deepcmp(const SEXP_t *list, uint32_t n)
+{
+	double ns;
+	SEXP_t *other = bench_append(n, &ns);
+	double t0 = now();
+	oscap_assert(SEXP_deepcmp(list, other));
+	double t1 = now();
+	SEXP_free(other);
+
+	/* The joined list shares the members with the original list until it's modified */
+	SEXP_t *empty = SEXP_list_new(NULL);
+	SEXP_t *copy = SEXP_list_join(list, empty);
+	SEXP_free(empty);
+	SEXP_t *num = SEXP_number_newu_32(n);
+	SEXP_list_add(copy, num);
+	SEXP_free(num);
+	oscap_assert(!SEXP_deepcmp(list, copy));
+	oscap_assert(SEXP_list_length(list) == n);
+
+	SEXP_t *rest = SEXP_list_rest(copy);
+	oscap_assert(SEXP_list_length(rest) == n);
+	num = SEXP_list_pop(copy);
+	oscap_assert(SEXP_number_getu_32(num) == 0);
+	SEXP_free(num);
+	oscap_assert(SEXP_deepcmp(rest, copy));
+	num = SEXP_list_last(rest);
+	oscap_assert(SEXP_number_getu_32(num) == n);
+	SEXP_free(num);
+
+	SEXP_free(rest);
+	SEXP_free(copy);
+	return (t1 - t0) / n;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t max = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+
+	printf("%9s %12s %12s %12s %12s\n", "items", "append ns", "nth ns", "iterate ns", "deepcmp ns");
+	for (uint32_t n = 10; n <= max; n *= 100) {
+		double append;
+		SEXP_t *list = bench_append(n, &append);
+		double nth = bench_nth(list, n);
+		double iterate = bench_iterate(list, n);
+		double deepcmp = bench_deepcmp(list, n);
+		printf("%9u %12.1f %12.1f %12.1f %12.1f\n", n, append, nth, iterate, deepcmp);
+		SEXP_free(list);
+	}
+
+	return 0;
+}
@@ -28,6 +28,7 @@
 #include <string.h>
 #include "common/list.h"
 #include "common/util.h"
+#include "common/oscap_arena.h"
 #include "oscap_assert.h"
 
 #define SEEN_LEN 9
@@ -314,6 +315,116 @@ static void _test_list_remove(void)
 	oscap_list_free(list, NULL);
 }
 
+static void _test_htable_grow_and_detach(int flags)
+{
+	char key[16];
+	struct oscap_htable *h = oscap_htable_new2(0, flags);
+	char **keys = calloc(10000, sizeof(char *));
+	for (long i = 0; i < 10000; i++) {
+		snprintf(key, sizeof(key), "key-%ld", i);
+		keys[i] = strdup(key);
+		oscap_assert(oscap_htable_add(h, keys[i], (void *) (i + 1)));
+		oscap_assert(!oscap_htable_add(h, keys[i], NULL));
+	}
+	oscap_assert(h->itemcount == 10000);
+	for (long i = 0; i < 10000; i++) {
+		snprintf(key, sizeof(key), "key-%ld", i);
+		oscap_assert(oscap_htable_get(h, key) == (void *) (i + 1));
+	}
+	oscap_assert(oscap_htable_get(h, "key-10000") == NULL);
+
+	// remove every odd item, the rest has to stay reachable
+	for (long i = 1; i < 10000; i += 2) {
+		snprintf(key, sizeof(key), "key-%ld", i);
+		oscap_assert(oscap_htable_detach(h, key) == (void *) (i + 1));
+		oscap_assert(oscap_htable_detach(h, key) == NULL);
+	}
+	oscap_assert(h->itemcount == 5000);
+	for (long i = 0; i < 10000; i++) {
+		snprintf(key, sizeof(key), "key-%ld", i);
+		oscap_assert(oscap_htable_get(h, key) == (i % 2 ? NULL : (void *) (i + 1)));
+	}
+
+	// iteration skips detached items and keeps the order of insertion
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(h);
+	long expected = 0;
+	while (oscap_htable_iterator_has_more(hit)) {
+		const struct oscap_htable_item *item = oscap_htable_iterator_next(hit);
+		oscap_assert(item->value == (void *) (expected + 1));
+		expected += 2;
+	}
+	oscap_assert(expected == 10000);
+	oscap_htable_iterator_free(hit);
+
+	// re-adding reuses the holes
+	for (long i = 1; i < 10000; i += 2) {
+		oscap_assert(oscap_htable_add(h, keys[i], (void *) (i + 1)));
+	}
+	for (long i = 0; i < 10000; i++) {
+		oscap_assert(oscap_htable_get(h, keys[i]) == (void *) (i + 1));
+	}
+	oscap_htable_free0(h);
+	for (int i = 0; i < 10000; i++)
+		free(keys[i]);
+	free(keys);
+}
+
+static void _test_htable_intern(void)
+{
+	struct oscap_htable *h = oscap_htable_new2(0, OSCAP_HTABLE_POOL_KEYS);
+	char buf[32];
+	strcpy(buf, "interned string");
+	const char *first = oscap_htable_intern(h, buf);
+	oscap_assert(first != buf);
+	oscap_assert(strcmp(first, "interned string") == 0);
+	oscap_assert(oscap_htable_intern(h, "interned string") == first);
+	oscap_assert(oscap_htable_intern(h, "other string") != first);
+	oscap_assert(oscap_htable_intern(h, NULL) == NULL);
+	oscap_assert(h->itemcount == 2);
+	oscap_htable_free0(h);
+}
+
+static void _test_arena(void)
+{
+	struct oscap_arena *arena = oscap_arena_new(0);
+	char *strings[1000];
+	char buf[32];
+
+	// objects survive allocation of many more objects and are aligned
+	for (int i = 0; i < 1000; i++) {
+		snprintf(buf, sizeof(buf), "string-%d", i);
+		strings[i] = oscap_arena_strdup(arena, buf);
+		oscap_assert(strings[i] != NULL);
+		long long *number = oscap_arena_alloc(arena, sizeof(long long));
+		oscap_assert(((size_t) number) % sizeof(long long) == 0);
+		*number = i;
+	}
+	// big objects don't waste the current chunk
+	size_t used = oscap_arena_get_used(arena);
+	char *big = oscap_arena_alloc(arena, 1024 * 1024);
+	memset(big, 'x', 1024 * 1024);
+	oscap_assert(oscap_arena_get_used(arena) >= used + 1024 * 1024);
+	for (int i = 0; i < 1000; i++) {
+		snprintf(buf, sizeof(buf), "string-%d", i);
+		oscap_assert(strcmp(strings[i], buf) == 0);
+	}
+	oscap_assert(oscap_arena_strdup(arena, NULL) == NULL);
+	oscap_arena_free(arena);
+
+	// pre-sized arena allocates the objects from one block
+	arena = oscap_arena_new(100 * 1024);
+	char *first = oscap_arena_alloc(arena, 1024);
+	for (int i = 1; i < 100; i++)
+		oscap_assert(oscap_arena_alloc(arena, 1024) == first + i * 1024);
+	oscap_arena_reserve(arena, 100 * 1024);
+	char *next = oscap_arena_alloc(arena, 1024);
+	for (int i = 1; i < 100; i++)
+		oscap_assert(oscap_arena_alloc(arena, 1024) == next + i * 1024);
+	oscap_assert(oscap_arena_get_used(arena) == 200 * 1024);
+	oscap_arena_free(arena);
+	oscap_arena_free(NULL);
+}
+
 int main(int argc, char *argv[])
 {
 	_test_first_item_is_not_skipped();
@@ -327,6 +438,11 @@ int main(int argc, char *argv[])
 	_test_hit_empty1();
 	_test_hit_single_item1();
 	_test_hit_multiple_items1();
+	_test_htable_grow_and_detach(OSCAP_HTABLE_COPY_KEYS);
+	_test_htable_grow_and_detach(OSCAP_HTABLE_BORROW_KEYS);
+	_test_htable_grow_and_detach(OSCAP_HTABLE_POOL_KEYS);
+	_test_htable_intern();
+	_test_arena();
 
 	_test_list_remove();
 
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+/*
+ * Microbenchmark of oscap_htable. Measures insertion, successful and
+ * unsuccessful lookups for growing numbers of XCCDF-like keys, next to
+ * a chained table with a fixed number of buckets for comparison.
+ *
+ * Usage: test_oscap_htable_bench [max_items]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "common/list.h"
+#include "common/util.h"
+#include "oscap_assert.h"
+
+#define FIXED_HSIZE 389
+
+struct fixed_item {
+	struct fixed_item *next;
+	char *key;
+	void *value;
+};
+
+static unsigned int fixed_hash(const char *str)
+{
+	unsigned h = 0;
+	for (const unsigned char *p = (const unsigned char *) str; *p != '\0'; p++)
+		h = (97 * h) + *p;
+	return h % FIXED_HSIZE;
+}
+
+static void fixed_add(struct fixed_item **table, const char *key, void *value)
+{
+	unsigned int h = fixed_hash(key);
+	for (struct fixed_item *it = table[h]; it != NULL; it = it->next) {
+		if (strcmp(it->key, key) == 0)
+			return;
+	}
+	struct fixed_item *item = malloc(sizeof(struct fixed_item));
+	item->key = strdup(key);
+	item->value = value;
+	item->next = table[h];
+	table[h] = item;
+}
+
+static void *fixed_get(struct fixed_item **table, const char *key)
+{
+	for (struct fixed_item *it = table[fixed_hash(key)]; it != NULL; it = it->next) {
+		if (strcmp(it->key, key) == 0)
+			return it->value;
+	}
+	return NULL;
+}
+
+static void fixed_free(struct fixed_item **table)
+{
+	for (int i = 0; i < FIXED_HSIZE; i++) {
+		struct fixed_item *it = table[i];
+		while (it != NULL) {
+			struct fixed_item *next = it->next;
+			free(it->key);
+			free(it);
+			it = next;
+		}
+	}
+	free(table);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static char **make_keys(size_t n, const char *prefix)
+{
+	char **keys = malloc(n * sizeof(char *));
+	char buf[128];
+	for (size_t i = 0; i < n; i++) {
+		snprintf(buf, sizeof(buf), "xccdf_org.ssgproject.content_%s_%zu", prefix, i * 2654435761u % 1000003u + i);
+		keys[i] = strdup(buf);
+	}
+	return keys;
+}
+
+static void free_keys(char **keys, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		free(keys[i]);
+	free(keys);
+}
+
+static void bench_htable(size_t n, char **keys, char **missing, int flags, const char *name)
+{
+	double t0 = now();
+	struct oscap_htable *h = oscap_htable_new2(0, flags);
+	for (size_t i = 0; i < n; i++)
+		oscap_htable_add(h, keys[i], keys[i]);
+	double t1 = now();
+	for (size_t i = 0; i < n; i++)
+		oscap_assert(oscap_htable_get(h, keys[i]) == keys[i]);
+	double t2 = now();
+	for (size_t i = 0; i < n; i++)
+		oscap_assert(oscap_htable_get(h, missing[i]) == NULL);
+	double t3 = now();
+	oscap_htable_free0(h);
+	printf("%-10s %9zu %12.1f %12.1f %12.1f\n", name, n, (t1 - t0) / n, (t2 - t1) / n, (t3 - t2) / n);
+}
+
+static void bench_fixed(size_t n, char **keys, char **missing)
+{
+	double t0 = now();
+	struct fixed_item **table = calloc(FIXED_HSIZE, sizeof(struct fixed_item *));
+	for (size_t i = 0; i < n; i++)
+		fixed_add(table, keys[i], keys[i]);
+	double t1 = now();
+	for (size_t i = 0; i < n; i++)
+		oscap_assert(fixed_get(table, keys[i]) == keys[i]);
+	double t2 = now();
+	for (size_t i = 0; i < n; i++)
+		oscap_assert(fixed_get(table, missing[i]) == NULL);
+	double t3 = now();
+	fixed_free(table);
+	printf("%-10s %9zu %12.1f %12.1f %12.1f\n", "fixed389", n, (t1 - t0) / n, (t2 - t1) / n, (t3 - t2) / n);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t max = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+	char **keys = make_keys(max, "rule");
+	char **missing = make_keys(max, "value");
+
+	printf("%-10s %9s %12s %12s %12s\n", "table", "items", "insert ns", "hit ns", "miss ns");
+	for (size_t n = 100; n <= max; n *= 10) {
+		bench_htable(n, keys, missing, OSCAP_HTABLE_COPY_KEYS, "copy");
+		bench_htable(n, keys, missing, OSCAP_HTABLE_POOL_KEYS, "pool");
+		bench_htable(n, keys, missing, OSCAP_HTABLE_BORROW_KEYS, "borrow");
+		/* The chained table degrades linearly, keep its runs short */
+		if (n <= 100000)
+			bench_fixed(n, keys, missing);
+	}
+
+	free_keys(keys, max);
+	free_keys(missing, max);
+	return 0;
+}
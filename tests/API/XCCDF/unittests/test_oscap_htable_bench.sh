@@ -0,0 +1,7 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# Keep the run short, the full benchmark is ./test_oscap_htable_bench 1000000
+./test_oscap_htable_bench 10000
@@ -464,25 +464,25 @@ function xccdf_eval_2_multiset(){
 	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/generator'
 	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_info'
 	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item[count(*) = 5]'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:filepath'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:path'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:filename'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:xpath'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:value_of'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:value_of[text()="300"]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item[count(*) = 5]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:filepath'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:path'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:filename'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:xpath'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:value_of'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:value_of[text()="300"]'
 	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[count(@*) = 4]'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:com.example.www:obj:1"]'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@version="1"]'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@flag="complete"]'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[reference]'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[count(reference/@*) = 1]'
-	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[reference/@item_ref]'
-	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@variable_instance="1"]'
-	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@variable_instance="2"]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[count(@*) = 3]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:com.example.www:obj:1"]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@version="1"]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@flag="complete"]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[reference]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[count(reference/@*) = 1]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[reference/@item_ref]'
+	# The object does not depend on the variable, the second variable instance reuses it
+	assert_exists 0 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@variable_instance]'
 	assert_exists 4 '/oval_results/results/system/oval_system_characteristics/*'
 	assert_exists 1 '/oval_results/results/system/tests'
 	assert_exists 3 '/oval_results/results/system/tests/test'
@@ -666,6 +666,46 @@ function xccdf_eval_1_multiset_syschar(){
 	done
 }
 
+#
+# Evaluate XCCDF while exporting two values from XCCDF document to an OVAL
+# variable read by a local variable. The local variable is computed again for
+# the second variable set, objects which do not depend on it are reused.
+#
+function xccdf_eval_3_local_variable(){
+	local oval_result="local_variable-oval.xml.result.xml"
+	local xccdf_result=$(mktemp -t ${FUNCNAME}.xml.XXXXXX)
+	local stderr=$(mktemp -t ${FUNCNAME}.err.XXXXXX)
+	local profile="xccdf_moc.elpmaxe.www_profile_12"
+	local file300="local_300.xml"
+	local file600="local_600.xml"
+	echo "Stderr file = $stderr"
+
+	cp $srcdir/testing_file_300.xml $file300
+	cp $srcdir/testing_file_600.xml $file600
+	[ ! -f $oval_result ] || rm $oval_result
+
+	$OSCAP xccdf eval --profile $profile --oval-results --results $xccdf_result \
+		$srcdir/test_xccdf_variable_instance.xccdf.xml 2> $stderr
+	[ -f $stderr ]; [ ! -s $stderr ]
+	$OSCAP oval validate --schematron $oval_result
+	local result="$xccdf_result"
+	assert_exists 2 '/Benchmark/TestResult/rule-result/result[text()="pass"]'
+	result="$oval_result"
+	assert_exists 2 '/oval_results/results/system/definitions/definition[@definition_id="oval:com.example.www:def:1" and @result="true"]'
+	assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:com.example.www:tst:1" and @variable_instance="2"]/tested_variable[@variable_id="oval:com.example.www:var:2" and text()="./'$file600'"]'
+	assert_exists 3 '/oval_results/results/system/oval_system_characteristics/collected_objects/object'
+	assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:com.example.www:obj:1"]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:com.example.www:obj:1" and @variable_instance="2"]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:com.example.www:obj:2" and not(@variable_instance)]'
+	assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/ind-sys:xmlfilecontent_item/ind-sys:filename[text()="'$file600'"]'
+	rm $stderr
+	rm $xccdf_result
+	rm $oval_result
+	for f in $file300 $file600; do
+		chmod u+w $f ; rm $f
+	done
+}
+
 test_init test_api_xccdf_variable_instance.log
 
 test_run "Export from XCCDF to variables: 1x2 values (multival)" xccdf_export_1_multival
@@ -681,5 +721,6 @@ test_run "Export from XCCDF to variables: 3x3 the last is subset (multiset,multi
 
 test_run "Evaluate XCCDF: 2x1 values (multiset)" xccdf_eval_2_multiset
 test_run "Evaluate XCCDF: 2x1 values (multiset) in syschar" xccdf_eval_1_multiset_syschar
+test_run "Evaluate XCCDF: 2x1 values (multiset) read by local variable" xccdf_eval_3_local_variable
 
 test_exit
@@ -0,0 +1,82 @@
+#!/usr/bin/env bash
+#
+# Copyright 2020 Red Hat Inc., Durham, North Carolina.
+# All Rights Reserved.
+#
+# Results are written gzip compressed when the file name ends with .gz
+# and compressed content and results are accepted as input.
+
+set -e -o pipefail
+
+. $builddir/tests/test_common.sh
+
+name=$(basename $0 .sh)
+dir=$(mktemp -d -t ${name}.XXXXXX)
+stderr=$(mktemp -t ${name}.err.XXXXXX)
+echo "Stderr file = $stderr"
+sds=$dir/sds.xml
+xccdf=$dir/xccdf.xml
+cp $srcdir/../DS/sds_multiple_oval/*.xml $dir/
+mv $dir/multiple-oval-xccdf.xml $xccdf
+
+function is_gzip() {
+	[ "$(head -c 2 "$1" | od -An -tx1 | tr -d ' ')" == "1f8b" ]
+}
+
+$OSCAP ds sds-compose "$xccdf" "$sds" 2> $stderr
+[ ! -s $stderr ]
+
+#
+# Evaluate gzipped source data stream, write gzipped results
+#
+gzip $sds
+pushd $dir
+ret=0
+$OSCAP xccdf eval --results-arf arf.xml.gz --results results.xml.gz \
+	--oval-results --oval-results-compression gzip "${sds}.gz" 2> $stderr || ret=$?
+popd
+[ $ret -eq 2 ]
+[ ! -s $stderr ]
+
+for file in arf.xml.gz results.xml.gz first-oval.xml.result.xml.gz second-oval.xml.result.xml.gz; do
+	is_gzip $dir/$file
+	gzip -t $dir/$file
+	[ ! -f $dir/${file%.gz} ]
+done
+zcat $dir/arf.xml.gz | grep -q '<arf:asset-report-collection'
+zcat $dir/first-oval.xml.result.xml.gz | grep -q '<oval_results'
+
+#
+# Read the compressed results back
+#
+$OSCAP info $dir/arf.xml.gz 2> $stderr | grep -q 'Result Data Stream'
+[ ! -s $stderr ]
+$OSCAP xccdf validate $dir/results.xml.gz 2> $stderr
+[ ! -s $stderr ]
+$OSCAP oval validate $dir/first-oval.xml.result.xml.gz 2> $stderr
+[ ! -s $stderr ]
+
+report=$dir/report.html
+$OSCAP xccdf generate report --output $report $dir/arf.xml.gz 2> $stderr
+[ ! -s $stderr ]
+grep -q 'OVAL test results details' $report
+
+#
+# OVAL results
+#
+$OSCAP oval eval --results $dir/oval-results.xml.gz $dir/first-oval.xml 2> $stderr > /dev/null
+[ ! -s $stderr ]
+is_gzip $dir/oval-results.xml.gz
+zcat $dir/oval-results.xml.gz | grep -q '<oval_results'
+
+#
+# Truncated input is reported
+#
+head -c 1000 $dir/arf.xml.gz > $dir/truncated.xml.gz
+ret=0
+$OSCAP info $dir/truncated.xml.gz 2> $stderr || ret=$?
+[ $ret -eq 1 ]
+grep -q 'Unexpected end of gzip data' $stderr
+
+rm $stderr
+rm -rf $dir
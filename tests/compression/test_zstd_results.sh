@@ -0,0 +1,100 @@
+#!/usr/bin/env bash
+#
+# Copyright 2020 Red Hat Inc., Durham, North Carolina.
+# All Rights Reserved.
+#
+# Results are written zstd compressed when the file name ends with .zst
+# and compressed content and results are accepted as input.
+
+set -e -o pipefail
+
+. $builddir/tests/test_common.sh
+
+name=$(basename $0 .sh)
+dir=$(mktemp -d -t ${name}.XXXXXX)
+stderr=$(mktemp -t ${name}.err.XXXXXX)
+echo "Stderr file = $stderr"
+sds=$dir/sds.xml
+xccdf=$dir/xccdf.xml
+cp $srcdir/../DS/sds_multiple_oval/*.xml $dir/
+mv $dir/multiple-oval-xccdf.xml $xccdf
+
+function is_zstd() {
+	[ "$(head -c 4 "$1" | od -An -tx1 | tr -d ' ')" == "28b52ffd" ]
+}
+
+$OSCAP ds sds-compose "$xccdf" "$sds" 2> $stderr
+[ ! -s $stderr ]
+
+#
+# Write compressed results
+#
+pushd $dir
+ret=0
+$OSCAP xccdf eval --results-arf arf.xml.zst --results results.xml.zst \
+	--oval-results --oval-results-compression zstd "$sds" 2> $stderr || ret=$?
+popd
+[ $ret -eq 2 ]
+[ ! -s $stderr ]
+
+for file in arf.xml.zst results.xml.zst first-oval.xml.result.xml.zst second-oval.xml.result.xml.zst; do
+	is_zstd $dir/$file
+	[ ! -f $dir/${file%.zst} ]
+done
+
+#
+# Read the compressed results back
+#
+$OSCAP info $dir/arf.xml.zst 2> $stderr | grep -q 'Result Data Stream'
+[ ! -s $stderr ]
+$OSCAP xccdf validate $dir/results.xml.zst 2> $stderr
+[ ! -s $stderr ]
+$OSCAP oval validate $dir/first-oval.xml.result.xml.zst 2> $stderr
+[ ! -s $stderr ]
+
+report=$dir/report.html
+$OSCAP xccdf generate report --output $report $dir/arf.xml.zst 2> $stderr
+[ ! -s $stderr ]
+grep -q 'OVAL test results details' $report
+
+#
+# OVAL results
+#
+$OSCAP oval eval --results $dir/oval-results.xml.zst $dir/first-oval.xml 2> $stderr > /dev/null
+[ ! -s $stderr ]
+is_zstd $dir/oval-results.xml.zst
+$OSCAP oval validate $dir/oval-results.xml.zst 2> $stderr
+[ ! -s $stderr ]
+
+#
+# Documents larger than one zstd block
+#
+big=$dir/big-oval.xml
+sed -n '1,/<description>/p' $dir/first-oval.xml | sed '$d' > $big
+echo '<description>' >> $big
+head -c 300000 /dev/urandom | base64 >> $big
+echo '</description>' >> $big
+sed -n '/<description>/,$p' $dir/first-oval.xml | sed '1d' >> $big
+$OSCAP oval eval --results $dir/big-results.xml.zst $big 2> $stderr > /dev/null
+[ ! -s $stderr ]
+[ $(stat -c %s $dir/big-results.xml.zst) -gt 131072 ]
+$OSCAP oval validate $dir/big-results.xml.zst 2> $stderr
+[ ! -s $stderr ]
+# Frames without a checksum end right after the last block
+if command -v zstd > /dev/null; then
+	zstd -q --no-check $big -o $big.zst
+	$OSCAP oval validate $big.zst 2> $stderr
+	[ ! -s $stderr ]
+fi
+
+#
+# Truncated input is reported
+#
+head -c 1000 $dir/arf.xml.zst > $dir/truncated.xml.zst
+ret=0
+$OSCAP info $dir/truncated.xml.zst 2> $stderr || ret=$?
+[ $ret -eq 1 ]
+grep -q 'Unexpected end of zstd data' $stderr
+
+rm $stderr
+rm -rf $dir
@@ -0,0 +1,49 @@
+#!/usr/bin/env bash
+
+# Copyright 2020 Red Hat Inc., Durham, North Carolina.
+# All Rights Reserved.
+#
+# OpenScap Probes Test Suite.
+#
+# The dpkginfo probe reads the dpkg status database of the scanned system.
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# Test Cases.
+
+function test_probes_dpkginfo {
+
+    probecheck "dpkginfo" || return 255
+
+    local DF="${srcdir}/test_probes_dpkginfo.xml"
+    local RF="results.xml"
+
+    [ -f $RF ] && rm -f $RF
+
+    tmpdir=$(mktemp -t -d "test_dpkginfo.XXXXXX")
+    mkdir -p "$tmpdir/var/lib/dpkg"
+    cp "${srcdir}/dpkg_status" "$tmpdir/var/lib/dpkg/status"
+
+    set_offline_chroot_dir "$tmpdir"
+    $OSCAP oval eval --results $RF $DF
+    set_offline_chroot_dir ""
+    rm -rf "$tmpdir"
+
+    result=$RF
+    assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:1:def:1"][@result="true"]'
+    assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:1:obj:1"]/reference'
+    assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:1:obj:4"]/reference'
+    assert_exists 2 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:1:obj:7"]/reference'
+
+    rm -f $RF
+}
+
+# Testing.
+
+test_init
+
+test_run "test_probes_dpkginfo" test_probes_dpkginfo
+
+test_exit
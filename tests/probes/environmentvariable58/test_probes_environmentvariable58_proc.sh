@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# Environments of more processes read from a fake /proc
+function test_probes_environmentvariable58_proc {
+    probecheck "environmentvariable58" || return 255
+
+    local DF="${srcdir}/test_probes_environmentvariable58_proc.xml"
+    local RF="test_probes_environmentvariable58_proc.results.xml"
+    local stderr=$(mktemp $1.err.XXXXXX)
+
+    [ -f $RF ] && rm -f $RF
+
+    tmpdir=$(mktemp -t -d "test_environmentvariable58_proc.XXXXXX")
+    mkdir -p "$tmpdir/proc/10" "$tmpdir/proc/20"
+    # the last variable isn't terminated
+    printf 'FOO=one\0NOEQ\0LAST=end' > "$tmpdir/proc/10/environ"
+    printf 'FOO=bar\0OTHER=x=y\0FOO=baz\0LAST=end\0' > "$tmpdir/proc/20/environ"
+
+    OSCAP_PROBE_ROOT="$tmpdir" $OSCAP oval eval --results $RF $DF 2> $stderr
+
+    [ -f $RF ]
+    verify_results "def" $DF $RF 1
+    verify_results "tst" $DF $RF 5
+
+    ! grep -Ei "(W: |E: )" $stderr
+
+    rm $stderr $RF
+    rm -rf "$tmpdir"
+}
+
+test_run "test_probes_environmentvariable58_proc" test_probes_environmentvariable58_proc
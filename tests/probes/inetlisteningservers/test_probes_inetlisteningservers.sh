@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+function test_probes_inetlisteningservers {
+	probecheck "inetlisteningservers" || return 255
+	require "python3" || return 255
+
+	local portfile=$(mktemp)
+	local DEFFILE=$(mktemp)
+	result=$(mktemp)
+
+	python3 -c "
+import socket, sys, time
+s = socket.socket()
+s.bind(('127.0.0.1', 0))
+s.listen()
+with open(sys.argv[1], 'w') as f:
+    f.write(str(s.getsockname()[1]))
+time.sleep(60)
+" $portfile &
+	local pid=$!
+	trap "kill $pid 2> /dev/null || true" EXIT
+
+	for i in $(seq 50); do
+		[ -s $portfile ] && break
+		sleep 0.1
+	done
+	local port=$(cat $portfile)
+	sed "s/PORT/$port/" $srcdir/test_probes_inetlisteningservers.xml > $DEFFILE
+
+	$OSCAP oval eval --results $result $DEFFILE
+
+	local item="/oval_results/results/system/oval_system_characteristics/system_data/lin-sys:inetlisteningserver_item"
+	assert_exists 1 "$item"
+	assert_exists 1 "$item/lin-sys:local_full_address[text()='127.0.0.1:$port']"
+	assert_exists 1 "$item/lin-sys:program_name[text()='python3']"
+	assert_exists 1 "$item/lin-sys:pid[text()='$pid']"
+	assert_exists 1 '/oval_results/results/system/definitions/definition[@result="true"]'
+
+	rm -f $portfile $DEFFILE $result
+}
+
+test_probes_inetlisteningservers
@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# Overlay mounts of container hosts have mount table lines longer than a page
+function test_probes_partition_long_options {
+    probecheck "partition" || return 255
+
+    local DF="${srcdir}/test_probes_partition_long_options.xml"
+    local RF="test_probes_partition_long_options.results.xml"
+
+    [ -f $RF ] && rm -f $RF
+
+    tmpdir=$(mktemp -t -d "test_partition_long_options.XXXXXX")
+    mkdir -p "$tmpdir/proc" "$tmpdir/merged"
+
+    local lowerdir="/var/lib/containers/storage/overlay/l/0"
+    for i in $(seq 1 200); do
+        lowerdir="$lowerdir:/var/lib/containers/storage/overlay/l/$i"
+    done
+    echo "overlay /merged overlay rw,relatime,lowerdir=$lowerdir,upperdir=/upper,workdir=/work 0 0" > "$tmpdir/proc/mounts"
+
+    OSCAP_PROBE_ROOT="$tmpdir" $OSCAP oval eval --results $RF $DF
+
+    [ -f $RF ]
+    verify_results "def" $DF $RF 1
+    verify_results "tst" $DF $RF 1
+
+    rm $RF
+    rm -rf "$tmpdir"
+}
+
+test_run "Probe partition mount table line longer than a page" test_probes_partition_long_options
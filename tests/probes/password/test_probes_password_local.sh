@@ -0,0 +1,41 @@
+#!/usr/bin/env bash
+
+# Copyright 2020 Red Hat Inc., Durham, North Carolina.
+# All Rights Reserved.
+#
+# OpenScap Probes Test Suite.
+#
+# The password probe reads only /etc/passwd with OSCAP_PROBE_LOCAL_USERS=1.
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# Test Cases.
+
+function test_probes_password_local {
+
+    probecheck "password" || return 255
+    grep -q '^root:' /etc/passwd || return 255
+
+    local DF="${srcdir}/test_probes_password_local.xml"
+    local RF="test_probes_password_local.results.xml"
+
+    [ -f $RF ] && rm -f $RF
+
+    OSCAP_PROBE_LOCAL_USERS=1 $OSCAP oval eval --results $RF $DF
+
+    result=$RF
+    assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:1:def:1"][@result="true"]'
+    assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:1:obj:2"]/reference'
+
+    rm -f $RF
+}
+
+# Testing.
+
+test_init
+
+test_run "test_probes_password_local" test_probes_password_local
+
+test_exit
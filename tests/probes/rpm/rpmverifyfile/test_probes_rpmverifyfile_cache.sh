@@ -0,0 +1,95 @@
+#!/usr/bin/env bash
+
+# Copyright 2020 Red Hat Inc., Durham, North Carolina.
+# All Rights Reserved.
+#
+# OpenScap Probes Test Suite.
+#
+# The foo package is installed into a private database, rpm finds it there
+# by the ~/.rpmmacros of a temporary home. The cache is given by
+# OSCAP_RPMVERIFY_CACHE.
+
+. $builddir/tests/test_common.sh
+. $srcdir/../rpm_common.sh
+
+set -e -o pipefail
+
+function rpmverifyfile_eval {
+    local expected="$1"
+
+    rm -f $RF
+    HOME="$tmpdir" OSCAP_RPMVERIFY_CACHE="$CACHE" $OSCAP oval eval --results $RF $DF 2> $stderr
+
+    result=$RF
+    assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/lin-sys:rpmverifyfile_item'
+    assert_exists 1 '/oval_results/results/system/oval_system_characteristics/system_data/lin-sys:rpmverifyfile_item/lin-sys:filedigest_differs[text()="'$expected'"]'
+}
+
+# Set the cached result of the digest check of the file
+function cache_set_differs {
+    sed -i "s|^\(\([^ ]* \)\{7\}\)[01] \(.* $FILE\)$|\1$1 \3|" "$CACHE"
+    grep -q "^\([^ ]* \)\{7\}$1 .* $FILE$" "$CACHE"
+}
+
+function test_probes_rpmverifyfile_cache {
+    probecheck "rpmverifyfile" || return 255
+    require "rpm" || return 255
+    require "rpmbuild" || return 255
+
+    DF="$srcdir/test_probes_rpmverifyfile_cache.xml"
+    RF="test_probes_rpmverifyfile_cache.results.xml"
+
+    tmpdir=$(mktemp -t -d "test_rpmverifyfile_cache.XXXXXX")
+    stderr="$tmpdir/stderr"
+    CACHE="$tmpdir/cache"
+    FILE="$tmpdir/etc/foo"
+    echo "%_dbpath $tmpdir/db" > "$tmpdir/.rpmmacros"
+    rpm_build
+    rpm -i ${RPMBUILD}/RPMS/noarch/foo-1.0-1.noarch.rpm --badreloc --relocate="/etc=$tmpdir/etc/" --dbpath="$tmpdir/db"
+
+    # The digest is checked and the result is cached
+    rpmverifyfile_eval "pass"
+    [ "$(stat -c %a "$CACHE")" = "600" ]
+    grep -q " $FILE$" "$CACHE"
+
+    # The cached result is used while the file is the same, the cache is
+    # kept only with the entries used during the scan
+    echo "1 1 1 1 1 1 1 0 0123abcd /no/such/file/oscap" >> "$CACHE"
+    cache_set_differs 1
+    rpmverifyfile_eval "fail"
+    if grep -q "/no/such/file/oscap" "$CACHE"; then
+        return 1
+    fi
+
+    # A new mtime invalidates the entry
+    touch -d "2001-01-01 00:00" "$FILE"
+    rpmverifyfile_eval "pass"
+
+    # So does a new size
+    echo "changed" >> "$FILE"
+    cache_set_differs 0
+    rpmverifyfile_eval "fail"
+
+    # A cache writable by others isn't trusted
+    cache_set_differs 0
+    chmod g+w "$CACHE"
+    rpmverifyfile_eval "fail"
+    grep -q "Ignoring rpmverify cache" $stderr
+
+    # Neither is a cache of another user
+    if [ "$(id -u)" = "0" ] && id nobody > /dev/null 2>&1; then
+        cache_set_differs 0
+        chown nobody "$CACHE"
+        rpmverifyfile_eval "fail"
+        grep -q "Ignoring rpmverify cache" $stderr
+    fi
+
+    rm -rf "$tmpdir"
+    rm -f $RF
+}
+
+test_init
+
+test_run "rpmverifyfile probe with the rpmverify cache" test_probes_rpmverifyfile_cache
+
+test_exit
@@ -18,7 +18,7 @@ function test_probes_rpmverifyfile {
 
     rm -f $RF
 
-    $OSCAP oval eval --results $RF $DF
+    OSCAP_MAX_THREADS=$1 $OSCAP oval eval --results $RF $DF
 
     result=$RF
 
@@ -87,7 +87,8 @@ test_init
 
 rpm_prepare_offline
 
-test_run "rpmverifyfile probe test with OVAL 5.11.1 (offline)" test_probes_rpmverifyfile
+test_run "rpmverifyfile probe test with OVAL 5.11.1 (offline), 1 thread" test_probes_rpmverifyfile 1
+test_run "rpmverifyfile probe test with OVAL 5.11.1 (offline), 4 threads" test_probes_rpmverifyfile 4
 
 rpm_cleanup_offline
 
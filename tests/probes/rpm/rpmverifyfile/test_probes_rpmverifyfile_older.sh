@@ -18,7 +18,7 @@ function test_probes_rpmverifyfile {
 
     rm -f $RF
 
-    $OSCAP oval eval --results $RF $DF
+    OSCAP_MAX_THREADS=$1 $OSCAP oval eval --results $RF $DF
 
     result=$RF
 
@@ -81,6 +81,7 @@ function test_probes_rpmverifyfile {
 
 test_init
 
-test_run "rpmverifyfile probe test with OVAL 5.11" test_probes_rpmverifyfile
+test_run "rpmverifyfile probe test with OVAL 5.11, 1 thread" test_probes_rpmverifyfile 1
+test_run "rpmverifyfile probe test with OVAL 5.11, 4 threads" test_probes_rpmverifyfile 4
 
 test_exit
\ No newline at end of file
@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# Objects using the "equals" operation read the sysctls directly,
+# other operations are evaluated on a snapshot of all sysctls.
+function perform_test {
+	probecheck "sysctl" || return 255
+	[ "$(uname)" = "Linux" ] || return 255
+
+	result=`mktemp`
+	stderr=`mktemp`
+	hostname=`hostname`
+	sc="/oval_results/results/system/oval_system_characteristics"
+
+	$OSCAP oval eval --results $result $srcdir/test_sysctl_probe_operations.oval.xml 2>$stderr
+
+	[ ! -s $stderr ]
+	assert_exists 1 "$sc/collected_objects/object[@id='oval:oscap:obj:1'][@flag='complete']/reference"
+	assert_exists 2 "$sc/collected_objects/object[@id='oval:oscap:obj:2'][@flag='complete']/reference"
+	assert_exists 1 "$sc/collected_objects/object[@id='oval:oscap:obj:3'][@flag='complete']"
+	assert_exists 1 "$sc/collected_objects/object[@id='oval:oscap:obj:4'][@flag='complete']/reference"
+	assert_exists 1 "$sc/collected_objects/object[@id='oval:oscap:obj:5'][@flag='does not exist']"
+	assert_exists 1 "$sc/system_data/unix-sys:sysctl_item/unix-sys:name[text()='kernel.hostname']"
+	assert_exists 1 "$sc/system_data/unix-sys:sysctl_item/unix-sys:value[text()='$hostname']"
+	assert_exists 1 "$sc/system_data/unix-sys:sysctl_item/unix-sys:name[text()='kernel.ostype']"
+	assert_exists 1 "$sc/system_data/unix-sys:sysctl_item/unix-sys:value[text()='Linux']"
+	assert_exists 0 "$sc/system_data/unix-sys:sysctl_item/unix-sys:name[text()='no.such.sysctl']"
+
+	rm $result
+	rm $stderr
+}
+
+perform_test
@@ -0,0 +1,297 @@
+/*
+ * Copyright 2020 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+/*
+ * Minimal systemd Manager on the bus given by DBUS_SYSTEM_BUS_ADDRESS.
+ *
+ * MOCK_SERVICES units mock-unit-NNN.service are listed, each of them wants
+ * the next one. The listed mock.target wants mock-hidden.target, which
+ * isn't listed but can be loaded, and that one wants mock-missing.target,
+ * which can't be loaded. Requests which are already queued when a GetAll
+ * request is processed are counted as one batch, the largest batch and
+ * the number of calls are written to the file given as the argument when
+ * the bus goes away.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dbus/dbus.h>
+
+#define MOCK_SERVICES 200
+#define MOCK_TARGET MOCK_SERVICES
+#define MOCK_HIDDEN (MOCK_SERVICES + 1)
+#define MOCK_PATH_PREFIX "/org/freedesktop/systemd1/unit/"
+#define MOCK_MAX_BATCH 1024
+
+static unsigned int list_calls, load_calls, get_all_calls, max_batch;
+
+static void unit_name(int index, char *buf, size_t size)
+{
+	if (index == MOCK_TARGET)
+		snprintf(buf, size, "mock.target");
+	else if (index == MOCK_HIDDEN)
+		snprintf(buf, size, "mock-hidden.target");
+	else
+		snprintf(buf, size, "mock-unit-%03d.service", index);
+}
+
+static void unit_path(int index, char *buf, size_t size)
+{
+	snprintf(buf, size, MOCK_PATH_PREFIX "%03d", index);
+}
+
+static void unit_description(int index, char *buf, size_t size)
+{
+	if (index == MOCK_TARGET)
+		snprintf(buf, size, "Mock target");
+	else if (index == MOCK_HIDDEN)
+		snprintf(buf, size, "Mock hidden target");
+	else
+		snprintf(buf, size, "Mock unit %d", index);
+}
+
+/* Index of the unit, -1 if it doesn't exist */
+static int unit_by_name(const char *name)
+{
+	char buf[64];
+
+	for (int i = 0; i <= MOCK_HIDDEN; ++i) {
+		unit_name(i, buf, sizeof buf);
+		if (strcmp(name, buf) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static int unit_by_path(const char *path)
+{
+	char buf[64];
+
+	for (int i = 0; i <= MOCK_HIDDEN; ++i) {
+		unit_path(i, buf, sizeof buf);
+		if (strcmp(path, buf) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static DBusMessage *list_units(DBusMessage *msg)
+{
+	DBusMessage *reply = dbus_message_new_method_return(msg);
+	DBusMessageIter args, array, unit;
+
+	dbus_message_iter_init_append(reply, &args);
+	dbus_message_iter_open_container(&args, DBUS_TYPE_ARRAY, "(ssssssouso)", &array);
+	for (int i = 0; i <= MOCK_TARGET; ++i) {
+		char name[64], path[64], description[64];
+		const char *s_name = name, *s_description = description, *loaded = "loaded",
+		           *active = "active", *running = "running", *empty = "", *s_path = path,
+		           *job_path = "/";
+		dbus_uint32_t job = 0;
+
+		unit_name(i, name, sizeof name);
+		unit_path(i, path, sizeof path);
+		unit_description(i, description, sizeof description);
+		dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, NULL, &unit);
+		dbus_message_iter_append_basic(&unit, DBUS_TYPE_STRING, &s_name);
+		dbus_message_iter_append_basic(&unit, DBUS_TYPE_STRING, &s_description);
+		dbus_message_iter_append_basic(&unit, DBUS_TYPE_STRING, &loaded);
+		dbus_message_iter_append_basic(&unit, DBUS_TYPE_STRING, &active);
+		dbus_message_iter_append_basic(&unit, DBUS_TYPE_STRING, &running);
+		dbus_message_iter_append_basic(&unit, DBUS_TYPE_STRING, &empty);
+		dbus_message_iter_append_basic(&unit, DBUS_TYPE_OBJECT_PATH, &s_path);
+		dbus_message_iter_append_basic(&unit, DBUS_TYPE_UINT32, &job);
+		dbus_message_iter_append_basic(&unit, DBUS_TYPE_STRING, &empty);
+		dbus_message_iter_append_basic(&unit, DBUS_TYPE_OBJECT_PATH, &job_path);
+		dbus_message_iter_close_container(&array, &unit);
+	}
+	dbus_message_iter_close_container(&args, &array);
+	list_calls++;
+	return reply;
+}
+
+static DBusMessage *load_unit(DBusMessage *msg)
+{
+	const char *name = NULL;
+	char path[64];
+	const char *s_path = path;
+	int index;
+	DBusMessage *reply;
+
+	load_calls++;
+	if (!dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &name, DBUS_TYPE_INVALID)
+	    || (index = unit_by_name(name)) == -1)
+		return dbus_message_new_error(msg, "org.freedesktop.systemd1.NoSuchUnit", "Unit not found.");
+
+	unit_path(index, path, sizeof path);
+	reply = dbus_message_new_method_return(msg);
+	dbus_message_append_args(reply, DBUS_TYPE_OBJECT_PATH, &s_path, DBUS_TYPE_INVALID);
+	return reply;
+}
+
+static void append_string_property(DBusMessageIter *dict, const char *name, const char *value)
+{
+	DBusMessageIter entry, variant;
+
+	dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY, NULL, &entry);
+	dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name);
+	dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT, "s", &variant);
+	dbus_message_iter_append_basic(&variant, DBUS_TYPE_STRING, &value);
+	dbus_message_iter_close_container(&entry, &variant);
+	dbus_message_iter_close_container(dict, &entry);
+}
+
+static void append_array_property(DBusMessageIter *dict, const char *name, const char **values, int count)
+{
+	DBusMessageIter entry, variant, array;
+
+	dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY, NULL, &entry);
+	dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name);
+	dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT, "as", &variant);
+	dbus_message_iter_open_container(&variant, DBUS_TYPE_ARRAY, "s", &array);
+	for (int i = 0; i < count; ++i)
+		dbus_message_iter_append_basic(&array, DBUS_TYPE_STRING, &values[i]);
+	dbus_message_iter_close_container(&variant, &array);
+	dbus_message_iter_close_container(&entry, &variant);
+	dbus_message_iter_close_container(dict, &entry);
+}
+
+static DBusMessage *get_all(DBusMessage *msg)
+{
+	int index = unit_by_path(dbus_message_get_path(msg));
+	char name[64], next[64], description[64];
+	const char *wants[2] = { next, NULL };
+	int wants_count = 0;
+	DBusMessage *reply;
+	DBusMessageIter args, dict;
+
+	get_all_calls++;
+	if (index == -1)
+		return dbus_message_new_error(msg, DBUS_ERROR_UNKNOWN_OBJECT, "Unknown object.");
+
+	unit_name(index, name, sizeof name);
+	unit_description(index, description, sizeof description);
+	if (index == MOCK_TARGET) {
+		wants[0] = "mock-hidden.target";
+		wants[1] = "mock-unit-000.service";
+		wants_count = 2;
+	} else if (index == MOCK_HIDDEN) {
+		wants[0] = "mock-missing.target";
+		wants_count = 1;
+	} else if (index < MOCK_SERVICES - 1) {
+		unit_name(index + 1, next, sizeof next);
+		wants_count = 1;
+	}
+
+	reply = dbus_message_new_method_return(msg);
+	dbus_message_iter_init_append(reply, &args);
+	dbus_message_iter_open_container(&args, DBUS_TYPE_ARRAY, "{sv}", &dict);
+	append_string_property(&dict, "Id", name);
+	append_string_property(&dict, "Description", description);
+	append_string_property(&dict, "ActiveState", index == MOCK_HIDDEN ? "inactive" : "active");
+	append_array_property(&dict, "Wants", wants, wants_count);
+	dbus_message_iter_close_container(&args, &dict);
+	return reply;
+}
+
+static DBusMessage *handle(DBusMessage *msg)
+{
+	if (dbus_message_is_method_call(msg, "org.freedesktop.systemd1.Manager", "ListUnits"))
+		return list_units(msg);
+	if (dbus_message_is_method_call(msg, "org.freedesktop.systemd1.Manager", "LoadUnit"))
+		return load_unit(msg);
+	if (dbus_message_is_method_call(msg, DBUS_INTERFACE_PROPERTIES, "GetAll"))
+		return get_all(msg);
+	if (dbus_message_get_type(msg) == DBUS_MESSAGE_TYPE_METHOD_CALL)
+		return dbus_message_new_error(msg, DBUS_ERROR_UNKNOWN_METHOD, "Unknown method.");
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	DBusConnection *conn;
+	DBusError err;
+	DBusMessage *batch[MOCK_MAX_BATCH];
+	FILE *stats;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s STATS_FILE\n", argv[0]);
+		return 2;
+	}
+
+	dbus_error_init(&err);
+	conn = dbus_bus_get_private(DBUS_BUS_SYSTEM, &err);
+	if (conn == NULL) {
+		fprintf(stderr, "Can't connect to the bus: %s\n", err.message);
+		return 1;
+	}
+	dbus_connection_set_exit_on_disconnect(conn, FALSE);
+	if (dbus_bus_request_name(conn, "org.freedesktop.systemd1", DBUS_NAME_FLAG_DO_NOT_QUEUE, &err)
+	    != DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER) {
+		fprintf(stderr, "Can't own the systemd name: %s\n", dbus_error_is_set(&err) ? err.message : "taken");
+		return 1;
+	}
+	/* The test waits for this line before it starts the probes */
+	printf("ready\n");
+	fflush(stdout);
+
+	while (dbus_connection_read_write(conn, -1)) {
+		unsigned int count = 0, get_alls = 0;
+		DBusMessage *msg;
+
+		while (count < MOCK_MAX_BATCH && (msg = dbus_connection_pop_message(conn)) != NULL) {
+			if (dbus_message_is_method_call(msg, DBUS_INTERFACE_PROPERTIES, "GetAll") && get_alls++ == 0) {
+				/* Let the rest of a pipelined window arrive */
+				usleep(50000);
+				dbus_connection_read_write(conn, 0);
+			}
+			batch[count++] = msg;
+		}
+		if (get_alls > max_batch)
+			max_batch = get_alls;
+
+		for (unsigned int i = 0; i < count; ++i) {
+			DBusMessage *reply = handle(batch[i]);
+
+			if (reply != NULL) {
+				dbus_connection_send(conn, reply, NULL);
+				dbus_message_unref(reply);
+			}
+			dbus_message_unref(batch[i]);
+		}
+		dbus_connection_flush(conn);
+	}
+
+	stats = fopen(argv[1], "w");
+	if (stats == NULL)
+		return 1;
+	fprintf(stats, "ListUnits %u\nLoadUnit %u\nGetAll %u\nBatch %u\n",
+	        list_calls, load_calls, get_all_calls, max_batch);
+	fclose(stats);
+
+	dbus_connection_close(conn);
+	dbus_connection_unref(conn);
+	return 0;
+}
@@ -0,0 +1,72 @@
+#!/usr/bin/env bash
+
+# Copyright 2020 Red Hat Inc., Durham, North Carolina.
+# All Rights Reserved.
+#
+# OpenScap Probes Test Suite.
+
+set -e -o pipefail
+
+. $builddir/tests/test_common.sh
+
+# A mock systemd on a private bus lists more units than fit in one window
+# of pipelined GetAll requests, and a target depending on a unit which
+# isn't listed.
+function test_probes_systemdunitproperty_mock_bus {
+    probecheck "systemdunitproperty" || return 255
+    probecheck "systemdunitdependency" || return 255
+    require "dbus-daemon" || return 255
+
+    local DF="${srcdir}/test_probes_systemdunitproperty_mock_bus.xml"
+    local RF="results.xml"
+    local MOCK="$builddir/tests/probes/systemdunitproperty/mock_systemd"
+
+    [ -f $RF ] && rm -f $RF
+
+    tmpdir=$(mktemp -t -d "test_systemdunitproperty_mock_bus.XXXXXX")
+    cat > "$tmpdir/bus.conf" <<EOF
+<busconfig>
+  <type>system</type>
+  <listen>unix:path=$tmpdir/system_bus_socket</listen>
+  <auth>EXTERNAL</auth>
+  <policy context="default">
+    <allow user="*"/>
+    <allow own="*"/>
+    <allow send_destination="*"/>
+    <allow receive_sender="*"/>
+  </policy>
+</busconfig>
+EOF
+    local bus_pid=$(dbus-daemon --config-file="$tmpdir/bus.conf" --fork --print-pid)
+    export DBUS_SYSTEM_BUS_ADDRESS="unix:path=$tmpdir/system_bus_socket"
+
+    mkfifo "$tmpdir/ready"
+    "$MOCK" "$tmpdir/stats" > "$tmpdir/ready" &
+    local mock_pid=$!
+    read line < "$tmpdir/ready"
+    [ "$line" == "ready" ]
+
+    $OSCAP oval eval --results $RF $DF
+
+    kill $bus_pid
+    wait $mock_pid
+    cat "$tmpdir/stats"
+
+    [ -f $RF ]
+    verify_results "def" $DF $RF 5
+    verify_results "tst" $DF $RF 5
+
+    # every listed unit was collected, the properties of every unit were
+    # fetched once, mock-hidden.target and mock-missing.target were loaded
+    [ $(grep -o 'Mock unit [0-9][0-9]*' $RF | sort -u | wc -l) -eq 200 ]
+    grep -q '^ListUnits 1$' "$tmpdir/stats"
+    grep -q '^LoadUnit 2$' "$tmpdir/stats"
+    grep -q '^GetAll 202$' "$tmpdir/stats"
+    # more requests were pending at once
+    [ $(sed -n 's/^Batch //p' "$tmpdir/stats") -gt 1 ]
+
+    rm $RF
+    rm -rf "$tmpdir"
+}
+
+test_run "Probe systemdunitproperty on a mock bus" test_probes_systemdunitproperty_mock_bus
@@ -0,0 +1,44 @@
+#!/usr/bin/env bash
+
+# Copyright 2020 Red Hat Inc., Durham, North Carolina.
+# All Rights Reserved.
+#
+# OpenScap Probes Test Suite.
+
+set -e -o pipefail
+
+. $builddir/tests/test_common.sh
+
+# The prefix has no system bus, the probe has to read the unit files.
+function test_probes_systemdunitproperty_unit_files {
+    probecheck "systemdunitproperty" || return 255
+
+    local DF="${srcdir}/test_probes_systemdunitproperty_unit_files.xml"
+    local RF="results.xml"
+
+    [ -f $RF ] && rm -f $RF
+
+    tmpdir=$(mktemp -t -d "test_systemdunitproperty_unit_files.XXXXXX")
+    local etc="$tmpdir/etc/systemd/system"
+    local lib="$tmpdir/usr/lib/systemd/system"
+    mkdir -p "$etc/multi-user.target.wants" "$etc/sshd.service.d" "$lib"
+
+    printf '[Unit]\nDescription=OpenSSH server daemon\nAfter=network.target\n\n[Service]\nExecStart=/usr/sbin/sshd\n\n[Install]\nWantedBy=multi-user.target\n' > "$lib/sshd.service"
+    printf '[Unit]\nDescription=Multi-User System\nRequires=basic.target\n' > "$lib/multi-user.target"
+    printf '[Unit]\nDescription=Basic System\n' > "$lib/basic.target"
+    printf '[Unit]\nDescription=Rescue Shell\n' > "$lib/rescue.service"
+    printf '[Unit]\nAfter=\nAfter=local-fs.target\n' > "$etc/sshd.service.d/override.conf"
+    ln -s /usr/lib/systemd/system/sshd.service "$etc/multi-user.target.wants/sshd.service"
+    ln -s /dev/null "$etc/rescue.service"
+
+    OSCAP_PROBE_ROOT="$tmpdir" $OSCAP oval eval --results $RF $DF
+
+    [ -f $RF ]
+    verify_results "def" $DF $RF 5
+    verify_results "tst" $DF $RF 5
+
+    rm $RF
+    rm -rf "$tmpdir"
+}
+
+test_run "Probe systemdunitproperty reading unit files" test_probes_systemdunitproperty_unit_files
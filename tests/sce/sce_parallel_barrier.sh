@@ -0,0 +1,12 @@
+#!/usr/bin/env bash
+
+# Passes only when the given number of these scripts run at the same time
+touch "$XCCDF_VALUE_DIR/$$"
+for i in $(seq 100); do
+	if [ $(ls "$XCCDF_VALUE_DIR" | wc -l) -ge $XCCDF_VALUE_COUNT ]; then
+		echo "barrier reached"
+		exit $XCCDF_RESULT_PASS
+	fi
+	sleep 0.1
+done
+exit $XCCDF_RESULT_FAIL
@@ -0,0 +1,7 @@
+#!/usr/bin/env bash
+
+# a process in its own session survives the kill of the script and keeps
+# the output pipes open
+setsid sleep 60 &
+sleep 60
+exit $XCCDF_RESULT_PASS
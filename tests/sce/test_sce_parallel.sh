@@ -0,0 +1,42 @@
+#!/usr/bin/env bash
+
+# Test that SCE scripts run concurrently, that their results are reported
+# in the order of rules and that the time limit is enforced, even when
+# a process started by the script survives the kill.
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+function test_sce_parallel {
+    local workdir=$(mktemp -d)
+    local barrier=$(mktemp -d)
+    local result=$(mktemp)
+    local stdout=$(mktemp)
+
+    cp "$srcdir/sce_parallel_barrier.sh" "$srcdir/sce_sleep.sh" "$workdir/"
+    sed "s|@DIR@|$barrier|" "$srcdir/test_sce_parallel.xccdf.xml" > "$workdir/test_sce_parallel.xccdf.xml"
+
+    OSCAP_MAX_THREADS=3 $OSCAP xccdf eval --results "$result" "$workdir/test_sce_parallel.xccdf.xml" > $stdout
+    cat $stdout
+
+    # each script passes only if all three of them run at the same time
+    [ $(grep -c '<result>pass</result>' $result) -eq 3 ]
+    grep -q '<check-import import-name="stdout">barrier reached' $result
+    grep '^Rule' $stdout | grep -o 'www_rule_[0-9]' | tr '\n' ' ' | grep -q '^www_rule_1 www_rule_2 www_rule_3 $'
+
+    local start=$(date +%s)
+    OSCAP_SCE_TIMEOUT=1 $OSCAP xccdf eval --profile timeout --results "$result" "$workdir/test_sce_parallel.xccdf.xml" > $stdout || [ $? -eq 2 ]
+    cat $stdout
+    [ $(($(date +%s) - start)) -lt 30 ]
+    grep -q '<result>error</result>' $result
+    grep -q 'exceeded the time limit' $result
+
+    rm -rf "$workdir" "$barrier" $result $stdout
+}
+
+test_init
+
+test_run "SCE scripts run in parallel" test_sce_parallel
+
+test_exit
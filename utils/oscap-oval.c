@@ -353,6 +353,8 @@ int app_evaluate_oval(const struct oscap_action *action)
 		printf("Definition %s: %s\n", action->id, oval_result_get_text(eval_result));
 	}
 	else {
+		/* app_oval_callback() never stops the evaluation */
+		oval_session_set_parallel_eval(session, true);
 		if ((oval_session_evaluate(session, app_oval_callback, NULL)) != 0)
 			goto cleanup;
 	}
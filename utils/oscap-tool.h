@@ -163,6 +163,7 @@ struct oscap_action {
 	int remote_resources;
 	int progress;
 	int oval_results;
+	char *oval_results_compression;
 	int without_sys_chars;
 	int thin_results;
 	int remediate;
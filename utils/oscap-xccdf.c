@@ -155,6 +155,8 @@ static struct oscap_module XCCDF_EVAL = {
 		"   --cpe <name>                  - Use given CPE dictionary or language (autodetected)\n"
 		"                                   for applicability checks.\n"
 		"   --oval-results                - Save OVAL results as well.\n"
+		"   --oval-results-compression <gzip|zstd>\n"
+		"                                 - Compress the OVAL results files saved by --oval-results.\n"
 		"   --check-engine-results        - Save results from check engines loaded from plugins as well.\n"
 		"   --export-variables            - Export OVAL external variables provided by XCCDF.\n"
 		"   --results <file>              - Write XCCDF Results into file.\n"
@@ -198,6 +200,8 @@ static struct oscap_module XCCDF_REMEDIATE = {
 		"   --stig-viewer <file>          - Writes XCCDF results into FILE in a format readable by DISA STIG Viewer\n"
 		"   --report <file>               - Write HTML report into file.\n"
 		"   --oval-results                - Save OVAL results.\n"
+		"   --oval-results-compression <gzip|zstd>\n"
+		"                                 - Compress the OVAL results files saved by --oval-results.\n"
 		"   --export-variables            - Export OVAL external variables provided by XCCDF.\n"
 		"   --check-engine-results        - Save results from check engines loaded from plugins as well.\n"
 		"   --progress                    - Switch to sparse output suitable for progress reporting.\n"
@@ -543,6 +547,8 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	if (session == NULL)
 		goto cleanup;
 	xccdf_session_set_validation(session, action->validate, getenv("OSCAP_FULL_VALIDATION") != NULL);
+	if (!xccdf_session_set_oval_results_compression(session, action->oval_results_compression))
+		goto cleanup;
 	if (action->thin_results) {
 		xccdf_session_set_thin_results(session, true);
 		xccdf_session_set_without_sys_chars_export(session, true);
@@ -705,6 +711,8 @@ int app_xccdf_remediate(const struct oscap_action *action)
 	if (session == NULL)
 		goto cleanup;
 	xccdf_session_set_validation(session, action->validate, getenv("OSCAP_FULL_VALIDATION") != NULL);
+	if (!xccdf_session_set_oval_results_compression(session, action->oval_results_compression))
+		goto cleanup;
 	xccdf_session_set_user_cpe(session, action->cpe);
 	xccdf_session_set_remote_resources(session, action->remote_resources, download_reporting_callback);
 	xccdf_session_set_custom_oval_files(session, action->f_ovals);
@@ -1104,7 +1112,8 @@ enum oval_opt {
     XCCDF_OPT_CPE_DICT,
     XCCDF_OPT_OUTPUT = 'o',
     XCCDF_OPT_RESULT_ID = 'i',
-	XCCDF_OPT_FIX_TYPE
+	XCCDF_OPT_FIX_TYPE,
+	XCCDF_OPT_OVAL_RESULTS_COMPRESSION
 };
 
 bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
@@ -1136,6 +1145,7 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		{"cpe-dict",	required_argument, NULL, XCCDF_OPT_CPE_DICT}, // DEPRECATED!
 		{"sce-template", 	required_argument, NULL, XCCDF_OPT_SCE_TEMPLATE},
 		{"fix-type", required_argument, NULL, XCCDF_OPT_FIX_TYPE},
+		{"oval-results-compression", required_argument, NULL, XCCDF_OPT_OVAL_RESULTS_COMPRESSION},
 	// flags
 		{"force",		no_argument, &action->force, 1},
 		{"oval-results",	no_argument, &action->oval_results, 1},
@@ -1185,6 +1195,9 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		case XCCDF_OPT_FIX_TYPE:
 			action->fix_type = optarg;
 			break;
+		case XCCDF_OPT_OVAL_RESULTS_COMPRESSION:
+			action->oval_results_compression = optarg;
+			break;
 		case 0: break;
 		default: return oscap_module_usage(action->module, stderr, NULL);
 		}